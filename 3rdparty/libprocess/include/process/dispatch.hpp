@@ -14,7 +14,7 @@
 #define __PROCESS_DISPATCH_HPP__
 
 #include <functional>
-#include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
+#include <memory>
 #include <string>
 
 #include <process/process.hpp>
@@ -54,18 +54,93 @@ namespace process {
 
 namespace internal {
 
+// A dispatch event which stores the function to get invoked inline,
+// so that dispatching only requires a single (recycled, see
+// `DispatchEvent::operator new`) allocation for both the event and
+// the function. The function gets invoked at most once.
+template <typename F>
+class Dispatcher : public DispatchEvent
+{
+public:
+  Dispatcher(
+      const UPID& pid,
+      F&& _f,
+      const Option<const std::type_info*>& functionType,
+      const std::string* method)
+    : DispatchEvent(pid, functionType, method),
+      f(std::move(_f)) {}
+
+  virtual void operator()(ProcessBase* process) const
+  {
+    f(process);
+  }
+
+private:
+  mutable F f;
+};
+
+
+// Delivers a dispatch event to the process associated with the pid
+// of the event, unless that process is no longer valid in which case
+// the event gets deleted.
+void dispatch(DispatchEvent* event);
+
+
 // The internal dispatch routine schedules a function to get invoked
 // within the context of the process associated with the specified pid
 // (first argument), unless that process is no longer valid. Note that
 // this routine does not expect anything in particular about the
 // specified function (second argument). The semantics are simple: the
 // function gets applied/invoked with the process as its first
-// argument. Currently we wrap the function in a shared_ptr but this
-// will probably change in the future to unique_ptr (or a variant).
-void dispatch(
+// argument. The function only needs to be movable as it gets moved
+// into the dispatch event.
+//
+// NOTE: this is not an overload of `dispatch` as it would be
+// ambiguous with the public `dispatch(const UPID& pid, F&& f)`.
+template <typename F>
+void _dispatch(
     const UPID& pid,
-    const std::shared_ptr<std::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType = None());
+    F&& f,
+    const Option<const std::type_info*>& functionType = None(),
+    const std::string* method = nullptr)
+{
+  typedef typename std::decay<F>::type Function;
+
+  internal::dispatch(new Dispatcher<Function>(
+      pid,
+      Function(std::forward<F>(f)),
+      functionType,
+      method));
+}
+
+
+// Returns the interned name of the method of the specified type with
+// the specified pointer bits, i.e., the same string for every call
+// with the same method.
+const std::string* intern(
+    const std::type_info& type,
+    const char* bits,
+    size_t size);
+
+
+// Returns the interned name of the specified method, which tells
+// apart methods with the same signature (see `DispatchEvent::method`).
+template <typename M>
+const std::string* methodOf(M m)
+{
+  // Remember the last method of this type interned by this thread,
+  // so that dispatching the same method again avoids the lock taken
+  // when interning.
+  static thread_local M last = nullptr;
+  static thread_local const std::string* name = nullptr;
+
+  if (name == nullptr || last != m) {
+    name = intern(typeid(M), reinterpret_cast<const char*>(&m), sizeof(M));
+    last = m;
+  }
+
+  return name;
+}
 
 
 // NOTE: This struct is used by the public `dispatch(const UPID& pid, F&& f)`
@@ -84,13 +159,11 @@ struct Dispatch<void>
   template <typename F>
   void operator()(const UPID& pid, F&& f)
   {
-    std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-        new std::function<void(ProcessBase*)>(
-            [=](ProcessBase*) {
-              f();
-            }));
-
-    internal::dispatch(pid, f_);
+    internal::_dispatch(
+        pid,
+        [=](ProcessBase*) {
+          f();
+        });
   }
 };
 
@@ -105,17 +178,28 @@ struct Dispatch<Future<R>>
   template <typename F>
   Future<R> operator()(const UPID& pid, F&& f)
   {
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());
-
-    std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-        new std::function<void(ProcessBase*)>(
-            [=](ProcessBase*) {
-              promise->associate(f());
-            }));
-
-    internal::dispatch(pid, f_);
-
-    return promise->future();
+    // NOTE: we use a struct rather than `std::bind` to store `f`
+    // together with the promise as `std::bind` would evaluate `f` if
+    // it is itself a bind expression.
+    struct Invoke
+    {
+      void operator()(ProcessBase*)
+      {
+        promise.associate(f());
+      }
+
+      typename std::decay<F>::type f;
+      Promise<R> promise;
+    };
+
+    Promise<R> promise;
+    Future<R> future = promise.future();
+
+    internal::_dispatch(
+        pid,
+        Invoke{std::forward<F>(f), std::move(promise)});
+
+    return future;
   }
 };
 
@@ -129,17 +213,28 @@ struct Dispatch
   template <typename F>
   Future<R> operator()(const UPID& pid, F&& f)
   {
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());
-
-    std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-        new std::function<void(ProcessBase*)>(
-            [=](ProcessBase*) {
-              promise->set(f());
-            }));
-
-    internal::dispatch(pid, f_);
-
-    return promise->future();
+    // NOTE: we use a struct rather than `std::bind` to store `f`
+    // together with the promise as `std::bind` would evaluate `f` if
+    // it is itself a bind expression.
+    struct Invoke
+    {
+      void operator()(ProcessBase*)
+      {
+        promise.set(f());
+      }
+
+      typename std::decay<F>::type f;
+      Promise<R> promise;
+    };
+
+    Promise<R> promise;
+    Future<R> future = promise.future();
+
+    internal::_dispatch(
+        pid,
+        Invoke{std::forward<F>(f), std::move(promise)});
+
+    return future;
   }
 };
 
@@ -157,16 +252,16 @@ struct Dispatch
 template <typename T>
 void dispatch(const PID<T>& pid, void (T::*method)())
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != nullptr);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != nullptr);
-            (t->*method)();
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  internal::_dispatch(
+      pid,
+      [=](ProcessBase* process) {
+        assert(process != nullptr);
+        T* t = dynamic_cast<T*>(process);
+        assert(t != nullptr);
+        (t->*method)();
+      },
+      &typeid(method),
+      internal::methodOf(method));
 }
 
 template <typename T>
@@ -198,19 +293,19 @@ void dispatch(const Process<T>* process, void (T::*method)())
       void (T::*method)(ENUM_PARAMS(N, P)),                             \
       ENUM_BINARY_PARAMS(N, A, &&a))                                    \
   {                                                                     \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            std::bind([method](ENUM(N, DECL, _),                        \
-                               ProcessBase* process) {                  \
-                        assert(process != nullptr);                     \
-                        T* t = dynamic_cast<T*>(process);               \
-                        assert(t != nullptr);                           \
-                        (t->*method)(ENUM_PARAMS(N, a));                \
-                      },                                                \
-                      ENUM(N, FORWARD, _),                              \
-                      lambda::_1)));                                    \
-                                                                        \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::_dispatch(                                                \
+        pid,                                                            \
+        std::bind([method](ENUM(N, DECL, _),                            \
+                           ProcessBase* process) {                      \
+                    assert(process != nullptr);                         \
+                    T* t = dynamic_cast<T*>(process);                   \
+                    assert(t != nullptr);                               \
+                    (t->*method)(ENUM_PARAMS(N, a));                    \
+                  },                                                    \
+                  ENUM(N, FORWARD, _),                                  \
+                  lambda::_1),                                          \
+        &typeid(method),                                                \
+        internal::methodOf(method));                                    \
   }                                                                     \
                                                                         \
   template <typename T,                                                 \
@@ -244,20 +339,24 @@ void dispatch(const Process<T>* process, void (T::*method)())
 template <typename R, typename T>
 Future<R> dispatch(const PID<T>& pid, Future<R> (T::*method)())
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  Promise<R> promise;
+  Future<R> future = promise.future();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
+  internal::_dispatch(
+      pid,
+      std::bind(
+          [method](Promise<R>& promise, ProcessBase* process) {
             assert(process != nullptr);
             T* t = dynamic_cast<T*>(process);
             assert(t != nullptr);
-            promise->associate((t->*method)());
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
-
-  return promise->future();
+            promise.associate((t->*method)());
+          },
+          std::move(promise),
+          lambda::_1),
+      &typeid(method),
+      internal::methodOf(method));
+
+  return future;
 }
 
 template <typename R, typename T>
@@ -282,24 +381,26 @@ Future<R> dispatch(const Process<T>* process, Future<R> (T::*method)())
       Future<R> (T::*method)(ENUM_PARAMS(N, P)),                        \
       ENUM_BINARY_PARAMS(N, A, &&a))                                    \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
+    Promise<R> promise;                                                 \
+    Future<R> future = promise.future();                                \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            std::bind([promise, method](ENUM(N, DECL, _),               \
-                                        ProcessBase* process) {         \
-                        assert(process != nullptr);                     \
-                        T* t = dynamic_cast<T*>(process);               \
-                        assert(t != nullptr);                           \
-                        promise->associate(                             \
-                            (t->*method)(ENUM_PARAMS(N, a)));           \
-                      },                                                \
-                      ENUM(N, FORWARD, _),                              \
-                      lambda::_1)));                                    \
+    internal::_dispatch(                                                \
+        pid,                                                            \
+        std::bind([method](Promise<R>& promise,                         \
+                           ENUM(N, DECL, _),                            \
+                           ProcessBase* process) {                      \
+                    assert(process != nullptr);                         \
+                    T* t = dynamic_cast<T*>(process);                   \
+                    assert(t != nullptr);                               \
+                    promise.associate((t->*method)(ENUM_PARAMS(N, a))); \
+                  },                                                    \
+                  std::move(promise),                                   \
+                  ENUM(N, FORWARD, _),                                  \
+                  lambda::_1),                                          \
+        &typeid(method),                                                \
+        internal::methodOf(method));                                    \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
-                                                                        \
-    return promise->future();                                           \
+    return future;                                                      \
   }                                                                     \
                                                                         \
   template <typename R,                                                 \
@@ -335,20 +436,24 @@ Future<R> dispatch(const Process<T>* process, Future<R> (T::*method)())
 template <typename R, typename T>
 Future<R> dispatch(const PID<T>& pid, R (T::*method)())
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  Promise<R> promise;
+  Future<R> future = promise.future();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
+  internal::_dispatch(
+      pid,
+      std::bind(
+          [method](Promise<R>& promise, ProcessBase* process) {
             assert(process != nullptr);
             T* t = dynamic_cast<T*>(process);
             assert(t != nullptr);
-            promise->set((t->*method)());
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
-
-  return promise->future();
+            promise.set((t->*method)());
+          },
+          std::move(promise),
+          lambda::_1),
+      &typeid(method),
+      internal::methodOf(method));
+
+  return future;
 }
 
 template <typename R, typename T>
@@ -373,23 +478,26 @@ Future<R> dispatch(const Process<T>* process, R (T::*method)())
       R (T::*method)(ENUM_PARAMS(N, P)),                                \
       ENUM_BINARY_PARAMS(N, A, &&a))                                    \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
-                                                                        \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            std::bind([promise, method](ENUM(N, DECL, _),               \
-                                        ProcessBase* process) {         \
-                        assert(process != nullptr);                     \
-                        T* t = dynamic_cast<T*>(process);               \
-                        assert(t != nullptr);                           \
-                        promise->set((t->*method)(ENUM_PARAMS(N, a)));  \
-                      },                                                \
-                      ENUM(N, FORWARD, _),                              \
-                      lambda::_1)));                                    \
+    Promise<R> promise;                                                 \
+    Future<R> future = promise.future();                                \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::_dispatch(                                                \
+        pid,                                                            \
+        std::bind([method](Promise<R>& promise,                         \
+                           ENUM(N, DECL, _),                            \
+                           ProcessBase* process) {                      \
+                    assert(process != nullptr);                         \
+                    T* t = dynamic_cast<T*>(process);                   \
+                    assert(t != nullptr);                               \
+                    promise.set((t->*method)(ENUM_PARAMS(N, a)));       \
+                  },                                                    \
+                  std::move(promise),                                   \
+                  ENUM(N, FORWARD, _),                                  \
+                  lambda::_1),                                          \
+        &typeid(method),                                                \
+        internal::methodOf(method));                                    \
                                                                         \
-    return promise->future();                                           \
+    return future;                                                      \
   }                                                                     \
                                                                         \
   template <typename R,                                                 \
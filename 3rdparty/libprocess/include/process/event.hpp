@@ -13,6 +13,7 @@
 #ifndef __PROCESS_EVENT_HPP__
 #define __PROCESS_EVENT_HPP__
 
+#include <chrono>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
 
 #include <process/future.hpp>
@@ -85,6 +86,11 @@ struct Event
 
   // JSON representation for an Event.
   operator JSON::Object() const;
+
+  // Time at which the event was enqueued on the event queue of its
+  // process, used to measure how long it waited on the queue (see
+  // `ProcessBase::enqueue` and `ProcessManager::resume`).
+  std::chrono::steady_clock::time_point enqueued;
 };
 
 
@@ -164,11 +170,11 @@ struct DispatchEvent : Event
 {
   DispatchEvent(
       const UPID& _pid,
-      const std::shared_ptr<lambda::function<void(ProcessBase*)>>& _f,
-      const Option<const std::type_info*>& _functionType)
+      const Option<const std::type_info*>& _functionType,
+      const std::string* _method = nullptr)
     : pid(_pid),
-      f(_f),
-      functionType(_functionType)
+      functionType(_functionType),
+      method(_method)
   {}
 
   virtual void visit(EventVisitor* visitor) const
@@ -176,14 +182,27 @@ struct DispatchEvent : Event
     visitor->visit(*this);
   }
 
+  // Invokes the function of this dispatch event on the specified
+  // process. The function itself is stored inline by the subclass
+  // created in `dispatch.hpp` so that a dispatch event (including its
+  // function) only requires a single allocation.
+  virtual void operator()(ProcessBase* process) const = 0;
+
+  // Dispatch events are allocated from (and returned to) per thread
+  // free lists of previously deleted dispatch events, see process.cpp.
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer, size_t size);
+
   // PID receiving the dispatch.
   const UPID pid;
 
-  // Function to get invoked as a result of this dispatch event.
-  const std::shared_ptr<lambda::function<void(ProcessBase*)>> f;
-
   const Option<const std::type_info*> functionType;
 
+  // The interned name of the dispatched method (if any), which unlike
+  // `functionType` tells apart methods with the same signature, see
+  // `internal::methodOf` in dispatch.hpp.
+  const std::string* const method;
+
 private:
   // Not copyable, not assignable.
   DispatchEvent(const DispatchEvent&);
@@ -14,6 +14,7 @@
 #define __PROCESS_FUTURE_HPP__
 
 #include <assert.h>
+#include <stdint.h>
 
 #include <atomic>
 #include <list>
@@ -447,22 +448,89 @@ private:
   enum State
   {
     PENDING,
+    COMPLETING, // Being set or failed, otherwise the same as PENDING.
     READY,
     FAILED,
     DISCARDED,
   };
 
+  // A callback installed via one of the `on*` functions. Only the
+  // member of the union that corresponds to `kind` gets constructed
+  // (by whoever allocates the callback, see `Data::allocate`).
+  struct Callback
+  {
+    enum Kind
+    {
+      DISCARD,
+      READY,
+      FAILED,
+      DISCARDED,
+      ANY,
+    };
+
+    Callback(Kind _kind, bool _inlined)
+      : kind(_kind), inlined(_inlined), next(nullptr) {}
+
+    ~Callback();
+
+    const Kind kind;
+
+    // Whether this callback lives in the inline storage of `Data`.
+    const bool inlined;
+
+    Callback* next;
+
+    union
+    {
+      DiscardCallback nullary; // Both DISCARD and DISCARDED.
+      ReadyCallback onReady;
+      FailedCallback onFailed;
+      AnyCallback onAny;
+    };
+  };
+
   struct Data
   {
     Data();
-    ~Data() = default;
+    ~Data();
+
+    // Allocates a callback using the inline storage below for the
+    // first `INLINE` callbacks of this future.
+    Callback* allocate(typename Callback::Kind kind);
+    void deallocate(Callback* callback);
+
+    // Adds the callback to the list unless the list has already been
+    // closed, in which case this returns false.
+    static bool push(std::atomic<Callback*>* list, Callback* callback);
+
+    // Closes the list with the specified marker and returns its
+    // callbacks in the order they were added, or `nullptr` if the
+    // list was already closed.
+    static Callback* close(
+        std::atomic<Callback*>* list,
+        Callback* marker = closed());
+
+    // Markers of a closed list, never dereferenced. The onDiscard
+    // callbacks are closed with `discarded()` by a successful discard
+    // and with `closed()` otherwise.
+    static Callback* closed()
+    {
+      return reinterpret_cast<Callback*>(static_cast<uintptr_t>(1));
+    }
 
-    void clearAllCallbacks();
+    static Callback* discarded()
+    {
+      return reinterpret_cast<Callback*>(static_cast<uintptr_t>(2));
+    }
+
+    static bool isClosed(Callback* head)
+    {
+      return head == closed() || head == discarded();
+    }
 
-    std::atomic_flag lock = ATOMIC_FLAG_INIT;
-    State state;
-    bool discard;
-    bool associated;
+    std::atomic<State> state;
+    std::atomic<bool> discard;
+    std::atomic<bool> associated;
 
     // One of:
     //   1. None, the state is PENDING or DISCARDED.
@@ -470,13 +538,36 @@ private:
     //   3. Error, the state is FAILED; 'error()' stores the message.
     Result<T> result;
 
-    std::vector<DiscardCallback> onDiscardCallbacks;
-    std::vector<ReadyCallback> onReadyCallbacks;
-    std::vector<FailedCallback> onFailedCallbacks;
-    std::vector<DiscardedCallback> onDiscardedCallbacks;
-    std::vector<AnyCallback> onAnyCallbacks;
+    // Callbacks get pushed onto lock-free (intrusive) stacks which
+    // are closed exactly once: `callbacks` (the onReady, onFailed,
+    // onDiscarded and onAny callbacks) when this future completes,
+    // and `discardCallbacks` when this future gets discarded or
+    // starts completing, whichever happens first. Whoever closes a
+    // list owns its callbacks. Once a list has been closed callbacks
+    // are invoked (or dropped) by whoever tries to install them.
+    std::atomic<Callback*> callbacks;
+    std::atomic<Callback*> discardCallbacks;
+
+    // Most futures only get one or two callbacks so we store the first
+    // few callbacks inline rather than allocating them separately.
+    static constexpr size_t INLINE = 2;
+
+    std::atomic<size_t> allocated;
+
+    typename std::aligned_storage<sizeof(Callback), alignof(Callback)>::type
+      storage[INLINE];
   };
 
+  // Drops the onDiscard callbacks as this future is about to be
+  // completed, unless this future has been discarded already in which
+  // case they are being invoked by `discard`. Must be called by the
+  // thread completing this future before it sets the final state.
+  void dropDiscardCallbacks();
+
+  // Invokes the callbacks for the state this future completed in,
+  // followed by the onAny callbacks, and then deletes all callbacks.
+  void complete();
+
   // Sets the value for this future, unless the future is already set,
   // failed, or discarded, in which case it returns false.
   bool set(const T& _t);
@@ -493,22 +584,6 @@ private:
 };
 
 
-namespace internal {
-
-// Helper for executing callbacks that have been registered.
-//
-// TODO(*): Invoke callbacks in another execution context.
-template <typename C, typename... Arguments>
-void run(const std::vector<C>& callbacks, Arguments&&... arguments)
-{
-  for (size_t i = 0; i < callbacks.size(); ++i) {
-    callbacks[i](std::forward<Arguments>(arguments)...);
-  }
-}
-
-} // namespace internal {
-
-
 // Represents a weak reference to a future. This class is used to
 // break cyclic dependencies between futures.
 template <typename T>
@@ -726,13 +801,14 @@ bool Promise<T>::associate(const Future<T>& future)
 {
   bool associated = false;
 
-  synchronized (f.data->lock) {
-    // Don't associate if this promise has completed. Note that this
-    // does not include if Future::discard was called on this future
-    // since in that case that would still leave the future PENDING
-    // (note that we cover that case below).
-    if (f.data->state == Future<T>::PENDING && !f.data->associated) {
-      associated = f.data->associated = true;
+  // Don't associate if this promise has completed. Note that this
+  // does not include if Future::discard was called on this future
+  // since in that case that would still leave the future PENDING
+  // (note that we cover that case below).
+  if (f.data->state == Future<T>::PENDING) {
+    bool expected = false;
+    if (f.data->associated.compare_exchange_strong(expected, true)) {
+      associated = true;
 
       // After this point we don't allow 'f' to be completed via the
       // promise since we've set 'associated' but Future::discard on
@@ -744,10 +820,6 @@ bool Promise<T>::associate(const Future<T>& future)
     }
   }
 
-  // Note that we do the actual associating after releasing the lock
-  // above to avoid deadlocking by attempting to require the lock
-  // within from invoking 'f.onDiscard' and/or 'f.set/fail' via the
-  // bind statements from doing 'future.onReady/onFailed'.
   if (associated) {
     // TODO(jieyu): Make 'f' a true alias of 'future'. Currently, only
     // 'discard' is associated in both directions. In other words, if
@@ -880,25 +952,19 @@ void discard(const std::list<Future<T>>& futures)
 template <typename T>
 bool Promise<T>::discard(Future<T> future)
 {
-  std::shared_ptr<typename Future<T>::Data> data = future.data;
+  typename Future<T>::State expected = Future<T>::PENDING;
 
-  bool result = false;
-
-  synchronized (data->lock) {
-    if (data->state == Future<T>::PENDING) {
-      data->state = Future<T>::DISCARDED;
-      result = true;
-    }
-  }
+  bool result = future.data->state.compare_exchange_strong(
+      expected,
+      Future<T>::COMPLETING);
 
   // Invoke all callbacks associated with this future being
-  // DISCARDED. We don't need a lock because the state is now in
-  // DISCARDED so there should not be any concurrent modifications.
+  // DISCARDED. Only the thread that transitioned the state may do so.
   if (result) {
-    internal::run(future.data->onDiscardedCallbacks);
-    internal::run(future.data->onAnyCallbacks, future);
+    future.dropDiscardCallbacks();
+    future.data->state = Future<T>::DISCARDED;
 
-    future.data->clearAllCallbacks();
+    future.complete();
   }
 
   return result;
@@ -914,33 +980,196 @@ Future<T> Future<T>::failed(const std::string& message)
 }
 
 
+template <typename T>
+Future<T>::Callback::~Callback()
+{
+  switch (kind) {
+    case DISCARD:
+    case DISCARDED:
+      nullary.~DiscardCallback();
+      break;
+    case READY:
+      onReady.~ReadyCallback();
+      break;
+    case FAILED:
+      onFailed.~FailedCallback();
+      break;
+    case ANY:
+      onAny.~AnyCallback();
+      break;
+  }
+}
+
+
 template <typename T>
 Future<T>::Data::Data()
   : state(PENDING),
     discard(false),
     associated(false),
-    result(None()) {}
+    result(None()),
+    callbacks(nullptr),
+    discardCallbacks(nullptr),
+    allocated(0) {}
+
+
+template <typename T>
+Future<T>::Data::~Data()
+{
+  // The lists have not been closed if this future never completed,
+  // e.g., because its promise got deleted.
+  for (std::atomic<Callback*>* list : {&callbacks, &discardCallbacks}) {
+    Callback* callback = list->load();
+    if (isClosed(callback)) {
+      continue;
+    }
+
+    while (callback != nullptr) {
+      Callback* next = callback->next;
+      deallocate(callback);
+      callback = next;
+    }
+  }
+}
+
+
+template <typename T>
+typename Future<T>::Callback* Future<T>::Data::allocate(
+    typename Callback::Kind kind)
+{
+  // NOTE: inline storage is never reused, even after the callback
+  // that used it got deallocated.
+  const size_t index = allocated.fetch_add(1, std::memory_order_relaxed);
+
+  if (index < INLINE) {
+    return new (&storage[index]) Callback(kind, true);
+  }
+
+  return new Callback(kind, false);
+}
+
+
+template <typename T>
+void Future<T>::Data::deallocate(Callback* callback)
+{
+  if (callback->inlined) {
+    callback->~Callback();
+  } else {
+    delete callback;
+  }
+}
+
+
+template <typename T>
+bool Future<T>::Data::push(std::atomic<Callback*>* list, Callback* callback)
+{
+  // NOTE: we need to acquire the effects of whoever closed the list
+  // (i.e., the state and result of the future) in case we fail.
+  Callback* head = list->load(std::memory_order_acquire);
+
+  do {
+    if (isClosed(head)) {
+      return false;
+    }
+
+    callback->next = head;
+  } while (!list->compare_exchange_weak(
+      head,
+      callback,
+      std::memory_order_release,
+      std::memory_order_acquire));
+
+  return true;
+}
+
+
+template <typename T>
+typename Future<T>::Callback* Future<T>::Data::close(
+    std::atomic<Callback*>* list,
+    Callback* marker)
+{
+  Callback* head = list->load(std::memory_order_acquire);
+
+  do {
+    if (isClosed(head)) {
+      return nullptr;
+    }
+  } while (!list->compare_exchange_weak(
+      head,
+      marker,
+      std::memory_order_acq_rel,
+      std::memory_order_acquire));
+
+  // The list is a stack, so reverse it in order to return the
+  // callbacks in the order they were added.
+  Callback* reversed = nullptr;
+  while (head != nullptr) {
+    Callback* next = head->next;
+    head->next = reversed;
+    reversed = head;
+    head = next;
+  }
+
+  return reversed;
+}
 
 
 template <typename T>
-void Future<T>::Data::clearAllCallbacks()
+void Future<T>::dropDiscardCallbacks()
 {
-  onAnyCallbacks.clear();
-  onDiscardCallbacks.clear();
-  onDiscardedCallbacks.clear();
-  onFailedCallbacks.clear();
-  onReadyCallbacks.clear();
+  Callback* callbacks = Data::close(&data->discardCallbacks);
+
+  while (callbacks != nullptr) {
+    Callback* next = callbacks->next;
+    data->deallocate(callbacks);
+    callbacks = next;
+  }
+}
+
+
+template <typename T>
+void Future<T>::complete()
+{
+  Callback* callbacks = Data::close(&data->callbacks);
+
+  const State state = data->state.load();
+
+  // TODO(*): Invoke callbacks in another execution context.
+  for (Callback* callback = callbacks;
+       callback != nullptr;
+       callback = callback->next) {
+    if (callback->kind == Callback::READY && state == READY) {
+      callback->onReady(data->result.get());
+    } else if (callback->kind == Callback::FAILED && state == FAILED) {
+      callback->onFailed(data->result.error());
+    } else if (callback->kind == Callback::DISCARDED && state == DISCARDED) {
+      callback->nullary();
+    }
+  }
+
+  for (Callback* callback = callbacks;
+       callback != nullptr;
+       callback = callback->next) {
+    if (callback->kind == Callback::ANY) {
+      callback->onAny(*this);
+    }
+  }
+
+  while (callbacks != nullptr) {
+    Callback* next = callbacks->next;
+    data->deallocate(callbacks);
+    callbacks = next;
+  }
 }
 
 
 template <typename T>
 Future<T>::Future()
-  : data(new Data()) {}
+  : data(std::make_shared<Data>()) {}
 
 
 template <typename T>
 Future<T>::Future(const T& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(_t);
 }
@@ -949,7 +1178,7 @@ Future<T>::Future(const T& _t)
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(u);
 }
@@ -957,7 +1186,7 @@ Future<T>::Future(const U& u)
 
 template <typename T>
 Future<T>::Future(const Failure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -965,7 +1194,7 @@ Future<T>::Future(const Failure& failure)
 
 template <typename T>
 Future<T>::Future(const ErrnoFailure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -983,7 +1212,7 @@ Future<T>::Future(Future<T>&& that)
 
 template <typename T>
 Future<T>::Future(const Try<T>& t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   if (t.isSome()){
     set(t.get());
@@ -1027,42 +1256,61 @@ bool Future<T>::operator<(const Future<T>& that) const
 template <typename T>
 bool Future<T>::discard()
 {
-  bool result = false;
-
-  std::vector<DiscardCallback> callbacks;
-  synchronized (data->lock) {
-    if (!data->discard && data->state == PENDING) {
-      result = data->discard = true;
-
-      // NOTE: We make a copy of the onDiscard callbacks here
-      // because it is possible that another thread completes this
-      // future (ready, failed or discarded) when the current thread
-      // is out of this critical section but *before* it executed the
-      // onDiscard callbacks. If that happens, the other thread might
-      // be clearing the onDiscard callbacks (via clearAllCallbacks())
-      // while the current thread is executing or clearing the
-      // onDiscard callbacks, causing thread safety issue.
-      callbacks = data->onDiscardCallbacks;
-      data->onDiscardCallbacks.clear();
+  // A discard only succeeds if it closes the onDiscard callbacks
+  // before the thread completing this future does (see
+  // `dropDiscardCallbacks`), so that the callbacks are either invoked
+  // here or dropped by that thread. Closing the list with the
+  // `discarded()` marker guarantees that any onDiscard callbacks
+  // installed from now on get invoked directly (see `onDiscard`).
+  //
+  // NOTE: the list may be empty, so `close` returning `nullptr` does
+  // not tell whether we closed it.
+  Callback* head = data->discardCallbacks.load(std::memory_order_acquire);
+
+  do {
+    if (Data::isClosed(head)) {
+      return false;
     }
+  } while (!data->discardCallbacks.compare_exchange_weak(
+      head,
+      Data::discarded(),
+      std::memory_order_acq_rel,
+      std::memory_order_acquire));
+
+  data->discard = true;
+
+  // The list is a stack, so reverse it in order to invoke the
+  // callbacks in the order they were added.
+  Callback* callbacks = nullptr;
+  while (head != nullptr) {
+    Callback* next = head->next;
+    head->next = callbacks;
+    callbacks = head;
+    head = next;
   }
 
-  // Invoke all callbacks associated with doing a discard on this
-  // future. We don't need a lock because 'Data::discard' should now
-  // be set so we won't be adding anything else to
-  // 'Data::onDiscardCallbacks'.
-  if (result) {
-    internal::run(callbacks);
+  // TODO(*): Invoke callbacks in another execution context.
+  for (Callback* callback = callbacks;
+       callback != nullptr;
+       callback = callback->next) {
+    callback->nullary();
   }
 
-  return result;
+  while (callbacks != nullptr) {
+    Callback* next = callbacks->next;
+    data->deallocate(callbacks);
+    callbacks = next;
+  }
+
+  return true;
 }
 
 
 template <typename T>
 bool Future<T>::isPending() const
 {
-  return data->state == PENDING;
+  const State state = data->state.load();
+  return state == PENDING || state == COMPLETING;
 }
 
 
@@ -1123,10 +1371,14 @@ bool Future<T>::await(const Duration& duration) const
 
   bool pending = false;
 
-  synchronized (data->lock) {
-    if (data->state == PENDING) {
-      pending = true;
-      data->onAnyCallbacks.push_back(lambda::bind(&internal::awaited, latch));
+  if (data->callbacks.load(std::memory_order_acquire) != Data::closed()) {
+    Callback* callback = data->allocate(Callback::ANY);
+    new (&callback->onAny) AnyCallback(lambda::bind(&internal::awaited, latch));
+
+    pending = Data::push(&data->callbacks, callback);
+
+    if (!pending) {
+      data->deallocate(callback);
     }
   }
 
@@ -1179,13 +1431,22 @@ const std::string& Future<T>::failure() const
 template <typename T>
 const Future<T>& Future<T>::onDiscard(DiscardCallback&& callback) const
 {
-  bool run = false;
+  Callback* head = data->discardCallbacks.load(std::memory_order_acquire);
 
-  synchronized (data->lock) {
-    if (data->discard) {
-      run = true;
-    } else if (data->state == PENDING) {
-      data->onDiscardCallbacks.emplace_back(std::move(callback));
+  bool run = head == Data::discarded();
+
+  if (!Data::isClosed(head)) {
+    Callback* node = data->allocate(Callback::DISCARD);
+    new (&node->nullary) DiscardCallback(std::move(callback));
+
+    // If the list got closed in the mean time either this future got
+    // discarded, in which case we need to invoke the callback, or it
+    // is completing in which case the callback is not needed.
+    if (!Data::push(&data->discardCallbacks, node)) {
+      callback = std::move(node->nullary);
+      data->deallocate(node);
+      run = data->discardCallbacks.load(std::memory_order_acquire) ==
+        Data::discarded();
     }
   }
 
@@ -1201,16 +1462,21 @@ const Future<T>& Future<T>::onDiscard(DiscardCallback&& callback) const
 template <typename T>
 const Future<T>& Future<T>::onReady(ReadyCallback&& callback) const
 {
-  bool run = false;
+  if (data->callbacks.load(std::memory_order_acquire) != Data::closed()) {
+    Callback* node = data->allocate(Callback::READY);
+    new (&node->onReady) ReadyCallback(std::move(callback));
 
-  synchronized (data->lock) {
-    if (data->state == READY) {
-      run = true;
-    } else if (data->state == PENDING) {
-      data->onReadyCallbacks.emplace_back(std::move(callback));
+    if (Data::push(&data->callbacks, node)) {
+      return *this;
     }
+
+    // This future completed in the mean time.
+    callback = std::move(node->onReady);
+    data->deallocate(node);
   }
 
+  const bool run = data->state == READY;
+
   // TODO(*): Invoke callback in another execution context.
   if (run) {
     callback(data->result.get());
@@ -1223,16 +1489,21 @@ const Future<T>& Future<T>::onReady(ReadyCallback&& callback) const
 template <typename T>
 const Future<T>& Future<T>::onFailed(FailedCallback&& callback) const
 {
-  bool run = false;
+  if (data->callbacks.load(std::memory_order_acquire) != Data::closed()) {
+    Callback* node = data->allocate(Callback::FAILED);
+    new (&node->onFailed) FailedCallback(std::move(callback));
 
-  synchronized (data->lock) {
-    if (data->state == FAILED) {
-      run = true;
-    } else if (data->state == PENDING) {
-      data->onFailedCallbacks.emplace_back(std::move(callback));
+    if (Data::push(&data->callbacks, node)) {
+      return *this;
     }
+
+    // This future completed in the mean time.
+    callback = std::move(node->onFailed);
+    data->deallocate(node);
   }
 
+  const bool run = data->state == FAILED;
+
   // TODO(*): Invoke callback in another execution context.
   if (run) {
     callback(data->result.error());
@@ -1245,16 +1516,21 @@ const Future<T>& Future<T>::onFailed(FailedCallback&& callback) const
 template <typename T>
 const Future<T>& Future<T>::onDiscarded(DiscardedCallback&& callback) const
 {
-  bool run = false;
+  if (data->callbacks.load(std::memory_order_acquire) != Data::closed()) {
+    Callback* node = data->allocate(Callback::DISCARDED);
+    new (&node->nullary) DiscardedCallback(std::move(callback));
 
-  synchronized (data->lock) {
-    if (data->state == DISCARDED) {
-      run = true;
-    } else if (data->state == PENDING) {
-      data->onDiscardedCallbacks.emplace_back(std::move(callback));
+    if (Data::push(&data->callbacks, node)) {
+      return *this;
     }
+
+    // This future completed in the mean time.
+    callback = std::move(node->nullary);
+    data->deallocate(node);
   }
 
+  const bool run = data->state == DISCARDED;
+
   // TODO(*): Invoke callback in another execution context.
   if (run) {
     callback();
@@ -1267,20 +1543,21 @@ const Future<T>& Future<T>::onDiscarded(DiscardedCallback&& callback) const
 template <typename T>
 const Future<T>& Future<T>::onAny(AnyCallback&& callback) const
 {
-  bool run = false;
+  if (data->callbacks.load(std::memory_order_acquire) != Data::closed()) {
+    Callback* node = data->allocate(Callback::ANY);
+    new (&node->onAny) AnyCallback(std::move(callback));
 
-  synchronized (data->lock) {
-    if (data->state == PENDING) {
-      data->onAnyCallbacks.emplace_back(std::move(callback));
-    } else {
-      run = true;
+    if (Data::push(&data->callbacks, node)) {
+      return *this;
     }
+
+    // This future completed in the mean time.
+    callback = std::move(node->onAny);
+    data->deallocate(node);
   }
 
   // TODO(*): Invoke callback in another execution context.
-  if (run) {
-    callback(*this);
-  }
+  callback(*this);
 
   return *this;
 }
@@ -1523,24 +1800,20 @@ template <typename T>
 template <typename U>
 bool Future<T>::_set(U&& u)
 {
-  bool result = false;
+  State expected = PENDING;
 
-  synchronized (data->lock) {
-    if (data->state == PENDING) {
-      data->result = std::forward<U>(u);
-      data->state = READY;
-      result = true;
-    }
-  }
+  bool result = data->state.compare_exchange_strong(expected, COMPLETING);
 
-  // Invoke all callbacks associated with this future being READY. We
-  // don't need a lock because the state is now in READY so there
-  // should not be any concurrent modifications.
+  // Invoke all callbacks associated with this future being READY.
+  // Transitioning to COMPLETING guarantees that no other thread
+  // completes this future concurrently.
   if (result) {
-    internal::run(data->onReadyCallbacks, data->result.get());
-    internal::run(data->onAnyCallbacks, *this);
+    dropDiscardCallbacks();
+
+    data->result = std::forward<U>(u);
+    data->state = READY;
 
-    data->clearAllCallbacks();
+    complete();
   }
 
   return result;
@@ -1550,24 +1823,20 @@ bool Future<T>::_set(U&& u)
 template <typename T>
 bool Future<T>::fail(const std::string& _message)
 {
-  bool result = false;
+  State expected = PENDING;
 
-  synchronized (data->lock) {
-    if (data->state == PENDING) {
-      data->result = Result<T>(Error(_message));
-      data->state = FAILED;
-      result = true;
-    }
-  }
+  bool result = data->state.compare_exchange_strong(expected, COMPLETING);
 
-  // Invoke all callbacks associated with this future being FAILED. We
-  // don't need a lock because the state is now in FAILED so there
-  // should not be any concurrent modifications.
+  // Invoke all callbacks associated with this future being FAILED.
+  // Transitioning to COMPLETING guarantees that no other thread
+  // completes this future concurrently.
   if (result) {
-    internal::run(data->onFailedCallbacks, data->result.error());
-    internal::run(data->onAnyCallbacks, *this);
+    dropDiscardCallbacks();
+
+    data->result = Result<T>(Error(_message));
+    data->state = FAILED;
 
-    data->clearAllCallbacks();
+    complete();
   }
 
   return result;
@@ -360,6 +360,16 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns the number of bytes written to the pipe which have not
+    // been read yet, i.e., how far the reader lags behind the writer.
+    size_t buffered() const;
+
+    // Returns Nothing once the reader has read all of the data written
+    // to the pipe so far (i.e., `buffered()` drops to zero) or once the
+    // read-end of the pipe is closed. This lets a writer produce more
+    // data only as fast as the reader consumes it.
+    Future<Nothing> drained() const;
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -391,7 +401,8 @@ private:
   {
     Data()
       : readEnd(Reader::OPEN),
-        writeEnd(Writer::OPEN) {}
+        writeEnd(Writer::OPEN),
+        buffered(0) {}
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a 'std::atomic_flag'.
@@ -407,6 +418,12 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // The total size of the unread writes.
+    size_t buffered;
+
+    // Represents writers waiting for the unread writes to be read.
+    std::queue<Owned<Promise<Nothing>>> drains;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
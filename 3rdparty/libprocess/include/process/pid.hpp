@@ -101,6 +101,14 @@ struct UPID
   // to which this UPID refers.
   void resolve();
 
+  // Returns true if this UPID has a cached weak pointer (see
+  // `resolve`) to a process which has not yet terminated, i.e., the
+  // process can be used without looking it up.
+  bool resolved() const
+  {
+    return reference.isSome() && !reference->expired();
+  }
+
   // TODO(benh): store all of the members of UPID behind a
   // copy-on-write implementation because UPID is often copied but
   // rarely written which means we could optimize performance by not
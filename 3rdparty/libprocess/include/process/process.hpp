@@ -43,6 +43,7 @@ namespace process {
 // Forward declaration.
 class EventQueue;
 class Gate;
+class Latencies;
 class Logging;
 class Sequence;
 
@@ -385,6 +386,7 @@ protected:
 private:
   friend class SocketManager;
   friend class ProcessManager;
+  friend class RunQueue;
   friend void* schedule(void*);
 
   // Process states.
@@ -405,6 +407,11 @@ private:
   // Flag for indicating that a terminate event has been injected.
   std::atomic<bool> termination = ATOMIC_VAR_INIT(false);
 
+  // Index of the worker thread that last ran this process, or -1 if
+  // there is none. Only used by the work stealing run queue in order
+  // to enqueue the process where it last ran.
+  std::atomic<int> affinity = ATOMIC_VAR_INIT(-1);
+
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event);
 
@@ -469,6 +476,9 @@ private:
   // a pointer so we can hide the implementation of `EventQueue`.
   std::unique_ptr<EventQueue> events;
 
+  // Latencies of the events of this process, see `Latencies`.
+  std::unique_ptr<Latencies> latencies;
+
   // NOTE: this is a shared pointer to a _pointer_, hence this is not
   // responsible for the ProcessBase itself.
   std::shared_ptr<ProcessBase*> reference;
@@ -19,6 +19,8 @@
 #endif // __WINDOWS__
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <process/address.hpp>
 #include <process/future.hpp>
@@ -153,6 +155,21 @@ public:
   virtual Future<size_t> send(const char* data, size_t size) = 0;
   virtual Future<size_t> sendfile(int_fd fd, off_t offset, size_t size) = 0;
 
+  /**
+   * Sends the data of the specified buffers, in order, ideally with a
+   * single vectored write (i.e., without first copying the buffers
+   * into one contiguous buffer). Like `send` this might only send
+   * part of the data and returns the number of bytes sent.
+   *
+   * The default implementation only sends (part of) the first
+   * non-empty buffer.
+   *
+   * @param buffers The data and size of each buffer, the buffers must
+   *     remain valid until the returned future has completed.
+   */
+  virtual Future<size_t> send(
+      const std::vector<std::pair<const char*, size_t>>& buffers);
+
   /**
    * An overload of `recv`, which receives data based on the specified
    * 'size' parameter.
@@ -377,6 +394,12 @@ public:
     return impl->sendfile(fd, offset, size);
   }
 
+  Future<size_t> send(
+      const std::vector<std::pair<const char*, size_t>>& buffers) const
+  {
+    return impl->send(buffers);
+  }
+
   Future<std::string> recv(const Option<ssize_t>& size = None())
   {
     return impl->recv(size);
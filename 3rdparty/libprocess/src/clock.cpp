@@ -12,20 +12,27 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
 #include <list>
 #include <map>
 #include <mutex>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include <process/clock.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 #include <process/time.hpp>
 #include <process/timeout.hpp>
+#include <process/timer.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/option.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
@@ -34,24 +41,465 @@
 
 using std::list;
 using std::map;
+using std::pair;
 using std::recursive_mutex;
 using std::set;
+using std::vector;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
-static recursive_mutex* timers_mutex = new recursive_mutex();
-
-
 // We namespace the clock related variables to keep them well
 // named. In the future we'll probably want to associate a clock with
 // a specific ProcessManager/SocketManager instance pair, so this will
 // likely change.
 namespace clock {
 
+// Timers are stored in hierarchical timing wheels so that creating
+// and canceling a timer takes constant time regardless of how many
+// timers are outstanding (see "Hashed and Hierarchical Timing Wheels"
+// by Varghese and Lauck).
+//
+// A slot in the lowest level of a wheel covers 'RESOLUTION' worth of
+// time and a slot in every other level covers an entire rotation of
+// the level below it. Timers that are too far in the future for the
+// highest level are kept in an overflow list that gets revisited every
+// time the highest level completes a rotation. The wheel only visits
+// slots that contain timers, so advancing a (paused) clock by a large
+// amount is cheap.
+//
+// NOTE: the resolution only determines the granularity of the slots,
+// a timer still only expires once its exact timeout has elapsed.
+class Wheel
+{
+public:
+  Wheel() : current(0)
+  {
+    clear();
+  }
+
+  ~Wheel()
+  {
+    clear();
+  }
+
+  Wheel(const Wheel&) = delete;
+  Wheel& operator=(const Wheel&) = delete;
+
+  // Adds a timer. The current time is used to position an empty wheel
+  // so that we don't need to visit all the time that has passed since
+  // the wheel was last used.
+  void add(uint64_t id, const Timer& timer, const Time& now);
+
+  // Returns false if the timer is not (or no longer) in this wheel.
+  bool remove(uint64_t id);
+
+  // Removes all timers that have expired as of 'now' and appends them
+  // (along with their ids) to 'timedout'.
+  void expire(const Time& now, vector<pair<uint64_t, Timer>>* timedout);
+
+  // Returns the timeout of the earliest timer, or a time before it if
+  // the earliest timer is not yet in the lowest level, or None if
+  // there are no timers.
+  Option<Time> next() const;
+
+  // Removes all timers without expiring them.
+  void clear();
+
+  bool empty() const
+  {
+    return nodes.empty();
+  }
+
+private:
+  static constexpr int LEVELS = 4;
+  static constexpr int BITS = 8;
+  static constexpr int64_t SLOTS = 1 << BITS;
+  static constexpr int64_t MASK = SLOTS - 1;
+  static constexpr int64_t WORDS = SLOTS / 64;
+
+  // Nanoseconds covered by a slot in the lowest level.
+  static constexpr int64_t RESOLUTION = 1000000;
+
+  struct Node
+  {
+    uint64_t id;
+    Timer timer;
+
+    // The timeout of the timer in units of 'RESOLUTION'.
+    int64_t tick;
+
+    // The level (or 'LEVELS' for the overflow list) and slot that
+    // this node is linked into.
+    int level;
+    int64_t slot;
+
+    Node* prev;
+    Node* next;
+  };
+
+  struct List
+  {
+    Node* head;
+    Node* tail;
+  };
+
+  static int64_t ticks(const Time& time)
+  {
+    return time.duration().ns() / RESOLUTION;
+  }
+
+  static Time time(int64_t tick)
+  {
+    if (tick > ticks(Time::max())) {
+      return Time::max();
+    }
+
+    return Time::epoch() + Nanoseconds(tick * RESOLUTION);
+  }
+
+  // Links the node into the slot that corresponds to its timeout
+  // relative to 'current'.
+  void place(Node* node);
+
+  void link(Node* node, int level, int64_t slot);
+  void unlink(Node* node);
+
+  // Relinks all the nodes in the list after it has been emptied.
+  void replace(List* list);
+
+  // Returns the next tick after 'current' at which we need to visit
+  // the wheel, i.e., a tick with timers in the lowest level or a tick
+  // at which timers need to be cascaded down from a higher level.
+  Option<int64_t> upcoming() const;
+
+  // Returns the first slot after 'index' in 'level' with timers.
+  Option<int64_t> search(int level, int64_t index) const;
+
+  // Cascades the timers of any higher level slots (or the overflow
+  // list) that 'current' just entered down to lower levels.
+  void cascade();
+
+  // Expires the timers in the current slot of the lowest level.
+  void fire(const Time& now, vector<pair<uint64_t, Timer>>* timedout);
+
+  List* list(int level, int64_t slot)
+  {
+    return level == LEVELS ? &overflow : &slots[level][slot];
+  }
+
+  // The tick the wheel has been advanced to. Timers with a timeout at
+  // or before 'current' are kept in the current slot of the lowest
+  // level until they get expired.
+  int64_t current;
+
+  List slots[LEVELS][SLOTS];
+  List overflow;
+
+  // Bitmap of the slots in each level that contain timers.
+  uint64_t occupied[LEVELS][WORDS];
+
+  hashmap<uint64_t, Node*> nodes;
+};
+
+
+void Wheel::add(uint64_t id, const Timer& timer, const Time& now)
+{
+  if (nodes.empty() && ticks(now) > current) {
+    current = ticks(now);
+  }
+
+  Node* node = new Node{
+      id, timer, ticks(timer.timeout().time()), 0, 0, nullptr, nullptr};
+
+  nodes[id] = node;
+
+  place(node);
+}
+
+
+bool Wheel::remove(uint64_t id)
+{
+  Option<Node*> node = nodes.get(id);
+  if (node.isNone()) {
+    return false;
+  }
+
+  unlink(node.get());
+  nodes.erase(id);
+  delete node.get();
+
+  return true;
+}
+
+
+void Wheel::expire(
+    const Time& now,
+    vector<pair<uint64_t, Timer>>* timedout)
+{
+  const int64_t target = ticks(now);
+
+  // The current slot might contain timers that expire later within
+  // the slot, or that were added after they had already expired.
+  fire(now, timedout);
+
+  Option<int64_t> tick = upcoming();
+
+  while (tick.isSome() && tick.get() <= target) {
+    current = tick.get();
+    cascade();
+    fire(now, timedout);
+    tick = upcoming();
+  }
+
+  // There aren't any timers to cascade or expire until after
+  // 'target' so we can skip straight to it.
+  if (target > current) {
+    current = target;
+  }
+}
+
+
+Option<Time> Wheel::next() const
+{
+  if (nodes.empty()) {
+    return None();
+  }
+
+  Option<int64_t> tick = current;
+
+  if (slots[0][current & MASK].head == nullptr) {
+    tick = upcoming();
+    CHECK_SOME(tick);
+
+    // We only know the exact timeouts for timers in the lowest level,
+    // for any higher level (or the overflow list) we return when the
+    // timers need to be cascaded.
+    if ((tick.get() >> BITS) != (current >> BITS)) {
+      return time(tick.get());
+    }
+  }
+
+  Option<Time> earliest = None();
+
+  for (Node* node = slots[0][tick.get() & MASK].head;
+       node != nullptr;
+       node = node->next) {
+    if (earliest.isNone() || node->timer.timeout().time() < earliest.get()) {
+      earliest = node->timer.timeout().time();
+    }
+  }
+
+  return earliest;
+}
+
+
+void Wheel::clear()
+{
+  foreachvalue (Node* node, nodes) {
+    delete node;
+  }
+
+  nodes.clear();
+
+  for (int level = 0; level < LEVELS; level++) {
+    for (int64_t slot = 0; slot < SLOTS; slot++) {
+      slots[level][slot] = List{nullptr, nullptr};
+    }
+
+    for (int64_t word = 0; word < WORDS; word++) {
+      occupied[level][word] = 0;
+    }
+  }
+
+  overflow = List{nullptr, nullptr};
+}
+
+
+void Wheel::place(Node* node)
+{
+  // Timers that have already expired go into the current slot.
+  const int64_t tick = node->tick > current ? node->tick : current;
+
+  for (int level = 0; level < LEVELS; level++) {
+    const int shift = BITS * (level + 1);
+
+    if ((tick >> shift) == (current >> shift)) {
+      link(node, level, (tick >> (BITS * level)) & MASK);
+      return;
+    }
+  }
+
+  link(node, LEVELS, 0);
+}
+
+
+void Wheel::link(Node* node, int level, int64_t slot)
+{
+  List* list = this->list(level, slot);
+
+  node->level = level;
+  node->slot = slot;
+  node->prev = list->tail;
+  node->next = nullptr;
+
+  if (list->tail != nullptr) {
+    list->tail->next = node;
+  } else {
+    list->head = node;
+  }
+
+  list->tail = node;
+
+  if (level != LEVELS) {
+    occupied[level][slot / 64] |= uint64_t(1) << (slot % 64);
+  }
+}
+
+
+void Wheel::unlink(Node* node)
+{
+  List* list = this->list(node->level, node->slot);
+
+  if (node->prev != nullptr) {
+    node->prev->next = node->next;
+  } else {
+    list->head = node->next;
+  }
+
+  if (node->next != nullptr) {
+    node->next->prev = node->prev;
+  } else {
+    list->tail = node->prev;
+  }
+
+  if (list->head == nullptr && node->level != LEVELS) {
+    occupied[node->level][node->slot / 64] &=
+      ~(uint64_t(1) << (node->slot % 64));
+  }
+}
+
+
+void Wheel::replace(List* list)
+{
+  Node* node = list->head;
+
+  while (node != nullptr) {
+    Node* next = node->next;
+    unlink(node);
+    place(node);
+    node = next;
+  }
+}
+
+
+Option<int64_t> Wheel::upcoming() const
+{
+  for (int level = 0; level < LEVELS; level++) {
+    Option<int64_t> slot =
+      search(level, (current >> (BITS * level)) & MASK);
+
+    if (slot.isSome()) {
+      const int shift = BITS * (level + 1);
+      return ((current >> shift) << shift) | (slot.get() << (BITS * level));
+    }
+  }
+
+  if (overflow.head != nullptr) {
+    const int shift = BITS * LEVELS;
+    return ((current >> shift) + 1) << shift;
+  }
+
+  return None();
+}
+
+
+Option<int64_t> Wheel::search(int level, int64_t index) const
+{
+  int64_t slot = index + 1;
+
+  while (slot < SLOTS) {
+    const uint64_t word = occupied[level][slot / 64] >> (slot % 64);
+
+    if (word == 0) {
+      // Skip to the next word.
+      slot = (slot / 64 + 1) * 64;
+      continue;
+    }
+
+    for (int64_t bit = 0; ; bit++) {
+      if (word & (uint64_t(1) << bit)) {
+        return slot + bit;
+      }
+    }
+  }
+
+  return None();
+}
+
+
+void Wheel::cascade()
+{
+  // NOTE: we cascade the highest levels first since their timers
+  // might end up in the slot of a lower level that we cascade next.
+  if ((current & ((int64_t(1) << (BITS * LEVELS)) - 1)) == 0) {
+    replace(&overflow);
+  }
+
+  for (int level = LEVELS - 1; level > 0; level--) {
+    const int shift = BITS * level;
+
+    if ((current & ((int64_t(1) << shift) - 1)) == 0) {
+      replace(&slots[level][(current >> shift) & MASK]);
+    }
+  }
+}
+
+
+void Wheel::fire(const Time& now, vector<pair<uint64_t, Timer>>* timedout)
+{
+  Node* node = slots[0][current & MASK].head;
+
+  while (node != nullptr) {
+    Node* next = node->next;
+
+    if (node->timer.timeout().time() <= now) {
+      unlink(node);
+      nodes.erase(node->id);
+      timedout->emplace_back(node->id, std::move(node->timer));
+      delete node;
+    }
+
+    node = next;
+  }
+}
+
+
+// The timers are sharded (by id) across multiple wheels, each with
+// its own lock, so that creating and canceling timers doesn't contend
+// on a single lock.
+//
+// NOTE: when both are needed 'timers_mutex' must be acquired before
+// the lock of a shard.
+struct Shard
+{
+  std::mutex mutex;
+  Wheel wheel;
+};
+
+constexpr size_t SHARDS = 16;
+
+Shard* shards = new Shard[SHARDS];
+
+} // namespace clock {
+
+
+// Protects the state of the clock (below) as well as the scheduling
+// of 'ticks'. The timers themselves are protected by their shard.
+static recursive_mutex* timers_mutex = new recursive_mutex();
+
+
+namespace clock {
+
 map<ProcessBase*, Time>* currents = new map<ProcessBase*, Time>();
 
 Time* initial = new Time(Time::epoch());
@@ -59,7 +507,7 @@ Time* current = new Time(Time::epoch());
 
 Duration* advanced = new Duration(Duration::zero());
 
-bool paused = false;
+std::atomic<bool> paused(false);
 
 // For supporting Clock::settled(), false if we're not currently
 // settling (or we're not paused), true if we're currently attempting
@@ -76,26 +524,52 @@ lambda::function<void(const list<Timer>&)>* callback =
 // scheduled 'ticks'.
 set<Time>* ticks = new set<Time>();
 
+// The earliest scheduled 'tick' (in nanoseconds), which lets
+// Clock::timer determine without acquiring 'timers_mutex' whether a
+// new timer requires a new 'tick'. Only updated while holding
+// 'timers_mutex' (see 'ticked').
+std::atomic<int64_t> earliest(Time::max().duration().ns());
+
+
+// Helper for updating 'earliest' after 'ticks' has been modified.
+void ticked(const set<Time>& ticks)
+{
+  earliest = ticks.empty()
+    ? Time::max().duration().ns()
+    : ticks.begin()->duration().ns();
+}
+
 
 // Helper for determining the time when the next timer elapses,
 // or None if no timers are pending, or the clock is paused and no
-// timers are expired. Note that we don't manipulate 'timers' directly
-// so that it's clear from the callsite that the use of 'timers' is
-// within a 'synchronized' block.
+// timers are expired. Note that this must be called within a
+// 'synchronized (timers_mutex)' block.
 //
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+// NOTE: the returned time might be earlier than the timeout of the
+// earliest timer (see 'Wheel::next'), in which case the 'tick' at
+// that time will not expire any timers but moves the earliest timers
+// closer to expiry.
+Option<Time> next()
 {
-  if (!timers.empty()) {
-    Time first = timers.begin()->first;
+  Option<Time> first = None();
+
+  for (size_t i = 0; i < SHARDS; i++) {
+    synchronized (shards[i].mutex) {
+      const Option<Time> time = shards[i].wheel.next();
+
+      if (time.isSome() && (first.isNone() || time.get() < first.get())) {
+        first = time;
+      }
+    }
+  }
 
+  if (first.isSome()) {
     // If the clock is paused and no timers are expired, the
     // timers cannot fire until the clock is advanced, so we
     // return None() here. Note that we pass nullptr to ensure
     // that this looks at the global clock, since this can be
     // called from a Process context through Clock::timer.
-    if (Clock::paused() && first > Clock::now(nullptr)) {
+    if (Clock::paused() && first.get() > Clock::now(nullptr)) {
       return None();
     }
 
@@ -111,21 +585,22 @@ void tick(const Time& time);
 
 
 // Helper for scheduling the next clock tick, if applicable. Note
-// that we don't manipulate 'timers' or 'ticks' directly so that
-// it's clear from the callsite that this needs to be called within
-// a 'synchronized' block.
+// that we don't manipulate 'ticks' directly so that it's clear from
+// the callsite that this needs to be called within a 'synchronized'
+// block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(nullptr).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
-  const Option<Time> next = clock::next(timers);
+  const Option<Time> next = clock::next();
 
   if (next.isSome()) {
     // Don't schedule a 'tick' if there is a 'tick' scheduled for
     // an earlier time, to avoid excessive pending timers.
     if (ticks->empty() || next.get() < (*ticks->begin())) {
       ticks->insert(next.get());
+      ticked(*ticks);
 
       // The delay can be negative if the timer is expired, this
       // is expected will result in a 'tick' firing immediately.
@@ -137,11 +612,12 @@ void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
 
 
 // NOTE: This method must remain robust to arbitrary invocations.
-// i.e. `tick` should not make any assumptions of what is held in `timers`,
-// which can be empty or have timers that trigger later than the current time.
+// i.e. `tick` should not make any assumptions of what is held in the
+// timer wheels, which can be empty or have timers that trigger later
+// than the current time.
 void tick(const Time& time)
 {
-  list<Timer> timedout;
+  vector<pair<uint64_t, Timer>> expired;
 
   synchronized (timers_mutex) {
     // We pass nullptr to be explicit about the fact that we want the
@@ -151,36 +627,50 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
-
-      VLOG(3) << "Have timeout(s) at " << timeout;
-
-      // Need to toggle 'settling' so that we don't prematurely say
-      // we're settled until after the timers are executed below,
-      // outside of the critical section.
-      if (clock::paused) {
-        clock::settling = true;
+    for (size_t i = 0; i < SHARDS; i++) {
+      synchronized (shards[i].mutex) {
+        shards[i].wheel.expire(now, &expired);
       }
-
-      timedout.splice(timedout.end(), (*timers)[timeout]);
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
-    // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
+    // Need to toggle 'settling' so that we don't prematurely say
+    // we're settled until after the timers are executed below,
+    // outside of the critical section.
+    if (clock::paused && !expired.empty()) {
+      clock::settling = true;
+    }
 
     // Remove this tick from the scheduled 'ticks', it may have
     // been removed already if the clock was paused / manipulated
     // in the interim.
     ticks->erase(time);
+    ticked(*ticks);
 
     // Schedule another "tick" if necessary.
-    scheduleTick(*timers, ticks);
+    scheduleTick(ticks);
+  }
+
+  // Execute the timers in order of their timeouts and, for the same
+  // timeout, in the order they were created (i.e., by their id).
+  std::sort(
+      expired.begin(),
+      expired.end(),
+      [](const pair<uint64_t, Timer>& left,
+         const pair<uint64_t, Timer>& right) {
+        const Time& l = left.second.timeout().time();
+        const Time& r = right.second.timeout().time();
+        return l < r || (l == r && left.first < right.first);
+      });
+
+  list<Timer> timedout;
+  foreach (auto& timer, expired) {
+    timedout.push_back(std::move(timer.second));
+  }
+
+  expired.clear();
+
+  if (!timedout.empty()) {
+    VLOG(3) << "Have " << timedout.size() << " timeout(s)";
   }
 
   (*clock::callback)(timedout);
@@ -191,9 +681,7 @@ void tick(const Time& time)
   // that will expire before the paused time and we've finished
   // executing expired timers.
   synchronized (timers_mutex) {
-    if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
+    if (clock::paused && clock::next().isNone()) {
       VLOG(3) << "Clock has settled";
       clock::settling = false;
     }
@@ -220,9 +708,13 @@ void Clock::finalize()
 
     // This, along with the `timers_mutex`, is all that is required to clean
     // up any pending timers.  Timers are triggered via "ticks".  However,
-    // we do not need to clear `ticks` because a "tick" with an empty `timers`
-    // map will effectively be a no-op.
-    timers->clear();
+    // we do not need to clear `ticks` because a "tick" with empty timer
+    // wheels will effectively be a no-op.
+    for (size_t i = 0; i < clock::SHARDS; i++) {
+      synchronized (clock::shards[i].mutex) {
+        clock::shards[i].wheel.clear();
+      }
+    }
   }
 }
 
@@ -235,16 +727,20 @@ Time Clock::now()
 
 Time Clock::now(ProcessBase* process)
 {
-  synchronized (timers_mutex) {
-    if (Clock::paused()) {
-      if (process != nullptr) {
-        if (clock::currents->count(process) != 0) {
-          return (*clock::currents)[process];
+  // We only need to synchronize if the clock is paused, which avoids
+  // contending on 'timers_mutex' when creating timers.
+  if (Clock::paused()) {
+    synchronized (timers_mutex) {
+      if (Clock::paused()) {
+        if (process != nullptr) {
+          if (clock::currents->count(process) != 0) {
+            return (*clock::currents)[process];
+          } else {
+            return (*clock::currents)[process] = *clock::initial;
+          }
         } else {
-          return (*clock::currents)[process] = *clock::initial;
+          return *clock::current;
         }
-      } else {
-        return *clock::current;
       }
     }
   }
@@ -279,19 +775,24 @@ Timer Clock::timer(
   VLOG(3) << "Created a timer for " << pid << " in " << stringify(duration)
           << " in the future (" << timeout.time() << ")";
 
+  // NOTE: we need the global time before acquiring the lock of the
+  // shard since this might acquire 'timers_mutex' (see 'Shard').
+  const Time now = Clock::now(nullptr);
+
   // Add the timer.
-  synchronized (timers_mutex) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
-      // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+  clock::Shard& shard = clock::shards[timer.id % clock::SHARDS];
 
-      // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
-    } else {
-      // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
+  synchronized (shard.mutex) {
+    shard.wheel.add(timer.id, timer, now);
+  }
+
+  // Schedule another "tick" if this timer is earlier than all the
+  // scheduled 'ticks'. Note that we add the timer before we check so
+  // that a concurrent 'tick' either expires the timer or schedules
+  // a 'tick' for it.
+  if (timer.timeout().time().duration().ns() < clock::earliest) {
+    synchronized (timers_mutex) {
+      clock::scheduleTick(clock::ticks);
     }
   }
 
@@ -302,18 +803,12 @@ Timer Clock::timer(
 bool Clock::cancel(const Timer& timer)
 {
   bool canceled = false;
-  synchronized (timers_mutex) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+
+  // Check if the timer is still pending, and if so, remove it.
+  clock::Shard& shard = clock::shards[timer.id % clock::SHARDS];
+
+  synchronized (shard.mutex) {
+    canceled = shard.wheel.remove(timer.id);
   }
 
   return canceled;
@@ -337,6 +832,7 @@ void Clock::pause()
       // that fire immediately will be scheduled while the clock
       // is paused.
       clock::ticks->clear();
+      clock::ticked(*clock::ticks);
     }
   }
 
@@ -365,7 +861,7 @@ void Clock::resume()
       clock::currents->clear();
 
       // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(clock::ticks);
     }
   }
 }
@@ -383,7 +879,7 @@ void Clock::advance(const Duration& duration)
       // Schedule another "tick" if necessary. Only "ticks" that
       // fire immediately will be scheduled here, since the clock
       // is paused.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(clock::ticks);
     }
   }
 }
@@ -420,7 +916,7 @@ void Clock::update(const Time& time)
         // Schedule another "tick" if necessary. Only "ticks" that
         // fire immediately will be scheduled here, since the clock
         // is paused.
-        clock::scheduleTick(*timers, clock::ticks);
+        clock::scheduleTick(clock::ticks);
       }
     }
   }
@@ -460,8 +956,7 @@ bool Clock::settled()
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    } else if (clock::next().isNone()) {
       VLOG(3) << "Clock is settled";
       return true;
     }
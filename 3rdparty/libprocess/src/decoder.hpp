@@ -21,16 +21,27 @@
 
 #include <glog/logging.h>
 
+#include <string.h>
+
+#include <algorithm>
 #include <deque>
+#include <iterator>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <process/address.hpp>
+#include <process/event.hpp>
 #include <process/http.hpp>
+#include <process/message.hpp>
+#include <process/pid.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/option.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 
@@ -753,11 +764,34 @@ private:
 // the request headers are received, but before the body data
 // is received. Callers are expected to read the body from the
 // Pipe::Reader in the request.
+//
+// If constructed with the address of this instance of libprocess,
+// the decoder also provides a fast path for inbound libprocess
+// messages: these get decoded straight into a `MessageEvent` once
+// the entire body has been received, without first building a
+// generic request (see `Decoded`). Buffers used while parsing (the
+// URL and the headers) are reused across requests.
 class StreamingRequestDecoder
 {
 public:
-  explicit StreamingRequestDecoder()
-    : failure(false), header(HEADER_FIELD), request(nullptr)
+  // A decoded request, i.e., either a generic 'PIPE' request or a
+  // libprocess message which was decoded via the fast path.
+  struct Decoded
+  {
+    http::Request* request;
+
+    MessageEvent* event;
+    bool keepAlive;
+  };
+
+  explicit StreamingRequestDecoder(
+      const Option<network::inet::Address>& _address = None())
+    : failure(false),
+      header(HEADER_FIELD),
+      headerCount(0),
+      address(_address),
+      request(nullptr),
+      keepAlive(false)
   {
     http_parser_settings_init(&settings);
 
@@ -793,12 +827,32 @@ public:
       writer->fail("Decoder is being deleted");
     }
 
-    foreach (http::Request* request, requests) {
-      delete request;
+    foreach (const Decoded& decoded, results) {
+      delete decoded.request;
+      delete decoded.event;
     }
   }
 
   std::deque<http::Request*> decode(const char* data, size_t length)
+  {
+    // The fast path must be disabled as the decoded messages could
+    // not be returned (see the overload below).
+    CHECK_NONE(address);
+
+    std::deque<Decoded> decoded;
+    decode(data, length, &decoded);
+
+    std::deque<http::Request*> result;
+    foreach (const Decoded& item, decoded) {
+      result.push_back(CHECK_NOTNULL(item.request));
+    }
+
+    return result;
+  }
+
+  // Decodes as much of the data as possible, appending the decoded
+  // requests and messages to `decoded` in the order they were sent.
+  void decode(const char* data, size_t length, std::deque<Decoded>* decoded)
   {
     size_t parsed = http_parser_execute(&parser, &settings, data, length);
     if (parsed != length) {
@@ -813,13 +867,15 @@ public:
       }
     }
 
-    if (!requests.empty()) {
-      std::deque<http::Request*> result = requests;
-      requests.clear();
-      return result;
+    if (!results.empty()) {
+      if (decoded->empty()) {
+        std::swap(*decoded, results);
+      } else {
+        std::move(
+            results.begin(), results.end(), std::back_inserter(*decoded));
+        results.clear();
+      }
     }
-
-    return std::deque<http::Request*>();
   }
 
   bool failed() const
@@ -835,16 +891,14 @@ private:
     CHECK(!decoder->failure);
 
     decoder->header = HEADER_FIELD;
-    decoder->field.clear();
-    decoder->value.clear();
+    decoder->headerCount = 0;
     decoder->query.clear();
     decoder->url.clear();
 
     CHECK(decoder->request == nullptr);
+    CHECK_NONE(decoder->message);
     CHECK_NONE(decoder->writer);
 
-    decoder->request = new http::Request();
-    decoder->request->type = http::Request::PIPE;
     decoder->writer = None();
     decoder->decompressor.reset();
 
@@ -865,8 +919,6 @@ private:
   {
     StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
 
-    CHECK_NOTNULL(decoder->request);
-
     // The current http_parser library (version 2.6.2 and below)
     // does not support incremental parsing of URLs. To compensate
     // we incrementally collect the data and parse it in
@@ -880,15 +932,21 @@ private:
   {
     StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
 
-    CHECK_NOTNULL(decoder->request);
+    // Start the next header, reusing the strings of the headers of
+    // previous requests if possible. Like the other decoders we
+    // always have at least one (possibly empty) header.
+    if (decoder->header != HEADER_FIELD || decoder->headerCount == 0) {
+      if (decoder->headerCount == decoder->headers.size()) {
+        decoder->headers.emplace_back();
+      } else {
+        decoder->headers[decoder->headerCount].first.clear();
+        decoder->headers[decoder->headerCount].second.clear();
+      }
 
-    if (decoder->header != HEADER_FIELD) {
-      decoder->request->headers[decoder->field] = decoder->value;
-      decoder->field.clear();
-      decoder->value.clear();
+      decoder->headerCount++;
     }
 
-    decoder->field.append(data, length);
+    decoder->headers[decoder->headerCount - 1].first.append(data, length);
     decoder->header = HEADER_FIELD;
 
     return 0;
@@ -898,28 +956,124 @@ private:
   {
     StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
 
-    CHECK_NOTNULL(decoder->request);
+    CHECK_GT(decoder->headerCount, 0u);
 
-    decoder->value.append(data, length);
+    decoder->headers[decoder->headerCount - 1].second.append(data, length);
     decoder->header = HEADER_VALUE;
     return 0;
   }
 
-  static int on_headers_complete(http_parser* p)
+  // Returns the value of the (first) header with the specified
+  // (case insensitive) name, if any.
+  const std::string* find(const std::string& name) const
   {
-    StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
+    http::CaseInsensitiveEqual equal;
 
-    CHECK_NOTNULL(decoder->request);
+    for (size_t i = 0; i < headerCount; i++) {
+      if (equal(headers[i].first, name)) {
+        return &headers[i].second;
+      }
+    }
 
-    // Add final header.
-    decoder->request->headers[decoder->field] = decoder->value;
-    decoder->field.clear();
-    decoder->value.clear();
+    return nullptr;
+  }
 
-    decoder->request->method =
-      http_method_str((http_method) decoder->parser.method);
+  // Attempts to decode a libprocess message (see `libprocess` and
+  // `parse` in process.cpp) from the headers and the URL path of
+  // the current request. Returns none if this is not a message
+  // or if it can not be decoded via the fast path, in which case
+  // the request must be decoded as a generic request. Note that
+  // this means that malformed messages still get the same error
+  // responses as before.
+  Option<Message> decodeMessage(const http_parser_url& _url)
+  {
+    if (address.isNone() ||
+        parser.method != HTTP_POST ||
+        (_url.field_set & (1 << UF_QUERY)) ||
+        !(_url.field_set & (1 << UF_PATH))) {
+      return None();
+    }
 
-    decoder->request->keepAlive = http_should_keep_alive(&decoder->parser) != 0;
+    const std::string* encoding = find("Content-Encoding");
+    if (encoding != nullptr && *encoding == "gzip") {
+      return None();
+    }
+
+    Option<UPID> from = None();
+
+    const std::string* libprocessFrom = find("Libprocess-From");
+    if (libprocessFrom != nullptr) {
+      from = UPID(strings::trim(*libprocessFrom));
+    } else {
+      const std::string identifier = "libprocess/";
+      const std::string* agent = find("User-Agent");
+      if (agent != nullptr &&
+          agent->compare(0, identifier.size(), identifier) == 0) {
+        from = UPID(agent->substr(identifier.size()));
+      }
+    }
+
+    if (from.isNone()) {
+      return None();
+    }
+
+    const char* path = url.data() + _url.field_data[UF_PATH].off;
+    const size_t length = _url.field_data[UF_PATH].len;
+
+    if (length == 0 || path[0] != '/') {
+      return None();
+    }
+
+    // The path is '/id/name' where 'id' might be percent-encoded.
+    const char* slash = (const char*) memchr(path + 1, '/', length - 1);
+
+    const size_t size = slash != nullptr
+      ? slash - (path + 1)
+      : length - 1;
+
+    Try<std::string> to = http::decode(std::string(path + 1, size));
+    if (to.isError()) {
+      return None();
+    }
+
+    // Reuse the receiver of a previous message on this connection if
+    // it still refers to a running process, so that neither decoding
+    // nor delivering this message needs to look up the process (see
+    // `UPID::resolve` and `ProcessManager::use`).
+    Option<UPID> receiver = receivers.get(to.get());
+
+    if (receiver.isNone() || !receiver->resolved()) {
+      if (receivers.size() >= MAX_RECEIVERS) {
+        receivers.clear();
+      }
+
+      receiver = UPID(to.get(), address.get());
+      receiver->resolve();
+
+      receivers[to.get()] = receiver.get();
+    }
+
+    Message decoded;
+    decoded.from = std::move(from.get());
+    decoded.to = std::move(receiver.get());
+
+    if (slash != nullptr) {
+      decoded.name.assign(slash + 1, path + length);
+    }
+
+    // Avoid growing the body incrementally when the length is known
+    // (i.e., the body is not chunked), but don't trust the peer with
+    // reserving arbitrarily large bodies up front.
+    if (parser.content_length <= MAX_BODY_RESERVE) {
+      decoded.body.reserve(static_cast<size_t>(parser.content_length));
+    }
+
+    return decoded;
+  }
+
+  static int on_headers_complete(http_parser* p)
+  {
+    StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
 
     // Parse the URL. This data was incrementally built up during calls
     // to `on_url`.
@@ -933,6 +1087,36 @@ private:
       return parse_url;
     }
 
+    // Try the fast path for libprocess messages first.
+    CHECK_NONE(decoder->message);
+    decoder->message = decoder->decodeMessage(url);
+
+    if (decoder->message.isSome()) {
+      decoder->keepAlive = http_should_keep_alive(&decoder->parser) != 0;
+      return 0;
+    }
+
+    CHECK(decoder->request == nullptr);
+
+    decoder->request = new http::Request();
+    decoder->request->type = http::Request::PIPE;
+
+    if (decoder->headerCount == 0) {
+      // Add the (empty) final header for consistency with the other
+      // decoders.
+      decoder->request->headers[""] = "";
+    }
+
+    for (size_t i = 0; i < decoder->headerCount; i++) {
+      decoder->request->headers[decoder->headers[i].first] =
+        decoder->headers[i].second;
+    }
+
+    decoder->request->method =
+      http_method_str((http_method) decoder->parser.method);
+
+    decoder->request->keepAlive = http_should_keep_alive(&decoder->parser) != 0;
+
     if (url.field_set & (1 << UF_PATH)) {
       decoder->request->url.path = std::string(
           decoder->url.data() + url.field_data[UF_PATH].off,
@@ -978,7 +1162,7 @@ private:
 
     // Send the request to the caller, but keep a Pipe::Writer for
     // streaming the body content into the request.
-    decoder->requests.push_back(decoder->request);
+    decoder->results.push_back(Decoded{decoder->request, nullptr, false});
     decoder->request = nullptr;
 
     return 0;
@@ -988,6 +1172,11 @@ private:
   {
     StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
 
+    if (decoder->message.isSome()) {
+      decoder->message->body.append(data, length);
+      return 0;
+    }
+
     CHECK_SOME(decoder->writer);
 
     http::Pipe::Writer writer = decoder->writer.get(); // Remove const.
@@ -1016,6 +1205,17 @@ private:
   {
     StreamingRequestDecoder* decoder = (StreamingRequestDecoder*) p->data;
 
+    if (decoder->message.isSome()) {
+      decoder->results.push_back(Decoded{
+          nullptr,
+          new MessageEvent(std::move(decoder->message.get())),
+          decoder->keepAlive});
+
+      decoder->message = None();
+
+      return 0;
+    }
+
     // This can happen if the callback `on_headers_complete()` had failed
     // earlier (e.g., due to invalid query parameters).
     if (decoder->writer.isNone()) {
@@ -1039,6 +1239,13 @@ private:
     return 0;
   }
 
+  // The maximum body size to reserve up front for a message, based
+  // on the 'Content-Length' header sent by the peer.
+  static const uint64_t MAX_BODY_RESERVE = 1024 * 1024;
+
+  // The maximum number of receivers cached per connection.
+  static const size_t MAX_RECEIVERS = 1024;
+
   bool failure;
 
   http_parser parser;
@@ -1050,16 +1257,28 @@ private:
     HEADER_VALUE
   } header;
 
-  std::string field;
-  std::string value;
+  // The headers of the current request; only the first `headerCount`
+  // entries are valid, the rest are kept to reuse their strings.
+  std::vector<std::pair<std::string, std::string>> headers;
+  size_t headerCount;
+
   std::string query;
   std::string url;
 
+  const Option<network::inet::Address> address;
+
   http::Request* request;
   Option<http::Pipe::Writer> writer;
   Owned<gzip::Decompressor> decompressor;
 
-  std::deque<http::Request*> requests;
+  // The message being decoded via the fast path, if any.
+  Option<Message> message;
+  bool keepAlive;
+
+  // The (resolved) receivers of the messages decoded so far, by ID.
+  hashmap<std::string, UPID> receivers;
+
+  std::deque<Decoded> results;
 };
 
 }  // namespace process {
@@ -19,6 +19,9 @@
 #include <limits>
 #include <map>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -59,11 +62,25 @@ public:
 };
 
 
+// Encodes data held in one or more buffers. The buffers get sent one
+// after another (see `next`) so that a large body never needs to be
+// copied into the same buffer as the (small) headers preceding it.
 class DataEncoder : public Encoder
 {
 public:
-  DataEncoder(const std::string& _data)
-    : data(_data), index(0) {}
+  DataEncoder(std::string data)
+    : index(0), size(data.size())
+  {
+    buffers.push_back(std::move(data));
+  }
+
+  DataEncoder(std::vector<std::string>&& _buffers)
+    : buffers(std::move(_buffers)), index(0), size(0)
+  {
+    foreach (const std::string& buffer, buffers) {
+      size += buffer.size();
+    }
+  }
 
   virtual ~DataEncoder() {}
 
@@ -72,12 +89,44 @@ public:
     return Encoder::DATA;
   }
 
+  // Returns the remaining data of the current buffer.
   virtual const char* next(size_t* length)
   {
-    size_t temp = index;
-    index = data.size();
-    *length = data.size() - temp;
-    return data.data() + temp;
+    size_t offset = index;
+
+    foreach (const std::string& buffer, buffers) {
+      if (offset < buffer.size()) {
+        *length = buffer.size() - offset;
+        index += *length;
+        return buffer.data() + offset;
+      }
+
+      offset -= buffer.size();
+    }
+
+    *length = 0;
+    return nullptr;
+  }
+
+  // Appends the remaining data of all of the buffers to `data` and
+  // returns the total length of the appended data, e.g., for sending
+  // all of the data at once with a vectored send.
+  virtual size_t next(std::vector<std::pair<const char*, size_t>>* data)
+  {
+    size_t offset = index;
+
+    foreach (const std::string& buffer, buffers) {
+      if (offset < buffer.size()) {
+        data->emplace_back(buffer.data() + offset, buffer.size() - offset);
+        offset = 0;
+      } else {
+        offset -= buffer.size();
+      }
+    }
+
+    const size_t length = size - index;
+    index = size;
+    return length;
   }
 
   virtual void backup(size_t length)
@@ -89,22 +138,37 @@ public:
 
   virtual size_t remaining() const
   {
-    return data.size() - index;
+    return size - index;
   }
 
 private:
-  const std::string data;
+  std::vector<std::string> buffers;
   size_t index;
+  size_t size;
 };
 
 
+// Encodes a message into the headers (and chunk size) followed by the
+// body and the end of the chunked encoding, so that sending a message
+// does not copy the body.
 class MessageEncoder : public DataEncoder
 {
 public:
-  MessageEncoder(const Message& message)
-    : DataEncoder(encode(message)) {}
+  MessageEncoder(Message message)
+    : DataEncoder(buffers(std::move(message))) {}
 
   static std::string encode(const Message& message)
+  {
+    std::string data;
+
+    foreach (const std::string& buffer, buffers(Message(message))) {
+      data += buffer;
+    }
+
+    return data;
+  }
+
+  static std::vector<std::string> buffers(Message&& message)
   {
     std::ostringstream out;
 
@@ -124,33 +188,52 @@ public:
         << "Connection: Keep-Alive\r\n"
         << "Host: \r\n";
 
+    std::vector<std::string> buffers;
+
     if (message.body.size() > 0) {
       out << "Transfer-Encoding: chunked\r\n\r\n"
           << std::hex << message.body.size() << "\r\n";
-      out.write(message.body.data(), message.body.size());
-      out << "\r\n"
-          << "0\r\n"
-          << "\r\n";
+
+      buffers.push_back(out.str());
+      buffers.push_back(std::move(message.body));
+      buffers.push_back("\r\n0\r\n\r\n");
     } else {
       out << "\r\n";
+
+      buffers.push_back(out.str());
     }
 
-    return out.str();
+    return buffers;
   }
 };
 
 
+// Encodes a response into the status line and headers followed by the
+// body, so that the body only gets copied (or compressed) once.
 class HttpResponseEncoder : public DataEncoder
 {
 public:
   HttpResponseEncoder(
       const http::Response& response,
       const http::Request& request)
-    : DataEncoder(encode(response, request)) {}
+    : DataEncoder(buffers(response, request)) {}
 
   static std::string encode(
       const http::Response& response,
       const http::Request& request)
+  {
+    std::string data;
+
+    foreach (const std::string& buffer, buffers(response, request)) {
+      data += buffer;
+    }
+
+    return data;
+  }
+
+  static std::vector<std::string> buffers(
+      const http::Response& response,
+      const http::Request& request)
   {
     std::ostringstream out;
 
@@ -178,24 +261,28 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
+    // Should we compress this response? Note that we only copy the
+    // body of the response if we don't compress it.
+    Option<std::string> compressed;
 
     if (response.type == http::Response::BODY &&
         response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
         !headers.contains("Content-Encoding") &&
         request.acceptsEncoding("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
-      if (compressed.isError()) {
-        LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
+      Try<std::string> compress = gzip::compress(response.body);
+      if (compress.isError()) {
+        LOG(WARNING) << "Failed to gzip response body: " << compress.error();
       } else {
-        body = std::move(compressed.get());
+        compressed = std::move(compress.get());
 
-        headers["Content-Length"] = stringify(body.length());
+        headers["Content-Length"] = stringify(compressed->length());
         headers["Content-Encoding"] = "gzip";
       }
     }
 
+    const std::string& body =
+      compressed.isSome() ? compressed.get() : response.body;
+
     foreachpair (const std::string& key, const std::string& value, headers) {
       out << key << ": " << value << "\r\n";
     }
@@ -213,19 +300,22 @@ public:
     // Use a CRLF to mark end of headers.
     out << "\r\n";
 
+    std::vector<std::string> buffers;
+    buffers.push_back(out.str());
+
     // Add the body if necessary.
     if (response.type == http::Response::BODY) {
       // If the Content-Length header was supplied, only write as much data
       // as the length specifies.
       Result<uint32_t> length = numify<uint32_t>(headers.get("Content-Length"));
       if (length.isSome() && length.get() <= body.length()) {
-        out.write(body.data(), length.get());
+        buffers.push_back(body.substr(0, length.get()));
       } else {
-        out.write(body.data(), body.size());
+        buffers.push_back(body);
       }
     }
 
-    return out.str();
+    return buffers;
   }
 };
 
@@ -13,6 +13,8 @@
 #ifndef __EVENT_LOOP_HPP__
 #define __EVENT_LOOP_HPP__
 
+#include <stddef.h>
+
 #include <stout/duration.hpp>
 #include <stout/lambda.hpp>
 
@@ -24,8 +26,9 @@ namespace process {
 class EventLoop
 {
 public:
-  // Initializes the event loop.
-  static void initialize();
+  // Initializes the specified number of event loops. I/O is sharded
+  // across the loops, each of which gets run by its own thread.
+  static void initialize(size_t loops);
 
   // Invoke the specified function in the event loop after the
   // specified duration.
@@ -37,10 +40,10 @@ public:
   // Returns the current time w.r.t. the event loop.
   static double time();
 
-  // Runs the event loop.
+  // Runs the event loops, returns once all of them have stopped.
   static void run();
 
-  // Asynchronously tells the event loop to stop and then returns.
+  // Asynchronously tells the event loops to stop and then returns.
   static void stop();
 };
 
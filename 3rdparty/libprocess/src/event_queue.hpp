@@ -123,23 +123,31 @@ private:
 
   Event* dequeue()
   {
-    Event* event = nullptr;
-
-    synchronized (mutex) {
-      if (events.size() > 0) {
-        Event* event = events.front();
-        events.pop_front();
-        return event;
+    // Drain all of the enqueued events at once into the consumer
+    // side `buffer` so that we only acquire the mutex once per batch
+    // of events rather than once per event. Swapping also lets the
+    // producers reuse the memory already allocated by `buffer`.
+    if (buffer.empty()) {
+      synchronized (mutex) {
+        std::swap(buffer, events);
       }
     }
 
     // Semantics are the consumer _must_ call `empty()` before calling
     // `dequeue()` which means an event must be present.
-    return CHECK_NOTNULL(event);
+    CHECK(!buffer.empty());
+
+    Event* event = buffer.front();
+    buffer.pop_front();
+    return event;
   }
 
   bool empty()
   {
+    if (!buffer.empty()) {
+      return false;
+    }
+
     synchronized (mutex) {
       return events.size() == 0;
     }
@@ -155,24 +163,34 @@ private:
         delete event;
       }
     }
+
+    while (!buffer.empty()) {
+      Event* event = buffer.front();
+      buffer.pop_front();
+      delete event;
+    }
   }
 
   template <typename T>
   size_t count()
   {
+    auto is = [](const Event* event) {
+      return event->is<T>();
+    };
+
+    size_t count = std::count_if(buffer.begin(), buffer.end(), is);
+
     synchronized (mutex) {
-      return std::count_if(
-          events.begin(),
-          events.end(),
-          [](const Event* event) {
-            return event->is<T>();
-          });
+      return count + std::count_if(events.begin(), events.end(), is);
     }
   }
 
   operator JSON::Array()
   {
     JSON::Array array;
+    foreach (Event* event, buffer) {
+      array.values.push_back(JSON::Object(*event));
+    }
     synchronized (mutex) {
       foreach (Event* event, events) {
         array.values.push_back(JSON::Object(*event));
@@ -184,6 +202,10 @@ private:
   std::mutex mutex;
   std::deque<Event*> events;
   bool comissioned = true;
+
+  // Events already dequeued from `events` but not yet consumed. Only
+  // ever accessed by the (single) consumer.
+  std::deque<Event*> buffer;
 #else // LOCK_FREE_EVENT_QUEUE
   void enqueue(Event* event)
   {
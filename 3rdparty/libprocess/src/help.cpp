@@ -104,7 +104,7 @@ void Help::add(
     const Option<string>& help)
 {
   // TODO(benh): Enable help for help.
-  if (id != "help" && id != "__processes__") {
+  if (id != "help" && id != "__processes__" && id != "__latencies__") {
     // Remove tail slash in usage information.
     const string path = "/" + getUsagePath(id, name);
 
@@ -29,6 +29,7 @@
 #include <string>
 #include <sstream>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <process/collect.hpp>
@@ -64,6 +65,7 @@ using std::istringstream;
 using std::map;
 using std::ostream;
 using std::ostringstream;
+using std::pair;
 using std::queue;
 using std::string;
 using std::tuple;
@@ -420,13 +422,20 @@ Pipe::Writer Pipe::writer() const
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
       future = Failure("closed");
     } else if (!data->writes.empty()) {
+      data->buffered -= data->writes.front().size();
       future = data->writes.front();
       data->writes.pop();
+
+      // Extract the writers waiting for the pipe to drain, if it has.
+      if (data->writes.empty()) {
+        std::swap(data->drains, drains);
+      }
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -438,6 +447,13 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  while (!drains.empty()) {
+    drains.front()->set(Nothing());
+    drains.pop();
+  }
+
   return future;
 }
 
@@ -468,6 +484,7 @@ bool Pipe::Reader::close()
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> drains;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -476,9 +493,15 @@ bool Pipe::Reader::close()
         data->writes.pop();
       }
 
+      data->buffered = 0;
+
       // Extract the pending reads so we can fail them.
       std::swap(data->reads, reads);
 
+      // Extract the writers waiting for the pipe to drain, as nothing
+      // is left to be read.
+      std::swap(data->drains, drains);
+
       closed = true;
       data->readEnd = Reader::CLOSED;
 
@@ -495,6 +518,11 @@ bool Pipe::Reader::close()
       reads.pop();
     }
 
+    while (!drains.empty()) {
+      drains.front()->set(Nothing());
+      drains.pop();
+    }
+
     if (notify) {
       data->readerClosure.set(Nothing());
     } else {
@@ -520,6 +548,7 @@ bool Pipe::Writer::write(string s)
       // Don't bother surfacing empty writes to the readers.
       if (!s.empty()) {
         if (data->reads.empty()) {
+          data->buffered += s.size();
           data->writes.push(std::move(s));
         } else {
           read = data->reads.front();
@@ -599,6 +628,27 @@ Future<Nothing> Pipe::Writer::readerClosed() const
 }
 
 
+size_t Pipe::Writer::buffered() const
+{
+  synchronized (data->lock) {
+    return data->buffered;
+  }
+}
+
+
+Future<Nothing> Pipe::Writer::drained() const
+{
+  synchronized (data->lock) {
+    if (data->buffered == 0 || data->readEnd == Reader::CLOSED) {
+      return Nothing();
+    }
+
+    data->drains.push(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+    return data->drains.back()->future();
+  }
+}
+
+
 namespace header {
 
 Try<WWWAuthenticate> WWWAuthenticate::create(const string& value)
@@ -1478,8 +1528,9 @@ Future<Nothing> send(network::Socket socket, Encoder* encoder)
       [=]() {
         switch (encoder->kind()) {
           case Encoder::DATA: {
-            const char* data = static_cast<DataEncoder*>(encoder)->next(size);
-            return socket.send(data, *size);
+            vector<pair<const char*, size_t>> buffers;
+            *size = static_cast<DataEncoder*>(encoder)->next(&buffers);
+            return socket.send(buffers);
           }
           case Encoder::FILE: {
             off_t offset = 0;
@@ -1609,19 +1660,22 @@ Future<Nothing> stream(
       [=](const string& data) mutable {
         bool finished = false;
 
-        ostringstream out;
+        vector<string> buffers;
 
         if (data.empty()) {
           // Finished reading.
-          out << "0\r\n" << "\r\n";
+          buffers.push_back("0\r\n\r\n");
           finished = true;
         } else {
+          ostringstream out;
           out << std::hex << data.size() << "\r\n";
-          out << data;
-          out << "\r\n";
+
+          buffers.push_back(out.str());
+          buffers.push_back(data);
+          buffers.push_back("\r\n");
         }
 
-        Encoder* encoder = new DataEncoder(out.str());
+        Encoder* encoder = new DataEncoder(std::move(buffers));
 
         return send(socket, encoder)
           .onAny([=]() {
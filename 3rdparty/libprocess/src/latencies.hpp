@@ -0,0 +1,446 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_LATENCIES_HPP__
+#define __PROCESS_LATENCIES_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include <process/event.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
+
+namespace process {
+
+// A histogram of latencies that can be recorded into concurrently
+// without any locking. Latencies are counted in buckets bounded by
+// powers of two microseconds, i.e., bucket `i` counts the latencies
+// of at least 2^(i-1) but less than 2^i microseconds, except for the
+// last bucket which counts all of the latencies that are too large
+// for the other buckets.
+class LatencyHistogram
+{
+public:
+  static constexpr size_t BUCKETS = 24;
+
+  // A copy of a histogram at some point in time, which can be merged
+  // with copies of other histograms.
+  struct Snapshot
+  {
+    Snapshot& operator+=(const Snapshot& that)
+    {
+      for (size_t i = 0; i < BUCKETS; i++) {
+        buckets[i] += that.buckets[i];
+      }
+
+      count += that.count;
+      total += that.total;
+      max = std::max(max, that.max);
+
+      return *this;
+    }
+
+    // Returns an upper bound (in microseconds) of the specified
+    // percentile (in the range [0, 100]) of the latencies.
+    uint64_t percentile(double p) const
+    {
+      const uint64_t rank = std::max<uint64_t>(
+          1, static_cast<uint64_t>(std::ceil(count * p / 100.0)));
+
+      uint64_t seen = 0;
+      for (size_t i = 0; i < BUCKETS - 1; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+          return std::min<uint64_t>(max, (uint64_t) 1 << i);
+        }
+      }
+
+      return max;
+    }
+
+    // JSON representation of the histogram, where the buckets are
+    // keyed by their (exclusive) upper bound in microseconds and
+    // empty buckets are omitted.
+    operator JSON::Object() const
+    {
+      JSON::Object object;
+      object.values["count"] = count;
+      object.values["total_us"] = total;
+      object.values["max_us"] = max;
+
+      if (count > 0) {
+        object.values["p50_us"] = percentile(50);
+        object.values["p90_us"] = percentile(90);
+        object.values["p99_us"] = percentile(99);
+      }
+
+      JSON::Object bounds;
+      for (size_t i = 0; i < BUCKETS; i++) {
+        if (buckets[i] > 0) {
+          const std::string bound = i < BUCKETS - 1
+            ? stringify((uint64_t) 1 << i)
+            : "inf";
+
+          bounds.values[bound] = buckets[i];
+        }
+      }
+
+      object.values["buckets"] = bounds;
+
+      return object;
+    }
+
+    std::array<uint64_t, BUCKETS> buckets = {};
+    uint64_t count = 0;
+    uint64_t total = 0; // In microseconds.
+    uint64_t max = 0; // In microseconds.
+  };
+
+  void record(const std::chrono::steady_clock::duration& latency)
+  {
+    const int64_t microseconds =
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+
+    const uint64_t value = microseconds > 0 ? microseconds : 0;
+
+    size_t bucket = 0;
+    while (bucket < BUCKETS - 1 && (value >> bucket) != 0) {
+      bucket++;
+    }
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t previous = max.load(std::memory_order_relaxed);
+    while (value > previous &&
+           !max.compare_exchange_weak(
+               previous, value, std::memory_order_relaxed)) {}
+  }
+
+  // NOTE: the snapshot of a histogram that is being recorded into is
+  // not necessarily consistent, e.g., the total might already include
+  // a latency which isn't counted in any bucket yet.
+  Snapshot snapshot() const
+  {
+    Snapshot snapshot;
+
+    for (size_t i = 0; i < BUCKETS; i++) {
+      snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+      snapshot.count += snapshot.buckets[i];
+    }
+
+    snapshot.total = total.load(std::memory_order_relaxed);
+    snapshot.max = max.load(std::memory_order_relaxed);
+
+    return snapshot;
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> buckets = {};
+  std::atomic<uint64_t> total = ATOMIC_VAR_INIT(0);
+  std::atomic<uint64_t> max = ATOMIC_VAR_INIT(0);
+};
+
+
+// The latencies of a process, i.e., how long its events wait on its
+// event queue (from `ProcessBase::enqueue` until they get dequeued in
+// `ProcessManager::resume`), how long the process waits on the run
+// queue before it gets resumed, and how long its handlers take for
+// each type of event, message name, and dispatched method. Also keeps
+// track of the depth of the event queue.
+//
+// Producers of events may call `enqueued` concurrently while the
+// consumer of the events (i.e., the worker thread running the
+// process) calls `resumed`, `dequeued` and `served`. Any thread can
+// take a snapshot of the latencies (as JSON) at the same time.
+class Latencies
+{
+public:
+  // The types of events, used as indexes into `handlers`.
+  enum Type
+  {
+    MESSAGE,
+    DISPATCH,
+    HTTP,
+    EXITED,
+    TERMINATE,
+    TYPES
+  };
+
+  // The latencies of all of the processes (including the processes
+  // which have terminated), recorded along with the latencies of each
+  // process so that they can be reported without going through all
+  // of the processes. The depth only counts the events of the
+  // processes which are still running.
+  struct Totals
+  {
+    std::atomic<int64_t> depth = ATOMIC_VAR_INIT(0);
+    LatencyHistogram queueing;
+    LatencyHistogram runQueue;
+    LatencyHistogram handlers;
+  };
+
+  static Totals& totals()
+  {
+    // NOTE: never deleted as processes might still be recording.
+    static Totals* totals = new Totals();
+    return *totals;
+  }
+
+  ~Latencies()
+  {
+    totals().depth.fetch_sub(
+        depth.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+
+  // The maximum number of message names and of dispatched methods
+  // for which the handler latencies are tracked separately, so that
+  // peers sending arbitrary message names can't exhaust memory.
+  static constexpr size_t MAX_NAMES = 1024;
+
+  // Records that the specified event is about to be enqueued.
+  void enqueued(Event* event)
+  {
+    event->enqueued = std::chrono::steady_clock::now();
+
+    const int64_t depth = 1 + this->depth.fetch_add(
+        1, std::memory_order_relaxed);
+
+    totals().depth.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t previous = maxDepth.load(std::memory_order_relaxed);
+    while (depth > previous &&
+           !maxDepth.compare_exchange_weak(
+               previous, depth, std::memory_order_relaxed)) {}
+  }
+
+  // Records that the process is about to be enqueued on the run queue.
+  void scheduled()
+  {
+    scheduledAt.store(
+        std::chrono::steady_clock::now().time_since_epoch().count(),
+        std::memory_order_relaxed);
+  }
+
+  // Records that the process has been resumed (after being dequeued
+  // from the run queue).
+  void resumed()
+  {
+    const std::chrono::steady_clock::time_point scheduled(
+        std::chrono::steady_clock::duration(
+            scheduledAt.load(std::memory_order_relaxed)));
+
+    const std::chrono::steady_clock::duration latency =
+      std::chrono::steady_clock::now() - scheduled;
+
+    runQueue.record(latency);
+    totals().runQueue.record(latency);
+  }
+
+  // Records that the specified event has been dequeued and returns
+  // the time at which it was dequeued.
+  std::chrono::steady_clock::time_point dequeued(const Event& event)
+  {
+    const std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+
+    depth.fetch_sub(1, std::memory_order_relaxed);
+    queueing.record(now - event.enqueued);
+
+    totals().depth.fetch_sub(1, std::memory_order_relaxed);
+    totals().queueing.record(now - event.enqueued);
+
+    return now;
+  }
+
+  // Records that the specified event, dequeued at the specified time,
+  // has been served.
+  void served(
+      const Event& event,
+      const std::chrono::steady_clock::time_point& dequeued)
+  {
+    const std::chrono::steady_clock::duration latency =
+      std::chrono::steady_clock::now() - dequeued;
+
+    struct Visitor : EventVisitor
+    {
+      virtual void visit(const MessageEvent& event)
+      {
+        type = MESSAGE;
+        name = &event.message.name;
+      }
+
+      virtual void visit(const DispatchEvent& event)
+      {
+        type = DISPATCH;
+        method = event.method;
+      }
+
+      virtual void visit(const HttpEvent&) { type = HTTP; }
+      virtual void visit(const ExitedEvent&) { type = EXITED; }
+      virtual void visit(const TerminateEvent&) { type = TERMINATE; }
+
+      Type type = TYPES;
+      const std::string* name = nullptr;
+      const std::string* method = nullptr;
+    } visitor;
+
+    event.visit(&visitor);
+
+    if (visitor.type == TYPES) {
+      return;
+    }
+
+    handlers[visitor.type].record(latency);
+    totals().handlers.record(latency);
+
+    // NOTE: a reference to an element of a `hashmap` remains valid
+    // even if the `hashmap` gets rehashed so we only need to hold the
+    // lock for the lookup.
+    LatencyHistogram* histogram = nullptr;
+
+    synchronized (lock) {
+      if (visitor.name != nullptr) {
+        auto iterator = messages.find(*visitor.name);
+        if (iterator != messages.end()) {
+          histogram = &iterator->second;
+        } else if (messages.size() < MAX_NAMES) {
+          histogram = &messages[*visitor.name];
+        }
+      } else if (visitor.method != nullptr) {
+        auto iterator = dispatches.find(visitor.method);
+        if (iterator != dispatches.end()) {
+          histogram = &iterator->second;
+        } else if (dispatches.size() < MAX_NAMES) {
+          histogram = &dispatches[visitor.method];
+        }
+      }
+    }
+
+    if (histogram != nullptr) {
+      histogram->record(latency);
+    }
+  }
+
+  // Returns the number of events on the event queue.
+  int64_t queued() const
+  {
+    return std::max<int64_t>(0, depth.load(std::memory_order_relaxed));
+  }
+
+  LatencyHistogram::Snapshot queueingSnapshot() const
+  {
+    return queueing.snapshot();
+  }
+
+  LatencyHistogram::Snapshot runQueueSnapshot() const
+  {
+    return runQueue.snapshot();
+  }
+
+  // Returns the handler latencies for all types of events.
+  LatencyHistogram::Snapshot handlersSnapshot() const
+  {
+    LatencyHistogram::Snapshot snapshot;
+    foreach (const LatencyHistogram& histogram, handlers) {
+      snapshot += histogram.snapshot();
+    }
+    return snapshot;
+  }
+
+  // JSON representation of the latencies.
+  operator JSON::Object()
+  {
+    static const char* names[] = {
+      "MESSAGE",
+      "DISPATCH",
+      "HTTP",
+      "EXITED",
+      "TERMINATE"
+    };
+
+    JSON::Object object;
+    object.values["event_queue_depth"] = queued();
+    object.values["max_event_queue_depth"] =
+      maxDepth.load(std::memory_order_relaxed);
+    object.values["event_queueing_delay"] = JSON::Object(queueingSnapshot());
+    object.values["run_queue_delay"] = JSON::Object(runQueueSnapshot());
+
+    JSON::Object types;
+    for (size_t type = 0; type < TYPES; type++) {
+      const LatencyHistogram::Snapshot snapshot = handlers[type].snapshot();
+      if (snapshot.count > 0) {
+        types.values[names[type]] = JSON::Object(snapshot);
+      }
+    }
+
+    object.values["event_handlers"] = types;
+
+    JSON::Object messages;
+    JSON::Object dispatches;
+
+    synchronized (lock) {
+      foreachpair (const std::string& name,
+                   const LatencyHistogram& histogram,
+                   this->messages) {
+        messages.values[name] = JSON::Object(histogram.snapshot());
+      }
+
+      // NOTE: the methods are keyed by their interned names (see
+      // `DispatchEvent::method`).
+      foreachpair (const std::string* method,
+                   const LatencyHistogram& histogram,
+                   this->dispatches) {
+        dispatches.values[*method] = JSON::Object(histogram.snapshot());
+      }
+    }
+
+    object.values["messages"] = messages;
+    object.values["dispatches"] = dispatches;
+
+    return object;
+  }
+
+private:
+  std::atomic<int64_t> depth = ATOMIC_VAR_INIT(0);
+  std::atomic<int64_t> maxDepth = ATOMIC_VAR_INIT(0);
+
+  // Time (since the epoch of the steady clock) at which the process
+  // was last enqueued on the run queue.
+  std::atomic<int64_t> scheduledAt = ATOMIC_VAR_INIT(0);
+
+  LatencyHistogram queueing;
+  LatencyHistogram runQueue;
+  std::array<LatencyHistogram, TYPES> handlers;
+
+  // Protects `messages` and `dispatches`, but not the histograms
+  // within them.
+  std::atomic_flag lock = ATOMIC_FLAG_INIT;
+  hashmap<std::string, LatencyHistogram> messages;
+  hashmap<const std::string*, LatencyHistogram> dispatches;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_LATENCIES_HPP__
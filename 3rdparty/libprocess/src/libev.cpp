@@ -12,10 +12,15 @@
 
 #include <ev.h>
 
+#include <glog/logging.h>
+
 #include <mutex>
 #include <queue>
+#include <thread>
+#include <vector>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 
@@ -24,47 +29,31 @@
 
 namespace process {
 
-ev_async async_watcher;
-// We need an asynchronous watcher to receive the request to shutdown.
-ev_async shutdown_watcher;
-
 // Define the initial values for all of the declarations made in
 // libev.hpp (since these need to live in the static data space).
-struct ev_loop* loop = nullptr;
-
-std::queue<ev_io*>* watchers = new std::queue<ev_io*>();
-
-std::mutex* watchers_mutex = new std::mutex();
+std::vector<Loop*>* loops = new std::vector<Loop*>();
 
-std::queue<lambda::function<void()>>* functions =
-  new std::queue<lambda::function<void()>>();
+thread_local Loop* _event_loop_ = nullptr;
 
-thread_local bool* _in_event_loop_ = nullptr;
 
-
-void handle_async(struct ev_loop* loop, ev_async* _, int revents)
+void handle_async(struct ev_loop* _, ev_async* watcher, int revents)
 {
-  std::queue<lambda::function<void()>> run_functions;
-  synchronized (watchers_mutex) {
-    // Start all the new I/O watchers.
-    while (!watchers->empty()) {
-      ev_io* watcher = watchers->front();
-      watchers->pop();
-      ev_io_start(loop, watcher);
-    }
+  Loop* loop = reinterpret_cast<Loop*>(watcher->data);
 
+  std::queue<lambda::function<void()>> run_functions;
+  synchronized (loop->mutex) {
     // Swap the functions into a temporary queue so that we can invoke
     // them outside of the mutex.
-    std::swap(run_functions, *functions);
+    std::swap(run_functions, loop->functions);
   }
 
   // Running the functions outside of the mutex reduces locking
   // contention as these are arbitrary functions that can take a long
   // time to execute. Doing this also avoids a deadlock scenario where
   // (A) mutexes are acquired before calling `run_in_event_loop`,
-  // followed by locking (B) `watchers_mutex`. If we executed the
+  // followed by locking (B) `loop->mutex`. If we executed the
   // functions inside the mutex, then the locking order violation
-  // would be this function acquiring the (B) `watchers_mutex`
+  // would be this function acquiring the (B) `loop->mutex`
   // followed by the arbitrary function acquiring the (A) mutexes.
   while (!run_functions.empty()) {
     (run_functions.front())();
@@ -79,15 +68,49 @@ void handle_shutdown(struct ev_loop* loop, ev_async* _, int revents)
 }
 
 
-void EventLoop::initialize()
+void EventLoop::initialize(size_t count)
 {
-  loop = ev_default_loop(EVFLAG_AUTO);
+  CHECK_GT(count, 0u);
+
+  // Tear down the loops of a previous initialization (i.e., when
+  // libprocess gets reinitialized), the threads running them have
+  // already been joined at this point (see `ProcessManager::finalize`).
+  foreach (Loop* loop, *loops) {
+    ev_async_stop(loop->loop, &loop->async_watcher);
+    ev_async_stop(loop->loop, &loop->shutdown_watcher);
+
+    if (!ev_is_default_loop(loop->loop)) {
+      ev_loop_destroy(loop->loop);
+    }
+
+    delete loop;
+  }
+
+  loops->clear();
+
+  for (size_t i = 0; i < count; i++) {
+    Loop* loop = new Loop();
 
-  ev_async_init(&async_watcher, handle_async);
-  ev_async_init(&shutdown_watcher, handle_shutdown);
+    // NOTE: only the default loop can handle signals and child
+    // watchers, which we don't use for the other loops.
+    loop->loop =
+      i == 0 ? ev_default_loop(EVFLAG_AUTO) : ev_loop_new(EVFLAG_AUTO);
 
-  ev_async_start(loop, &async_watcher);
-  ev_async_start(loop, &shutdown_watcher);
+    if (loop->loop == nullptr) {
+      LOG(FATAL) << "Failed to initialize event loop " << i;
+    }
+
+    ev_async_init(&loop->async_watcher, handle_async);
+    ev_async_init(&loop->shutdown_watcher, handle_shutdown);
+
+    loop->async_watcher.data = loop;
+    loop->shutdown_watcher.data = loop;
+
+    ev_async_start(loop->loop, &loop->async_watcher);
+    ev_async_start(loop->loop, &loop->shutdown_watcher);
+
+    loops->push_back(loop);
+  }
 }
 
 
@@ -124,11 +147,21 @@ Future<Nothing> delay(
   const double repeat = 0.0;
 
   ev_timer_init(timer, handle_delay, after, repeat);
-  ev_timer_start(loop, timer);
+  ev_timer_start(loops->front()->loop, timer);
 
   return Nothing();
 }
 
+
+void run(Loop* loop)
+{
+  _event_loop_ = loop;
+
+  ev_loop(loop->loop, 0);
+
+  _event_loop_ = nullptr;
+}
+
 } // namespace internal {
 
 
@@ -150,17 +183,26 @@ double EventLoop::time()
 
 void EventLoop::run()
 {
-  __in_event_loop__ = true;
+  // The first loop is run by the calling thread, every other loop
+  // gets its own thread.
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < loops->size(); i++) {
+    threads.emplace_back(&internal::run, (*loops)[i]);
+  }
 
-  ev_loop(loop, 0);
+  internal::run(loops->front());
 
-  __in_event_loop__ = false;
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
 }
 
 
 void EventLoop::stop()
 {
-  ev_async_send(loop, &shutdown_watcher);
+  foreach (Loop* loop, *loops) {
+    ev_async_send(loop->loop, &loop->shutdown_watcher);
+  }
 }
 
 } // namespace process {
@@ -17,6 +17,7 @@
 
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
@@ -26,30 +27,50 @@
 
 namespace process {
 
-// Event loop.
-extern struct ev_loop* loop;
+// An event loop along with what's needed to interrupt it (e.g., to
+// run functions within it) from other threads. Each loop is run by
+// its own thread (see `EventLoop::run`).
+struct Loop
+{
+  struct ev_loop* loop = nullptr;
+
+  // Asynchronous watcher for interrupting the loop to specifically
+  // deal with functions (via run_in_event_loop).
+  ev_async async_watcher;
+
+  // Asynchronous watcher to receive the request to shutdown.
+  ev_async shutdown_watcher;
+
+  // Queue of functions to be invoked asynchronously within the event
+  // loop (protected by 'mutex' below).
+  std::queue<lambda::function<void()>> functions;
+  std::mutex mutex;
+};
 
-// Asynchronous watcher for interrupting loop to specifically deal
-// with IO watchers and functions (via run_in_event_loop).
-extern ev_async async_watcher;
 
-// Queue of I/O watchers to be asynchronously added to the event loop
-// (protected by 'watchers' below).
-// TODO(benh): Replace this queue with functions that we put in
-// 'functions' below that perform the ev_io_start themselves.
-extern std::queue<ev_io*>* watchers;
-extern std::mutex* watchers_mutex;
+// Event loops. The first loop is libev's default loop which also
+// handles all delays (see `EventLoop::delay`). I/O on file
+// descriptors is sharded across all of the loops (see `loop_of`).
+extern std::vector<Loop*>* loops;
 
-// Queue of functions to be invoked asynchronously within the vent
-// loop (protected by 'watchers' above).
-extern std::queue<lambda::function<void()>>* functions;
 
-// Per thread bool pointer. We use a pointer to lazily construct the
-// actual bool.
-extern thread_local bool* _in_event_loop_;
+// Per thread pointer to the loop the thread is running, if any.
+extern thread_local Loop* _event_loop_;
 
-#define __in_event_loop__ *(_in_event_loop_ == nullptr ?                \
-  _in_event_loop_ = new bool(false) : _in_event_loop_)
+#define __in_event_loop__ (_event_loop_ != nullptr)
+
+// Whether the calling thread is running the specified loop, e.g., the
+// loop of the file descriptor being watched (see `loop_of`).
+#define __in_event_loop_of__(loop) (_event_loop_ == (loop))
+
+
+// Returns the loop that handles I/O on the file descriptor. Note that
+// we always use the same loop for a file descriptor so that a reused
+// file descriptor can't end up being watched by two loops at once.
+inline Loop* loop_of(int fd)
+{
+  return (*loops)[static_cast<size_t>(fd) % loops->size()];
+}
 
 
 // Wrapper around function we want to run in the event loop.
@@ -67,12 +88,14 @@ void _run_in_event_loop(
 }
 
 
-// Helper for running a function in the event loop.
+// Helper for running a function in the specified event loop.
 template <typename T>
-Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+Future<T> run_in_event_loop(
+    Loop* loop,
+    const lambda::function<Future<T>()>& f)
 {
   // If this is already the event loop then just run the function.
-  if (__in_event_loop__) {
+  if (_event_loop_ == loop) {
     return f();
   }
 
@@ -81,16 +104,24 @@ Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
   Future<T> future = promise->future();
 
   // Enqueue the function.
-  synchronized (watchers_mutex) {
-    functions->push(lambda::bind(&_run_in_event_loop<T>, f, promise));
+  synchronized (loop->mutex) {
+    loop->functions.push(lambda::bind(&_run_in_event_loop<T>, f, promise));
   }
 
   // Interrupt the loop.
-  ev_async_send(loop, &async_watcher);
+  ev_async_send(loop->loop, &loop->async_watcher);
 
   return future;
 }
 
+
+// Helper for running a function in the first event loop.
+template <typename T>
+Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+{
+  return run_in_event_loop(loops->front(), f);
+}
+
 } // namespace process {
 
 #endif // __LIBEV_HPP__
@@ -27,7 +27,7 @@ namespace process {
 // stop it in the event loop.
 struct Poll
 {
-  Poll()
+  explicit Poll(Loop* _loop) : loop(_loop)
   {
     // Need to explicitly instantiate the watchers.
     watcher.io.reset(new ev_io());
@@ -41,6 +41,9 @@ struct Poll
     std::shared_ptr<ev_async> async;
   } watcher;
 
+  // The event loop that polls the file descriptor.
+  Loop* loop;
+
   Promise<short> promise;
 };
 
@@ -50,6 +53,8 @@ void polled(struct ev_loop* loop, ev_io* watcher, int revents)
 {
   Poll* poll = (Poll*) watcher->data;
 
+  CHECK(__in_event_loop_of__(poll->loop));
+
   ev_io_stop(loop, poll->watcher.io.get());
 
   // Stop the async watcher (also clears if pending so 'discard_poll'
@@ -68,6 +73,8 @@ void discard_poll(struct ev_loop* loop, ev_async* watcher, int revents)
 {
   Poll* poll = (Poll*) watcher->data;
 
+  CHECK(__in_event_loop_of__(poll->loop));
+
   // Check and see if we have a pending 'polled' callback and if so
   // let it "win".
   if (ev_is_pending(poll->watcher.io.get())) {
@@ -90,15 +97,17 @@ namespace io {
 namespace internal {
 
 // Helper/continuation of 'poll' on future discard.
-void _poll(const std::shared_ptr<ev_async>& async)
+void _poll(Loop* loop, const std::shared_ptr<ev_async>& async)
 {
-  ev_async_send(loop, async.get());
+  ev_async_send(loop->loop, async.get());
 }
 
 
-Future<short> poll(int_fd fd, short events)
+Future<short> poll(Loop* loop, int_fd fd, short events)
 {
-  Poll* poll = new Poll();
+  CHECK(__in_event_loop_of__(loop));
+
+  Poll* poll = new Poll(loop);
 
   // Have the watchers data point back to the struct.
   poll->watcher.async->data = poll;
@@ -109,7 +118,7 @@ Future<short> poll(int_fd fd, short events)
 
   // Initialize and start the async watcher.
   ev_async_init(poll->watcher.async.get(), discard_poll);
-  ev_async_start(loop, poll->watcher.async.get());
+  ev_async_start(loop->loop, poll->watcher.async.get());
 
   // Make sure we stop polling if a discard occurs on our future.
   // Note that it's possible that we'll invoke '_poll' when someone
@@ -117,11 +126,11 @@ Future<short> poll(int_fd fd, short events)
   // in this case while we will interrupt the event loop since the
   // async watcher has already been stopped we won't cause
   // 'discard_poll' to get invoked.
-  future.onDiscard(lambda::bind(&_poll, poll->watcher.async));
+  future.onDiscard(lambda::bind(&_poll, loop, poll->watcher.async));
 
   // Initialize and start the I/O watcher.
   ev_io_init(poll->watcher.io.get(), polled, fd, events);
-  ev_io_start(loop, poll->watcher.io.get());
+  ev_io_start(loop->loop, poll->watcher.io.get());
 
   return future;
 }
@@ -135,7 +144,12 @@ Future<short> poll(int_fd fd, short events)
 
   // TODO(benh): Check if the file descriptor is non-blocking?
 
-  return run_in_event_loop<short>(lambda::bind(&internal::poll, fd, events));
+  // Polling is sharded across the event loops by file descriptor.
+  Loop* loop = loop_of(fd);
+
+  return run_in_event_loop<short>(
+      loop,
+      lambda::bind(&internal::poll, loop, fd, events));
 }
 
 } // namespace io {
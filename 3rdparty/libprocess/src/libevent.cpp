@@ -15,6 +15,8 @@
 #endif // __WINDOWS__
 
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <event2/event.h>
 #include <event2/thread.h>
@@ -23,6 +25,7 @@
 #include <process/logging.hpp>
 #include <process/once.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/synchronized.hpp>
 
 #include "event_loop.hpp"
@@ -30,15 +33,12 @@
 
 namespace process {
 
-event_base* base = nullptr;
-
+std::vector<Loop*>* loops = new std::vector<Loop*>();
 
-static std::mutex* functions_mutex = new std::mutex();
-std::queue<lambda::function<void()>>* functions =
-  new std::queue<lambda::function<void()>>();
+event_base* base = nullptr;
 
 
-thread_local bool* _in_event_loop_ = nullptr;
+thread_local Loop* _event_loop_ = nullptr;
 
 
 void async_function(evutil_socket_t socket, short which, void* arg)
@@ -48,8 +48,8 @@ void async_function(evutil_socket_t socket, short which, void* arg)
 
   std::queue<lambda::function<void()>> q;
 
-  synchronized (functions_mutex) {
-    std::swap(q, *functions);
+  synchronized (_event_loop_->mutex) {
+    std::swap(q, _event_loop_->functions);
   }
 
   while (!q.empty()) {
@@ -60,28 +60,29 @@ void async_function(evutil_socket_t socket, short which, void* arg)
 
 
 void run_in_event_loop(
+    Loop* loop,
     const lambda::function<void()>& f,
     EventLoopLogicFlow event_loop_logic_flow)
 {
-  if (__in_event_loop__ && event_loop_logic_flow == ALLOW_SHORT_CIRCUIT) {
+  if (_event_loop_ == loop && event_loop_logic_flow == ALLOW_SHORT_CIRCUIT) {
     f();
     return;
   }
 
-  synchronized (functions_mutex) {
-    functions->push(f);
+  synchronized (loop->mutex) {
+    loop->functions.push(f);
 
     // Add an event and activate it to interrupt the event loop.
     // TODO(jmlvanre): after libevent v 2.1 we can use
     // event_self_cbarg instead of re-assigning the event. For now we
     // manually re-assign the event to pass in the pointer to the
     // event itself as the callback argument.
-    event* ev = evtimer_new(base, async_function, nullptr);
+    event* ev = evtimer_new(loop->base, async_function, nullptr);
 
     // 'event_assign' is only valid on non-pending AND non-active
     // events. This means we have to assign the callback before
     // calling 'event_active'.
-    if (evtimer_assign(ev, base, async_function, ev) < 0) {
+    if (evtimer_assign(ev, loop->base, async_function, ev) < 0) {
       LOG(FATAL) << "Failed to assign callback on event";
     }
 
@@ -90,12 +91,22 @@ void run_in_event_loop(
 }
 
 
-void EventLoop::run()
+void run_in_event_loop(
+    const lambda::function<void()>& f,
+    EventLoopLogicFlow event_loop_logic_flow)
 {
-  __in_event_loop__ = true;
+  run_in_event_loop(loops->front(), f, event_loop_logic_flow);
+}
+
+
+namespace internal {
+
+void run(Loop* loop)
+{
+  _event_loop_ = loop;
 
   do {
-    int result = event_base_loop(base, EVLOOP_ONCE);
+    int result = event_base_loop(loop->base, EVLOOP_ONCE);
     if (result < 0) {
       LOG(FATAL) << "Failed to run event loop";
     } else if (result > 0) {
@@ -103,21 +114,42 @@ void EventLoop::run()
       continue;
     } else {
       CHECK_EQ(0, result);
-      if (event_base_got_break(base)) {
+      if (event_base_got_break(loop->base)) {
         break;
-      } else if (event_base_got_exit(base)) {
+      } else if (event_base_got_exit(loop->base)) {
         break;
       }
     }
   } while (true);
 
-  __in_event_loop__ = false;
+  _event_loop_ = nullptr;
+}
+
+} // namespace internal {
+
+
+void EventLoop::run()
+{
+  // The first loop is run by the calling thread, every other loop
+  // gets its own thread.
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < loops->size(); i++) {
+    threads.emplace_back(&internal::run, (*loops)[i]);
+  }
+
+  internal::run(loops->front());
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
 }
 
 
 void EventLoop::stop()
 {
-  event_base_loopexit(base, nullptr);
+  foreach (Loop* loop, *loops) {
+    event_base_loopexit(loop->base, nullptr);
+  }
 }
 
 
@@ -177,8 +209,10 @@ double EventLoop::time()
 }
 
 
-void EventLoop::initialize()
+void EventLoop::initialize(size_t count)
 {
+  CHECK_GT(count, 0u);
+
   static Once* initialized = new Once();
 
   if (initialized->once()) {
@@ -208,12 +242,22 @@ void EventLoop::initialize()
   struct event_config* config = event_config_new();
   event_config_avoid_method(config, "epoll");
 
-  base = event_base_new_with_config(config);
+  for (size_t i = 0; i < count; i++) {
+    Loop* loop = new Loop();
 
-  if (base == nullptr) {
-    LOG(FATAL) << "Failed to initialize, event_base_new";
+    loop->base = event_base_new_with_config(config);
+
+    if (loop->base == nullptr) {
+      LOG(FATAL) << "Failed to initialize, event_base_new";
+    }
+
+    loops->push_back(loop);
   }
 
+  event_config_free(config);
+
+  base = loops->front()->base;
+
   initialized->done();
 }
 
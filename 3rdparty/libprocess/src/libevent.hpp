@@ -15,21 +15,57 @@
 
 #include <event2/event.h>
 
+#include <mutex>
+#include <queue>
+#include <vector>
+
 #include <stout/lambda.hpp>
 
 namespace process {
 
-// Event loop.
+// An event loop along with the functions to be run within it (see
+// `run_in_event_loop`). Each loop is run by its own thread (see
+// `EventLoop::run`).
+struct Loop
+{
+  event_base* base = nullptr;
+
+  // Queue of functions to be invoked asynchronously within the event
+  // loop (protected by 'mutex' below).
+  std::queue<lambda::function<void()>> functions;
+  std::mutex mutex;
+};
+
+
+// Event loops. The first loop handles all delays (see
+// `EventLoop::delay`) as well as all SSL sockets. I/O polled on file
+// descriptors is sharded across all of the loops (see `loop_of`).
+extern std::vector<Loop*>* loops;
+
+
+// Event base of the first event loop.
 extern event_base* base;
 
 
-// Per thread bool pointer. We use a pointer to lazily construct the
-// actual bool.
-extern thread_local bool* _in_event_loop_;
+// Per thread pointer to the loop the thread is running, if any.
+extern thread_local Loop* _event_loop_;
+
 
+#define __in_event_loop__ (_event_loop_ != nullptr)
 
-#define __in_event_loop__ *(_in_event_loop_ == nullptr ?                \
-  _in_event_loop_ = new bool(false) : _in_event_loop_)
+// Whether the calling thread is running the specified loop, e.g., the
+// first loop for SSL sockets or the loop of the file descriptor being
+// polled (see `loop_of`).
+#define __in_event_loop_of__(loop) (_event_loop_ == (loop))
+
+
+// Returns the loop that handles I/O on the file descriptor. Note that
+// we always use the same loop for a file descriptor so that a reused
+// file descriptor can't end up being watched by two loops at once.
+inline Loop* loop_of(evutil_socket_t fd)
+{
+  return (*loops)[static_cast<size_t>(fd) % loops->size()];
+}
 
 
 enum EventLoopLogicFlow
@@ -39,6 +75,14 @@ enum EventLoopLogicFlow
 };
 
 
+// Runs the function in the specified event loop.
+void run_in_event_loop(
+    Loop* loop,
+    const lambda::function<void()>& f,
+    EventLoopLogicFlow event_loop_logic_flow = ALLOW_SHORT_CIRCUIT);
+
+
+// Runs the function in the first event loop.
 void run_in_event_loop(
     const lambda::function<void()>& f,
     EventLoopLogicFlow event_loop_logic_flow = ALLOW_SHORT_CIRCUIT);
@@ -32,8 +32,10 @@ struct Poll
 };
 
 
-void pollCallback(evutil_socket_t, short what, void* arg)
+void pollCallback(evutil_socket_t fd, short what, void* arg)
 {
+  CHECK(__in_event_loop_of__(loop_of(fd)));
+
   Poll* poll = reinterpret_cast<Poll*>(arg);
 
   if (poll->promise.future().hasDiscard()) {
@@ -53,11 +55,11 @@ void pollCallback(evutil_socket_t, short what, void* arg)
 }
 
 
-void pollDiscard(const std::weak_ptr<event>& ev, short events)
+void pollDiscard(Loop* loop, const std::weak_ptr<event>& ev, short events)
 {
   // Discarding inside the event loop prevents `pollCallback()` from being
   // called twice if the future is discarded.
-  run_in_event_loop([=]() {
+  run_in_event_loop(loop, [=]() {
     std::shared_ptr<event> shared = ev.lock();
     // If `ev` cannot be locked `pollCallback` already ran. If it was locked
     // but not pending, `pollCallback` is scheduled to be executed.
@@ -76,6 +78,9 @@ Future<short> poll(int_fd fd, short events)
 {
   process::initialize();
 
+  // Polling is sharded across the event loops by file descriptor.
+  Loop* loop = loop_of(fd);
+
   internal::Poll* poll = new internal::Poll();
 
   Future<short> future = poll->promise.future();
@@ -88,7 +93,7 @@ Future<short> poll(int_fd fd, short events)
   // Bind `event_free` to the destructor of the `ev` shared pointer
   // guaranteeing that the event will be freed only once.
   poll->ev.reset(
-      event_new(base, fd, what, &internal::pollCallback, poll),
+      event_new(loop->base, fd, what, &internal::pollCallback, poll),
       event_free);
 
   if (poll->ev == nullptr) {
@@ -105,7 +110,7 @@ Future<short> poll(int_fd fd, short events)
   event_add(poll->ev.get(), nullptr);
 
   return future
-    .onDiscard(lambda::bind(&internal::pollDiscard, ev, what));
+    .onDiscard(lambda::bind(&internal::pollDiscard, loop, ev, what));
 }
 
 } // namespace io {
@@ -125,7 +125,7 @@ LibeventSSLSocketImpl::~LibeventSSLSocketImpl()
         // disabled, and cleaning up any remaining state associated
         // with the event loop.
 
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
 
         if (_listener != nullptr) {
           evconnlistener_free(_listener);
@@ -178,7 +178,7 @@ Try<Nothing> LibeventSSLSocketImpl::shutdown(int how)
 
   run_in_event_loop(
       [self]() {
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
         CHECK(self);
 
         CHECK_NOTNULL(self->bev);
@@ -213,7 +213,7 @@ Try<Nothing> LibeventSSLSocketImpl::shutdown(int how)
 // top of file.
 void LibeventSSLSocketImpl::recv_callback(bufferevent* /*bev*/, void* arg)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   std::weak_ptr<LibeventSSLSocketImpl>* handle =
     reinterpret_cast<std::weak_ptr<LibeventSSLSocketImpl>*>(CHECK_NOTNULL(arg));
@@ -235,7 +235,7 @@ void LibeventSSLSocketImpl::recv_callback(bufferevent* /*bev*/, void* arg)
 //    read callback.
 void LibeventSSLSocketImpl::recv_callback()
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   Owned<RecvRequest> request;
 
@@ -278,7 +278,7 @@ void LibeventSSLSocketImpl::recv_callback()
 // top of file.
 void LibeventSSLSocketImpl::send_callback(bufferevent* /*bev*/, void* arg)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   std::weak_ptr<LibeventSSLSocketImpl>* handle =
     reinterpret_cast<std::weak_ptr<LibeventSSLSocketImpl>*>(CHECK_NOTNULL(arg));
@@ -296,7 +296,7 @@ void LibeventSSLSocketImpl::send_callback(bufferevent* /*bev*/, void* arg)
 // 'recv_callback'.
 void LibeventSSLSocketImpl::send_callback()
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   Owned<SendRequest> request;
 
@@ -317,7 +317,7 @@ void LibeventSSLSocketImpl::event_callback(
     short events,
     void* arg)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   std::weak_ptr<LibeventSSLSocketImpl>* handle =
     reinterpret_cast<std::weak_ptr<LibeventSSLSocketImpl>*>(CHECK_NOTNULL(arg));
@@ -335,7 +335,7 @@ void LibeventSSLSocketImpl::event_callback(
 // 'recv_callback'.
 void LibeventSSLSocketImpl::event_callback(short events)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   // TODO(bmahler): Libevent's invariant is that `events` contains:
   //
@@ -643,7 +643,7 @@ Future<size_t> LibeventSSLSocketImpl::recv(char* data, size_t size)
       if (self != nullptr) {
         run_in_event_loop(
             [self]() {
-              CHECK(__in_event_loop__);
+              CHECK(__in_event_loop_of__(loops->front()));
               CHECK(self);
 
               Owned<RecvRequest> request;
@@ -681,7 +681,7 @@ Future<size_t> LibeventSSLSocketImpl::recv(char* data, size_t size)
 
   run_in_event_loop(
       [self]() {
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
         CHECK(self);
 
         bool recv = false;
@@ -751,7 +751,7 @@ Future<size_t> LibeventSSLSocketImpl::send(const char* data, size_t size)
 
   run_in_event_loop(
       [self, buffer]() {
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
         CHECK(self);
 
         // Check if the socket is closed or the write end has
@@ -836,7 +836,7 @@ Future<size_t> LibeventSSLSocketImpl::sendfile(
 
   run_in_event_loop(
       [self, owned_fd, offset, size]() {
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
         CHECK(self);
 
         // Check if the socket is closed or the write end has
@@ -887,7 +887,7 @@ Try<Nothing> LibeventSSLSocketImpl::listen(int backlog)
          sockaddr* addr,
          int addr_length,
          void* arg) {
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
 
         std::weak_ptr<LibeventSSLSocketImpl>* handle =
           reinterpret_cast<std::weak_ptr<LibeventSSLSocketImpl>*>(
@@ -964,7 +964,7 @@ void LibeventSSLSocketImpl::peek_callback(
     short what,
     void* arg)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   CHECK(what & EV_READ);
   char data[6];
@@ -1028,7 +1028,7 @@ void LibeventSSLSocketImpl::peek_callback(
 
 void LibeventSSLSocketImpl::accept_callback(AcceptRequest* request)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   Queue<Future<std::shared_ptr<SocketImpl>>> accept_queue_ = accept_queue;
 
@@ -1059,7 +1059,7 @@ void LibeventSSLSocketImpl::accept_callback(AcceptRequest* request)
 
 void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
 {
-  CHECK(__in_event_loop__);
+  CHECK(__in_event_loop_of__(loops->front()));
 
   // Set up SSL object.
   SSL* ssl = SSL_new(openssl::context());
@@ -1098,7 +1098,7 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
         // This handles error states or 'BEV_EVENT_CONNECTED' events
         // and satisfies the promise by constructing a new socket if
         // the connection was successfuly established.
-        CHECK(__in_event_loop__);
+        CHECK(__in_event_loop_of__(loops->front()));
 
         AcceptRequest* request =
           reinterpret_cast<AcceptRequest*>(CHECK_NOTNULL(arg));
@@ -44,6 +44,8 @@ public:
   Future<size_t> recv(char* data, size_t size) override;
   // Send does not currently support discard. See implementation.
   Future<size_t> send(const char* data, size_t size) override;
+  // Don't hide the vectored and `std::string` overloads of `send`.
+  using SocketImpl::send;
   Future<size_t> sendfile(int_fd fd, off_t offset, size_t size) override;
   Try<Nothing> listen(int backlog) override;
   Future<std::shared_ptr<SocketImpl>> accept() override;
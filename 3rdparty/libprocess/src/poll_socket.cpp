@@ -11,16 +11,28 @@
 // limitations under the License
 
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #ifdef __WINDOWS__
 #include <stout/windows.hpp>
 #else
+#include <limits.h>
+#include <string.h>
+
 #include <netinet/tcp.h>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
 #endif // __WINDOWS__
 
 #include <process/io.hpp>
 #include <process/network.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
+
 #include <stout/os/sendfile.hpp>
 #include <stout/os/strerror.hpp>
 #include <stout/os.hpp>
@@ -28,7 +40,9 @@
 #include "config.hpp"
 #include "poll_socket.hpp"
 
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace process {
 namespace network {
@@ -222,6 +236,68 @@ Future<size_t> socket_send_data(
 }
 
 
+#ifndef __WINDOWS__
+// Maximum number of buffers passed to a single `sendmsg`; any buffers
+// beyond this are sent by a subsequent call.
+constexpr size_t MAX_SEND_BUFFERS = 64 < IOV_MAX ? 64 : IOV_MAX;
+
+
+Future<size_t> socket_send_buffers(
+    const std::shared_ptr<PollSocketImpl>& impl,
+    const vector<pair<const char*, size_t>>& buffers)
+{
+  struct iovec iov[MAX_SEND_BUFFERS];
+  size_t count = 0;
+
+  foreach (const auto& buffer, buffers) {
+    if (count == MAX_SEND_BUFFERS) {
+      break;
+    } else if (buffer.second > 0) {
+      iov[count].iov_base = const_cast<char*>(buffer.first);
+      iov[count].iov_len = buffer.second;
+      count++;
+    }
+  }
+
+  CHECK(count > 0);
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = iov;
+  message.msg_iovlen = count;
+
+  while (true) {
+    ssize_t length = ::sendmsg(impl->get(), &message, MSG_NOSIGNAL);
+
+    int error = errno;
+
+    if (length < 0 && net::is_restartable_error(error)) {
+      // Interrupted, try again now.
+      continue;
+    } else if (length < 0 && net::is_retryable_error(error)) {
+      // Might block, try again later.
+      return io::poll(impl->get(), io::WRITE)
+        .then(lambda::bind(&internal::socket_send_buffers, impl, buffers));
+    } else if (length <= 0) {
+      // Socket error or closed.
+      if (length < 0) {
+        const string error = os::strerror(errno);
+        VLOG(1) << "Socket error while sending: " << error;
+        return Failure(ErrnoError("Socket send failed"));
+      } else {
+        VLOG(1) << "Socket closed while sending";
+        return length;
+      }
+    } else {
+      CHECK(length > 0);
+
+      return length;
+    }
+  }
+}
+#endif // __WINDOWS__
+
+
 Future<size_t> socket_send_file(
     const std::shared_ptr<PollSocketImpl>& impl,
     int_fd fd,
@@ -277,6 +353,23 @@ Future<size_t> PollSocketImpl::send(const char* data, size_t size)
 }
 
 
+Future<size_t> PollSocketImpl::send(
+    const vector<pair<const char*, size_t>>& buffers)
+{
+#ifdef __WINDOWS__
+  // Vectored sends are not yet supported on Windows, fall back to
+  // sending a single buffer at a time.
+  return SocketImpl::send(buffers);
+#else
+  return io::poll(get(), io::WRITE)
+    .then(lambda::bind(
+        &internal::socket_send_buffers,
+        shared(this),
+        buffers));
+#endif // __WINDOWS__
+}
+
+
 Future<size_t> PollSocketImpl::sendfile(int_fd fd, off_t offset, size_t size)
 {
   return io::poll(get(), io::WRITE)
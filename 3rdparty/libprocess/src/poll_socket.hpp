@@ -11,6 +11,8 @@
 // limitations under the License
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <process/socket.hpp>
 
@@ -36,6 +38,8 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   virtual Future<size_t> send(const char* data, size_t size);
   virtual Future<size_t> sendfile(int_fd fd, off_t offset, size_t size);
+  virtual Future<size_t> send(
+      const std::vector<std::pair<const char*, size_t>>& buffers);
   virtual Kind kind() const { return SocketImpl::Kind::POLL; }
 };
 
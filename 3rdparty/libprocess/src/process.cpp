@@ -43,6 +43,7 @@
 #endif // __WINDOWS__
 
 #include <algorithm>
+#include <chrono>
 #include <deque>
 #include <fstream>
 #include <iomanip>
@@ -86,6 +87,8 @@
 #include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
 
 #include <process/ssl/flags.hpp>
@@ -104,6 +107,7 @@
 #include <stout/os.hpp>
 #include <stout/os/strerror.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
@@ -115,6 +119,7 @@
 #include "event_loop.hpp"
 #include "event_queue.hpp"
 #include "gate.hpp"
+#include "latencies.hpp"
 #include "process_reference.hpp"
 #include "run_queue.hpp"
 
@@ -245,6 +250,47 @@ struct Flags : public virtual flags::FlagsBase
         "libprocess is listening may not match the address from\n"
         "which libprocess connects to other actors.\n",
         false);
+
+    add(&Flags::resume_quantum_events,
+        "resume_quantum_events",
+        "The maximum number of events a process serves each time it is\n"
+        "resumed before it yields its worker thread to other processes.\n"
+        "The process is put back on the run queue if it still has events\n"
+        "to serve. If not specified the process serves events until its\n"
+        "event queue is empty.",
+        [](const Option<size_t>& value) -> Option<Error> {
+          if (value.isSome() && value.get() == 0) {
+            return Error(
+                "LIBPROCESS_RESUME_QUANTUM_EVENTS must be greater than 0");
+          }
+
+          return None();
+        });
+
+    add(&Flags::resume_quantum_duration,
+        "resume_quantum_duration",
+        "The maximum amount of time a process serves events each time it\n"
+        "is resumed before it yields its worker thread to other processes.\n"
+        "Like '--resume_quantum_events' a single event is never\n"
+        "interrupted, the quantum is only checked in between events.");
+
+    add(&Flags::max_pipelined_requests,
+        "max_pipelined_requests",
+        "The maximum number of requests (including messages) received\n"
+        "on a connection which have not been responded to yet. Once\n"
+        "reached, no more requests are received on the connection until\n"
+        "some of the outstanding requests have been responded to. Note\n"
+        "that the requests received with a single read from the socket\n"
+        "might exceed this maximum.",
+        1024,
+        [](const size_t& value) -> Option<Error> {
+          if (value == 0) {
+            return Error(
+                "LIBPROCESS_MAX_PIPELINED_REQUESTS must be greater than 0");
+          }
+
+          return None();
+        });
   }
 
   Option<net::IP> ip;
@@ -253,6 +299,9 @@ struct Flags : public virtual flags::FlagsBase
   Option<int> port;
   Option<int> advertise_port;
   bool require_peer_address_ip_match;
+  Option<size_t> resume_quantum_events;
+  Option<Duration> resume_quantum_duration;
+  size_t max_pipelined_requests;
 };
 
 } // namespace internal {
@@ -283,6 +332,125 @@ map<string, string> types;
 } // namespace mime {
 
 
+// Keeps track of the requests received on a connection which have not
+// been responded to yet (i.e., the pipelining depth of the
+// connection) and bounds them: `decode_recv` stops receiving requests
+// on the connection while the maximum is reached and the `HttpProxy`
+// of the connection resumes receiving once it has sent enough
+// responses (see `--max_pipelined_requests`).
+//
+// NOTE: only the requests which the `HttpProxy` has been asked to
+// respond to are accounted for, so the depth of a connection might
+// exceed the maximum by the requests decoded from a single read.
+class Pipeline
+{
+public:
+  explicit Pipeline(size_t _capacity) : capacity(_capacity) {}
+
+  // Records that the `HttpProxy` has been asked to respond to
+  // another request.
+  void requested()
+  {
+    synchronized (mutex) {
+      ++depth;
+    }
+
+    ++total;
+  }
+
+  // Records that the `HttpProxy` has responded to a request, in
+  // which case receiving requests is resumed if it has been paused
+  // and the depth is below the maximum again.
+  void responded()
+  {
+    lambda::function<void()> resume;
+
+    synchronized (mutex) {
+      CHECK_GT(depth, 0u);
+      --depth;
+
+      if (paused.isSome() && depth < capacity) {
+        resume = paused.get();
+        paused = None();
+      }
+    }
+
+    --total;
+
+    if (resume) {
+      resume();
+    }
+  }
+
+  // Records that the `HttpProxy` has terminated, i.e., that none of
+  // the outstanding requests will be responded to. Receiving requests
+  // is resumed if it has been paused so that the closing of the
+  // socket gets observed.
+  void close()
+  {
+    lambda::function<void()> resume;
+
+    synchronized (mutex) {
+      closed = true;
+      total -= depth;
+      depth = 0;
+
+      if (paused.isSome()) {
+        resume = paused.get();
+        paused = None();
+      }
+    }
+
+    if (resume) {
+      resume();
+    }
+  }
+
+  // Returns true if receiving requests must be paused because the
+  // depth has reached the maximum, in which case `resume` gets
+  // invoked once the depth is below the maximum again. Otherwise
+  // returns false and the caller is expected to continue receiving.
+  bool pause(const lambda::function<void()>& resume)
+  {
+    synchronized (mutex) {
+      if (closed || depth < capacity) {
+        return false;
+      }
+
+      CHECK_NONE(paused);
+      paused = resume;
+    }
+
+    ++stalls;
+
+    return true;
+  }
+
+  // Pipelining depth of all connections, see the
+  // 'libprocess/http_pipelined_requests' metric.
+  static std::atomic<int64_t> total;
+
+  // Number of times receiving requests was paused, see the
+  // 'libprocess/http_pipelining_stalls' metric.
+  static metrics::Counter stalls;
+
+private:
+  const size_t capacity;
+
+  std::mutex mutex;
+  size_t depth = 0;
+  bool closed = false;
+  Option<lambda::function<void()>> paused;
+};
+
+
+std::atomic<int64_t> Pipeline::total = ATOMIC_VAR_INIT(0);
+
+
+metrics::Counter Pipeline::stalls =
+  metrics::Counter("libprocess/http_pipelining_stalls");
+
+
 // Provides a process that manages sending HTTP responses so as to
 // satisfy HTTP/1.1 pipelining. Each request should either enqueue a
 // response, or ask the proxy to handle a future response. The process
@@ -307,11 +475,15 @@ public:
   // responses have been processed (e.g., waited for and sent).
   void handle(const Future<Response>& future, const Request& request);
 
+  // The requests on the socket which haven't been responded to yet.
+  const std::shared_ptr<Pipeline> pipeline;
+
 protected:
   void finalize() override;
 
 private:
-  // Starts "waiting" on the next available future response.
+  // Processes all of the responses which are already available (in
+  // order) and then starts "waiting" on the next future response.
   void next();
 
   // Invoked once a future response has been satisfied.
@@ -418,6 +590,9 @@ public:
 
   PID<HttpProxy> proxy(const Socket& socket);
 
+  // Returns the pipeline of the `HttpProxy` of the socket, if any.
+  Option<std::shared_ptr<Pipeline>> pipeline(const Socket& socket);
+
   // Used to clean up the pointer to an `HttpProxy` in case the
   // `HttpProxy` is killed outside the control of the `SocketManager`.
   // This generally happens when `process::finalize` is called.
@@ -526,6 +701,13 @@ public:
       const Socket& socket,
       Request* request);
 
+  // Delivers an inbound libprocess message and enqueues the response
+  // to the request which carried the message.
+  void handle(
+      const Socket& socket,
+      MessageEvent* event,
+      const Request& request);
+
   bool deliver(
       ProcessBase* receiver,
       Event* event,
@@ -562,6 +744,9 @@ public:
   // The /__processes__ route.
   Future<Response> __processes__(const Request&);
 
+  // The /__latencies__ route.
+  Future<Response> __latencies__(const Request&);
+
   void install(Filter* f)
   {
     // NOTE: even though `filter` is atomic we still need to
@@ -579,13 +764,38 @@ public:
     return threads.size() - 1; // Less 1 for event loop thread.
   }
 
+  // Number of times a process yielded its worker thread because it
+  // used up its quantum (see `resume`). Added to the metrics once
+  // the metrics process has been spawned.
+  metrics::Counter resume_quantum_expirations =
+    metrics::Counter("libprocess/resume_quantum_expirations");
+
 private:
   // Delegate process name to receive root HTTP requests.
   const Option<string> delegate;
 
-  // Map of all local spawned and running processes.
-  hashmap<string, ProcessBase*> processes;
-  std::recursive_mutex processes_mutex;
+  // Map of all local spawned and running processes, sharded by the
+  // ID of the process so that looking up processes (e.g., for every
+  // message received from the network) doesn't bounce a single mutex
+  // between the worker threads. The shard of a process is always
+  // locked when spawning or cleaning up that process, so a lookup
+  // only needs the lock of the shard of the ID it's looking up.
+  //
+  // NOTE: never acquire the lock of more than one shard at a time.
+  struct ProcessesShard
+  {
+    hashmap<string, ProcessBase*> processes;
+    std::recursive_mutex mutex;
+  };
+
+  static constexpr size_t PROCESSES_SHARDS = 16;
+
+  ProcessesShard processes[PROCESSES_SHARDS];
+
+  ProcessesShard& shard(const string& id)
+  {
+    return processes[std::hash<string>()(id) % PROCESSES_SHARDS];
+  }
 
   // Queue of runnable processes.
   //
@@ -662,6 +872,9 @@ static AuthorizationCallbacks* authorization_callbacks = nullptr;
 // Global route that returns process information.
 static Route* processes_route = nullptr;
 
+// Route for getting the latencies of the processes.
+static Route* latencies_route = nullptr;
+
 // Global help.
 PID<Help> help;
 
@@ -968,10 +1181,12 @@ void decode_recv(
     return;
   }
 
-  // Decode as much of the data as possible into HTTP requests.
-  const deque<Request*> requests = decoder->decode(data, length.get());
+  // Decode as much of the data as possible into HTTP requests and
+  // libprocess messages.
+  deque<StreamingRequestDecoder::Decoded> decoded;
+  decoder->decode(data, length.get(), &decoded);
 
-  if (requests.empty() && decoder->failed()) {
+  if (decoded.empty() && decoder->failed()) {
      VLOG(1) << "Decoder error while receiving";
      socket_manager->close(socket);
      delete[] data;
@@ -979,7 +1194,7 @@ void decode_recv(
      return;
   }
 
-  if (!requests.empty()) {
+  if (!decoded.empty()) {
     // Get the peer address to augment the requests.
     Try<Address> address = socket.peer();
 
@@ -987,19 +1202,55 @@ void decode_recv(
       VLOG(1) << "Failed to get peer address while receiving: "
               << address.error();
       socket_manager->close(socket);
+      foreach (const StreamingRequestDecoder::Decoded& item, decoded) {
+        delete item.request;
+        delete item.event;
+      }
       delete[] data;
       delete decoder;
       return;
     }
 
-    foreach (Request* request, requests) {
-      request->client = address.get();
-      process_manager->handle(socket, request);
+    foreach (const StreamingRequestDecoder::Decoded& item, decoded) {
+      if (item.request != nullptr) {
+        item.request->client = address.get();
+        process_manager->handle(socket, item.request);
+      } else {
+        // A libprocess message decoded via the fast path, we only
+        // need a minimal request for enqueueing the response.
+        const Message& message = CHECK_NOTNULL(item.event)->message;
+
+        Request request;
+        request.method = "POST";
+        request.url.path = "/";
+        request.url.path += message.to.id;
+        request.url.path += "/" + message.name;
+        request.keepAlive = item.keepAlive;
+        request.client = address.get();
+
+        process_manager->handle(socket, item.event, request);
+      }
     }
   }
 
-  socket.recv(data, size)
-    .onAny(lambda::bind(&decode_recv, lambda::_1, data, size, socket, decoder));
+  lambda::function<void()> recv = [=]() {
+    socket.recv(data, size)
+      .onAny(lambda::bind(
+          &decode_recv, lambda::_1, data, size, socket, decoder));
+  };
+
+  // Stop receiving while the maximum number of pipelined requests
+  // are waiting to be responded to (see `Pipeline`).
+  if (!decoded.empty()) {
+    Option<std::shared_ptr<Pipeline>> pipeline =
+      socket_manager->pipeline(socket);
+
+    if (pipeline.isSome() && pipeline.get()->pause(recv)) {
+      return;
+    }
+  }
+
+  recv();
 }
 
 } // namespace internal {
@@ -1054,7 +1305,8 @@ void on_accept(const Future<Socket>& socket)
     const size_t size = 80 * 1024;
     char* data = new char[size];
 
-    StreamingRequestDecoder* decoder = new StreamingRequestDecoder();
+    StreamingRequestDecoder* decoder =
+      new StreamingRequestDecoder(__address__);
 
     socket.get().recv(data, size)
       .onAny(lambda::bind(
@@ -1203,8 +1455,33 @@ bool initialize(
   process_manager = new ProcessManager(delegate);
   socket_manager = new SocketManager();
 
-  // Initialize the event loop.
-  EventLoop::initialize();
+  // Initialize the event loops. We default to a single event loop
+  // but allow the operator to run more event loops (each with its own
+  // thread) using an environment variable, for when a single event
+  // loop thread can't keep up with all of the I/O (e.g., a master with
+  // tens of thousands of agents linked).
+  size_t num_event_loops = 1;
+
+  constexpr char event_loops_env_var[] = "LIBPROCESS_NUM_EVENT_LOOPS";
+  Option<string> event_loops = os::getenv(event_loops_env_var);
+  if (event_loops.isSome()) {
+    constexpr size_t maxval = 64;
+    Try<size_t> number = numify<size_t>(event_loops.get().c_str());
+    if (number.isSome() && number.get() > 0 && number.get() <= maxval) {
+      VLOG(1) << "Overriding default number of event loops "
+              << num_event_loops << ", using the value "
+              << event_loops_env_var << "=" << number.get() << " instead";
+      num_event_loops = number.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << event_loops.get()
+                   << " for " << event_loops_env_var
+                   << ", using default value " << num_event_loops
+                   << ". Valid values are integers in the range 1 to "
+                   << maxval;
+    }
+  }
+
+  EventLoop::initialize(num_event_loops);
 
   // Setup processing threads.
   long num_worker_threads = process_manager->init_threads();
@@ -1349,6 +1626,70 @@ bool initialize(
       metrics::internal::MetricsProcess::create(readonlyAuthenticationRealm),
       true);
 
+  metrics::add(process_manager->resume_quantum_expirations);
+
+  metrics::add(Pipeline::stalls);
+
+  metrics::add(metrics::Gauge(
+      "libprocess/http_pipelined_requests",
+      []() -> Future<double> {
+        return static_cast<double>(Pipeline::total.load());
+      }));
+
+  // Add metrics for the latencies of all processes (see
+  // `Latencies::Totals`). Note that the event queue depth only counts
+  // the events of the running processes.
+  Latencies::Totals& totals = Latencies::totals();
+
+  metrics::add(metrics::Gauge(
+      "libprocess/event_queue_depth",
+      [&totals]() -> Future<double> {
+        return static_cast<double>(
+            std::max<int64_t>(0, totals.depth.load()));
+      }));
+
+  const vector<pair<string, const LatencyHistogram*>> latencies = {
+    {"libprocess/event_queueing_delay_us", &totals.queueing},
+    {"libprocess/run_queue_delay_us", &totals.runQueue},
+    {"libprocess/event_handler_time_us", &totals.handlers}};
+
+  foreach (const auto& latency, latencies) {
+    const string& name = latency.first;
+    const LatencyHistogram* histogram = latency.second;
+
+    metrics::add(metrics::Gauge(
+        name + "/count",
+        [histogram]() -> Future<double> {
+          return static_cast<double>(histogram->snapshot().count);
+        }));
+
+    metrics::add(metrics::Gauge(
+        name + "/max",
+        [histogram]() -> Future<double> {
+          const LatencyHistogram::Snapshot snapshot = histogram->snapshot();
+
+          if (snapshot.count == 0) {
+            return Failure("No value");
+          }
+
+          return static_cast<double>(snapshot.max);
+        }));
+
+    foreach (int percentile, vector<int>({50, 90, 99})) {
+      metrics::add(metrics::Gauge(
+          name + "/p" + stringify(percentile),
+          [histogram, percentile]() -> Future<double> {
+            const LatencyHistogram::Snapshot snapshot = histogram->snapshot();
+
+            if (snapshot.count == 0) {
+              return Failure("No value");
+            }
+
+            return static_cast<double>(snapshot.percentile(percentile));
+          }));
+    }
+  }
+
   // Create the global logging process.
   _logging = spawn(new Logging(readwriteAuthenticationRealm), true);
 
@@ -1380,6 +1721,12 @@ bool initialize(
 
   processes_route = new Route("/__processes__", None(), __processes__);
 
+  // Add a route for getting the latencies of the processes.
+  lambda::function<Future<Response>(const Request&)> __latencies__ =
+    lambda::bind(&ProcessManager::__latencies__, process_manager, lambda::_1);
+
+  latencies_route = new Route("/__latencies__", None(), __latencies__);
+
   VLOG(1) << "libprocess is initialized on " << address() << " with "
           << num_worker_threads << " worker threads";
 
@@ -1400,10 +1747,13 @@ void finalize(bool finalize_wsa)
   // waits during clean up, so we make sure the clock is running normally.
   Clock::resume();
 
-  // This will terminate the underlying process for the `Route`.
+  // This will terminate the underlying processes for the `Route`s.
   delete processes_route;
   processes_route = nullptr;
 
+  delete latencies_route;
+  latencies_route = nullptr;
+
   // Close the server socket.
   // This will prevent any further connections managed by the `SocketManager`.
   synchronized (socket_mutex) {
@@ -1506,6 +1856,7 @@ long workers()
 
 HttpProxy::HttpProxy(const Socket& _socket)
   : ProcessBase(ID::generate("__http__")),
+    pipeline(new Pipeline(libprocess_flags->max_pipelined_requests)),
     socket(_socket) {}
 
 
@@ -1542,6 +1893,8 @@ void HttpProxy::finalize()
     delete item;
   }
 
+  pipeline->close();
+
   // Just in case this process gets killed outside of `SocketManager::close`,
   // remove the proxy from the socket.
   socket_manager->unproxy(socket);
@@ -1558,6 +1911,8 @@ void HttpProxy::handle(const Future<Response>& future, const Request& request)
 {
   items.push(new Item(request, future));
 
+  pipeline->requested();
+
   if (items.size() == 1) {
     next();
   }
@@ -1566,6 +1921,29 @@ void HttpProxy::handle(const Future<Response>& future, const Request& request)
 
 void HttpProxy::next()
 {
+  // The next response gets processed once we're done streaming.
+  if (pipe.isSome()) {
+    return;
+  }
+
+  // Process the responses which are already available right away
+  // rather than waiting on (i.e., dispatching to ourselves for) each
+  // of them, e.g., all of the responses to libprocess messages.
+  while (items.size() > 0 && !items.front()->future.isPending()) {
+    Item* item = items.front();
+
+    bool processed = process(item->future, item->request);
+
+    items.pop();
+    delete item;
+
+    pipeline->responded();
+
+    if (!processed) {
+      return;
+    }
+  }
+
   if (items.size() > 0) {
     // Wait for any transition of the future.
     items.front()->future.onAny(
@@ -1588,6 +1966,8 @@ void HttpProxy::waited(const Future<Response>& future)
   items.pop();
   delete item;
 
+  pipeline->responded();
+
   if (processed) {
     next();
   }
@@ -2130,6 +2510,19 @@ PID<HttpProxy> SocketManager::proxy(const Socket& socket)
 }
 
 
+Option<std::shared_ptr<Pipeline>> SocketManager::pipeline(
+    const Socket& socket)
+{
+  synchronized (mutex) {
+    if (proxies.count(socket) > 0) {
+      return proxies[socket]->pipeline;
+    }
+  }
+
+  return None();
+}
+
+
 void SocketManager::unproxy(const Socket& socket)
 {
   synchronized (mutex) {
@@ -2157,9 +2550,11 @@ void send(Encoder* encoder, Socket socket)
 {
   switch (encoder->kind()) {
     case Encoder::DATA: {
-      size_t size;
-      const char* data = static_cast<DataEncoder*>(encoder)->next(&size);
-      socket.send(data, size)
+      // Send all of the remaining buffers at once (e.g., the headers
+      // and the body of a message) to avoid copying them together.
+      vector<pair<const char*, size_t>> buffers;
+      size_t size = static_cast<DataEncoder*>(encoder)->next(&buffers);
+      socket.send(buffers)
         .onAny(lambda::bind(
             &internal::_send,
             lambda::_1,
@@ -2330,7 +2725,7 @@ void SocketManager::send_connect(
     return;
   }
 
-  Encoder* encoder = new MessageEncoder(message);
+  Encoder* encoder = new MessageEncoder(std::move(message));
 
   // Receive and ignore data from this socket. Note that we don't
   // expect to receive anything other than HTTP '202 Accepted'
@@ -2373,7 +2768,7 @@ void SocketManager::send(Message&& message, const SocketImpl::Kind& kind)
       }
 
       if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(message));
+        outgoing[socket.get()].push(new MessageEncoder(std::move(message)));
         return;
       } else {
         // Initialize the outgoing queue.
@@ -2421,7 +2816,7 @@ void SocketManager::send(Message&& message, const SocketImpl::Kind& kind)
   } else {
     // If we're not connecting and we haven't added the encoder to
     // the 'outgoing' queue then schedule it to be sent.
-    internal::send(new MessageEncoder(message), socket.get());
+    internal::send(new MessageEncoder(std::move(message)), socket.get());
   }
 }
 
@@ -2786,21 +3181,29 @@ void ProcessManager::finalize()
     // and the calls to `process:terminate` and `process::wait`.
     // If the process has already terminated, further termination
     // is a noop.
-    UPID pid;
+    Option<UPID> pid = None();
 
-    synchronized (processes_mutex) {
-      if (processes.empty()) {
+    foreach (ProcessesShard& shard, processes) {
+      synchronized (shard.mutex) {
+        if (!shard.processes.empty()) {
+          // Grab the `UPID` for the next process we'll terminate.
+          pid = shard.processes.values().front()->self();
+        }
+      }
+
+      if (pid.isSome()) {
         break;
       }
+    }
 
-      // Grab the `UPID` for the next process we'll terminate.
-      pid = processes.values().front()->self();
+    if (pid.isNone()) {
+      break;
     }
 
     // Terminate this process but do not inject the message,
     // i.e. allow it to finish its work first.
-    process::terminate(pid, false);
-    process::wait(pid);
+    process::terminate(pid.get(), false);
+    process::wait(pid.get());
   }
 
   // Send signal to all processing threads to stop running.
@@ -2890,7 +3293,8 @@ long ProcessManager::init_threads()
         }));
   }
 
-  // Create a thread for the event loop.
+  // Create a thread for the event loops (which creates a thread for
+  // every additional event loop).
   threads.emplace_back(new std::thread(&EventLoop::run));
 
   return num_worker_threads;
@@ -2906,8 +3310,10 @@ ProcessReference ProcessManager::use(const UPID& pid)
   }
 
   if (pid.address == __address__) {
-    synchronized (processes_mutex) {
-      Option<ProcessBase*> process = processes.get(pid.id);
+    ProcessesShard& shard = this->shard(pid.id);
+
+    synchronized (shard.mutex) {
+      Option<ProcessBase*> process = shard.processes.get(pid.id);
       if (process.isSome()) {
         return ProcessReference(process.get()->reference);
       }
@@ -2970,56 +3376,9 @@ void ProcessManager::handle(
           return;
         }
 
-        MessageEvent* event = CHECK_NOTNULL(future.get());
-
-        // Verify that the UPID this peer is claiming is on the same IP
-        // address the peer is sending from.
-        if (libprocess_flags->require_peer_address_ip_match) {
-          CHECK_SOME(request->client);
-
-          // If the client address is not an IP address (e.g. coming
-          // from a domain socket), we also reject the message.
-          Try<Address> client_ip_address =
-            network::convert<Address>(request->client.get());
-
-          if (client_ip_address.isError() ||
-              event->message.from.address.ip != client_ip_address->ip) {
-            Response response = BadRequest(
-                "UPID IP address validation failed: Message from " +
-                stringify(event->message.from) + " was sent from IP " +
-                stringify(request->client.get()));
-
-            dispatch(proxy, &HttpProxy::enqueue, response, *request);
-
-            VLOG(1) << "Returning '" << response.status << "'"
-                    << " for '" << request->url.path << "'"
-                    << ": " << response.body;
-
-            delete request;
-            delete event;
-            return;
-          }
-        }
-
-        // TODO(benh): Use the sender PID when delivering in order to
-        // capture happens-before timing relationships for testing.
-        bool accepted = deliver(event->message.to, event);
-
-        // NOTE: prior to commit d5fe51c on April 11, 2014 we needed
-        // to ignore sending responses in the event the receiver was a
-        // version of libprocess that didn't properly ignore
-        // responses. Now we always send a response.
-        if (accepted) {
-          VLOG(2) << "Delivered libprocess message to " << request->url.path;
-          dispatch(proxy, &HttpProxy::enqueue, Accepted(), *request);
-        } else {
-          VLOG(1) << "Failed to deliver libprocess message to "
-                  << request->url.path;
-          dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
-        }
+        handle(socket, CHECK_NOTNULL(future.get()), *request);
 
         delete request;
-        return;
       });
 
     return;
@@ -3130,6 +3489,63 @@ void ProcessManager::handle(
 }
 
 
+void ProcessManager::handle(
+    const Socket& socket,
+    MessageEvent* event,
+    const Request& request)
+{
+  CHECK(event != nullptr);
+
+  // Get the HttpProxy pid for this socket.
+  PID<HttpProxy> proxy = socket_manager->proxy(socket);
+
+  // Verify that the UPID this peer is claiming is on the same IP
+  // address the peer is sending from.
+  if (libprocess_flags->require_peer_address_ip_match) {
+    CHECK_SOME(request.client);
+
+    // If the client address is not an IP address (e.g. coming
+    // from a domain socket), we also reject the message.
+    Try<Address> client_ip_address =
+      network::convert<Address>(request.client.get());
+
+    if (client_ip_address.isError() ||
+        event->message.from.address.ip != client_ip_address->ip) {
+      Response response = BadRequest(
+          "UPID IP address validation failed: Message from " +
+          stringify(event->message.from) + " was sent from IP " +
+          stringify(request.client.get()));
+
+      dispatch(proxy, &HttpProxy::enqueue, response, request);
+
+      VLOG(1) << "Returning '" << response.status << "'"
+              << " for '" << request.url.path << "'"
+              << ": " << response.body;
+
+      delete event;
+      return;
+    }
+  }
+
+  // TODO(benh): Use the sender PID when delivering in order to
+  // capture happens-before timing relationships for testing.
+  bool accepted = deliver(event->message.to, event);
+
+  // NOTE: prior to commit d5fe51c on April 11, 2014 we needed
+  // to ignore sending responses in the event the receiver was a
+  // version of libprocess that didn't properly ignore
+  // responses. Now we always send a response.
+  if (accepted) {
+    VLOG(2) << "Delivered libprocess message to " << request.url.path;
+    dispatch(proxy, &HttpProxy::enqueue, Accepted(), request);
+  } else {
+    VLOG(1) << "Failed to deliver libprocess message to "
+            << request.url.path;
+    dispatch(proxy, &HttpProxy::enqueue, NotFound(), request);
+  }
+}
+
+
 bool ProcessManager::deliver(
     ProcessBase* receiver,
     Event* event,
@@ -3189,12 +3605,14 @@ UPID ProcessManager::spawn(ProcessBase* process, bool manage)
       << "Attempted to spawn a process (" << process->self()
       << ") that has already been initialized";
   } else {
-    synchronized (processes_mutex) {
-      if (processes.count(process->pid.id) > 0) {
+    ProcessesShard& shard = this->shard(process->pid.id);
+
+    synchronized (shard.mutex) {
+      if (shard.processes.count(process->pid.id) > 0) {
         LOG(WARNING)
           << "Attempted to spawn already running process " << process->pid;
       } else {
-        processes[process->pid.id] = process;
+        shard.processes[process->pid.id] = process;
 
         // NOTE: we set process reference on it's `UPID` _after_ we've
         // spawned so that we make sure that we'll take the
@@ -3244,9 +3662,27 @@ void ProcessManager::resume(ProcessBase* process)
 
   VLOG(2) << "Resuming " << process->pid << " at " << Clock::now();
 
+  process->latencies->resumed();
+
   bool terminate = false;
   bool blocked = false;
 
+  // Whether the process used up its quantum and needs to be put back
+  // on the run queue once we are done with it.
+  bool yield = false;
+
+  // NOTE: the flags are only ever reset after all worker threads
+  // have been joined, see `finalize`.
+  const Option<size_t> quantumEvents = libprocess_flags->resume_quantum_events;
+  const Option<Duration> quantumDuration =
+    libprocess_flags->resume_quantum_duration;
+
+  size_t served = 0;
+  Stopwatch stopwatch;
+  if (quantumDuration.isSome()) {
+    stopwatch.start();
+  }
+
   ProcessBase::State state = process->state.load();
 
   CHECK(state == ProcessBase::State::BOTTOM ||
@@ -3261,14 +3697,32 @@ void ProcessManager::resume(ProcessBase* process)
   }
 
   while (!terminate && !blocked) {
+    // Check if this process has used up its quantum, in which case we
+    // yield to other processes if there are more events to serve.
+    // Because the process stays READY nobody else will enqueue it
+    // onto the run queue, which is why we do it ourselves below.
+    if (served > 0 &&
+        ((quantumEvents.isSome() && served >= quantumEvents.get()) ||
+         (quantumDuration.isSome() &&
+          stopwatch.elapsed() >= quantumDuration.get())) &&
+        !process->events->consumer.empty()) {
+      yield = true;
+      break;
+    }
+
     Event* event = nullptr;
 
     // NOTE: the event queue requires only a _single_ consumer at a
     // time ... this is where we act as that single consumer (and down
     // in `ProcessManager::cleanup` which we call from here).
 
+    // Time at which the event was dequeued, used to measure how long
+    // it took to serve it.
+    std::chrono::steady_clock::time_point dequeued;
+
     if (!process->events->consumer.empty()) {
       event = process->events->consumer.dequeue();
+      dequeued = process->latencies->dequeued(*event);
     } else {
       state = ProcessBase::State::BLOCKED;
       process->state.store(state);
@@ -3309,6 +3763,7 @@ void ProcessManager::resume(ProcessBase* process)
           delete event;
           event = process->events->consumer.dequeue();
           CHECK_NOTNULL(event);
+          dequeued = process->latencies->dequeued(*event);
         }
       }
 
@@ -3353,7 +3808,11 @@ void ProcessManager::resume(ProcessBase* process)
         terminate = true;
       }
 
+      process->latencies->served(*event, dequeued);
+
       delete event;
+
+      served++;
     }
   }
 
@@ -3375,6 +3834,17 @@ void ProcessManager::resume(ProcessBase* process)
   if (terminate && manage) {
     delete process;
   }
+
+  // NOTE: another worker thread might resume `process` as soon as we
+  // enqueue it so we must not use it after this point!
+  if (yield) {
+    ++resume_quantum_expirations;
+
+    VLOG(2) << "Yielding " << process->pid << " after serving "
+            << served << " events";
+
+    enqueue(process);
+  }
 }
 
 
@@ -3389,9 +3859,10 @@ void ProcessManager::cleanup(ProcessBase* process)
   // First, set the terminating state so no more events will get
   // enqueued and then decomission the event queue which will also
   // delete all the pending events. We want to delete the events
-  // before we hold `processes_mutex` because deleting an event could
-  // cause code outside libprocess to get executed which might cause a
-  // deadlock with `processes_mutex`. Also, deleting the events now
+  // before we hold the mutex of the shard of this process because
+  // deleting an event could cause code outside libprocess to get
+  // executed which might cause a deadlock with that mutex (or with
+  // the mutex of another shard). Also, deleting the events now
   // rather than later has the nice property of making sure that any
   // _new_ events that might have gotten enqueued _BACK_ onto this
   // process due to the deleting of the pending events will get
@@ -3409,11 +3880,13 @@ void ProcessManager::cleanup(ProcessBase* process)
   std::shared_ptr<Gate> gate = process->gate;
 
   // Remove process.
-  synchronized (processes_mutex) {
+  ProcessesShard& shard = this->shard(process->pid.id);
+
+  synchronized (shard.mutex) {
     // Reset the reference so that we don't keep giving out references
     // in `ProcessManager::use`.
     //
-    // NOTE: this must be done from within the `processes_mutex` since
+    // NOTE: this must be done from within the mutex of the shard since
     // that is where we read it and this is considered a write.
     process->reference.reset();
 
@@ -3425,7 +3898,7 @@ void ProcessManager::cleanup(ProcessBase* process)
 #endif
     }
 
-    processes.erase(process->pid.id);
+    shard.processes.erase(process->pid.id);
 
     // Note that we don't remove the process from the clock during
     // cleanup, but rather the clock is reset for a process when it is
@@ -3458,7 +3931,7 @@ void ProcessManager::cleanup(ProcessBase* process)
     // ***************************************************************
 
     // Note that we need to open the gate within `synchronized
-    // (processes_mutex)` so that there is a happens-before
+    // (shard.mutex)` so that there is a happens-before
     // relationship with respect to a process terminating and another
     // process starting with the same `UPID`.
     CHECK(gate);
@@ -3611,7 +4084,14 @@ string ProcessManager::absolutePath(const string& path)
     return path;
   }
 
-  if (processes.find(decode.get()) != processes.end()) {
+  ProcessesShard& shard = this->shard(decode.get());
+
+  bool process = false;
+  synchronized (shard.mutex) {
+    process = shard.processes.contains(decode.get());
+  }
+
+  if (process) {
     // Return path when the first token is a process id.
     return path;
   } else {
@@ -3638,6 +4118,8 @@ void ProcessManager::enqueue(ProcessBase* process)
   // it's not running. Otherwise, check and see which thread this
   // process was last running on, and put it on that threads runq.
 
+  process->latencies->scheduled();
+
   runq.enqueue(process);
 }
 
@@ -3732,31 +4214,72 @@ void ProcessManager::settle()
 
 Future<Response> ProcessManager::__processes__(const Request&)
 {
-  synchronized (processes_mutex) {
-    return collect(lambda::map(
-        [](ProcessBase* process) {
-          // TODO(benh): Try and "inject" this dispatch or create a
-          // high-priority set of events (i.e., mailbox).
-          return dispatch(
-              process->self(),
-              [process]() -> JSON::Object {
-                return *process;
-              });
-        },
-        process_manager->processes.values()))
-      .then([](const std::list<JSON::Object>& objects) -> Response {
-        JSON::Array array;
-        foreach (const JSON::Object& object, objects) {
-          array.values.push_back(object);
-        }
-        return OK(array);
+  list<Future<JSON::Object>> futures;
+
+  foreach (ProcessesShard& shard, process_manager->processes) {
+    synchronized (shard.mutex) {
+      foreachvalue (ProcessBase* process, shard.processes) {
+        // TODO(benh): Try and "inject" this dispatch or create a
+        // high-priority set of events (i.e., mailbox).
+        futures.push_back(dispatch(
+            process->self(),
+            [process]() -> JSON::Object {
+              return *process;
+            }));
+      }
+    }
+  }
+
+  return collect(futures)
+    .then([](const std::list<JSON::Object>& objects) -> Response {
+      JSON::Array array;
+      foreach (const JSON::Object& object, objects) {
+        array.values.push_back(object);
+      }
+      return OK(array);
+    });
+}
+
+
+Future<Response> ProcessManager::__latencies__(const Request&)
+{
+  // The latencies of each process along with the total time spent in
+  // its handlers, so that the busiest processes can be listed first.
+  vector<pair<uint64_t, JSON::Object>> objects;
+
+  foreach (ProcessesShard& shard, processes) {
+    synchronized (shard.mutex) {
+      foreachvalue (ProcessBase* process, shard.processes) {
+        JSON::Object object = *process->latencies;
+        object.values["id"] = (const string&) process->pid.id;
+
+        objects.emplace_back(
+            process->latencies->handlersSnapshot().total,
+            std::move(object));
+      }
+    }
+  }
+
+  std::stable_sort(
+      objects.begin(),
+      objects.end(),
+      [](const pair<uint64_t, JSON::Object>& left,
+         const pair<uint64_t, JSON::Object>& right) {
+        return left.first > right.first;
       });
+
+  JSON::Array array;
+  foreach (const auto& object, objects) {
+    array.values.push_back(object.second);
   }
+
+  return OK(array);
 }
 
 
 ProcessBase::ProcessBase(const string& id)
   : events(new EventQueue()),
+    latencies(new Latencies()),
     reference(std::make_shared<ProcessBase*>(this)),
     gate(std::make_shared<Gate>())
 {
@@ -3839,6 +4362,7 @@ void ProcessBase::enqueue(Event* event)
     case State::BOTTOM:
     case State::READY:
     case State::BLOCKED:
+      latencies->enqueued(event);
       events->producer.enqueue(event);
       break;
     case State::TERMINATING:
@@ -3920,7 +4444,7 @@ void ProcessBase::visit(const MessageEvent& event)
 
 void ProcessBase::visit(const DispatchEvent& event)
 {
-  (*event.f)(this);
+  event(this);
 }
 
 
@@ -4342,15 +4866,160 @@ bool exited(const UPID& from, const UPID& to)
 
 namespace internal {
 
-void dispatch(
-    const UPID& pid,
-    const std::shared_ptr<lambda::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType)
+// Per thread free lists of memory blocks for dispatch events (see
+// `DispatchEvent::operator new`). The blocks are bucketed by their
+// size rounded up to a multiple of `GRANULARITY` and dispatch events
+// larger than `GRANULARITY * BUCKETS` are not recycled.
+//
+// Dispatch events are usually allocated by one thread and deleted by
+// another thread, so every free list is bounded by `CAPACITY` to keep
+// the threads that mostly delete dispatch events from accumulating
+// memory.
+//
+// NOTE: all of the state is trivially destructible so that it stays
+// valid while other thread local objects get destroyed; the blocks
+// themselves get freed by `DispatchEventReclaimer` below.
+struct DispatchEventFreeLists
+{
+  static constexpr size_t GRANULARITY = 64;
+  static constexpr size_t BUCKETS = 8;
+  static constexpr size_t CAPACITY = 256;
+
+  struct Block
+  {
+    Block* next;
+  };
+
+  Block* heads[BUCKETS];
+  size_t sizes[BUCKETS];
+
+  // Whether or not this thread is exiting, in which case blocks are
+  // no longer cached.
+  bool exiting;
+};
+
+
+thread_local DispatchEventFreeLists dispatch_event_free_lists = {};
+
+
+// Frees all of the cached blocks of a thread when the thread exits.
+struct DispatchEventReclaimer
+{
+  ~DispatchEventReclaimer()
+  {
+    DispatchEventFreeLists& lists = dispatch_event_free_lists;
+
+    lists.exiting = true;
+
+    for (size_t bucket = 0; bucket < DispatchEventFreeLists::BUCKETS;
+         bucket++) {
+      while (lists.heads[bucket] != nullptr) {
+        DispatchEventFreeLists::Block* block = lists.heads[bucket];
+        lists.heads[bucket] = block->next;
+        ::operator delete(block);
+      }
+      lists.sizes[bucket] = 0;
+    }
+  }
+};
+
+} // namespace internal {
+
+
+void* DispatchEvent::operator new(size_t size)
+{
+  using internal::DispatchEventFreeLists;
+
+  const size_t bucket = (size - 1) / DispatchEventFreeLists::GRANULARITY;
+
+  if (bucket >= DispatchEventFreeLists::BUCKETS) {
+    return ::operator new(size);
+  }
+
+  DispatchEventFreeLists& lists = internal::dispatch_event_free_lists;
+
+  if (lists.heads[bucket] != nullptr) {
+    DispatchEventFreeLists::Block* block = lists.heads[bucket];
+    lists.heads[bucket] = block->next;
+    lists.sizes[bucket]--;
+    return block;
+  }
+
+  // Always allocate the full size of the bucket so that the block can
+  // be reused for any dispatch event of the same bucket.
+  return ::operator new((bucket + 1) * DispatchEventFreeLists::GRANULARITY);
+}
+
+
+void DispatchEvent::operator delete(void* pointer, size_t size)
+{
+  using internal::DispatchEventFreeLists;
+
+  if (pointer == nullptr) {
+    return;
+  }
+
+  const size_t bucket = (size - 1) / DispatchEventFreeLists::GRANULARITY;
+
+  DispatchEventFreeLists& lists = internal::dispatch_event_free_lists;
+
+  if (bucket >= DispatchEventFreeLists::BUCKETS ||
+      lists.exiting ||
+      lists.sizes[bucket] >= DispatchEventFreeLists::CAPACITY) {
+    ::operator delete(pointer);
+    return;
+  }
+
+  // Make sure the cached blocks get freed when this thread exits.
+  static thread_local internal::DispatchEventReclaimer reclaimer;
+  (void) reclaimer;
+
+  DispatchEventFreeLists::Block* block =
+    static_cast<DispatchEventFreeLists::Block*>(pointer);
+
+  block->next = lists.heads[bucket];
+  lists.heads[bucket] = block;
+  lists.sizes[bucket]++;
+}
+
+
+namespace internal {
+
+void dispatch(DispatchEvent* event)
 {
   process::initialize();
 
-  DispatchEvent* event = new DispatchEvent(pid, f, functionType);
-  process_manager->deliver(pid, event, __process__);
+  process_manager->deliver(event->pid, event, __process__);
+}
+
+
+const string* intern(const std::type_info& type, const char* bits, size_t size)
+{
+  // NOTE: these are never deleted since the names are referenced by
+  // the dispatch events (and the latencies of the processes).
+  static std::mutex* mutex = new std::mutex();
+  static hashmap<string, string>* names = new hashmap<string, string>();
+
+  string key = type.name();
+  key.append(bits, size);
+
+  synchronized (mutex) {
+    auto iterator = names->find(key);
+    if (iterator != names->end()) {
+      return &iterator->second;
+    }
+
+    // The name of a method is its (implementation specific) type name
+    // along with the leading word of the pointer, which for a
+    // non-virtual method is usually the address of the function and
+    // can therefore be resolved to a symbol.
+    const void* address = nullptr;
+    memcpy(&address, bits, std::min(size, sizeof(address)));
+
+    string& name = (*names)[key];
+    name = string(type.name()) + "@" + stringify(address);
+    return &name;
+  }
 }
 
 } // namespace internal {
@@ -20,7 +20,13 @@
 //      -DENABLE_LOCK_FREE_RUN_QUEUE (cmake) which enables the
 //      lock-free run queue implementation (see below for more details).
 //
-//  (2) --enable-last-in-first-out-fixed-size-semaphore (autotools) or
+//  (2) --enable-work-stealing-run-queue (autotools) or
+//      -DENABLE_WORK_STEALING_RUN_QUEUE (cmake) which enables a run
+//      queue with a local queue per worker thread and work stealing
+//      between worker threads (see below for more details). This
+//      can not be combined with (1).
+//
+//  (3) --enable-last-in-first-out-fixed-size-semaphore (autotools) or
 //      -DENABLE_LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE (cmake) which
 //      enables an optimized semaphore implementation (see semaphore.hpp
 //      for more details).
@@ -32,22 +38,32 @@
 // _runtime_ decisions because we wanted the run queue implementation
 // to be compile-time optimized (e.g., inlined, etc).
 
+#if defined(LOCK_FREE_RUN_QUEUE) && defined(WORK_STEALING_RUN_QUEUE)
+#error "The lock-free and the work stealing run queues are exclusive"
+#endif // LOCK_FREE_RUN_QUEUE && WORK_STEALING_RUN_QUEUE
+
 #ifdef LOCK_FREE_RUN_QUEUE
 #include <concurrentqueue.h>
 #endif // LOCK_FREE_RUN_QUEUE
 
 #include <algorithm>
+#include <array>
+#include <deque>
 #include <list>
+#include <memory>
+
+#include <glog/logging.h>
 
 #include <process/process.hpp>
 
 #include <stout/synchronized.hpp>
+#include <stout/unreachable.hpp>
 
 #include "semaphore.hpp"
 
 namespace process {
 
-#ifndef LOCK_FREE_RUN_QUEUE
+#if !defined(LOCK_FREE_RUN_QUEUE) && !defined(WORK_STEALING_RUN_QUEUE)
 class RunQueue
 {
 public:
@@ -130,7 +146,7 @@ private:
 #endif // LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
 };
 
-#else // LOCK_FREE_RUN_QUEUE
+#elif defined(LOCK_FREE_RUN_QUEUE)
 
 class RunQueue
 {
@@ -199,7 +215,222 @@ private:
 #endif // LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
 };
 
-#endif // LOCK_FREE_RUN_QUEUE
+#else // WORK_STEALING_RUN_QUEUE
+
+// A run queue where every worker thread owns a local queue of
+// runnable processes and idle worker threads steal processes from
+// the local queues of busy worker threads.
+//
+// A process is enqueued on the local queue of the worker thread that
+// last ran it (see `ProcessBase::affinity`) so that it tends to run
+// on the same core again. A process without an affinity is enqueued
+// on the local queue of the enqueuing worker thread, or on a shared
+// queue when enqueued from outside of a worker thread (e.g., from the
+// event loop or before any worker thread has started).
+//
+// Worker threads enroll lazily the first time they call `dequeue`.
+// A worker thread first looks in its own local queue, then in the
+// shared queue and finally tries to steal from the other worker
+// threads.
+//
+// Like the lock-free run queue every call to `enqueue` signals the
+// semaphore exactly once, so a worker thread returning from `wait`
+// is guaranteed to find a process in _some_ queue eventually.
+class RunQueue
+{
+public:
+  bool extract(ProcessBase*)
+  {
+    // NOTE: extracting a process would break the invariant that
+    // every unit of the semaphore corresponds to an enqueued process
+    // (see `dequeue`) so, like the lock-free run queue, we do not
+    // support it.
+    return false;
+  }
+
+  void wait()
+  {
+    semaphore.wait();
+  }
+
+  void enqueue(ProcessBase* process)
+  {
+    const size_t size = enrolled.load(std::memory_order_acquire);
+
+    int index = process->affinity.load(std::memory_order_relaxed);
+    if (index < 0 || (size_t) index >= size) {
+      index = worker();
+    }
+
+    Queue* queue = index < 0 ? &shared : queues[index].get();
+
+    synchronized (queue->mutex) {
+      queue->processes.push_back(process);
+    }
+
+    epoch.fetch_add(1);
+    semaphore.signal();
+  }
+
+  // Precondition: `wait` must get called before `dequeue`!
+  ProcessBase* dequeue()
+  {
+    if (worker() < 0) {
+      worker() = enroll();
+    }
+
+    const int index = worker();
+
+    // NOTE: we loop _forever_ until we actually dequeue a process
+    // because the contract for using the run queue is that `wait`
+    // must be called first so we know that there is something to be
+    // dequeued or the run queue has been decommissioned and we should
+    // just return `nullptr`. We might not find the process on the
+    // first pass because another worker thread may have taken the
+    // process that was enqueued for us while a process it was woken
+    // up for is still being enqueued.
+    do {
+      ProcessBase* process = pop(queues[index].get());
+
+      if (process == nullptr) {
+        process = pop(&shared);
+      }
+
+      if (process == nullptr) {
+        process = steal(index);
+      }
+
+      if (process != nullptr) {
+        process->affinity.store(index, std::memory_order_relaxed);
+        return process;
+      }
+    } while (!semaphore.decomissioned());
+
+    return nullptr;
+  }
+
+  // NOTE: this function can't be const because `synchronized (mutex)`
+  // is not const ...
+  bool empty()
+  {
+    synchronized (shared.mutex) {
+      if (!shared.processes.empty()) {
+        return false;
+      }
+    }
+
+    const size_t size = enrolled.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < size; i++) {
+      synchronized (queues[i]->mutex) {
+        if (!queues[i]->processes.empty()) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  void decomission()
+  {
+    semaphore.decomission();
+  }
+
+  size_t capacity() const
+  {
+    return std::min(semaphore.capacity(), queues.size());
+  }
+
+  // Epoch used to capture changes to the run queue when settling.
+  std::atomic_long epoch = ATOMIC_VAR_INIT(0L);
+
+private:
+  struct Queue
+  {
+    std::deque<ProcessBase*> processes;
+    std::mutex mutex;
+  };
+
+  // Returns the index of the local queue of the calling worker
+  // thread or -1 if the calling thread is not an (enrolled) worker
+  // thread.
+  static int& worker()
+  {
+    static thread_local int index = -1;
+    return index;
+  }
+
+  int enroll()
+  {
+    synchronized (enroll_mutex) {
+      const size_t index = enrolled.load();
+
+      CHECK(index < queues.size())
+        << "Number of worker threads can not exceed " << queues.size();
+
+      queues[index].reset(new Queue());
+      enrolled.store(index + 1, std::memory_order_release);
+
+      return static_cast<int>(index);
+    }
+
+    UNREACHABLE();
+  }
+
+  // The owner of a queue runs processes in the order they were
+  // enqueued.
+  static ProcessBase* pop(Queue* queue)
+  {
+    synchronized (queue->mutex) {
+      if (!queue->processes.empty()) {
+        ProcessBase* process = queue->processes.front();
+        queue->processes.pop_front();
+        return process;
+      }
+    }
+
+    return nullptr;
+  }
+
+  // Thieves take the most recently enqueued process so that the
+  // owner keeps the processes it is about to run.
+  ProcessBase* steal(int index)
+  {
+    const size_t size = enrolled.load(std::memory_order_acquire);
+
+    for (size_t i = 1; i < size; i++) {
+      Queue* victim = queues[(index + i) % size].get();
+
+      synchronized (victim->mutex) {
+        if (!victim->processes.empty()) {
+          ProcessBase* process = victim->processes.back();
+          victim->processes.pop_back();
+          return process;
+        }
+      }
+    }
+
+    return nullptr;
+  }
+
+  // Local queues, one per enrolled worker thread. The bound matches
+  // the maximum of `LIBPROCESS_NUM_WORKER_THREADS`.
+  std::array<std::unique_ptr<Queue>, 1024> queues;
+  std::atomic<size_t> enrolled = ATOMIC_VAR_INIT(0);
+  std::mutex enroll_mutex;
+
+  // Queue for processes enqueued from outside of a worker thread.
+  Queue shared;
+
+#ifndef LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
+  DecomissionableKernelSemaphore semaphore;
+#else
+  DecomissionableLastInFirstOutFixedSizeSemaphore semaphore;
+#endif // LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
+};
+
+#endif // WORK_STEALING_RUN_QUEUE
 
 } // namespace process {
 
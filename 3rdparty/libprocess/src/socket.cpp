@@ -12,6 +12,8 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/shared_array.hpp>
 
@@ -21,6 +23,7 @@
 
 #include <process/ssl/flags.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/os.hpp>
 #include <stout/unreachable.hpp>
 
@@ -29,7 +32,9 @@
 #endif
 #include "poll_socket.hpp"
 
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace process {
 namespace network {
@@ -241,6 +246,19 @@ Future<Nothing> SocketImpl::send(const string& _data)
     .then(lambda::bind(&_send, shared_from_this(), data, 0, lambda::_1));
 }
 
+
+Future<size_t> SocketImpl::send(
+    const vector<pair<const char*, size_t>>& buffers)
+{
+  foreach (const auto& buffer, buffers) {
+    if (buffer.second > 0) {
+      return send(buffer.first, buffer.second);
+    }
+  }
+
+  return 0;
+}
+
 } // namespace internal {
 } // namespace network {
 } // namespace process {
@@ -0,0 +1,248 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The benchmarks counting heap allocations. They are kept in their
+// own binary since they replace the global `operator new`, which
+// would otherwise change the allocator used by all other benchmarks.
+
+#include <gtest/gtest.h>
+
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/gmock.hpp>
+#include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/process.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
+
+#include "decoder.hpp"
+#include "encoder.hpp"
+
+using process::Future;
+using process::Message;
+using process::MessageEncoder;
+using process::Process;
+using process::StreamingRequestDecoder;
+using process::UPID;
+
+using std::cout;
+using std::deque;
+using std::endl;
+using std::string;
+
+// Number of heap allocations made by the current thread while
+// `count_allocations` is true, see `operator new` below.
+static thread_local bool count_allocations = false;
+static thread_local long allocations = 0;
+
+
+// Replaces the global `operator new` (and `operator delete`) in order
+// to count the allocations of the benchmarks below. All other forms of
+// `operator new` and `operator delete` forward to these.
+void* operator new(size_t size)
+{
+  if (count_allocations) {
+    allocations++;
+  }
+
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return pointer;
+}
+
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+
+int main(int argc, char** argv)
+{
+  // Initialize Google Mock/Test.
+  testing::InitGoogleMock(&argc, argv);
+
+  // Add the libprocess test event listeners.
+  ::testing::TestEventListeners& listeners =
+    ::testing::UnitTest::GetInstance()->listeners();
+
+  listeners.Append(process::ClockTestEventListener::instance());
+  listeners.Append(process::FilterTestEventListener::instance());
+
+  int result = RUN_ALL_TESTS();
+
+  process::finalize(true);
+  return result;
+}
+
+
+class AllocationProcess : public Process<AllocationProcess>
+{
+public:
+  void handle(long)
+  {
+    count++;
+  }
+
+  long compute(long value)
+  {
+    count++;
+    return value;
+  }
+
+  Future<long> _compute(long value)
+  {
+    count++;
+    return value;
+  }
+
+  long count = 0;
+};
+
+
+// Reports the number of heap allocations made by the dispatching
+// thread per `dispatch`, for methods returning `void`, a value and a
+// future. Note that allocations made by the process while serving the
+// dispatch (e.g., to delete the dispatch event) are not counted.
+TEST(ProcessTest, Process_BENCHMARK_DispatchAllocations)
+{
+  constexpr long repeats = 100000;
+
+  AllocationProcess process;
+  spawn(process);
+
+  // Dispatch once up front so that any lazy initialization (e.g., of
+  // libprocess itself) is not counted.
+  AWAIT_READY(dispatch(process, &AllocationProcess::compute, 0L));
+
+  auto run = [&](const string& name, const std::function<void()>& f) {
+    Stopwatch watch;
+    watch.start();
+
+    allocations = 0;
+    count_allocations = true;
+
+    for (long i = 0; i < repeats; i++) {
+      f();
+    }
+
+    count_allocations = false;
+
+    Duration elapsed = watch.elapsed();
+
+    cout << name << " allocations per dispatch: "
+         << (double) allocations / repeats
+         << ", elapsed: " << elapsed << endl;
+
+    // Make sure all of the dispatches have been served before we
+    // move on to the next run.
+    AWAIT_READY(dispatch(process, &AllocationProcess::compute, 0L));
+  };
+
+  run("void", [&]() {
+    dispatch(process, &AllocationProcess::handle, 42L);
+  });
+
+  run("R", [&]() {
+    dispatch(process, &AllocationProcess::compute, 42L);
+  });
+
+  run("Future<R>", [&]() {
+    dispatch(process, &AllocationProcess::_compute, 42L);
+  });
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Decodes many inbound libprocess messages, both as generic requests
+// (reading the body from the request's pipe, like `parse` does) and
+// via the message fast path of the decoder, and reports the time and
+// heap allocations per message.
+TEST(ProcessTest, Process_BENCHMARK_DecodeMessages)
+{
+  constexpr size_t messages = 100000;
+  constexpr size_t batch = 100;
+
+  Message message;
+  message.from = UPID("sender", process::address());
+  message.to = UPID("receiver", process::address());
+  message.name = "name";
+  message.body = string(100, '1');
+
+  string data;
+  for (size_t i = 0; i < batch; i++) {
+    data += MessageEncoder::encode(message);
+  }
+
+  auto run = [&](const string& name, bool fast) {
+    StreamingRequestDecoder decoder(
+        fast
+          ? Option<process::network::inet::Address>(process::address())
+          : None());
+
+    Stopwatch watch;
+    watch.start();
+
+    allocations = 0;
+    count_allocations = true;
+
+    for (size_t i = 0; i < messages / batch; i++) {
+      deque<StreamingRequestDecoder::Decoded> decoded;
+      decoder.decode(data.data(), data.size(), &decoded);
+
+      ASSERT_EQ(batch, decoded.size());
+
+      foreach (const StreamingRequestDecoder::Decoded& item, decoded) {
+        if (item.request != nullptr) {
+          Future<string> body = item.request->reader->readAll();
+          ASSERT_TRUE(body.isReady());
+          delete item.request;
+        }
+
+        delete item.event;
+      }
+    }
+
+    count_allocations = false;
+
+    Duration elapsed = watch.elapsed();
+
+    cout << name << " allocations per message: "
+         << (double) allocations / messages
+         << ", elapsed: " << elapsed << endl;
+  };
+
+  run("Request", false);
+  run("MessageEvent", true);
+}
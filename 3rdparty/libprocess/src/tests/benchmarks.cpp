@@ -18,11 +18,14 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/count_down_latch.hpp>
 #include <process/future.hpp>
@@ -30,14 +33,17 @@
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/timer.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
 #include <stout/stopwatch.hpp>
 
 namespace http = process::http;
 
+using process::Clock;
 using process::CountDownLatch;
 using process::Future;
 using process::MessageEvent;
@@ -45,6 +51,7 @@ using process::Owned;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
+using process::Timer;
 using process::UPID;
 
 using std::cout;
@@ -478,6 +485,12 @@ TEST(ProcessTest, Process_BENCHMARK_ThroughputPerformance)
 
   cout << "Estimated Total: " << std::fixed << throughput << endl;
 
+  // Include the per worker throughput so that the scalability of the
+  // run queue can be compared across different values of
+  // `LIBPROCESS_NUM_WORKER_THREADS`.
+  cout << "Estimated Per Worker (" << process::workers() << " workers): "
+       << std::fixed << throughput / process::workers() << endl;
+
   foreach (const Owned<Client>& client, clients) {
     terminate(client->self());
     wait(client->self());
@@ -574,3 +587,51 @@ TEST(ProcessTest, Process_BENCHMARK_DispatchDefer)
   DispatchProcess::run<DispatchProcess::Movable>("Movable", repeats);
   DispatchProcess::run<DispatchProcess::Copyable>("Copyable", repeats);
 }
+
+
+// Creates and then cancels millions of timers from multiple threads,
+// similar to the master creating (and later canceling) a timer for
+// every outstanding offer.
+TEST(ProcessTest, Process_BENCHMARK_Timers)
+{
+  constexpr size_t threads = 4;
+  constexpr size_t timers = 1000000;
+
+  // Make sure the event loop is ready before creating timers.
+  process::initialize();
+
+  vector<vector<Timer>> created(threads);
+
+  auto run = [&](const string& name, const std::function<void(size_t)>& f) {
+    Stopwatch watch;
+    watch.start();
+
+    vector<std::thread> workers;
+    for (size_t thread = 0; thread < threads; thread++) {
+      workers.emplace_back(f, thread);
+    }
+
+    foreach (std::thread& worker, workers) {
+      worker.join();
+    }
+
+    cout << name << " " << threads * timers << " timers from " << threads
+         << " threads took " << watch.elapsed() << endl;
+  };
+
+  run("Creating", [&](size_t thread) {
+    created[thread].reserve(timers);
+
+    for (size_t i = 0; i < timers; i++) {
+      // Spread the timeouts over a range like offer timeouts would.
+      created[thread].push_back(
+          Clock::timer(Minutes(5) + Milliseconds(i % 60000), []() {}));
+    }
+  });
+
+  run("Canceling", [&](size_t thread) {
+    foreach (const Timer& timer, created[thread]) {
+      EXPECT_TRUE(Clock::cancel(timer));
+    }
+  });
+}
@@ -15,8 +15,12 @@
 #include <deque>
 #include <string>
 
+#include <process/address.hpp>
+#include <process/event.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
 
 #include <stout/gtest.hpp>
 
@@ -26,7 +30,10 @@ namespace http = process::http;
 
 using process::DataDecoder;
 using process::Future;
+using process::MessageEvent;
 using process::Owned;
+using process::ProcessBase;
+using process::UPID;
 using process::ResponseDecoder;
 using process::StreamingRequestDecoder;
 using process::StreamingResponseDecoder;
@@ -150,6 +157,122 @@ TYPED_TEST(RequestDecoderTest, InvalidQueryArgs)
 }
 
 
+// Tests that libprocess messages are decoded via the fast path in
+// order with the other requests, as long as they are well formed.
+TEST(DecoderTest, StreamingRequestMessage)
+{
+  const process::network::inet::Address address =
+    process::network::inet4::Address::LOOPBACK_ANY();
+
+  StreamingRequestDecoder decoder(address);
+
+  const string data =
+    "POST /receiver%40x/name HTTP/1.1\r\n"
+    "User-Agent: libprocess/sender@127.0.0.1:5050\r\n"
+    "Connection: Keep-Alive\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nhello\r\n0\r\n\r\n"
+    "GET /path HTTP/1.1\r\n"
+    "\r\n"
+    "POST /receiver HTTP/1.1\r\n"
+    "Libprocess-From: sender@127.0.0.1:5050\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n"
+    "POST /receiver/name?key=value HTTP/1.1\r\n"
+    "Libprocess-From: sender@127.0.0.1:5050\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+  // Decode the data in two parts to split the first message.
+  deque<StreamingRequestDecoder::Decoded> decoded;
+  decoder.decode(data.data(), 100, &decoded);
+  decoder.decode(data.data() + 100, data.length() - 100, &decoded);
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(4u, decoded.size());
+
+  ASSERT_EQ(nullptr, decoded[0].request);
+  Owned<MessageEvent> event(decoded[0].event);
+  EXPECT_TRUE(decoded[0].keepAlive);
+  EXPECT_EQ(UPID("sender@127.0.0.1:5050"), event->message.from);
+  EXPECT_EQ(UPID("receiver@x", address), event->message.to);
+  EXPECT_EQ("name", event->message.name);
+  EXPECT_EQ("hello", event->message.body);
+
+  ASSERT_EQ(nullptr, decoded[1].event);
+  Owned<http::Request> request(decoded[1].request);
+  EXPECT_EQ("GET", request->method);
+  EXPECT_EQ("/path", request->url.path);
+
+  ASSERT_EQ(nullptr, decoded[2].request);
+  event.reset(decoded[2].event);
+  EXPECT_EQ(UPID("sender@127.0.0.1:5050"), event->message.from);
+  EXPECT_EQ(UPID("receiver", address), event->message.to);
+  EXPECT_EQ("", event->message.name);
+  EXPECT_EQ("", event->message.body);
+
+  // Messages with a query are decoded as generic requests.
+  ASSERT_EQ(nullptr, decoded[3].event);
+  request.reset(decoded[3].request);
+  EXPECT_EQ("POST", request->method);
+  EXPECT_EQ("/receiver/name", request->url.path);
+  EXPECT_SOME_EQ(
+      "sender@127.0.0.1:5050",
+      request->headers.get("Libprocess-From"));
+}
+
+
+// Tests that the receivers of decoded messages are resolved, and
+// that a receiver is resolved again once its process terminates.
+TEST(DecoderTest, StreamingRequestMessageReceiver)
+{
+  ProcessBase process("receiver");
+  const UPID pid = process::spawn(process);
+
+  StreamingRequestDecoder decoder(pid.address);
+
+  const string data =
+    "POST /receiver/name HTTP/1.1\r\n"
+    "Libprocess-From: sender@127.0.0.1:5050\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+  deque<StreamingRequestDecoder::Decoded> decoded;
+  decoder.decode(data.data(), data.length(), &decoded);
+  decoder.decode(data.data(), data.length(), &decoded);
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(2u, decoded.size());
+
+  Owned<MessageEvent> first(decoded[0].event);
+  Owned<MessageEvent> second(decoded[1].event);
+  ASSERT_NE(nullptr, first.get());
+  ASSERT_NE(nullptr, second.get());
+
+  EXPECT_EQ(pid, first->message.to);
+  EXPECT_TRUE(first->message.to.resolved());
+  EXPECT_EQ(pid, second->message.to);
+  EXPECT_TRUE(second->message.to.resolved());
+
+  process::terminate(pid);
+  process::wait(pid);
+
+  EXPECT_FALSE(first->message.to.resolved());
+
+  decoded.clear();
+  decoder.decode(data.data(), data.length(), &decoded);
+
+  ASSERT_EQ(1u, decoded.size());
+
+  Owned<MessageEvent> third(decoded[0].event);
+  ASSERT_NE(nullptr, third.get());
+
+  EXPECT_EQ(pid, third->message.to);
+  EXPECT_FALSE(third->message.to.resolved());
+}
+
+
 TEST(DecoderTest, Response)
 {
   ResponseDecoder decoder;
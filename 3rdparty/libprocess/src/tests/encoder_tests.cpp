@@ -14,12 +14,14 @@
 
 #include <deque>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/http.hpp>
 #include <process/owned.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 
 #include "encoder.hpp"
@@ -27,11 +29,13 @@
 
 namespace http = process::http;
 
+using process::DataEncoder;
 using process::HttpResponseEncoder;
 using process::Owned;
 using process::ResponseDecoder;
 
 using std::deque;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -69,6 +73,106 @@ TEST(EncoderTest, Response)
 }
 
 
+// Tests that the data of a multi-buffer encoder is sent again from
+// where a partial (vectored) send stopped.
+TEST(EncoderTest, DataBuffers)
+{
+  DataEncoder encoder(vector<string>{"abc", "defg", "hi"});
+
+  EXPECT_EQ(9u, encoder.remaining());
+
+  vector<pair<const char*, size_t>> data;
+  ASSERT_EQ(9u, encoder.next(&data));
+  ASSERT_EQ(3u, data.size());
+  EXPECT_EQ("abc", string(data[0].first, data[0].second));
+  EXPECT_EQ("defg", string(data[1].first, data[1].second));
+  EXPECT_EQ("hi", string(data[2].first, data[2].second));
+
+  EXPECT_EQ(0u, encoder.remaining());
+
+  // Only the first 5 bytes were sent.
+  encoder.backup(4);
+  EXPECT_EQ(4u, encoder.remaining());
+
+  data.clear();
+  ASSERT_EQ(4u, encoder.next(&data));
+  ASSERT_EQ(2u, data.size());
+  EXPECT_EQ("fg", string(data[0].first, data[0].second));
+  EXPECT_EQ("hi", string(data[1].first, data[1].second));
+
+  // Only the first byte was sent.
+  encoder.backup(3);
+
+  size_t length;
+  const char* next = encoder.next(&length);
+  ASSERT_NE(nullptr, next);
+  EXPECT_EQ("g", string(next, length));
+
+  next = encoder.next(&length);
+  ASSERT_NE(nullptr, next);
+  EXPECT_EQ("hi", string(next, length));
+
+  EXPECT_EQ(nullptr, encoder.next(&length));
+  EXPECT_EQ(0u, length);
+  EXPECT_EQ(0u, encoder.remaining());
+}
+
+
+// Tests that a response is encoded into the headers followed by the
+// body, and that it is sent again from where a partial send stopped
+// within the headers.
+TEST(EncoderTest, ResponseBuffers)
+{
+  http::Request request;
+  const http::OK response(string(1024, 'x'));
+
+  const vector<string> buffers =
+    HttpResponseEncoder::buffers(response, request);
+
+  ASSERT_EQ(2u, buffers.size());
+  EXPECT_EQ(response.body, buffers[1]);
+
+  HttpResponseEncoder encoder(response, request);
+
+  vector<pair<const char*, size_t>> data;
+  const size_t length = encoder.next(&data);
+  ASSERT_EQ(2u, data.size());
+
+  string encoded;
+  foreach (const auto& buffer, data) {
+    encoded.append(buffer.first, buffer.second);
+  }
+
+  ASSERT_EQ(length, encoded.size());
+
+  // All but the last 3 bytes of the headers were sent.
+  encoder.backup(response.body.size() + 3);
+
+  data.clear();
+  ASSERT_EQ(response.body.size() + 3, encoder.next(&data));
+  ASSERT_EQ(2u, data.size());
+  EXPECT_EQ(3u, data[0].second);
+  EXPECT_EQ(response.body, string(data[1].first, data[1].second));
+
+  // The data sent should decode to the response.
+  string sent = encoded.substr(0, encoded.size() - response.body.size() - 3);
+  foreach (const auto& buffer, data) {
+    sent.append(buffer.first, buffer.second);
+  }
+
+  EXPECT_EQ(encoded, sent);
+
+  ResponseDecoder decoder;
+  deque<http::Response*> responses = decoder.decode(sent.data(), sent.size());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1u, responses.size());
+
+  Owned<http::Response> decoded(responses[0]);
+  EXPECT_EQ(response.body, decoded->body);
+}
+
+
 TEST(EncoderTest, AcceptableEncodings)
 {
   // Create requests that do not accept gzip encoding.
@@ -12,13 +12,17 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/nothing.hpp>
 #include <stout/try.hpp>
 
@@ -526,6 +530,96 @@ TEST(FutureTest, THREADSAFE_Select)
 }
 
 
+// Ensures that every callback gets invoked exactly once, and in the
+// order it was installed, even when callbacks get installed while the
+// future is concurrently being completed.
+TEST(FutureTest, THREADSAFE_ConcurrentCallbacks)
+{
+  const int threads = 4;
+  const int callbacks = 1000;
+
+  Promise<int> promise;
+  Future<int> future = promise.future();
+
+  std::atomic<int> ready(0);
+  std::atomic<int> any(0);
+
+  std::vector<std::thread> installers;
+  for (int i = 0; i < threads; i++) {
+    installers.emplace_back([&]() {
+      for (int j = 0; j < callbacks; j++) {
+        future
+          .onReady([&](int value) {
+            EXPECT_EQ(42, value);
+            ++ready;
+          })
+          .onAny([&](const Future<int>& future) {
+            EXPECT_TRUE(future.isReady());
+            ++any;
+          });
+      }
+    });
+  }
+
+  promise.set(42);
+
+  foreach (std::thread& installer, installers) {
+    installer.join();
+  }
+
+  EXPECT_EQ(threads * callbacks, ready.load());
+  EXPECT_EQ(threads * callbacks, any.load());
+
+  // Callbacks of a single thread must be invoked in order.
+  std::vector<int> order;
+  Promise<Nothing> promise2;
+  for (int i = 0; i < 10; i++) {
+    promise2.future().onReady([&order, i]() { order.push_back(i); });
+  }
+
+  promise2.set(Nothing());
+
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), order);
+}
+
+
+// Ensures that the onDiscard callbacks get invoked exactly once if
+// and only if a discard succeeds, even when the discard races with
+// the future being completed.
+TEST(FutureTest, THREADSAFE_DiscardRacingSet)
+{
+  const int iterations = 10000;
+
+  for (int i = 0; i < iterations; i++) {
+    Promise<int> promise;
+    Future<int> future = promise.future();
+
+    std::atomic<int> discards(0);
+
+    future.onDiscard([&]() { ++discards; });
+
+    std::atomic<bool> discarded(false);
+
+    std::thread discarder([&]() {
+      discarded = future.discard();
+    });
+
+    std::thread installer([&]() {
+      future.onDiscard([&]() { ++discards; });
+    });
+
+    promise.set(42);
+
+    discarder.join();
+    installer.join();
+
+    ASSERT_TRUE(future.isReady());
+    ASSERT_EQ(discarded.load() ? 2 : 0, discards.load());
+    ASSERT_EQ(discarded.load(), future.hasDiscard());
+  }
+}
+
+
 TEST(FutureTest, FromTry)
 {
   Try<int> t = 1;
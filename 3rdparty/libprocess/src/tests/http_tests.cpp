@@ -26,6 +26,7 @@
 #include <vector>
 
 #include <process/address.hpp>
+#include <process/after.hpp>
 #include <process/authenticator.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
@@ -36,13 +37,17 @@
 #ifdef USE_SSL_SOCKET
 #include <process/jwt.hpp>
 #endif // USE_SSL_SOCKET
+#include <process/loop.hpp>
 #include <process/owned.hpp>
 #include <process/socket.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <process/ssl/gtest.hpp>
 
 #include <stout/base64.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
@@ -470,6 +475,65 @@ TEST_P(HTTPTest, PipeEOF)
 }
 
 
+TEST_P(HTTPTest, PipeBuffered)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  EXPECT_EQ(0u, writer.buffered());
+
+  // Writes which complete a pending 'read' are not buffered.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(writer.write("hello"));
+  AWAIT_EQ("hello", read);
+  EXPECT_EQ(0u, writer.buffered());
+
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world"));
+  EXPECT_EQ(10u, writer.buffered());
+
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_EQ(5u, writer.buffered());
+
+  // Closing the read end discards the unread writes.
+  EXPECT_TRUE(reader.close());
+  EXPECT_EQ(0u, writer.buffered());
+}
+
+
+TEST_P(HTTPTest, PipeDrained)
+{
+  http::Pipe pipe;
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  // Nothing has been written yet.
+  AWAIT_READY(writer.drained());
+
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world"));
+
+  Future<Nothing> drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("hello", reader.read());
+  EXPECT_TRUE(drained.isPending());
+
+  AWAIT_EQ("world", reader.read());
+  AWAIT_READY(drained);
+
+  // Closing the read end drains the pipe as well.
+  EXPECT_TRUE(writer.write("hello"));
+
+  drained = writer.drained();
+  EXPECT_TRUE(drained.isPending());
+
+  EXPECT_TRUE(reader.close());
+  AWAIT_READY(drained);
+}
+
+
 TEST_P(HTTPTest, PipeFailure)
 {
   http::Pipe pipe;
@@ -1176,6 +1240,206 @@ TEST(HTTPConnectionTest, Pipeline)
 }
 
 
+// Ensures that a response to a request received while streaming a
+// response is only sent once the streaming has finished, even if the
+// response is available right away.
+TEST(HTTPConnectionTest, PipelineStreaming)
+{
+  Http http;
+
+  http::URL pipeUrl = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/pipe");
+
+  http::URL getUrl = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/get");
+
+  Future<http::Connection> connect = http::connect(pipeUrl);
+  AWAIT_READY(connect);
+
+  http::Connection connection = connect.get();
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+
+  Future<Nothing> get;
+
+  EXPECT_CALL(*http.process, pipe(_))
+    .WillOnce(Return(ok));
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureSatisfy(&get),
+                    Return(http::OK("2"))));
+
+  http::Request request1, request2;
+
+  request1.method = "GET";
+  request2.method = "GET";
+
+  request1.url = pipeUrl;
+  request2.url = getUrl;
+
+  request1.keepAlive = true;
+  request2.keepAlive = true;
+
+  Future<http::Response> response1 = connection.send(request1, true);
+
+  // Send the second request once streaming has started.
+  AWAIT_READY(response1);
+
+  Future<http::Response> response2 = connection.send(request2);
+
+  AWAIT_READY(get);
+
+  ASSERT_SOME(response1->reader);
+
+  http::Pipe::Reader reader = response1->reader.get();
+  http::Pipe::Writer writer = pipe.writer();
+
+  EXPECT_TRUE(writer.write("1"));
+  AWAIT_EQ("1", reader.read());
+
+  // The second response must not be sent while streaming.
+  EXPECT_TRUE(response2.isPending());
+
+  EXPECT_TRUE(writer.write("1"));
+  AWAIT_EQ("1", reader.read());
+
+  EXPECT_TRUE(writer.close());
+  AWAIT_EQ("", reader.read());
+
+  AWAIT_READY(response2);
+  EXPECT_EQ("2", response2->body);
+
+  AWAIT_READY(connection.disconnect());
+  AWAIT_READY(connection.disconnected());
+}
+
+
+// Returns the number of times receiving requests on a connection was
+// paused, see `--max_pipelined_requests`.
+static Future<double> pipeliningStalls()
+{
+  return process::metrics::snapshot(None())
+    .then([](const hashmap<string, double>& snapshot) {
+      return snapshot.at("libprocess/http_pipelining_stalls");
+    });
+}
+
+
+// Ensures that receiving requests on a connection is paused once the
+// maximum number of pipelined requests are waiting to be responded
+// to, and resumed once the responses have been sent.
+TEST(HTTPConnectionTest, PipelineBound)
+{
+  os::setenv("LIBPROCESS_MAX_PIPELINED_REQUESTS", "1");
+
+  process::reinitialize(
+      None(),
+      READWRITE_HTTP_AUTHENTICATION_REALM,
+      READONLY_HTTP_AUTHENTICATION_REALM);
+
+  Future<double> stalls = pipeliningStalls();
+  AWAIT_READY(stalls);
+
+  {
+    Http http;
+
+    http::URL url = http::URL(
+        "http",
+        http.process->self().address.ip,
+        http.process->self().address.port,
+        http.process->self().id + "/get");
+
+    Future<http::Connection> connect = http::connect(url);
+    AWAIT_READY(connect);
+
+    http::Connection connection = connect.get();
+
+    Promise<http::Response> promise1, promise2, promise3;
+    Future<http::Request> get1, get2, get3;
+
+    EXPECT_CALL(*http.process, get(_))
+      .WillOnce(DoAll(FutureArg<0>(&get1),
+                      Return(promise1.future())))
+      .WillOnce(DoAll(FutureArg<0>(&get2),
+                      Return(promise2.future())))
+      .WillOnce(DoAll(FutureArg<0>(&get3),
+                      Return(promise3.future())));
+
+    http::Request request;
+    request.method = "GET";
+    request.url = url;
+    request.keepAlive = true;
+
+    Future<http::Response> response1 = connection.send(request);
+
+    AWAIT_READY(get1);
+
+    Future<http::Response> response2 = connection.send(request);
+
+    // Receiving pauses either right after the first request or once
+    // the second request has been received, depending on when the
+    // first request gets accounted for.
+    Future<Nothing> stalled = process::loop(
+        []() {
+          return process::after(Milliseconds(10))
+            .then(&pipeliningStalls);
+        },
+        [=](double value) -> process::ControlFlow<Nothing> {
+          if (value > stalls.get()) {
+            return process::Break();
+          }
+          return process::Continue();
+        });
+
+    AWAIT_READY(stalled);
+
+    // The third request must not be received until the earlier ones
+    // have been responded to.
+    Future<http::Response> response3 = connection.send(request);
+
+    EXPECT_TRUE(get3.isPending());
+
+    promise1.set(http::OK("1"));
+
+    AWAIT_READY(response1);
+    EXPECT_EQ("1", response1->body);
+
+    AWAIT_READY(get2);
+
+    promise2.set(http::OK("2"));
+
+    AWAIT_READY(response2);
+    EXPECT_EQ("2", response2->body);
+
+    AWAIT_READY(get3);
+
+    promise3.set(http::OK("3"));
+
+    AWAIT_READY(response3);
+    EXPECT_EQ("3", response3->body);
+
+    AWAIT_READY(connection.disconnect());
+    AWAIT_READY(connection.disconnected());
+  }
+
+  os::unsetenv("LIBPROCESS_MAX_PIPELINED_REQUESTS");
+
+  process::reinitialize(
+      None(),
+      READWRITE_HTTP_AUTHENTICATION_REALM,
+      READONLY_HTTP_AUTHENTICATION_REALM);
+}
+
+
 TEST(HTTPConnectionTest, ClosingRequest)
 {
   Http http;
@@ -13,11 +13,15 @@
 #include <gmock/gmock.h>
 
 #include <string>
+#include <vector>
 
+#include <process/after.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/io.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 
@@ -30,6 +34,18 @@ namespace io = process::io;
 using process::Future;
 
 using std::string;
+using std::vector;
+
+namespace process {
+
+// We need to reinitialize libprocess in order to test against
+// different numbers of event loops.
+void reinitialize(
+    const Option<string>& delegate,
+    const Option<string>& readonlyAuthenticationRealm,
+    const Option<string>& readwriteAuthenticationRealm);
+
+} // namespace process {
 
 class IOTest: public TemporaryDirectoryTest {};
 
@@ -55,6 +71,78 @@ TEST_F(IOTest, THREADSAFE_Poll)
 }
 
 
+// Tests that I/O gets served by every event loop when running more
+// than one, and that timers keep firing (they all live on the first
+// loop, see `EventLoop::delay`).
+TEST_F(IOTest, THREADSAFE_MultipleEventLoops)
+{
+  os::setenv("LIBPROCESS_NUM_EVENT_LOOPS", "4");
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+
+  // File descriptors are sharded across the loops by their number, so
+  // with consecutive descriptors every loop ends up watching some.
+  vector<int> reads;
+  vector<int> writes;
+  for (int i = 0; i < 8; i++) {
+    int pipes[2];
+    ASSERT_NE(-1, pipe(pipes));
+    reads.push_back(pipes[0]);
+    writes.push_back(pipes[1]);
+  }
+
+  vector<Future<short>> polls;
+  foreach (int fd, reads) {
+    polls.push_back(io::poll(fd, io::READ));
+  }
+
+  foreach (int fd, writes) {
+    AWAIT_EXPECT_EQ(io::WRITE, io::poll(fd, io::WRITE));
+  }
+
+  foreach (const Future<short>& poll, polls) {
+    EXPECT_TRUE(poll.isPending());
+  }
+
+  AWAIT_READY(process::after(Milliseconds(10)));
+
+  foreach (int fd, writes) {
+    ASSERT_EQ(3, write(fd, "hi", 3));
+  }
+
+  foreach (const Future<short>& poll, polls) {
+    AWAIT_EXPECT_EQ(io::READ, poll);
+  }
+
+  // A poll that never gets ready is discarded by the timer.
+  Future<short> poll = io::poll(reads.front(), io::WRITE)
+    .after(Milliseconds(10), [](Future<short> future) {
+      future.discard();
+      return future;
+    });
+
+  AWAIT_DISCARDED(poll);
+
+  foreach (int fd, reads) {
+    ASSERT_SOME(os::close(fd));
+  }
+
+  foreach (int fd, writes) {
+    ASSERT_SOME(os::close(fd));
+  }
+
+  os::unsetenv("LIBPROCESS_NUM_EVENT_LOOPS");
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+}
+
+
 TEST_F(IOTest, THREADSAFE_Read)
 {
   int pipes[2];
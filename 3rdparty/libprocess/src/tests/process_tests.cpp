@@ -24,7 +24,9 @@
 #include <netinet/tcp.h>
 #endif // __WINDOWS__
 
+#include <algorithm>
 #include <atomic>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -47,16 +49,21 @@
 #include <process/socket.hpp>
 #include <process/subprocess.hpp>
 #include <process/time.hpp>
+#include <process/timer.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/result.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 #include <stout/os/killtree.hpp>
@@ -87,6 +94,7 @@ using process::run;
 using process::Subprocess;
 using process::TerminateEvent;
 using process::Time;
+using process::Timer;
 using process::UPID;
 
 using process::firewall::DisabledEndpointsFirewallRule;
@@ -367,6 +375,108 @@ TEST(ProcessTest, THREADSAFE_Handlers)
 }
 
 
+class LatenciesProcess : public Process<LatenciesProcess>
+{
+public:
+  LatenciesProcess()
+  {
+    install("message", &LatenciesProcess::message);
+  }
+
+  Nothing settle() { return Nothing(); }
+
+  // Methods with the same signature, which must not share a histogram.
+  void first() {}
+  void second() {}
+
+private:
+  void message(const UPID&, const string&) {}
+};
+
+
+// Tests that the latencies of the events of a process are exposed
+// via the '/__latencies__' endpoint.
+TEST(ProcessTest, THREADSAFE_Latencies)
+{
+  LatenciesProcess process;
+
+  PID<LatenciesProcess> pid = spawn(&process);
+
+  ASSERT_FALSE(!pid);
+
+  post(pid, "message");
+  post(pid, "message");
+
+  dispatch(pid, &LatenciesProcess::first);
+  dispatch(pid, &LatenciesProcess::first);
+  dispatch(pid, &LatenciesProcess::second);
+
+  // The other events get served before this dispatch.
+  AWAIT_READY(dispatch(pid, &LatenciesProcess::settle));
+
+  Future<http::Response> response =
+    http::get(UPID("__latencies__", process::address()));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> array = JSON::parse<JSON::Array>(response->body);
+  ASSERT_SOME(array);
+
+  Option<JSON::Object> latencies;
+  foreach (const JSON::Value& value, array->values) {
+    ASSERT_TRUE(value.is<JSON::Object>());
+
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> id = object.find<JSON::String>("id");
+    if (id.isSome() && id->value == pid.id) {
+      latencies = object;
+    }
+  }
+
+  ASSERT_SOME(latencies);
+
+  Result<JSON::Number> count =
+    latencies->find<JSON::Number>("messages.message.count");
+
+  ASSERT_SOME(count);
+  EXPECT_EQ(2u, count->as<uint64_t>());
+
+  count = latencies->find<JSON::Number>("event_handlers.MESSAGE.count");
+
+  ASSERT_SOME(count);
+  EXPECT_EQ(2u, count->as<uint64_t>());
+
+  count = latencies->find<JSON::Number>("event_queueing_delay.count");
+
+  ASSERT_SOME(count);
+  EXPECT_LE(2u, count->as<uint64_t>());
+
+  // Each dispatched method gets its own histogram.
+  Result<JSON::Object> dispatches =
+    latencies->find<JSON::Object>("dispatches");
+
+  ASSERT_SOME(dispatches);
+
+  vector<uint64_t> counts;
+  foreachvalue (const JSON::Value& value, dispatches->values) {
+    ASSERT_TRUE(value.is<JSON::Object>());
+
+    count = value.as<JSON::Object>().find<JSON::Number>("count");
+
+    ASSERT_SOME(count);
+    counts.push_back(count->as<uint64_t>());
+  }
+
+  // NOTE: the dispatch of `settle` might not have been recorded yet.
+  EXPECT_EQ(1, std::count(counts.begin(), counts.end(), 2u));
+  EXPECT_EQ(0, std::count(counts.begin(), counts.end(), 3u));
+
+  terminate(pid);
+  wait(pid);
+}
+
+
 // Tests DROP_MESSAGE and DROP_DISPATCH and in particular that an
 // event can get dropped before being processed.
 TEST(ProcessTest, THREADSAFE_Expect)
@@ -571,6 +681,55 @@ TEST(ProcessTest, THREADSAFE_Delay)
 }
 
 
+// Ensures that timers fire in order of their timeouts (and creation
+// for equal timeouts), no matter how far in the future they are and
+// how far the clock gets advanced at once.
+TEST(ProcessTest, THREADSAFE_Timers)
+{
+  Clock::pause();
+
+  std::mutex mutex;
+  vector<int> fired;
+
+  auto timer = [&](const Duration& duration, int value) {
+    return Clock::timer(duration, [&mutex, &fired, value]() {
+      synchronized (mutex) {
+        fired.push_back(value);
+      }
+    });
+  };
+
+  timer(Milliseconds(1) + Nanoseconds(500), 2);
+  timer(Milliseconds(1), 1);
+  timer(Milliseconds(300), 3);
+  timer(Seconds(70), 4);
+  Timer canceled = timer(Seconds(70), 0);
+  timer(Hours(5), 5);
+  timer(Hours(5), 6);
+  timer(Days(60), 7);
+
+  EXPECT_TRUE(Clock::cancel(canceled));
+
+  Clock::advance(Milliseconds(1));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1}), fired);
+  }
+
+  Clock::advance(Days(61));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1, 2, 3, 4, 5, 6, 7}), fired);
+  }
+
+  EXPECT_FALSE(Clock::cancel(canceled));
+
+  Clock::resume();
+}
+
+
 class OrderProcess : public Process<OrderProcess>
 {
 public:
@@ -1142,6 +1301,120 @@ TEST(ProcessTest, THREADSAFE_Settle)
 }
 
 
+namespace process {
+
+// We need to reinitialize libprocess in order to test against
+// different values of the resume quantum flags.
+void reinitialize(
+    const Option<string>& delegate,
+    const Option<string>& readonlyAuthenticationRealm,
+    const Option<string>& readwriteAuthenticationRealm);
+
+} // namespace process {
+
+
+class QuantumProcess : public Process<QuantumProcess>
+{
+public:
+  QuantumProcess() : released(false), served(0) {}
+
+  // NOTE: we spin rather than wait on a `Future` so that we don't
+  // hand the only worker thread over to another process.
+  void block()
+  {
+    while (!released.load()) {
+      os::sleep(Milliseconds(1));
+    }
+  }
+
+  void ping()
+  {
+    ++served;
+  }
+
+  std::atomic_bool released;
+  std::atomic_int served;
+};
+
+
+// Tests that a process with a backlog of events puts itself back on
+// the run queue once it has served its resume quantum, letting other
+// processes run in between.
+TEST(ProcessTest, THREADSAFE_ResumeQuantum)
+{
+  // With a single worker thread the run queue is served in order,
+  // so we can tell exactly when the busy process gave up the thread.
+  os::setenv("LIBPROCESS_NUM_WORKER_THREADS", "1");
+  os::setenv("LIBPROCESS_RESUME_QUANTUM_EVENTS", "1");
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+
+  QuantumProcess busy;
+  QuantumProcess other;
+
+  spawn(busy);
+  spawn(other);
+
+  dispatch(busy, &QuantumProcess::block);
+
+  const int pings = 100;
+  for (int i = 0; i < pings; i++) {
+    dispatch(busy, &QuantumProcess::ping);
+  }
+
+  // Without a quantum `busy` would serve all of its pings before
+  // giving up the worker thread, so `other` would observe all of them.
+  Future<int> observed = dispatch(other.self(), [&busy]() {
+    return busy.served.load();
+  });
+
+  busy.released.store(true);
+
+  AWAIT_READY(observed);
+  EXPECT_LT(observed.get(), pings);
+
+  Future<int> served = dispatch(busy.self(), [&busy]() {
+    return busy.served.load();
+  });
+
+  AWAIT_EXPECT_EQ(pings, served);
+
+  Future<http::Response> response =
+    http::get(UPID("metrics", process::address()), "snapshot");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> snapshot = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(snapshot);
+
+  ASSERT_EQ(1u, snapshot->values.count(
+      "libprocess/resume_quantum_expirations"));
+
+  JSON::Value expirations =
+    snapshot->values.at("libprocess/resume_quantum_expirations");
+
+  ASSERT_TRUE(expirations.is<JSON::Number>());
+  EXPECT_LE(1u, expirations.as<JSON::Number>().as<uint64_t>());
+
+  terminate(other);
+  wait(other);
+
+  terminate(busy);
+  wait(busy);
+
+  os::unsetenv("LIBPROCESS_NUM_WORKER_THREADS");
+  os::unsetenv("LIBPROCESS_RESUME_QUANTUM_EVENTS");
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+}
+
+
 TEST(ProcessTest, THREADSAFE_Pid)
 {
   TimeoutProcess process;
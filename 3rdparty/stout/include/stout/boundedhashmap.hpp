@@ -33,6 +33,19 @@ public:
 
   BoundedHashMap(size_t capacity) : capacity_(capacity) {}
 
+  BoundedHashMap(const BoundedHashMap<Key, Value>& other)
+    : capacity_(other.capacity_),
+      entries_(other.entries_)
+  {
+    // Build up the index, which must refer to our own entries rather
+    // than to those of `other`.
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      keys_[it->first] = it;
+    }
+  }
+
+  BoundedHashMap& operator=(const BoundedHashMap<Key, Value>&) = delete;
+
   // NOTE: We don't provide `operator[]`, unlike LinkedHashMap,
   // because it would be difficult to implement correctly for bounded
   // maps with zero capacity.
@@ -25,7 +25,6 @@
 
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression as well.
 namespace gzip {
 
 namespace internal {
@@ -169,6 +168,115 @@ private:
 };
 
 
+// Provides the ability to incrementally compress a stream of input
+// data, e.g., one which is too large to be held in memory as a whole.
+// The compression level should be within the range [-1, 9], see
+// `compress` below.
+class Compressor
+{
+public:
+  Compressor(int level = Z_DEFAULT_COMPRESSION)
+    : _finished(false)
+  {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+
+    int code = deflateInit2(
+        &stream,
+        level,          // Compression level.
+        Z_DEFLATED,     // Compression method.
+        MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+        8,              // Default memLevel value.
+        Z_DEFAULT_STRATEGY);
+
+    if (code != Z_OK) {
+      Error error = internal::GzipError("Failed to deflateInit2", stream, code);
+      ABORT(error.message);
+    }
+  }
+
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  ~Compressor()
+  {
+    // NOTE: `deflateEnd` returns `Z_DATA_ERROR` if the stream was not
+    // finished, which is expected if the compressor gets abandoned.
+    int code = deflateEnd(&stream);
+    if (code != Z_OK && code != Z_DATA_ERROR) {
+      ABORT("Failed to deflateEnd");
+    }
+  }
+
+  // Returns the next compressed chunk of data, or an Error if the
+  // compression fails. Note that the chunk might be empty since the
+  // compressed data gets buffered until enough input is available.
+  Try<std::string> compress(const std::string& decompressed)
+  {
+    if (_finished) {
+      return Error("Stream is finished");
+    }
+
+    return compress(decompressed, Z_NO_FLUSH);
+  }
+
+  // Returns the last compressed chunk of data, which completes the
+  // stream, or an Error if the compression fails.
+  Try<std::string> finish()
+  {
+    if (_finished) {
+      return Error("Stream is finished");
+    }
+
+    _finished = true;
+
+    return compress("", Z_FINISH);
+  }
+
+private:
+  Try<std::string> compress(const std::string& decompressed, int flush)
+  {
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = static_cast<uInt>(decompressed.length());
+
+    // Build up the compressed result.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result;
+
+    // NOTE: When not finishing, `deflate` is done consuming the input
+    // once it leaves some of the output buffer unused.
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+
+      int code = deflate(&stream, flush);
+
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        return internal::GzipError("Failed to deflate", stream, code);
+      }
+
+      // Consume output and reset the buffer.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+
+      if (code == Z_STREAM_END) {
+        break;
+      }
+    } while (stream.avail_out == 0 || flush == Z_FINISH);
+
+    return result;
+  }
+
+  z_stream_s stream;
+  bool _finished;
+};
+
+
 // Returns a gzip compressed version of the provided string.
 // The compression level should be within the range [-1, 9].
 // See zlib.h:
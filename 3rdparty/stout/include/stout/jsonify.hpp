@@ -22,6 +22,7 @@
 #include <functional>
 #include <ostream>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -115,6 +116,47 @@ private:
 #endif // __WINDOWS__
 };
 
+
+// A stream buffer which hands the characters written into it to a
+// callback in chunks of `size` characters (except for the last chunk
+// which is handed over by `flush`), rather than accumulating all of
+// them like a `std::stringbuf`.
+class ChunkedBuffer : public std::streambuf
+{
+public:
+  ChunkedBuffer(size_t size, std::function<void(std::string&&)> chunk)
+    : buffer_(size > 0 ? size : 1, '\0'), chunk_(std::move(chunk))
+  {
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+  }
+
+  // Hands the characters written since the last chunk to the callback.
+  void flush()
+  {
+    if (pptr() > pbase()) {
+      chunk_(std::string(pbase(), pptr()));
+      setp(&buffer_[0], &buffer_[0] + buffer_.size());
+    }
+  }
+
+protected:
+  int_type overflow(int_type c) override
+  {
+    flush();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+  }
+
+private:
+  std::string buffer_;
+  std::function<void(std::string&&)> chunk_;
+};
+
 } // namespace internal {
 
 
@@ -139,6 +181,22 @@ public:
     return stream.str();
   }
 
+  // Writes the JSON in chunks of `size` characters (except for the
+  // last chunk which might be shorter) to the `chunk` callback as it
+  // gets generated, e.g., so that a large JSON document can be
+  // streamed without ever being held in memory as a whole.
+  void write(size_t size, const std::function<void(std::string&&)>& chunk) &&
+  {
+    // Needed to set C locale and therefore creating proper JSON output.
+    internal::ClassicLocale guard;
+
+    internal::ChunkedBuffer buffer(size, chunk);
+    std::ostream stream(&buffer);
+
+    write_(&stream);
+    buffer.flush();
+  }
+
 private:
   Proxy(std::function<void(std::ostream*)> write) : write_(std::move(write)) {}
 
@@ -56,6 +56,32 @@ TEST(BoundedHashMapTest, Set)
 }
 
 
+TEST(BoundedHashMapTest, Copy)
+{
+  BoundedHashMap<string, int> map(2);
+
+  map.set("foo", 1);
+  map.set("bar", 2);
+
+  BoundedHashMap<string, int> copy(map);
+
+  EXPECT_EQ(list<string>({"foo", "bar"}), copy.keys());
+
+  // The copy is independent of the original.
+  copy.set("bar", 3);
+  EXPECT_SOME_EQ(3, copy.get("bar"));
+  EXPECT_SOME_EQ(2, map.get("bar"));
+
+  map.erase("foo");
+  EXPECT_SOME_EQ(1, copy.get("foo"));
+
+  // The copy has the capacity of the original.
+  copy.set("baz", 4);
+  EXPECT_NONE(copy.get("foo"));
+  EXPECT_EQ(list<string>({"bar", "baz"}), copy.keys());
+}
+
+
 TEST(BoundedHashMapTest, EmptyMap)
 {
   BoundedHashMap<string, int> map(0);
@@ -99,4 +99,38 @@ TEST(GzipTest, Decompressor)
 
   ASSERT_EQ(s, decompressed);
 }
+
+
+TEST(GzipTest, Compressor)
+{
+  string s =
+    "Lorem ipsum dolor sit amet, consectetur adipisicing elit, sed do "
+    "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad "
+    "minim veniam, quis nostrud exercitation ullamco laboris nisi ut "
+    "aliquip ex ea commodo consequat. Duis aute irure dolor in reprehenderit "
+    "in voluptate velit esse cillum dolore eu fugiat nulla pariatur. "
+    "Excepteur sint occaecat cupidatat non proident, sunt in culpa qui "
+    "officia deserunt mollit anim id est laborum.";
+
+  gzip::Compressor compressor;
+
+  // Compress 1 byte at a time.
+  string compressed;
+
+  for (size_t i = 0; i < s.size(); i++) {
+    Try<string> compressedChunk = compressor.compress(s.substr(i, 1));
+    ASSERT_SOME(compressedChunk);
+    compressed += compressedChunk.get();
+  }
+
+  Try<string> compressedChunk = compressor.finish();
+  ASSERT_SOME(compressedChunk);
+  compressed += compressedChunk.get();
+
+  EXPECT_ERROR(compressor.compress(s));
+
+  Try<string> decompressed = gzip::decompress(compressed);
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ(s, decompressed.get());
+}
 #endif // HAVE_LIBZ
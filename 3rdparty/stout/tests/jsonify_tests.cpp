@@ -338,3 +338,35 @@ TEST(JsonifyTest, JSONNull)
   JSON::Array numbers = JSON::Array{1, JSON::Null(), 3};
   EXPECT_EQ("[1,null,3]", string(jsonify(numbers)));
 }
+
+
+// Tests that JSON written in chunks is identical to the JSON written
+// as a whole, and that all of the chunks but the last are full.
+TEST(JsonifyTest, Chunked)
+{
+  vector<int> numbers;
+  for (int i = 0; i < 1000; i++) {
+    numbers.push_back(i);
+  }
+
+  auto write = [&numbers](JSON::ObjectWriter* writer) {
+    writer->field("name", "numbers");
+    writer->field("numbers", numbers);
+  };
+
+  vector<string> chunks;
+  jsonify(write).write(64, [&chunks](string&& chunk) {
+    chunks.push_back(std::move(chunk));
+  });
+
+  ASSERT_LT(1u, chunks.size());
+
+  for (size_t i = 0; i < chunks.size() - 1; i++) {
+    EXPECT_EQ(64u, chunks[i].size());
+  }
+
+  EXPECT_LT(0u, chunks.back().size());
+  EXPECT_GE(64u, chunks.back().size());
+
+  EXPECT_EQ(string(jsonify(write)), strings::join("", chunks));
+}
@@ -106,6 +106,18 @@ option(
   "Build libprocess with lock free run queue"
   FALSE)
 
+option(
+  ENABLE_WORK_STEALING_RUN_QUEUE
+  "Build libprocess with work stealing run queue"
+  FALSE)
+
+if (ENABLE_LOCK_FREE_RUN_QUEUE AND ENABLE_WORK_STEALING_RUN_QUEUE)
+  message(
+    FATAL_ERROR
+    "The lock free run queue and the work stealing run queue can not be "
+    "enabled at the same time.")
+endif ()
+
 option(
   HAS_AUTHENTICATION
   "Build Mesos against authentication libraries"
@@ -41,6 +41,26 @@
 namespace mesos {
 namespace allocator {
 
+/**
+ * Tunes how an allocator allocates. An allocator may ignore any of
+ * these, this depends on the implementation.
+ */
+struct Options
+{
+  /**
+   * The number of shards the allocator may partition the agents into
+   * in order to allocate their resources in parallel.
+   */
+  size_t allocationParallelism = 1;
+
+  /**
+   * Whether the allocator should allocate the resources affected by
+   * each event as soon as possible, rather than only in batches.
+   */
+  bool incrementalAllocation = false;
+};
+
+
 /**
  * Basic model of an allocator: resources are allocated to a framework
  * in the form of offers. A framework can refuse some resources in
@@ -81,6 +101,7 @@ public:
    *     to the frameworks.
    * @param inverseOfferCallback A callback the allocator uses to send reclaim
    *     allocations from the frameworks.
+   * @param options Tunes how the allocator allocates, see `Options`.
    */
   virtual void initialize(
       const Duration& allocationInterval,
@@ -95,7 +116,8 @@ public:
       const Option<std::set<std::string>>&
         fairnessExcludeResourceNames = None(),
       bool filterGpuResources = true,
-      const Option<DomainInfo>& domain = None()) = 0;
+      const Option<DomainInfo>& domain = None(),
+      const Options& options = Options()) = 0;
 
   /**
    * Informs the allocator of the recovered state from the master.
@@ -160,7 +160,12 @@ public:
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
     // another writer) must be restarted.
-    explicit Writer(Log* log);
+    //
+    // Up to 'window' appends and truncates can be in flight at once,
+    // their futures are set in the order of their positions. Appending
+    // or truncating while the window is full fails (and so do the
+    // following appends and truncates, until the writer is restarted).
+    explicit Writer(Log* log, size_t window = 1);
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
@@ -39,7 +39,15 @@ class LogStorageProcess;
 class LogStorage : public mesos::state::Storage
 {
 public:
-  LogStorage(mesos::log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // If 'appends' is true, a value which extends the value it replaces
+  // is stored as an APPEND of the extra bytes rather than as a DIFF or
+  // a SNAPSHOT. NOTE: Readers of the log which do not know about
+  // APPENDs fail to recover such a value, so this should only be
+  // enabled once all the readers of the log support it.
+  LogStorage(
+      mesos::log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      bool appends = false);
 
   virtual ~LogStorage();
 
@@ -82,6 +82,8 @@ private:
       if (resource.has_shared()) {
         sharedCount = 1;
       }
+
+      updateKey();
     }
 
     // By implicitly converting to Resource we are able to keep Resource_
@@ -124,6 +126,10 @@ private:
         std::ostream& stream, const Resource_& resource_);
 
   private:
+    // Updates `key` after any of the fields of `resource` it is
+    // computed from has changed.
+    void updateKey();
+
     // The protobuf Resource that is being managed.
     Resource resource;
 
@@ -131,6 +137,13 @@ private:
     // 'resource' is non-shared. This is an int so as to support arithmetic
     // operations involving subtraction.
     Option<int> sharedCount;
+
+    // A hash of the fields of `resource` that have to be equal for two
+    // Resource_ objects to be addable, subtractable or to contain one
+    // another (e.g., the name, reservations and allocation). Comparing
+    // the keys first lets us skip most of the Resource_ objects in a
+    // Resources object without comparing their protobufs.
+    size_t key;
   };
 
 public:
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include <functional>
 #include <ostream>
 #include <set>
 #include <string>
@@ -23,6 +24,8 @@
 
 #include <glog/logging.h>
 
+#include <boost/functional/hash.hpp>
+
 #include <google/protobuf/repeated_field.h>
 
 #include <mesos/resources.hpp>
@@ -1179,8 +1182,43 @@ bool Resources::Resource_::isEmpty() const
 }
 
 
+void Resources::Resource_::updateKey()
+{
+  // NOTE: Only fields that are compared by both `addable()` and
+  // `subtractable()` can be hashed here, since Resource_ objects
+  // with different keys are assumed to be neither.
+  key = std::hash<string>()(resource.name());
+
+  boost::hash_combine(key, static_cast<int>(resource.type()));
+  boost::hash_combine(key, resource.has_shared());
+  boost::hash_combine(key, resource.has_revocable());
+
+  if (resource.has_allocation_info()) {
+    boost::hash_combine(key, resource.allocation_info().role());
+  }
+
+  foreach (const Resource::ReservationInfo& reservation,
+           resource.reservations()) {
+    boost::hash_combine(key, reservation.role());
+  }
+
+  if (resource.has_disk() && resource.disk().has_persistence()) {
+    boost::hash_combine(key, resource.disk().persistence().id());
+  }
+
+  if (resource.has_provider_id()) {
+    boost::hash_combine(key, resource.provider_id().value());
+  }
+}
+
+
 bool Resources::Resource_::contains(const Resource_& that) const
 {
+  // Resource_ objects with different keys can't contain one another.
+  if (key != that.key) {
+    return false;
+  }
+
   // Both Resource_ objects should have the same sharedness.
   if (isShared() != that.isShared()) {
     return false;
@@ -1286,18 +1324,24 @@ Resources::Resources(const RepeatedPtrField<Resource>& _resources)
 
 bool Resources::contains(const Resources& that) const
 {
-  Resources remaining = *this;
+  // We only copy these resources once a persistent volume needs to
+  // be subtracted from them, since most of the time there are none.
+  Option<Resources> remaining;
 
   foreach (const Resource_& resource_, that.resources) {
     // NOTE: We use _contains because Resources only contain valid
     // Resource objects, and we don't want the performance hit of the
     // validity check.
-    if (!remaining._contains(resource_)) {
+    if (!(remaining.isSome() ? remaining.get() : *this)._contains(resource_)) {
       return false;
     }
 
     if (isPersistentVolume(resource_.resource)) {
-      remaining.subtract(resource_);
+      if (remaining.isNone()) {
+        remaining = *this;
+      }
+
+      remaining->subtract(resource_);
     }
   }
 
@@ -1332,6 +1376,7 @@ void Resources::allocate(const string& role)
 {
   foreach (Resource_& resource_, resources) {
     resource_.resource.mutable_allocation_info()->set_role(role);
+    resource_.updateKey();
   }
 }
 
@@ -1341,6 +1386,7 @@ void Resources::unallocate()
   foreach (Resource_& resource_, resources) {
     if (resource_.resource.has_allocation_info()) {
       resource_.resource.clear_allocation_info();
+      resource_.updateKey();
     }
   }
 }
@@ -1447,6 +1493,7 @@ Resources Resources::pushReservation(
   foreach (Resource_ resource_, *this) {
     resource_.resource.add_reservations()->CopyFrom(reservation);
     CHECK_NONE(Resources::validate(resource_.resource));
+    resource_.updateKey();
     result.add(resource_);
   }
 
@@ -1461,6 +1508,7 @@ Resources Resources::popReservation() const
   foreach (Resource_ resource_, resources) {
     CHECK_GT(resource_.resource.reservations_size(), 0);
     resource_.resource.mutable_reservations()->RemoveLast();
+    resource_.updateKey();
     result.add(resource_);
   }
 
@@ -1474,6 +1522,7 @@ Resources Resources::toUnreserved() const
 
   foreach (Resource_ resource_, *this) {
     resource_.resource.clear_reservations();
+    resource_.updateKey();
     result.add(resource_);
   }
 
@@ -1941,6 +1990,7 @@ Option<Resources> Resources::find(const Resource& target) const
           r.resource.mutable_reservations()->CopyFrom(
               resource_.resource.reservations());
 
+          r.updateKey();
           found.add(r);
         }
 
@@ -2017,7 +2067,8 @@ void Resources::add(const Resource_& that)
 
   bool found = false;
   foreach (Resource_& resource_, resources) {
-    if (internal::addable(resource_.resource, that)) {
+    if (resource_.key == that.key &&
+        internal::addable(resource_.resource, that)) {
       resource_ += that;
       found = true;
       break;
@@ -2092,7 +2143,8 @@ void Resources::subtract(const Resource_& that)
   for (size_t i = 0; i < resources.size(); i++) {
     Resource_& resource_ = resources[i];
 
-    if (internal::subtractable(resource_.resource, that)) {
+    if (resource_.key == that.key &&
+        internal::subtractable(resource_.resource, that)) {
       resource_ -= that;
 
       // Remove the resource if it has become negative or empty.
@@ -229,7 +229,8 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
           set<UPID>(),
           masterFlags.log_auto_initialize,
           "registrar/");
-      storage = new mesos::state::LogStorage(log);
+      storage = new mesos::state::LogStorage(
+          log, 0, masterFlags.registry_store_deltas);
 #endif // __WINDOWS__
     } else {
       EXIT(EXIT_FAILURE)
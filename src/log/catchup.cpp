@@ -17,13 +17,19 @@
 #include <stdint.h>
 
 #include <list>
+#include <set>
 
 #include <process/collect.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
+#include <process/protobuf.hpp>
 #include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
@@ -34,6 +40,7 @@
 using namespace process;
 
 using std::list;
+using std::set;
 
 namespace mesos {
 namespace internal {
@@ -308,6 +315,312 @@ static Future<Nothing> catchup(
 }
 
 
+// The number of positions requested by a single read request, and
+// the number of read requests that can be outstanding to a replica.
+// Note that a replica might return fewer positions than requested
+// (see 'ReadResponse'), in which case the rest is requested again.
+static const uint64_t TRANSFER_RANGE_SIZE = 1024;
+static const size_t TRANSFER_WINDOW = 4;
+
+
+// Transfers the positions from all the other replicas in parallel.
+// The positions are split into ranges which are requested from the
+// replicas with a window of outstanding requests to each of them, so
+// that the transfer is not bounded by the round trip to a replica. A
+// request remains outstanding until the local replica has committed
+// the transferred actions.
+class TransferProcess : public ProtobufProcess<TransferProcess>
+{
+public:
+  TransferProcess(
+      const Shared<Replica>& _replica,
+      const Shared<Network>& _network,
+      uint64_t _from,
+      uint64_t _to,
+      const Duration& _timeout,
+      const Option<lambda::function<void(const TransferProgress&)>>&
+        _progress)
+    : ProcessBase(ID::generate("log-transfer")),
+      replica(_replica),
+      network(_network),
+      timeout(_timeout),
+      progress(_progress),
+      remaining(Bound<uint64_t>::closed(_from), Bound<uint64_t>::closed(_to)),
+      storing(0),
+      transferred(0),
+      bytes(0)
+  {
+    if (_from <= _to) {
+      ranges.push_back(Range(_from, _to));
+    }
+  }
+
+  virtual ~TransferProcess() {}
+
+  Future<Nothing> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
+
+    stopwatch.start();
+
+    listing = network->pids();
+    listing.onAny(defer(self(), &Self::listed));
+  }
+
+  virtual void finalize()
+  {
+    listing.discard();
+
+    foreach (Future<ReadResponse> future, reading) {
+      future.discard();
+    }
+
+    // TODO(benh): Discard our promise only after 'listing' and
+    // 'reading' have completed (ready, failed, or discarded).
+    promise.discard();
+  }
+
+private:
+  struct Range
+  {
+    Range(uint64_t _from, uint64_t _to) : from(_from), to(_to) {}
+
+    uint64_t from;
+    uint64_t to;
+
+    // The replicas that had no learned action to transfer at the
+    // beginning of this range.
+    set<UPID> tried;
+  };
+
+  void listed()
+  {
+    // The future 'listing' can only be discarded in 'finalize'.
+    CHECK(!listing.isDiscarded());
+
+    if (listing.isFailed()) {
+      promise.fail("Failed to get the replicas: " + listing.failure());
+      terminate(self());
+      return;
+    }
+
+    foreach (const UPID& pid, listing.get()) {
+      if (pid != replica->pid()) {
+        peers.insert(pid);
+        outstanding[pid] = 0;
+      }
+    }
+
+    transfer();
+  }
+
+  void transfer()
+  {
+    foreach (const UPID& peer, peers) {
+      while (outstanding[peer] < TRANSFER_WINDOW) {
+        Option<Range> range = assign(peer);
+
+        if (range.isNone()) {
+          break;
+        }
+
+        read(peer, range.get());
+      }
+    }
+
+    if (reading.empty() && storing == 0) {
+      // Stop the process if there is nothing left to transfer or no
+      // replica left to transfer the remaining positions from.
+      LOG(INFO) << "Transferred " << transferred << " position(s) ("
+                << Bytes(bytes) << ") in " << stopwatch.elapsed() << ", "
+                << remaining.size() << " position(s) not transferred";
+
+      promise.set(Nothing());
+      terminate(self());
+    }
+  }
+
+  // Returns the next range to request from the replica, if any.
+  Option<Range> assign(const UPID& peer)
+  {
+    list<Range>::iterator iterator;
+    for (iterator = ranges.begin(); iterator != ranges.end(); ++iterator) {
+      if (iterator->tried.count(peer) > 0) {
+        continue;
+      }
+
+      Range range = *iterator;
+
+      if (range.to - range.from >= TRANSFER_RANGE_SIZE) {
+        range.to = range.from + TRANSFER_RANGE_SIZE - 1;
+        iterator->from = range.to + 1;
+      } else {
+        ranges.erase(iterator);
+      }
+
+      return range;
+    }
+
+    return None();
+  }
+
+  void read(const UPID& peer, const Range& range)
+  {
+    ReadRequest request;
+    request.set_from(range.from);
+    request.set_to(range.to);
+
+    Future<ReadResponse> future = protocol::read(peer, request)
+      .after(timeout, [](Future<ReadResponse> future) {
+        future.discard();
+        return Failure("Timed out");
+      });
+
+    outstanding[peer]++;
+    reading.insert(future);
+
+    future.onAny(defer(self(), &Self::_read, peer, range, lambda::_1));
+  }
+
+  void _read(
+      const UPID& peer,
+      Range range,
+      const Future<ReadResponse>& future)
+  {
+    reading.erase(future);
+
+    if (!future.isReady()) {
+      outstanding[peer]--;
+
+      // Stop transferring from the replica, the range is requested
+      // again from the other replicas.
+      if (peers.erase(peer) > 0) {
+        LOG(INFO) << "Stopped transferring from replica " << peer << ": "
+                  << (future.isFailed() ? future.failure() : "discarded");
+      }
+
+      ranges.push_front(range);
+    } else if (future->actions_size() == 0) {
+      outstanding[peer]--;
+      range.tried.insert(peer);
+      ranges.push_front(range);
+    } else {
+      const ReadResponse& response = future.get();
+
+      // Hand the actions to the local replica as if they were learned
+      // by a coordinator so that they are stored with a single sync.
+      LearnedMessage message;
+      message.mutable_action()->CopyFrom(response.actions(0));
+
+      for (int i = 1; i < response.actions_size(); i++) {
+        message.add_actions()->CopyFrom(response.actions(i));
+      }
+
+      send(replica->pid(), message);
+
+      // Note that the positions before the first action have been
+      // truncated (see 'ReadResponse').
+      const uint64_t from = range.from;
+      const uint64_t last =
+        response.actions(response.actions_size() - 1).position();
+
+      if (last < range.to) {
+        range.from = last + 1;
+        ranges.push_front(range);
+      }
+
+      // The request to the replica stays outstanding until the local
+      // replica has committed the actions, so that the transfer does
+      // not outpace the local storage. Note that 'committed' is
+      // dispatched after the learned message above has been queued.
+      storing++;
+
+      replica->committed()
+        .onAny(defer(self(),
+                     &Self::stored,
+                     peer,
+                     from,
+                     last,
+                     response.actions_size(),
+                     response.ByteSize(),
+                     lambda::_1));
+    }
+
+    transfer();
+  }
+
+  void stored(
+      const UPID& peer,
+      uint64_t from,
+      uint64_t last,
+      uint64_t actions,
+      uint64_t size,
+      const Future<Nothing>& future)
+  {
+    outstanding[peer]--;
+    storing--;
+
+    // Leave the positions in 'remaining' so that they are reported as
+    // not transferred, rather than requesting them again since the
+    // local replica is likely to fail to commit them again.
+    if (!future.isReady()) {
+      LOG(WARNING) << "Failed to store the positions " << from << " -> "
+                   << last << " transferred from replica " << peer << ": "
+                   << (future.isFailed() ? future.failure() : "discarded");
+
+      transfer();
+      return;
+    }
+
+    remaining -=
+      (Bound<uint64_t>::closed(from), Bound<uint64_t>::closed(last));
+
+    transferred += actions;
+    bytes += size;
+
+    if (progress.isSome()) {
+      TransferProgress progress_;
+      progress_.transferred = transferred;
+      progress_.bytes = bytes;
+      progress_.remaining = remaining.size();
+      progress_.elapsed = stopwatch.elapsed();
+
+      progress.get()(progress_);
+    }
+
+    transfer();
+  }
+
+  const Shared<Replica> replica;
+  const Shared<Network> network;
+  const Duration timeout;
+  const Option<lambda::function<void(const TransferProgress&)>> progress;
+
+  // The ranges left to request and the positions left to transfer.
+  list<Range> ranges;
+  IntervalSet<uint64_t> remaining;
+
+  set<UPID> peers;
+  hashmap<UPID, size_t> outstanding;
+
+  // The transferred batches the local replica has yet to commit.
+  size_t storing;
+
+  uint64_t transferred;
+  uint64_t bytes;
+  Stopwatch stopwatch;
+
+  process::Promise<Nothing> promise;
+  Future<set<UPID>> listing;
+  set<Future<ReadResponse>> reading;
+};
+
+
 /////////////////////////////////////////////////
 // Public interfaces below.
 /////////////////////////////////////////////////
@@ -347,6 +660,29 @@ Future<Nothing> catchup(
   return future;
 }
 
+
+Future<Nothing> transfer(
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    uint64_t from,
+    uint64_t to,
+    const Duration& timeout,
+    const Option<lambda::function<void(const TransferProgress&)>>& progress)
+{
+  TransferProcess* process =
+    new TransferProcess(
+        replica,
+        network,
+        from,
+        to,
+        timeout,
+        progress);
+
+  Future<Nothing> future = process->future();
+  spawn(process, true);
+  return future;
+}
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
@@ -24,6 +24,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/interval.hpp>
+#include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 
@@ -50,6 +51,37 @@ extern process::Future<Nothing> catchup(
     const IntervalSet<uint64_t>& positions,
     const Duration& timeout = Seconds(10));
 
+
+// The progress of a transfer (see below).
+struct TransferProgress
+{
+  uint64_t transferred; // Number of positions transferred so far.
+  uint64_t bytes; // Size of the actions transferred so far.
+  uint64_t remaining; // Number of positions left to transfer.
+  Duration elapsed; // Time since the transfer started.
+};
+
+
+// Transfers the learned actions within [from, to] from the other
+// replicas in the network to the local replica. Instead of running
+// Paxos for each position, the actions are read in bulk from all the
+// other replicas in parallel, with several outstanding reads to each
+// of them (a replica is no longer read from once it fails to respond
+// within the timeout). This is much faster when the local replica is
+// missing a large part of the log, e.g., a new or wiped replica.
+// Positions that could not be transferred (e.g., not learned by any
+// other replica) remain missing and can be caught-up using the
+// function above. If specified, 'progress' is invoked each time
+// actions have been transferred.
+extern process::Future<Nothing> transfer(
+    const process::Shared<Replica>& replica,
+    const process::Shared<Network>& network,
+    uint64_t from,
+    uint64_t to,
+    const Duration& timeout = Seconds(10),
+    const Option<lambda::function<void(const TransferProgress&)>>& progress =
+      None());
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
@@ -18,6 +18,7 @@
 #include <stdlib.h>
 
 #include <set>
+#include <vector>
 
 #include <process/defer.hpp>
 #include <process/delay.hpp>
@@ -37,6 +38,7 @@
 using namespace process;
 
 using std::set;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -859,6 +861,28 @@ Future<Nothing> learn(const Shared<Network>& network, const Action& action)
 }
 
 
+Future<Nothing> learn(
+    const Shared<Network>& network,
+    const vector<Action>& actions)
+{
+  CHECK(!actions.empty());
+
+  LearnedMessage message;
+  message.mutable_action()->CopyFrom(actions.front());
+  message.mutable_action()->set_learned(true);
+
+  for (size_t i = 1; i < actions.size(); i++) {
+    CHECK_EQ(actions[i - 1].position() + 1, actions[i].position());
+
+    Action* action = message.add_actions();
+    action->CopyFrom(actions[i]);
+    action->set_learned(true);
+  }
+
+  return network->broadcast(message);
+}
+
+
 Future<Action> fill(
     size_t quorum,
     const Shared<Network>& network,
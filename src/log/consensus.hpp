@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <process/future.hpp>
 #include <process/shared.hpp>
 
@@ -113,6 +115,14 @@ extern process::Future<Nothing> learn(
     const Action& action);
 
 
+// Runs the learn phase for several consecutive log positions at once
+// by broadcasting a single learned message. The actions must be
+// ordered by position and non-empty.
+extern process::Future<Nothing> learn(
+    const process::Shared<Network>& network,
+    const std::vector<Action>& actions);
+
+
 // Tries to reach consensus for the given log position by running a
 // full Paxos round (i.e., promise -> write -> learn). If no value has
 // been previously agreed on for the given log position, a NOP will be
@@ -17,15 +17,20 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <map>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
+#include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
 #include "log/consensus.hpp"
@@ -35,7 +40,9 @@
 
 using namespace process;
 
+using std::map;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -47,14 +54,21 @@ public:
   CoordinatorProcess(
       size_t _quorum,
       const Shared<Replica>& _replica,
-      const Shared<Network>& _network)
+      const Shared<Network>& _network,
+      size_t _window)
     : ProcessBase(ID::generate("log-coordinator")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
+      window(_window),
       state(INITIAL),
       proposal(0),
-      index(0) {}
+      index(0),
+      sequence(0),
+      learning(0)
+  {
+    CHECK_GT(window, 0u);
+  }
 
   virtual ~CoordinatorProcess() {}
 
@@ -68,7 +82,13 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreachvalue (const Owned<Write>& write, writes) {
+      write->writing.discard();
+      write->promise.discard();
+    }
+
+    writes.clear();
   }
 
 private:
@@ -92,22 +112,42 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
+  // An append or truncate that has been assigned a log position but
+  // has not been learned yet. The 'id' tells a write apart from a
+  // later write to the same position after this one was given up.
+  struct Write
+  {
+    uint64_t id;
+    Action action;
+    Future<WriteResponse> writing;
+    bool accepted;
+    process::Promise<Option<uint64_t>> promise;
+  };
+
   Future<Option<uint64_t>> write(const Action& action);
   Future<WriteResponse> runWritePhase(const Action& action);
-  Future<Option<uint64_t>> checkWritePhase(
-      const Action& action,
-      const WriteResponse& response);
-  Future<Nothing> runLearnPhase(const Action& action);
-  Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t>> updateIndexAfterWritten(bool missing);
+  void checkWritePhase(
+      uint64_t id,
+      uint64_t position,
+      const Future<WriteResponse>& response);
+  void learn();
+  Future<Nothing> runLearnPhase(const vector<Action>& actions);
+  Future<IntervalSet<uint64_t>> checkLearnPhase(uint64_t from, uint64_t to);
+  void learned(
+      uint64_t id,
+      const Future<IntervalSet<uint64_t>>& missing);
   void writingFinished();
-  void writingFailed();
+  void writingFailed(const string& message);
+  void writingDiscarded(uint64_t id, uint64_t position);
   void writingAborted();
 
   const size_t quorum;
   const Shared<Replica> replica;
   const Shared<Network> network;
 
+  // The maximum number of positions being written concurrently.
+  const size_t window;
+
   // The current state of the coordinator. A coordinator needs to be
   // elected first to perform append and truncate operations. If one
   // tries to do an append or a truncate while the coordinator is not
@@ -130,8 +170,22 @@ private:
   // The position to which the next entry will be written.
   uint64_t index;
 
+  // Used to generate the ids of writes.
+  uint64_t sequence;
+
   Future<Option<uint64_t>> electing;
-  Future<Option<uint64_t>> writing;
+
+  // The writes in flight, keyed by their positions. The coordinator
+  // is in WRITING state iff this is not empty. Writes may be accepted
+  // by a quorum out of order, but are learned (and their futures set)
+  // in the order of their positions.
+  map<uint64_t, Owned<Write>> writes;
+
+  // The number of writes at the front of 'writes' whose learn phase
+  // is in flight. Writes accepted in the meantime are learned in the
+  // next batch, so that a single learned message is broadcasted for
+  // all of them.
+  size_t learning;
 };
 
 
@@ -307,7 +361,7 @@ Future<Option<uint64_t>> CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
+  } else if (state == WRITING && writes.size() >= window) {
     return Failure("Coordinator is currently writing");
   }
 
@@ -327,7 +381,7 @@ Future<Option<uint64_t>> CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
+  } else if (state == WRITING && writes.size() >= window) {
     return Failure("Coordinator is currently writing");
   }
 
@@ -348,18 +402,40 @@ Future<Option<uint64_t>> CoordinatorProcess::write(const Action& action)
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
+  CHECK(state == ELECTED || state == WRITING);
   CHECK(action.has_performed() && action.has_type());
+  CHECK_EQ(action.position(), index);
+  CHECK_LT(writes.size(), window);
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
-
-  return writing;
+  // The position is taken as soon as the write is issued so that the
+  // following appends and truncates can be written concurrently.
+  index++;
+
+  Owned<Write> write(new Write());
+  write->id = sequence++;
+  write->action = action;
+  write->accepted = false;
+
+  writes[action.position()] = write;
+
+  write->writing = runWritePhase(action)
+    .onAny(defer(
+        self(),
+        &Self::checkWritePhase,
+        write->id,
+        action.position(),
+        lambda::_1));
+
+  write->promise.future()
+    .onDiscard(defer(
+        self(),
+        &Self::writingDiscarded,
+        write->id,
+        action.position()));
+
+  return write->promise.future();
 }
 
 
@@ -369,72 +445,226 @@ Future<WriteResponse> CoordinatorProcess::runWritePhase(const Action& action)
 }
 
 
-Future<Option<uint64_t>> CoordinatorProcess::checkWritePhase(
-    const Action& action,
-    const WriteResponse& response)
+void CoordinatorProcess::checkWritePhase(
+    uint64_t id,
+    uint64_t position,
+    const Future<WriteResponse>& response)
 {
-  if (!response.okay()) {
+  // Ignore the write if it has been given up in the meantime.
+  if (writes.count(position) == 0 || writes[position]->id != id) {
+    return;
+  }
+
+  if (response.isDiscarded()) {
+    writingAborted();
+    return;
+  } else if (response.isFailed()) {
+    writingFailed(response.failure());
+    return;
+  }
+
+  if (!response->okay()) {
     // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
+    CHECK_LE(writes[position]->action.performed(), response->proposal());
+    proposal = std::max(proposal, response->proposal());
+
+    // None of the writes at or after this position can be learned
+    // with the current proposal number, so we give up on all of them
+    // and let the next write retry this position.
+    index = position;
+
+    vector<Owned<Write>> rejected;
+    while (writes.count(position) > 0) {
+      rejected.push_back(writes[position]);
+      writes.erase(position++);
+    }
+
+    foreach (const Owned<Write>& write, rejected) {
+      write->writing.discard();
+      write->promise.set(Option<uint64_t>::none());
+    }
+
+    if (writes.empty()) {
+      writingFinished();
+    }
+
+    return;
+  }
 
-    return None();
+  writes[position]->accepted = true;
+
+  learn();
+}
+
+
+void CoordinatorProcess::learn()
+{
+  // Wait for the batch in flight to be learned, the writes accepted
+  // in the meantime will be learned together in the next batch.
+  if (learning > 0) {
+    return;
+  }
+
+  // Only the accepted writes at the front can be learned so that
+  // positions are always learned in order.
+  vector<Action> actions;
+  foreachvalue (const Owned<Write>& write, writes) {
+    if (!write->accepted) {
+      break;
+    }
+
+    actions.push_back(write->action);
+  }
+
+  if (actions.empty()) {
+    return;
   }
 
-  return runLearnPhase(action)
-    .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+  learning = actions.size();
+
+  runLearnPhase(actions)
+    .then(defer(
+        self(),
+        &Self::checkLearnPhase,
+        actions.front().position(),
+        actions.back().position()))
+    .onAny(defer(
+        self(),
+        &Self::learned,
+        writes.begin()->second->id,
+        lambda::_1));
 }
 
 
-Future<Nothing> CoordinatorProcess::runLearnPhase(const Action& action)
+Future<Nothing> CoordinatorProcess::runLearnPhase(
+    const vector<Action>& actions)
 {
-  return log::learn(network, action);
+  if (actions.size() == 1) {
+    return log::learn(network, actions.front());
+  }
+
+  return log::learn(network, actions);
 }
 
 
-Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
+Future<IntervalSet<uint64_t>> CoordinatorProcess::checkLearnPhase(
+    uint64_t from,
+    uint64_t to)
 {
   // Make sure that the local replica has learned the newly written
-  // log entry. Since messages are delivered and dispatched in order
-  // locally, we should always have the new entry learned by now.
-  return replica->missing(action.position());
+  // log entries. Since messages are delivered and dispatched in order
+  // locally, we should always have the new entries learned by now.
+  return replica->missing(from, to);
 }
 
 
-Future<Option<uint64_t>> CoordinatorProcess::updateIndexAfterWritten(
-    bool missing)
+void CoordinatorProcess::learned(
+    uint64_t id,
+    const Future<IntervalSet<uint64_t>>& missing)
 {
-  CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+  // Ignore the batch if its writes have been given up in the meantime.
+  if (writes.empty() || writes.begin()->second->id != id) {
+    return;
+  }
+
+  if (missing.isDiscarded()) {
+    writingAborted();
+    return;
+  } else if (missing.isFailed()) {
+    writingFailed(missing.failure());
+    return;
+  }
+
+  CHECK(missing->empty())
+    << "Not expecting local replica to be missing positions "
+    << stringify(missing.get()) << " after the writing is done";
+
+  vector<Owned<Write>> learned;
+  for (; learning > 0; learning--) {
+    CHECK(!writes.empty());
+
+    learned.push_back(writes.begin()->second);
+    writes.erase(writes.begin());
+  }
 
-  return index++;
+  foreach (const Owned<Write>& write, learned) {
+    write->promise.set(Option<uint64_t>(write->action.position()));
+  }
+
+  if (writes.empty()) {
+    writingFinished();
+  } else {
+    learn();
+  }
 }
 
 
 void CoordinatorProcess::writingFinished()
 {
   CHECK_EQ(state, WRITING);
+  CHECK(writes.empty());
   state = ELECTED;
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::writingFailed(const string& message)
 {
-  CHECK_EQ(state, WRITING);
+  if (state != WRITING) {
+    return;
+  }
+
+  vector<Owned<Write>> failed;
+  foreachvalue (const Owned<Write>& write, writes) {
+    failed.push_back(write);
+  }
+
+  writes.clear();
+  learning = 0;
   state = INITIAL;
+
+  foreach (const Owned<Write>& write, failed) {
+    write->writing.discard();
+    write->promise.fail(message);
+  }
+}
+
+
+void CoordinatorProcess::writingDiscarded(uint64_t id, uint64_t position)
+{
+  // Ignore the discard if the write is no longer in flight.
+  if (writes.count(position) == 0 || writes[position]->id != id) {
+    return;
+  }
+
+  writingAborted();
 }
 
 
 void CoordinatorProcess::writingAborted()
 {
-  CHECK_EQ(state, WRITING);
+  if (state != WRITING) {
+    return;
+  }
 
   // Demote the coordinator if a write operation is discarded since we
   // don't actually know the write was successful or not and we really
   // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
+  // write (see MESOS-1038 for more details). All the other writes in
+  // flight are discarded as well since they can not be learned once
+  // a position before them might be missing.
+  vector<Owned<Write>> aborted;
+  foreachvalue (const Owned<Write>& write, writes) {
+    aborted.push_back(write);
+  }
+
+  writes.clear();
+  learning = 0;
   state = INITIAL;
+
+  foreach (const Owned<Write>& write, aborted) {
+    write->writing.discard();
+    write->promise.discard();
+  }
 }
 
 
@@ -446,9 +676,10 @@ void CoordinatorProcess::writingAborted()
 Coordinator::Coordinator(
     size_t quorum,
     const Shared<Replica>& replica,
-    const Shared<Network>& network)
+    const Shared<Network>& network,
+    size_t window)
 {
-  process = new CoordinatorProcess(quorum, replica, network);
+  process = new CoordinatorProcess(quorum, replica, network, window);
   spawn(process);
 }
 
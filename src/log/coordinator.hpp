@@ -40,10 +40,15 @@ class CoordinatorProcess;
 class Coordinator
 {
 public:
+  // Up to 'window' appends and truncates can be in flight at once.
+  // Their positions are written concurrently but learned in order,
+  // and the positions accepted together are learned using a single
+  // broadcast to the network.
   Coordinator(
       size_t quorum,
       const process::Shared<Replica>& replica,
-      const process::Shared<Network>& network);
+      const process::Shared<Network>& network,
+      size_t window = 1);
 
   ~Coordinator();
 
@@ -60,7 +65,9 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. Fails if the window of writes in
+  // flight is full. The returned futures of concurrent appends and
+  // truncates are set in the order of their positions.
   process::Future<Option<uint64_t>> append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
@@ -25,6 +25,7 @@
 
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -127,14 +128,27 @@ static string encode(uint64_t position, bool adjust = true)
 
 
 LevelDBStorage::LevelDBStorage()
-  : db(nullptr), first(None())
+  : db(nullptr), first(None()), begin(0), stopping(false)
 {
-  // Nothing to see here.
+  compactor = std::thread(&LevelDBStorage::_compact, this);
 }
 
 
 LevelDBStorage::~LevelDBStorage()
 {
+  // Stop the background compactions before closing the db, only
+  // waiting for the one in progress (if any). The queued ones are
+  // dropped since the truncated positions are compacted again when
+  // restoring (see LevelDBStorage::restore).
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    compactions.clear();
+  }
+
+  queued.notify_one();
+  compactor.join();
+
   delete db; // Might be null if open failed in LevelDBStorage::restore.
 }
 
@@ -173,17 +187,59 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   VLOG(1) << "Opened db in " << stopwatch.elapsed();
 
-  stopwatch.start(); // Restart the stopwatch.
+  // Look for a checkpoint in the metadata, in which case we only need
+  // to read the positions after it.
+  Option<Metadata> metadata;
 
-  // TODO(benh): Conditionally compact to avoid long recovery times?
-  db->CompactRange(nullptr, nullptr);
+  string value;
+  status = db->Get(leveldb::ReadOptions(), encode(0, false), &value);
 
-  VLOG(1) << "Compacted db in " << stopwatch.elapsed();
+  if (status.ok()) {
+    Record record;
+
+    if (!record.ParseFromString(value)) {
+      return Error("Failed to deserialize record");
+    }
+
+    if (record.type() == Record::METADATA &&
+        record.metadata().has_checkpoint()) {
+      metadata = record.metadata();
+    }
+  } else if (!status.IsNotFound()) {
+    return Error(status.ToString());
+  }
 
   State state;
   state.begin = 0;
   state.end = 0;
 
+  if (metadata.isSome()) {
+    const Metadata::Checkpoint& checkpoint = metadata->checkpoint();
+
+    VLOG(1) << "Found checkpoint at position " << checkpoint.position();
+
+    state.metadata = metadata.get();
+    state.begin = checkpoint.begin();
+    state.end = checkpoint.position();
+    state.learned += (Bound<uint64_t>::closed(checkpoint.begin()),
+                      Bound<uint64_t>::closed(checkpoint.position()));
+
+    first = checkpoint.first();
+
+    // The positions deleted by truncations are compacted in the
+    // background once they have been deleted, but this might not
+    // have completed before the replica stopped.
+    compact(None(), checkpoint.first());
+  } else {
+    stopwatch.start(); // Restart the stopwatch.
+
+    // Without a checkpoint every key is read below, so we compact
+    // the db first to skip the keys deleted by truncations.
+    db->CompactRange(nullptr, nullptr);
+
+    VLOG(1) << "Compacted db in " << stopwatch.elapsed();
+  }
+
   // TODO(benh): Consider just reading the "promise" record (e.g.,
   // 'encode(0, false)') and then iterating over the rest of the
   // records and confirming that they are all indeed of type
@@ -197,7 +253,11 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   stopwatch.start(); // Restart the stopwatch.
 
-  iterator->SeekToFirst();
+  if (metadata.isSome()) {
+    iterator->Seek(encode(metadata->checkpoint().position() + 1));
+  } else {
+    iterator->SeekToFirst();
+  }
 
   VLOG(1) << "Seeked to beginning of db in " << stopwatch.elapsed();
 
@@ -273,6 +333,10 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   delete iterator;
 
+  begin = state.begin;
+  stored = state.metadata;
+  learned = state.learned;
+
   return state;
 }
 
@@ -289,6 +353,14 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
   record.set_type(Record::METADATA);
   record.mutable_metadata()->CopyFrom(metadata);
 
+  // Keep the checkpoint, which is only advanced by the storage.
+  if (stored.has_checkpoint()) {
+    record.mutable_metadata()->mutable_checkpoint()->CopyFrom(
+        stored.checkpoint());
+  } else {
+    record.mutable_metadata()->clear_checkpoint();
+  }
+
   string value;
 
   if (!record.SerializeToString(&value)) {
@@ -301,6 +373,8 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
     return Error(status.ToString());
   }
 
+  stored = record.metadata();
+
   VLOG(1) << "Persisting metadata (" << value.size()
           << " bytes) to leveldb took " << stopwatch.elapsed();
 
@@ -310,8 +384,22 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
 {
-  Stopwatch stopwatch;
-  stopwatch.start();
+  Try<Nothing> staged = stage(action);
+
+  if (staged.isError()) {
+    return staged;
+  }
+
+  return commit();
+}
+
+
+Try<Nothing> LevelDBStorage::stage(const Action& action)
+{
+  // Remember the state to restore if the commit fails.
+  if (committed.isNone()) {
+    committed = Committed{first, begin, learned};
+  }
 
   Record record;
   record.set_type(Record::ACTION);
@@ -323,14 +411,8 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     return Error("Failed to serialize record");
   }
 
-  leveldb::WriteOptions options;
-  options.sync = true;
-
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
-
-  if (!status.ok()) {
-    return Error(status.ToString());
-  }
+  batch.Put(encode(action.position()), value);
+  staged[action.position()] = action;
 
   // Updated the first position. Notice that we use 'min' here instead
   // of checking 'isNone()' because it's likely that log entries are
@@ -338,18 +420,18 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   // catch-up policy is used).
   first = min(first, action.position());
 
-  VLOG(1) << "Persisting action (" << value.size()
-          << " bytes) to leveldb took " << stopwatch.elapsed();
+  if (action.has_learned() && action.learned()) {
+    learned += action.position();
+  } else {
+    learned -= action.position();
+  }
 
-  // Delete positions if a truncate action has been *learned*. Note
-  // that we do this in a best-effort fashion (i.e., we ignore any
-  // failures to the database since we can always try again).
+  // Delete positions if a truncate action has been *learned*. The
+  // deletes are committed together with the staged actions.
   if (action.has_type() && action.type() == Action::TRUNCATE &&
       action.has_learned() && action.learned()) {
     CHECK(action.has_truncate());
 
-    stopwatch.start(); // Restart the stopwatch.
-
     // To actually perform the truncation in leveldb we need to remove
     // all the keys that represent positions no longer in the log. We
     // do this by attempting to delete all keys that represent the
@@ -365,8 +447,6 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     // cheaper than using an iterator to determine the first position
     // (which was, for posterity, the second implementation).
 
-    leveldb::WriteBatch batch;
-
     CHECK_SOME(first);
 
     // Add positions up to (but excluding) the truncate position to
@@ -380,37 +460,208 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
     uint64_t index = 0;
     while ((first.get() + index) < action.truncate().to()) {
       batch.Delete(encode(first.get() + index));
+      staged.erase(first.get() + index);
       index++;
     }
 
-    // If we added any positions, attempt to delete them!
+    // Save the new first position!
     if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        VLOG(1) << "Deleting ~" << index
-                << " keys from leveldb took " << stopwatch.elapsed();
-      }
+      truncated += (Bound<uint64_t>::closed(first.get()),
+                    Bound<uint64_t>::open(action.truncate().to()));
+
+      first = action.truncate().to();
+    }
+
+    begin = std::max(begin, action.truncate().to());
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> LevelDBStorage::commit()
+{
+  if (staged.empty()) {
+    committed = None();
+    return Nothing();
+  }
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // Advance the checkpoint together with the staged actions.
+  Option<Metadata> metadata = checkpoint();
+
+  if (metadata.isSome()) {
+    Record record;
+    record.set_type(Record::METADATA);
+    record.mutable_metadata()->CopyFrom(metadata.get());
+
+    string value;
+
+    if (record.SerializeToString(&value)) {
+      batch.Put(encode(0, false), value);
+    } else {
+      metadata = None(); // Retried on the next commit.
     }
   }
 
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  const size_t size = staged.size();
+
+  batch.Clear();
+  staged.clear();
+
+  CHECK_SOME(committed);
+
+  if (!status.ok()) {
+    // Roll back the positions updated by the staged actions (and
+    // the checkpoint) since none of them have been written.
+    first = committed->first;
+    begin = committed->begin;
+    learned = committed->learned;
+
+    committed = None();
+    truncated = IntervalSet<uint64_t>();
+
+    return Error(status.ToString());
+  }
+
+  committed = None();
+
+  VLOG(1) << "Persisting " << size << " action(s) to leveldb took "
+          << stopwatch.elapsed();
+
+  if (metadata.isSome()) {
+    stored = metadata.get();
+  }
+
+  foreach (const Interval<uint64_t>& interval, truncated) {
+    compact(interval.lower(), interval.upper());
+  }
+
+  truncated = IntervalSet<uint64_t>();
+
   return Nothing();
 }
 
 
+Option<Metadata> LevelDBStorage::checkpoint()
+{
+  // The checkpoint is stored with the metadata, so there is nothing
+  // to do until the metadata has been stored.
+  if (first.isNone() || !stored.IsInitialized()) {
+    return None();
+  }
+
+  // The positions from the beginning of the log up to the checkpoint
+  // are known to be learned, so we look for the learned positions
+  // that immediately follow them.
+  uint64_t from = begin;
+
+  if (stored.has_checkpoint() && stored.checkpoint().position() >= begin) {
+    from = stored.checkpoint().position() + 1;
+  }
+
+  learned -= (Bound<uint64_t>::closed(0), Bound<uint64_t>::open(from));
+
+  uint64_t position;
+
+  if (!learned.empty() && learned.begin()->lower() == from) {
+    position = learned.begin()->upper() - 1;
+  } else if (from > 0) {
+    // Nothing new has been learned after the checkpoint, but we might
+    // still need to store it if the log has been truncated (in which
+    // case the checkpoint might even be empty, i.e., end right before
+    // the beginning of the log).
+    position = from - 1;
+  } else {
+    return None();
+  }
+
+  if (stored.has_checkpoint() &&
+      stored.checkpoint().position() == position &&
+      stored.checkpoint().begin() == begin &&
+      stored.checkpoint().first() == first.get()) {
+    return None();
+  }
+
+  Metadata metadata = stored;
+  metadata.mutable_checkpoint()->set_position(position);
+  metadata.mutable_checkpoint()->set_begin(begin);
+  metadata.mutable_checkpoint()->set_first(first.get());
+
+  return metadata;
+}
+
+
+void LevelDBStorage::compact(const Option<uint64_t>& from, uint64_t to)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    compactions.push_back(std::make_pair(from, to));
+  }
+
+  queued.notify_one();
+}
+
+
+void LevelDBStorage::_compact()
+{
+  while (true) {
+    Option<uint64_t> from;
+    uint64_t to;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      queued.wait(lock, [this]() {
+        return stopping || !compactions.empty();
+      });
+
+      if (stopping) {
+        return;
+      }
+
+      from = compactions.front().first;
+      to = compactions.front().second;
+
+      compactions.pop_front();
+    }
+
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    const string limit = encode(to);
+    leveldb::Slice end(limit);
+
+    if (from.isSome()) {
+      const string start = encode(from.get());
+      leveldb::Slice begin(start);
+      db->CompactRange(&begin, &end);
+    } else {
+      db->CompactRange(nullptr, &end);
+    }
+
+    VLOG(1) << "Compacted db up to position " << to
+            << " in " << stopwatch.elapsed();
+  }
+}
+
+
 Try<Action> LevelDBStorage::read(uint64_t position)
 {
   Stopwatch stopwatch;
   stopwatch.start();
 
+  if (staged.contains(position)) {
+    return staged.at(position);
+  }
+
   leveldb::ReadOptions options;
 
   string value;
@@ -18,9 +18,18 @@
 #define __LOG_LEVELDB_HPP__
 
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <stdint.h>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <stout/hashmap.hpp>
+#include <stout/interval.hpp>
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -40,12 +49,68 @@ public:
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
   virtual Try<Action> read(uint64_t position);
+  virtual Try<Nothing> stage(const Action& action);
+  virtual Try<Nothing> commit();
 
 private:
+  // Advances the checkpoint past the learned positions that follow
+  // it, returning the metadata with the new checkpoint (if any).
+  Option<Metadata> checkpoint();
+
+  // Compacts the positions in [from, to) in the background, e.g.,
+  // once they have been deleted by a truncation, so that the deleted
+  // keys are not read again when restoring.
+  void compact(const Option<uint64_t>& from, uint64_t to);
+
+  // Runs the compactions queued by 'compact' until stopping.
+  void _compact();
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // Beginning position of the log (after learned truncations).
+  uint64_t begin;
+
+  // The metadata as last stored, including the checkpoint (if any).
+  Metadata stored;
+
+  // Learned positions after the checkpoint, used to advance it.
+  IntervalSet<uint64_t> learned;
+
+  // The state as of the last commit, restored if the staged actions
+  // fail to be committed.
+  struct Committed
+  {
+    Option<uint64_t> first;
+    uint64_t begin;
+    IntervalSet<uint64_t> learned;
+  };
+
+  Option<Committed> committed;
+
+  // Positions deleted by the staged truncations, to be compacted
+  // once they have been committed.
+  IntervalSet<uint64_t> truncated;
+
+  // The background compactions run in order on a dedicated thread
+  // (rather than on a libprocess worker thread) which is joined
+  // before closing the database.
+  std::thread compactor;
+
+  // Protects the queued compactions and 'stopping'.
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::deque<std::pair<Option<uint64_t>, uint64_t>> compactions;
+  bool stopping;
+
+  // The writes (and truncation deletes) of the staged actions, which
+  // are written to leveldb with a single sync on commit.
+  leveldb::WriteBatch batch;
+
+  // The staged actions, so that they can be read before the commit.
+  hashmap<uint64_t, Action> staged;
 };
 
 } // namespace log {
@@ -186,12 +186,17 @@ Future<Shared<Replica>> LogProcess::recover()
     // 'release' in Shared which will provide this CHECK internally.
     CHECK(replica.unique());
 
+    // Keep track of the catch-up progress for the metrics.
+    lambda::function<void(const TransferProgress&)> progress =
+      defer(self(), &Self::transferring, lambda::_1);
+
     recovering =
       log::recover(
           quorum,
           replica.own().get(),
           network,
-          autoInitialize)
+          autoInitialize,
+          progress)
       .onAny(defer(self(), &Self::_recover));
   }
 
@@ -242,12 +247,40 @@ void LogProcess::_recover()
 }
 
 
+void LogProcess::transferring(const TransferProgress& progress)
+{
+  transferred = progress;
+}
+
+
 double LogProcess::_recovered()
 {
   return recovered.future().isReady() ? 1 : 0;
 }
 
 
+double LogProcess::_catchup_transferred()
+{
+  return transferred.isSome() ? transferred->transferred : 0;
+}
+
+
+double LogProcess::_catchup_remaining()
+{
+  return transferred.isSome() ? transferred->remaining : 0;
+}
+
+
+double LogProcess::_catchup_throughput()
+{
+  if (transferred.isNone() || transferred->elapsed == Duration::zero()) {
+    return 0;
+  }
+
+  return transferred->transferred / transferred->elapsed.secs();
+}
+
+
 void LogProcess::watch(
     const UPID& pid,
     const set<zookeeper::Group::Membership>& memberships)
@@ -442,10 +475,11 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+LogWriterProcess::LogWriterProcess(Log* log, size_t _window)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
+    window(_window),
     recovering(dispatch(log->process, &LogProcess::recover)),
     coordinator(nullptr),
     error(None()) {}
@@ -531,7 +565,7 @@ Future<Option<Log::Position>> LogWriterProcess::_start()
 
   CHECK_READY(recovering);
 
-  coordinator = new Coordinator(quorum, recovering.get(), network);
+  coordinator = new Coordinator(quorum, recovering.get(), network, window);
 
   LOG(INFO) << "Attempting to start the writer";
 
@@ -719,9 +753,9 @@ Future<Log::Position> Log::Reader::ending()
 /////////////////////////////////////////////////
 
 
-Log::Writer::Writer(Log* log)
+Log::Writer::Writer(Log* log, size_t window)
 {
-  process = new LogWriterProcess(log);
+  process = new LogWriterProcess(log, window);
   spawn(process);
 }
 
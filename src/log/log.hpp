@@ -75,9 +75,20 @@ private:
   // Continuations.
   void _recover();
 
+  // Invoked as the missing positions are transferred from the other
+  // replicas during the recovery.
+  void transferring(const TransferProgress& progress);
+
   // Return true if the log has finished recovery.
   double _recovered();
 
+  // The number of positions transferred and left to transfer, and
+  // the number of positions transferred per second, while catching up
+  // during the recovery.
+  double _catchup_transferred();
+  double _catchup_remaining();
+  double _catchup_throughput();
+
   // TODO(benh): Factor this out into "membership renewer".
   void watch(
       const process::UPID& pid,
@@ -95,6 +106,7 @@ private:
   Option<process::Future<process::Owned<Replica>>> recovering;
   process::Promise<Nothing> recovered;
   std::list<process::Promise<process::Shared<Replica>>*> promises;
+  Option<TransferProgress> transferred;
 
   // For renewing membership. We store a Group instance in order to
   // continually renew the replicas membership (when using ZooKeeper).
@@ -163,7 +175,7 @@ private:
 class LogWriterProcess : public process::Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(mesos::log::Log* log);
+  LogWriterProcess(mesos::log::Log* log, size_t window);
 
   process::Future<Option<mesos::log::Log::Position>> start();
   process::Future<Option<mesos::log::Log::Position>> append(
@@ -195,6 +207,7 @@ private:
 
   const size_t quorum;
   const process::Shared<Network> network;
+  const size_t window;
 
   process::Future<process::Shared<Replica>> recovering;
   std::list<process::Promise<Nothing>*> promises;
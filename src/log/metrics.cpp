@@ -38,10 +38,22 @@ Metrics::Metrics(
         defer(process, &LogProcess::_recovered)),
     ensemble_size(
         prefix.getOrElse("") + "log/ensemble_size",
-        defer(process, &LogProcess::_ensemble_size))
+        defer(process, &LogProcess::_ensemble_size)),
+    catchup_transferred(
+        prefix.getOrElse("") + "log/catchup/transferred",
+        defer(process, &LogProcess::_catchup_transferred)),
+    catchup_remaining(
+        prefix.getOrElse("") + "log/catchup/remaining",
+        defer(process, &LogProcess::_catchup_remaining)),
+    catchup_throughput(
+        prefix.getOrElse("") + "log/catchup/throughput",
+        defer(process, &LogProcess::_catchup_throughput))
 {
   process::metrics::add(recovered);
   process::metrics::add(ensemble_size);
+  process::metrics::add(catchup_transferred);
+  process::metrics::add(catchup_remaining);
+  process::metrics::add(catchup_throughput);
 }
 
 
@@ -49,6 +61,9 @@ Metrics::~Metrics()
 {
   process::metrics::remove(recovered);
   process::metrics::remove(ensemble_size);
+  process::metrics::remove(catchup_transferred);
+  process::metrics::remove(catchup_remaining);
+  process::metrics::remove(catchup_throughput);
 }
 
 } // namespace log {
@@ -39,6 +39,10 @@ struct Metrics
   process::metrics::Gauge recovered;
 
   process::metrics::Gauge ensemble_size;
+
+  process::metrics::Gauge catchup_transferred;
+  process::metrics::Gauge catchup_remaining;
+  process::metrics::Gauge catchup_throughput;
 };
 
 } // namespace log {
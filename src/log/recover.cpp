@@ -436,12 +436,15 @@ public:
       size_t _quorum,
       const Owned<Replica>& _replica,
       const Shared<Network>& _network,
-      bool _autoInitialize)
+      bool _autoInitialize,
+      const Option<lambda::function<void(const TransferProgress&)>>&
+        _progress)
     : ProcessBase(ID::generate("log-recover")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
-      autoInitialize(_autoInitialize) {}
+      autoInitialize(_autoInitialize),
+      progress(_progress) {}
 
   Future<Owned<Replica>> future() { return promise.future(); }
 
@@ -546,21 +549,37 @@ private:
 
     LOG(INFO) << "Starting catch-up from position " << begin << " to " << end;
 
-    IntervalSet<uint64_t> positions(
-        Bound<uint64_t>::closed(begin),
-        Bound<uint64_t>::closed(end));
-
     // Share the ownership of the replica. From this point until the
     // point where the ownership of the replica is regained, we should
     // not access the 'replica' field.
     Shared<Replica> shared = replica.share();
 
+    // Most of the positions have usually been learned by the other
+    // replicas already, so we first transfer them in bulk and only
+    // run Paxos for the positions that are still missing afterwards.
+    return log::transfer(shared, network, begin, end, Seconds(10), progress)
+      .then(defer(self(), &Self::_catchup, shared, begin, end))
+      .then(defer(self(), &Self::getReplicaOwnership, shared))
+      .then(defer(self(), &Self::updateReplicaStatus, Metadata::VOTING));
+  }
+
+  Future<Nothing> _catchup(Shared<Replica> shared, uint64_t begin, uint64_t end)
+  {
+    return shared->missing(begin, end)
+      .then(defer(self(), &Self::__catchup, shared, lambda::_1));
+  }
+
+  Future<Nothing> __catchup(
+      Shared<Replica> shared,
+      const IntervalSet<uint64_t>& positions)
+  {
+    LOG(INFO) << "Catching-up " << positions.size()
+              << " position(s) that were not transferred";
+
     // Since we do not know what proposal number to use (the log is
     // empty), we use none and leave log::catchup to automatically
     // bump the proposal number.
-    return log::catchup(quorum, shared, network, None(), positions)
-      .then(defer(self(), &Self::getReplicaOwnership, shared))
-      .then(defer(self(), &Self::updateReplicaStatus, Metadata::VOTING));
+    return log::catchup(quorum, shared, network, None(), positions);
   }
 
   Future<Nothing> updateReplicaStatus(const Metadata::Status& status)
@@ -617,6 +636,7 @@ private:
   Owned<Replica> replica;
   const Shared<Network> network;
   const bool autoInitialize;
+  const Option<lambda::function<void(const TransferProgress&)>> progress;
 
   Future<Nothing> chain;
 
@@ -628,14 +648,16 @@ Future<Owned<Replica>> recover(
     size_t quorum,
     const Owned<Replica>& replica,
     const Shared<Network>& network,
-    bool autoInitialize)
+    bool autoInitialize,
+    const Option<lambda::function<void(const TransferProgress&)>>& progress)
 {
   RecoverProcess* process =
     new RecoverProcess(
         quorum,
         replica,
         network,
-        autoInitialize);
+        autoInitialize,
+        progress);
 
   Future<Owned<Replica>> future = process->future();
   spawn(process, true);
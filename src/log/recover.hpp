@@ -23,8 +23,11 @@
 #include <process/owned.hpp>
 #include <process/shared.hpp>
 
+#include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 
+#include "log/catchup.hpp"
 #include "log/network.hpp"
 #include "log/replica.hpp"
 
@@ -49,11 +52,15 @@ namespace log {
 // an empty replica will be allowed to vote if ALL replicas (i.e.,
 // quorum * 2 - 1) are empty. This allows us to bootstrap the
 // replicated log without explicitly using an initialization tool.
+// If specified, 'progress' is invoked as the missing positions are
+// transferred from the other replicas (see 'transfer').
 extern process::Future<process::Owned<Replica>> recover(
     size_t quorum,
     const process::Owned<Replica>& replica,
     const process::Shared<Network>& network,
-    bool autoInitialize = false);
+    bool autoInitialize = false,
+    const Option<lambda::function<void(const TransferProgress&)>>& progress =
+      None());
 
 } // namespace log {
 } // namespace internal {
@@ -17,12 +17,16 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/exit.hpp>
@@ -30,6 +34,7 @@
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 #include <stout/utils.hpp>
 
@@ -42,7 +47,9 @@
 using namespace process;
 
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -54,10 +61,17 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<ReadRequest, ReadResponse> read;
 
 } // namespace protocol {
 
 
+// The (approximate) maximum size of the actions returned by a single
+// read request, so that a replica catching up a large log is sent
+// the actions in reasonably sized batches.
+static const Bytes MAX_READ_RESPONSE_SIZE = Megabytes(4);
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
@@ -99,6 +113,9 @@ public:
   // Returns the highest implicit promise this replica has given.
   uint64_t promised();
 
+  // Returns once the staged actions (if any) have been committed.
+  Future<Nothing> committed();
+
   // Updates the status of this replica. The update will be persisted
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
@@ -114,13 +131,40 @@ private:
   // Handles a request from a recover process.
   void recover(const UPID& from, const RecoverRequest& request);
 
-  // Handles a message notifying of a learned action.
-  void learned(const UPID& from, const Action& action);
+  // Handles a request from a replica catching up to read the learned
+  // actions within a range of positions (see 'log::transfer').
+  void transfer(const UPID& from, const ReadRequest& request);
+
+  // Handles a message notifying of learned actions.
+  void learned(
+      const UPID& from,
+      const Action& action,
+      const vector<Action>& actions);
 
   // Persists the specified action to storage. Returns true on success
   // and false otherwise.
   bool persist(const Action& action);
 
+  // Stages the specified action in storage to be persisted by the
+  // next commit, which is dispatched after the messages already
+  // queued for this replica so that the writes arriving together
+  // share a single sync. The positions of the log are updated right
+  // away, see 'commit()'. Returns true on success and false otherwise.
+  bool stage(const Action& action);
+
+  // Commits the staged actions and sends the responses that were
+  // waiting for them. Rolls back if the commit fails.
+  void commit();
+
+  // Restores the positions of the log as of the last commit after
+  // the staged actions failed to be committed, and drops the
+  // responses (and fails the callers) that were waiting for them.
+  void rollback(const string& message);
+
+  // Updates the positions of the log after the specified action has
+  // been written to storage.
+  void written(const Action& action);
+
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
   // otherwise.
@@ -147,13 +191,34 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // The write responses waiting for the staged actions to be
+  // committed, and whether a commit has been dispatched.
+  vector<pair<UPID, WriteResponse>> pending;
+  bool committing;
+
+  // The callers of 'committed()' waiting for the staged actions.
+  vector<Owned<process::Promise<Nothing>>> waiting;
+
+  // The positions of the log as of the last commit, if any actions
+  // have been staged since.
+  struct Positions
+  {
+    uint64_t begin;
+    uint64_t end;
+    IntervalSet<uint64_t> holes;
+    IntervalSet<uint64_t> unlearned;
+  };
+
+  Option<Positions> lastCommitted;
 };
 
 
 ReplicaProcess::ReplicaProcess(const string& path)
   : ProcessBase(ID::generate("log-replica")),
     begin(0),
-    end(0)
+    end(0),
+    committing(false)
 {
   // TODO(benh): Factor out and expose storage.
   storage = new LevelDBStorage();
@@ -170,9 +235,13 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
+  install<ReadRequest>(
+      &ReplicaProcess::transfer);
+
   install<LearnedMessage>(
       &ReplicaProcess::learned,
-      &LearnedMessage::action);
+      &LearnedMessage::action,
+      &LearnedMessage::actions);
 }
 
 
@@ -306,6 +375,18 @@ uint64_t ReplicaProcess::promised()
 }
 
 
+Future<Nothing> ReplicaProcess::committed()
+{
+  if (!committing) {
+    return Nothing();
+  }
+
+  Owned<process::Promise<Nothing>> promise(new process::Promise<Nothing>());
+  waiting.push_back(promise);
+  return promise->future();
+}
+
+
 bool ReplicaProcess::update(const Metadata::Status& status)
 {
   Metadata metadata_;
@@ -578,13 +659,13 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
+      if (stage(action)) {
         WriteResponse response;
         response.set_type(WriteResponse::ACCEPT);
         response.set_okay(true);
         response.set_proposal(request.proposal());
         response.set_position(request.position());
-        reply(response);
+        pending.push_back(std::make_pair(from, response));
       }
     }
   } else if (result.isSome()) {
@@ -657,13 +738,13 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
+        if (stage(action)) {
           WriteResponse response;
           response.set_type(WriteResponse::ACCEPT);
           response.set_okay(true);
           response.set_proposal(request.proposal());
           response.set_position(request.position());
-          reply(response);
+          pending.push_back(std::make_pair(from, response));
         }
       }
     }
@@ -689,13 +770,71 @@ void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
 }
 
 
-void ReplicaProcess::learned(const UPID& from, const Action& action)
+void ReplicaProcess::transfer(const UPID& from, const ReadRequest& request)
+{
+  LOG(INFO) << "Replica in " << status()
+            << " status received a read request for positions "
+            << request.from() << " to " << request.to() << " from " << from;
+
+  ReadResponse response;
+
+  // Only the learned actions are returned since their values can no
+  // longer change. We stop at the first position that has not been
+  // learned (or is missing) so that the returned actions are always
+  // at consecutive positions.
+  Bytes size = 0;
+
+  for (uint64_t position = std::max(request.from(), begin);
+       position <= std::min(request.to(), end) &&
+         size < MAX_READ_RESPONSE_SIZE;
+       position++) {
+    Result<Action> action = read(position);
+
+    if (action.isError()) {
+      LOG(ERROR) << "Error getting log record at " << position
+                 << ": " << action.error();
+      break;
+    } else if (action.isNone() ||
+               !action->has_learned() ||
+               !action->learned()) {
+      break;
+    }
+
+    size += Bytes(action->ByteSize());
+    response.add_actions()->CopyFrom(action.get());
+  }
+
+  reply(response);
+}
+
+
+void ReplicaProcess::learned(
+    const UPID& from,
+    const Action& action,
+    const vector<Action>& actions)
 {
   LOG(INFO) << "Replica received learned notice for position "
-            << action.position() << " from " << from;
+            << action.position()
+            << (actions.empty()
+                ? ""
+                : " to " + stringify(actions.back().position()))
+            << " from " << from;
 
   CHECK(action.learned());
-  persist(action);
+
+  if (!stage(action)) {
+    return;
+  }
+
+  foreach (const Action& next, actions) {
+    CHECK(next.learned());
+
+    // Stop at the first failure so that the learned positions remain
+    // a prefix of the batch; the rest will be filled by catch-up.
+    if (!stage(next)) {
+      return;
+    }
+  }
 }
 
 
@@ -705,12 +844,124 @@ bool ReplicaProcess::persist(const Action& action)
 
   if (persisted.isError()) {
     LOG(ERROR) << "Error writing to log: " << persisted.error();
+
+    // The actions staged before this one failed to be committed too.
+    if (lastCommitted.isSome()) {
+      rollback(persisted.error());
+    }
+
     return false;
   }
 
+  // The actions staged before this one have been committed too.
+  lastCommitted = None();
+
   VLOG(1) << "Persisted action " << action.type()
           << " at position " << action.position();
 
+  written(action);
+
+  return true;
+}
+
+
+bool ReplicaProcess::stage(const Action& action)
+{
+  Try<Nothing> staged = storage->stage(action);
+
+  if (staged.isError()) {
+    LOG(ERROR) << "Error writing to log: " << staged.error();
+    return false;
+  }
+
+  if (lastCommitted.isNone()) {
+    lastCommitted = Positions{begin, end, holes, unlearned};
+  }
+
+  if (!committing) {
+    committing = true;
+    dispatch(self(), &ReplicaProcess::commit);
+  }
+
+  written(action);
+
+  return true;
+}
+
+
+void ReplicaProcess::commit()
+{
+  CHECK(committing);
+  committing = false;
+
+  Try<Nothing> committed = storage->commit();
+
+  // NOTE: The positions of the log were updated when the actions got
+  // staged rather than here, since a local coordinator expects this
+  // replica to know about the positions it has learned as soon as the
+  // learned message has been processed (see 'checkLearnPhase' in
+  // coordinator.cpp). The staged actions are lost if the commit fails
+  // though (the storage rolls back to the last commit), so we can't
+  // carry on with positions that are not in storage, e.g., reporting
+  // them as learned to a coordinator.
+  if (committed.isError()) {
+    LOG(ERROR) << "Failed to commit the staged actions to the log: "
+               << committed.error();
+
+    rollback(committed.error());
+    return;
+  }
+
+  lastCommitted = None();
+
+  vector<pair<UPID, WriteResponse>> responses;
+  std::swap(responses, pending);
+
+  vector<Owned<process::Promise<Nothing>>> promises;
+  std::swap(promises, waiting);
+
+  VLOG(1) << "Committed staged actions for " << responses.size()
+          << " write request(s)";
+
+  foreach (const auto& response, responses) {
+    send(response.first, response.second);
+  }
+
+  foreach (const Owned<process::Promise<Nothing>>& promise, promises) {
+    promise->set(Nothing());
+  }
+}
+
+
+void ReplicaProcess::rollback(const string& message)
+{
+  CHECK_SOME(lastCommitted);
+
+  begin = lastCommitted->begin;
+  end = lastCommitted->end;
+  holes = lastCommitted->holes;
+  unlearned = lastCommitted->unlearned;
+
+  lastCommitted = None();
+
+  // The writers will time out and retry (as if the write requests had
+  // been dropped) rather than learn about actions which are not in
+  // storage.
+  LOG(WARNING) << "Dropping " << pending.size() << " write response(s)"
+               << " after failing to commit the staged actions";
+
+  pending.clear();
+
+  foreach (const Owned<process::Promise<Nothing>>& promise, waiting) {
+    promise->fail("Failed to commit the staged actions: " + message);
+  }
+
+  waiting.clear();
+}
+
+
+void ReplicaProcess::written(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -745,8 +996,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
@@ -841,6 +1090,12 @@ Future<uint64_t> Replica::promised() const
 }
 
 
+Future<Nothing> Replica::committed() const
+{
+  return dispatch(process, &ReplicaProcess::committed);
+}
+
+
 Future<bool> Replica::update(const Metadata::Status& status)
 {
   return dispatch(process, &ReplicaProcess::update, status);
@@ -27,6 +27,7 @@
 #include <process/protobuf.hpp>
 
 #include <stout/interval.hpp>
+#include <stout/nothing.hpp>
 
 #include "messages/log.hpp"
 
@@ -40,6 +41,7 @@ namespace protocol {
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<ReadRequest, ReadResponse> read;
 
 } // namespace protocol {
 
@@ -89,6 +91,11 @@ public:
   // Returns the highest implicit promise this replica has given.
   process::Future<uint64_t> promised() const;
 
+  // Returns once the actions this replica has received so far (e.g.,
+  // in learned messages) have been committed to storage, or fails if
+  // they could not be committed.
+  process::Future<Nothing> committed() const;
+
   // Updates the status of this replica. Returns true if status was
   // updated successfully, false otherwise. Made "virtual" for
   // mocking in tests.
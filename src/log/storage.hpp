@@ -54,6 +54,13 @@ public:
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
   virtual Try<Action> read(uint64_t position) = 0;
+
+  // Group commit: a staged action is visible to 'read' right away
+  // but is only durable once 'commit' returns, which persists all
+  // the staged actions at once. Persisting an action also commits
+  // the actions staged before it.
+  virtual Try<Nothing> stage(const Action& action) = 0;
+  virtual Try<Nothing> commit() = 0;
 };
 
 } // namespace log {
@@ -59,7 +59,9 @@ public:
       const Option<std::set<std::string>>&
         fairnessExcludeResourceNames = None(),
       bool filterGpuResources = true,
-      const Option<DomainInfo>& domain = None());
+      const Option<DomainInfo>& domain = None(),
+      const mesos::allocator::Options& options =
+        mesos::allocator::Options());
 
   void recover(
       const int expectedAgentCount,
@@ -199,7 +201,9 @@ public:
       const Option<std::set<std::string>>&
         fairnessExcludeResourceNames = None(),
       bool filterGpuResources = true,
-      const Option<DomainInfo>& domain = None()) = 0;
+      const Option<DomainInfo>& domain = None(),
+      const mesos::allocator::Options& options =
+        mesos::allocator::Options()) = 0;
 
   virtual void recover(
       const int expectedAgentCount,
@@ -348,7 +352,8 @@ inline void MesosAllocator<AllocatorProcess>::initialize(
       inverseOfferCallback,
     const Option<std::set<std::string>>& fairnessExcludeResourceNames,
     bool filterGpuResources,
-    const Option<DomainInfo>& domain)
+    const Option<DomainInfo>& domain,
+    const mesos::allocator::Options& options)
 {
   process::dispatch(
       process,
@@ -358,7 +363,8 @@ inline void MesosAllocator<AllocatorProcess>::initialize(
       inverseOfferCallback,
       fairnessExcludeResourceNames,
       filterGpuResources,
-      domain);
+      domain,
+      options);
 }
 
 
@@ -17,6 +17,8 @@
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include <algorithm>
+#include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -26,11 +28,16 @@
 #include <mesos/type_utils.hpp>
 
 #include <process/after.hpp>
+#include <process/async.hpp>
+#include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/event.hpp>
 #include <process/id.hpp>
 #include <process/loop.hpp>
+#include <process/process.hpp>
+#include <process/shared.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/check.hpp>
@@ -40,13 +47,17 @@
 
 #include "common/protobuf_utils.hpp"
 
+using std::list;
+using std::pair;
 using std::set;
 using std::string;
 using std::vector;
 
 using mesos::allocator::InverseOfferStatus;
+using mesos::allocator::Options;
 
 using process::after;
+using process::Clock;
 using process::Continue;
 using process::ControlFlow;
 using process::Failure;
@@ -54,6 +65,8 @@ using process::Future;
 using process::loop;
 using process::Owned;
 using process::PID;
+using process::Shared;
+using process::Time;
 using process::Timeout;
 
 using mesos::internal::protobuf::framework::Capabilities;
@@ -131,6 +144,90 @@ private:
 };
 
 
+// Returns whether frameworks with either capabilities can be offered
+// the same resources out of those available on an agent, see
+// `offerableResources()`.
+static bool sameOffers(const Capabilities& left, const Capabilities& right)
+{
+  return left.revocableResources == right.revocableResources &&
+         left.gpuResources == right.gpuResources &&
+         left.sharedResources == right.sharedResources &&
+         left.reservationRefinement == right.reservationRefinement &&
+         left.regionAware == right.regionAware;
+}
+
+
+// Returns the total quantity of each scalar resource.
+static hashmap<string, Value::Scalar> scalarQuantities(
+    const Resources& resources)
+{
+  hashmap<string, Value::Scalar> quantities;
+
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      quantities[resource.name()] += resource.scalar();
+    }
+  }
+
+  return quantities;
+}
+
+
+void HierarchicalAllocatorProcess::OfferFilters::add(
+    OfferFilter* offerFilter,
+    const Resources& resources)
+{
+  filters.insert(offerFilter);
+
+  const hashmap<string, Value::Scalar> quantities =
+    scalarQuantities(resources);
+
+  foreachpair (const string& name, const Value::Scalar& quantity, quantities) {
+    if (!refused.contains(name) || !(quantity <= refused.at(name))) {
+      refused[name] = quantity;
+    }
+  }
+}
+
+
+bool HierarchicalAllocatorProcess::OfferFilters::mayFilter(
+    const Resources& resources) const
+{
+  const hashmap<string, Value::Scalar> quantities =
+    scalarQuantities(resources);
+
+  foreachpair (const string& name, const Value::Scalar& quantity, quantities) {
+    auto refusedQuantity = refused.find(name);
+
+    if (refusedQuantity == refused.end() ||
+        !(quantity <= refusedQuantity->second)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool HierarchicalAllocatorProcess::OfferFilters::filter(
+    const Resources& resources) const
+{
+  // Skip going through the filters if none of them can filter
+  // the resources.
+  if (!mayFilter(resources)) {
+    return false;
+  }
+
+  foreach (OfferFilter* offerFilter, filters) {
+    if (offerFilter->filter(resources)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 HierarchicalAllocatorProcess::Framework::Framework(
     const FrameworkInfo& frameworkInfo,
     const set<string>& _suppressedRoles)
@@ -151,7 +248,8 @@ void HierarchicalAllocatorProcess::initialize(
       _inverseOfferCallback,
     const Option<set<string>>& _fairnessExcludeResourceNames,
     bool _filterGpuResources,
-    const Option<DomainInfo>& _domain)
+    const Option<DomainInfo>& _domain,
+    const Options& options)
 {
   allocationInterval = _allocationInterval;
   offerCallback = _offerCallback;
@@ -159,6 +257,8 @@ void HierarchicalAllocatorProcess::initialize(
   fairnessExcludeResourceNames = _fairnessExcludeResourceNames;
   filterGpuResources = _filterGpuResources;
   domain = _domain;
+  allocationParallelism = options.allocationParallelism;
+  incrementalAllocation = options.incrementalAllocation;
   initialized = true;
   paused = false;
 
@@ -1163,6 +1263,13 @@ void HierarchicalAllocatorProcess::recoverResources(
             << ", allocated: " << slave.allocated << ")"
             << " on agent " << slaveId
             << " from framework " << frameworkId;
+
+    // Offer the recovered resources without waiting for the next
+    // batch allocation. Since the allocation is deferred, it does
+    // take the filter installed below into account.
+    if (incrementalAllocation) {
+      allocate(slaveId);
+    }
   }
 
   // No need to install the filter if 'filters' is none.
@@ -1203,6 +1310,16 @@ void HierarchicalAllocatorProcess::recoverResources(
 
   CHECK_SOME(timeout);
 
+  // When the recovered resources are offered right away, a framework
+  // declining them is filtered from them like for any non-zero
+  // timeout (see below), i.e., it is not offered them again before
+  // the batch allocation following the expiry of the filter, even if
+  // it declined them with a zero timeout. Otherwise it would be
+  // offered them over and over until then.
+  if (incrementalAllocation) {
+    timeout = std::max(allocationInterval, timeout.get());
+  }
+
   if (timeout.get() != Duration::zero()) {
     VLOG(1) << "Framework " << frameworkId
             << " filtered agent " << slaveId
@@ -1215,7 +1332,7 @@ void HierarchicalAllocatorProcess::recoverResources(
 
     OfferFilter* offerFilter = new RefusedOfferFilter(unallocated);
     frameworks.at(frameworkId)
-      .offerFilters[role][slaveId].insert(offerFilter);
+      .offerFilters[role][slaveId].add(offerFilter, unallocated);
 
     // Expire the filter after both an `allocationInterval` and the
     // `timeout` have elapsed. This ensures that the filter does not
@@ -1223,28 +1340,15 @@ void HierarchicalAllocatorProcess::recoverResources(
     // see MESOS-4302 for more information.
     //
     // Because the next periodic allocation goes through a dispatch
-    // after `allocationInterval`, we do the same for `expire()`
-    // (with a helper `_expire()`) to achieve the above.
+    // after `allocationInterval`, we do the same for
+    // `expireOfferFilters()` (with a helper `_expireOfferFilters()`)
+    // to achieve the above.
     //
     // TODO(alexr): If we allocated upon resource recovery
     // (MESOS-3078), we would not need to increase the timeout here.
     timeout = std::max(allocationInterval, timeout.get());
 
-    // We need to disambiguate the function call to pick the correct
-    // `expire()` overload.
-    void (Self::*expireOffer)(
-        const FrameworkID&,
-        const string&,
-        const SlaveID&,
-        OfferFilter*) = &Self::expire;
-
-    delay(timeout.get(),
-          self(),
-          expireOffer,
-          frameworkId,
-          role,
-          slaveId,
-          offerFilter);
+    expire(frameworkId, role, slaveId, offerFilter, timeout.get());
   }
 }
 
@@ -1308,7 +1412,12 @@ void HierarchicalAllocatorProcess::reviveOffers(
   LOG(INFO) << "Revived offers for roles " << stringify(roles)
             << " of framework " << frameworkId;
 
-  allocate();
+  // Only the revived framework can be offered more than before.
+  if (incrementalAllocation) {
+    allocate(frameworkId, None());
+  } else {
+    allocate();
+  }
 }
 
 
@@ -1458,7 +1567,35 @@ Future<Nothing> HierarchicalAllocatorProcess::allocate(
 }
 
 
-Nothing HierarchicalAllocatorProcess::_allocate()
+Future<Nothing> HierarchicalAllocatorProcess::allocate(
+    const FrameworkID& frameworkId,
+    const Option<SlaveID>& slaveId)
+{
+  if (paused) {
+    VLOG(1) << "Skipped allocation because the allocator is paused";
+
+    return Nothing();
+  }
+
+  if (slaveId.isNone()) {
+    frameworkAllocationCandidates[frameworkId] = None();
+  } else if (!frameworkAllocationCandidates.contains(frameworkId)) {
+    frameworkAllocationCandidates[frameworkId] =
+      hashset<SlaveID>({slaveId.get()});
+  } else if (frameworkAllocationCandidates.at(frameworkId).isSome()) {
+    frameworkAllocationCandidates.at(frameworkId)->insert(slaveId.get());
+  }
+
+  if (allocation.isNone() || !allocation->isPending()) {
+    metrics.allocation_run_latency.start();
+    allocation = dispatch(self(), &Self::_allocate);
+  }
+
+  return allocation.get();
+}
+
+
+Future<Nothing> HierarchicalAllocatorProcess::_allocate()
 {
   metrics.allocation_run_latency.stop();
 
@@ -1470,11 +1607,42 @@ Nothing HierarchicalAllocatorProcess::_allocate()
 
   ++metrics.allocation_runs;
 
+  metrics.allocation_run.start();
+
+  if (allocationParallelism <= 1) {
+    __allocate(OfferCandidates());
+    return Nothing();
+  }
+
+  // The allocator keeps processing events while the offer candidates
+  // are computed, which includes adding allocation candidates to this
+  // allocation (see `allocate()`). Any event might change what can be
+  // offered, hence each candidate is checked to still be current when
+  // it is used, see `___allocate()`.
+  return offerCandidates()
+    .then(defer(self(), [=](const OfferCandidates& candidates) {
+      removedOfferFilters.reset();
+
+      if (paused) {
+        VLOG(1) << "Skipped allocation because the allocator is paused";
+
+        metrics.allocation_run.stop();
+        return Nothing();
+      }
+
+      __allocate(candidates);
+      return Nothing();
+    }));
+}
+
+
+void HierarchicalAllocatorProcess::__allocate(
+    const OfferCandidates& candidates)
+{
   Stopwatch stopwatch;
   stopwatch.start();
-  metrics.allocation_run.start();
 
-  __allocate();
+  ___allocate(candidates);
 
   // NOTE: For now, we implement maintenance inverse offers within the
   // allocator. We leverage the existing timer/cycle of offers to also do any
@@ -1484,29 +1652,17 @@ Nothing HierarchicalAllocatorProcess::_allocate()
   metrics.allocation_run.stop();
 
   VLOG(1) << "Performed allocation for " << allocationCandidates.size()
-          << " agents in " << stopwatch.elapsed();
+          << " agents and " << frameworkAllocationCandidates.size()
+          << " frameworks in " << stopwatch.elapsed();
 
   // Clear the candidates on completion of the allocation run.
   allocationCandidates.clear();
-
-  return Nothing();
+  frameworkAllocationCandidates.clear();
 }
 
 
-// TODO(alexr): Consider factoring out the quota allocation logic.
-void HierarchicalAllocatorProcess::__allocate()
+vector<SlaveID> HierarchicalAllocatorProcess::allocationSlaveIds() const
 {
-  // Compute the offerable resources, per framework:
-  //   (1) For reserved resources on the slave, allocate these to a
-  //       framework having the corresponding role.
-  //   (2) For unreserved resources on the slave, allocate these
-  //       to a framework of any role.
-  hashmap<FrameworkID, hashmap<string, hashmap<SlaveID, Resources>>> offerable;
-
-  // NOTE: This function can operate on a small subset of
-  // `allocationCandidates`, we have to make sure that we don't
-  // assume cluster knowledge when summing resources from that set.
-
   vector<SlaveID> slaveIds;
   slaveIds.reserve(allocationCandidates.size());
 
@@ -1520,6 +1676,63 @@ void HierarchicalAllocatorProcess::__allocate()
     }
   }
 
+  // Add the slaves that are only allocation candidates for some of the
+  // frameworks, see `isAllocationCandidate()`. When a framework is a
+  // candidate for all slaves, we skip the slaves that don't have any
+  // resources left to offer, in order to only walk the ones that can
+  // actually be allocated to it.
+  if (!frameworkAllocationCandidates.empty()) {
+    hashset<SlaveID> frameworkSlaveIds;
+    bool allSlaves = false;
+
+    foreachvalue (const Option<hashset<SlaveID>>& candidates,
+                  frameworkAllocationCandidates) {
+      if (candidates.isNone()) {
+        allSlaves = true;
+      } else {
+        frameworkSlaveIds |= candidates.get();
+      }
+    }
+
+    if (allSlaves) {
+      foreachpair (const SlaveID& slaveId, const Slave& slave, slaves) {
+        if (allocatable(slave.available()) || !slave.total.shared().empty()) {
+          frameworkSlaveIds.insert(slaveId);
+        }
+      }
+    }
+
+    foreach (const SlaveID& slaveId, frameworkSlaveIds) {
+      if (!allocationCandidates.contains(slaveId) &&
+          slaves.contains(slaveId) &&
+          isWhitelisted(slaveId) &&
+          slaves.at(slaveId).activated) {
+        slaveIds.push_back(slaveId);
+      }
+    }
+  }
+
+
+  return slaveIds;
+}
+
+
+// TODO(alexr): Consider factoring out the quota allocation logic.
+void HierarchicalAllocatorProcess::___allocate(
+    const OfferCandidates& candidates)
+{
+  // Compute the offerable resources, per framework:
+  //   (1) For reserved resources on the slave, allocate these to a
+  //       framework having the corresponding role.
+  //   (2) For unreserved resources on the slave, allocate these
+  //       to a framework of any role.
+  hashmap<FrameworkID, hashmap<string, hashmap<SlaveID, Resources>>> offerable;
+
+  // NOTE: This function can operate on a small subset of
+  // `allocationCandidates`, we have to make sure that we don't
+  // assume cluster knowledge when summing resources from that set.
+  vector<SlaveID> slaveIds = allocationSlaveIds();
+
   // Randomize the order in which slaves' resources are allocated.
   //
   // TODO(vinod): Implement a smarter sorting algorithm.
@@ -1553,6 +1766,11 @@ void HierarchicalAllocatorProcess::__allocate()
   // allocated in the current cycle.
   hashmap<SlaveID, Resources> offeredSharedResources;
 
+  // The resources allocated on each agent during this allocation, which
+  // tell whether the offer candidates are still current, see
+  // `OfferCandidate`.
+  hashmap<SlaveID, Resources> allocatedResources;
+
   // Quota comes first and fair share second. Here we process only those
   // roles for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
@@ -1611,6 +1829,10 @@ void HierarchicalAllocatorProcess::__allocate()
         CHECK(slaves.contains(slaveId));
         CHECK(frameworks.contains(frameworkId));
 
+        if (!isAllocationCandidate(frameworkId, slaveId)) {
+          continue;
+        }
+
         const Framework& framework = frameworks.at(frameworkId);
         Slave& slave = slaves.at(slaveId);
 
@@ -1698,6 +1920,8 @@ void HierarchicalAllocatorProcess::__allocate()
                 << " to role " << role << " of framework " << frameworkId
                 << " as part of its role quota";
 
+        allocatedResources[slaveId] += resources;
+
         resources.allocate(role);
 
         // NOTE: We perform "coarse-grained" allocation for quota'ed
@@ -1784,6 +2008,27 @@ void HierarchicalAllocatorProcess::__allocate()
       break;
     }
 
+    CHECK(slaves.contains(slaveId));
+    Slave& slave = slaves.at(slaveId);
+
+    // The offer candidates of the agent, if they were computed ahead
+    // from the resources that are still available on it. We still go
+    // through the roles and the frameworks which are not suppressed in
+    // their current fair share order, and only use a candidate as long
+    // as it assumes what has actually been allocated on the agent, the
+    // current quota of the role and capabilities of the framework, so
+    // that the allocations are the same as without the candidates. The
+    // current offer filters of the framework are applied to the
+    // candidate by `offerableResources()`.
+    const AgentCandidates* agentCandidates = nullptr;
+
+    auto computed = candidates.find(slaveId);
+    if (computed != candidates.end() &&
+        computed->second.available == slave.available().nonShared() &&
+        computed->second.shared == slave.total.shared()) {
+      agentCandidates = &computed->second;
+    }
+
     foreach (const string& role, roleSorter->sort()) {
       // NOTE: Suppressed frameworks are not included in the sort.
       CHECK(frameworkSorters.contains(role));
@@ -1793,95 +2038,45 @@ void HierarchicalAllocatorProcess::__allocate()
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
-        CHECK(slaves.contains(slaveId));
         CHECK(frameworks.contains(frameworkId));
 
-        const Framework& framework = frameworks.at(frameworkId);
-        Slave& slave = slaves.at(slaveId);
-
-        // Only offer resources from slaves that have GPUs to
-        // frameworks that are capable of receiving GPUs.
-        // See MESOS-5634.
-        if (filterGpuResources &&
-            !framework.capabilities.gpuResources &&
-            slave.total.gpus().getOrElse(0) > 0) {
+        if (!isAllocationCandidate(frameworkId, slaveId)) {
           continue;
         }
 
-        // If this framework is not region-aware, don't offer it
-        // resources on agents in remote regions.
-        if (!framework.capabilities.regionAware && isRemoteSlave(slave)) {
-          continue;
-        }
-
-        // Calculate the currently available resources on the slave, which
-        // is the difference in non-shared resources between total and
-        // allocated, plus all shared resources on the agent (if applicable).
-        // Since shared resources are offerable even when they are in use, we
-        // make one copy of the shared resources available regardless of the
-        // past allocations.
-        Resources available = slave.available().nonShared();
-
-        // Offer a shared resource only if it has not been offered in
-        // this offer cycle to a framework.
-        if (framework.capabilities.sharedResources) {
-          available += slave.total.shared();
-          if (offeredSharedResources.contains(slaveId)) {
-            available -= offeredSharedResources[slaveId];
+        const OfferCandidate* candidate = nullptr;
+        if (agentCandidates != nullptr) {
+          auto roleCandidates = agentCandidates->candidates.find(role);
+
+          if (roleCandidates != agentCandidates->candidates.end()) {
+            auto frameworkCandidate =
+              roleCandidates->second.find(frameworkId_);
+
+            if (frameworkCandidate != roleCandidates->second.end() &&
+                frameworkCandidate->second.allocated ==
+                  allocatedResources[slaveId] &&
+                frameworkCandidate->second.quota == quotas.contains(role) &&
+                sameOffers(
+                    frameworkCandidate->second.capabilities,
+                    frameworks.at(frameworkId).capabilities)) {
+              candidate = &frameworkCandidate->second;
+            }
           }
         }
 
-        // The resources we offer are the unreserved resources as well as the
-        // reserved resources for this particular role and all its ancestors
-        // in the role hierarchy.
-        //
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        //
-        // NOTE: We do not offer roles with quota any more non-revocable
-        // resources once their quota is satisfied. However, note that this is
-        // not strictly true due to the coarse-grained nature (per agent) of the
-        // allocation algorithm in stage 1.
-        //
-        // TODO(mpark): Offer unreserved resources as revocable beyond quota.
-        Resources resources = available.allocatableTo(role);
-        if (quotas.contains(role)) {
-          resources -= available.unreserved();
-        }
+        Option<Resources> available = offerableResources(
+            slaveId, role, frameworkId, offeredSharedResources, candidate);
 
         // It is safe to break here, because all frameworks under a role would
         // consider the same resources, so in case we don't have allocatable
         // resources, we don't have to check for other frameworks under the
         // same role. We only break out of the innermost loop, so the next step
         // will use the same slaveId, but a different role.
-        //
-        // The difference to the second `allocatable` check is that here we also
-        // check for revocable resources, which can be disabled on a per frame-
-        // work basis, which requires us to go through all frameworks in case we
-        // have allocatable revocable resources.
-        if (!allocatable(resources)) {
+        if (available.isNone()) {
           break;
         }
 
-        // Remove revocable resources if the framework has not opted for them.
-        if (!framework.capabilities.revocableResources) {
-          resources = resources.nonRevocable();
-        }
-
-        // When reservation refinements are present, old frameworks without the
-        // RESERVATION_REFINEMENT capability won't be able to understand the
-        // new format. While it's possible to translate the refined reservations
-        // into the old format by "hiding" the intermediate reservations in the
-        // "stack", this leads to ambiguity when processing RESERVE / UNRESERVE
-        // operations. This is due to the loss of information when we drop the
-        // intermediatereservations. Therefore, for now we simply filter out
-        // resources with refined reservations if the framework does not have
-        // the capability.
-        if (!framework.capabilities.reservationRefinement) {
-          resources = resources.filter([](const Resource& resource) {
-            return !Resources::hasRefinedReservations(resource);
-          });
-        }
+        Resources resources = available.get();
 
         // If the resources are not allocatable, ignore. We cannot break
         // here, because another framework under the same role could accept
@@ -1890,11 +2085,6 @@ void HierarchicalAllocatorProcess::__allocate()
           continue;
         }
 
-        // If the framework filters these resources, ignore.
-        if (isFiltered(frameworkId, role, slaveId, resources)) {
-          continue;
-        }
-
         // If the offer generated by `resources` would force the second
         // stage to use more than `remainingClusterResources`, move along.
         // We do not terminate early, as offers generated further in the
@@ -1913,6 +2103,8 @@ void HierarchicalAllocatorProcess::__allocate()
         VLOG(2) << "Allocating " << resources << " on agent " << slaveId
                 << " to role " << role << " of framework " << frameworkId;
 
+        allocatedResources[slaveId] += resources;
+
         resources.allocate(role);
 
         // NOTE: We perform "coarse-grained" allocation, meaning that we always
@@ -1950,6 +2142,365 @@ void HierarchicalAllocatorProcess::__allocate()
 }
 
 
+Option<Resources> HierarchicalAllocatorProcess::offerableResources(
+    const SlaveID& slaveId,
+    const string& role,
+    const FrameworkID& frameworkId,
+    const hashmap<SlaveID, Resources>& offeredSharedResources,
+    const OfferCandidate* candidate) const
+{
+  CHECK(slaves.contains(slaveId));
+  CHECK(frameworks.contains(frameworkId));
+
+  const Framework& framework = frameworks.at(frameworkId);
+  const Slave& slave = slaves.at(slaveId);
+
+  // Only offer resources from slaves that have GPUs to
+  // frameworks that are capable of receiving GPUs.
+  // See MESOS-5634.
+  if (filterGpuResources &&
+      !framework.capabilities.gpuResources &&
+      slave.total.gpus().getOrElse(0) > 0) {
+    return Resources();
+  }
+
+  // If this framework is not region-aware, don't offer it
+  // resources on agents in remote regions.
+  if (!framework.capabilities.regionAware && isRemoteSlave(slave)) {
+    return Resources();
+  }
+
+  Option<Resources> resources;
+
+  if (candidate != nullptr) {
+    resources = candidate->resources;
+  } else {
+    // Calculate the currently available resources on the slave, which
+    // is the difference in non-shared resources between total and
+    // allocated, plus all shared resources on the agent (if applicable).
+    // Since shared resources are offerable even when they are in use, we
+    // make one copy of the shared resources available regardless of the
+    // past allocations.
+    Resources available = slave.available().nonShared();
+
+    // Offer a shared resource only if it has not been offered in
+    // this offer cycle to a framework.
+    if (framework.capabilities.sharedResources) {
+      available += slave.total.shared();
+      if (offeredSharedResources.contains(slaveId)) {
+        available -= offeredSharedResources.at(slaveId);
+      }
+    }
+
+    resources = offerableResources(
+        available, role, quotas.contains(role), framework.capabilities);
+  }
+
+  // If the framework filters these resources, ignore.
+  if (resources.isSome() &&
+      allocatable(resources.get()) &&
+      isFiltered(frameworkId, role, slaveId, resources.get())) {
+    return Resources();
+  }
+
+  return resources;
+}
+
+
+Option<Resources> HierarchicalAllocatorProcess::offerableResources(
+    const Resources& available,
+    const string& role,
+    bool quota,
+    const Capabilities& capabilities)
+{
+  // The resources we offer are the unreserved resources as well as the
+  // reserved resources for this particular role and all its ancestors
+  // in the role hierarchy.
+  //
+  // NOTE: Currently, frameworks are allowed to have '*' role.
+  // Calling reserved('*') returns an empty Resources object.
+  //
+  // NOTE: We do not offer roles with quota any more non-revocable
+  // resources once their quota is satisfied. However, note that this is
+  // not strictly true due to the coarse-grained nature (per agent) of the
+  // allocation algorithm in stage 1.
+  //
+  // TODO(mpark): Offer unreserved resources as revocable beyond quota.
+  Resources resources = available.allocatableTo(role);
+  if (quota) {
+    resources -= available.unreserved();
+  }
+
+  // The difference to the `allocatable` check of the caller is that here
+  // we also check for revocable resources, which can be disabled on a per
+  // framework basis, which requires the caller to go through all
+  // frameworks in case we have allocatable revocable resources.
+  if (!allocatable(resources)) {
+    return None();
+  }
+
+  // Remove revocable resources if the framework has not opted for them.
+  if (!capabilities.revocableResources) {
+    resources = resources.nonRevocable();
+  }
+
+  // When reservation refinements are present, old frameworks without the
+  // RESERVATION_REFINEMENT capability won't be able to understand the
+  // new format. While it's possible to translate the refined reservations
+  // into the old format by "hiding" the intermediate reservations in the
+  // "stack", this leads to ambiguity when processing RESERVE / UNRESERVE
+  // operations. This is due to the loss of information when we drop the
+  // intermediatereservations. Therefore, for now we simply filter out
+  // resources with refined reservations if the framework does not have
+  // the capability.
+  if (!capabilities.reservationRefinement) {
+    resources = resources.filter([](const Resource& resource) {
+      return !Resources::hasRefinedReservations(resource);
+    });
+  }
+
+  return resources;
+}
+
+
+struct HierarchicalAllocatorProcess::CandidatesSnapshot
+{
+  struct Agent
+  {
+    SlaveID id;
+
+    // Whether the agent is an allocation candidate for all frameworks.
+    bool candidate;
+
+    // The non-shared resources available on the agent, and its shared
+    // resources.
+    Resources available;
+    Resources shared;
+
+    bool gpus;
+    bool remote;
+
+    protobuf::slave::Capabilities capabilities;
+  };
+
+  struct Framework
+  {
+    string id;
+
+    Capabilities capabilities;
+
+    // The agents the framework is an allocation candidate for on top
+    // of those which are candidates for all frameworks, `None` standing
+    // for all agents (see `frameworkAllocationCandidates`).
+    Option<hashset<SlaveID>> candidates;
+
+    // The offer filters of the framework for the role.
+    hashmap<SlaveID, OfferFilters> offerFilters;
+  };
+
+  struct Role
+  {
+    string name;
+    bool quota;
+
+    // The frameworks of the role in their fair share order.
+    vector<Framework> frameworks;
+  };
+
+  // Computes the offer candidates of the agents in `[begin, end)`.
+  OfferCandidates compute(size_t begin, size_t end) const;
+
+  vector<Agent> agents;
+
+  // The roles in their fair share order.
+  vector<Role> roles;
+
+  bool filterGpuResources;
+
+  // Keeps the offer filters removed meanwhile from being deleted while
+  // the offer candidates are computed.
+  std::shared_ptr<vector<OfferFilter*>> removedOfferFilters;
+};
+
+
+HierarchicalAllocatorProcess::OfferCandidates
+HierarchicalAllocatorProcess::CandidatesSnapshot::compute(
+    size_t begin,
+    size_t end) const
+{
+  OfferCandidates candidates;
+
+  for (size_t i = begin; i < end; i++) {
+    const Agent& agent = agents[i];
+
+    AgentCandidates& agentCandidates = candidates[agent.id];
+    agentCandidates.available = agent.available;
+    agentCandidates.shared = agent.shared;
+
+    // Mirrors the second stage of the allocation on the agent (see
+    // `___allocate()`), except that a framework that can be offered
+    // anything is assumed to be allocated what it can be offered.
+    Resources allocated;
+
+    foreach (const Role& role, roles) {
+      foreach (const Framework& framework, role.frameworks) {
+        if (!agent.candidate &&
+            framework.candidates.isSome() &&
+            !framework.candidates->contains(agent.id)) {
+          continue;
+        }
+
+        // The candidate is not needed if the framework is never offered
+        // anything on the agent, see `offerableResources()`.
+        if ((filterGpuResources &&
+             !framework.capabilities.gpuResources &&
+             agent.gpus) ||
+            (!framework.capabilities.regionAware && agent.remote)) {
+          continue;
+        }
+
+        Resources available = agent.available - allocated.nonShared();
+
+        if (framework.capabilities.sharedResources) {
+          available += agent.shared;
+          available -= allocated.shared();
+        }
+
+        const Option<Resources> resources = offerableResources(
+            available, role.name, role.quota, framework.capabilities);
+
+        agentCandidates.candidates[role.name][framework.id] =
+          OfferCandidate{
+              allocated, role.quota, framework.capabilities, resources};
+
+        if (resources.isNone()) {
+          break;
+        }
+
+        if (!allocatable(resources.get()) ||
+            implicitlyFiltered(
+                framework.capabilities,
+                agent.capabilities,
+                role.name).isSome()) {
+          continue;
+        }
+
+        auto agentFilters = framework.offerFilters.find(agent.id);
+        if (agentFilters != framework.offerFilters.end() &&
+            agentFilters->second.filter(resources.get())) {
+          continue;
+        }
+
+        allocated += resources.get();
+      }
+    }
+  }
+
+  return candidates;
+}
+
+
+Future<HierarchicalAllocatorProcess::OfferCandidates>
+HierarchicalAllocatorProcess::offerCandidates()
+{
+  Owned<CandidatesSnapshot> snapshot(new CandidatesSnapshot());
+
+  foreach (const SlaveID& slaveId, allocationSlaveIds()) {
+    const Slave& slave = slaves.at(slaveId);
+
+    snapshot->agents.push_back(CandidatesSnapshot::Agent{
+        slaveId,
+        allocationCandidates.contains(slaveId),
+        slave.available().nonShared(),
+        slave.total.shared(),
+        slave.total.gpus().getOrElse(0) > 0,
+        isRemoteSlave(slave),
+        slave.capabilities});
+  }
+
+  if (snapshot->agents.empty()) {
+    return OfferCandidates();
+  }
+
+  foreach (const string& role, roleSorter->sort()) {
+    CHECK(frameworkSorters.contains(role));
+
+    snapshot->roles.push_back(
+        CandidatesSnapshot::Role{role, quotas.contains(role), {}});
+
+    foreach (const string& frameworkId_, frameworkSorters.at(role)->sort()) {
+      FrameworkID frameworkId;
+      frameworkId.set_value(frameworkId_);
+
+      CHECK(frameworks.contains(frameworkId));
+
+      const Framework& framework = frameworks.at(frameworkId);
+
+      CandidatesSnapshot::Framework candidate;
+      candidate.id = frameworkId_;
+      candidate.capabilities = framework.capabilities;
+
+      auto candidates = frameworkAllocationCandidates.find(frameworkId);
+      if (candidates == frameworkAllocationCandidates.end()) {
+        candidate.candidates = hashset<SlaveID>();
+      } else {
+        candidate.candidates = candidates->second;
+      }
+
+      auto roleFilters = framework.offerFilters.find(role);
+      if (roleFilters != framework.offerFilters.end()) {
+        candidate.offerFilters = roleFilters->second;
+      }
+
+      snapshot->roles.back().frameworks.push_back(std::move(candidate));
+    }
+  }
+
+  snapshot->filterGpuResources = filterGpuResources;
+
+  // The snapshot refers to the offer filters, hence those removed from
+  // now on are only deleted once the snapshot is, see `_expire()`.
+  removedOfferFilters.reset(
+      new vector<OfferFilter*>(),
+      [](vector<OfferFilter*>* offerFilters) {
+        foreach (OfferFilter* offerFilter, *offerFilters) {
+          delete offerFilter;
+        }
+
+        delete offerFilters;
+      });
+
+  snapshot->removedOfferFilters = removedOfferFilters;
+
+  const size_t agents = snapshot->agents.size();
+  const size_t shards = std::min(allocationParallelism, agents);
+
+  Shared<CandidatesSnapshot> shared = snapshot.share();
+
+  list<Future<OfferCandidates>> computed;
+
+  for (size_t shard = 0; shard < shards; shard++) {
+    const size_t begin = agents * shard / shards;
+    const size_t end = agents * (shard + 1) / shards;
+
+    computed.push_back(process::async([shared, begin, end]() {
+      return shared->compute(begin, end);
+    }));
+  }
+
+  return collect(computed)
+    .then([](const list<OfferCandidates>& computed) {
+      OfferCandidates candidates;
+
+      foreach (const OfferCandidates& shard, computed) {
+        candidates.insert(shard.begin(), shard.end());
+      }
+
+      return candidates;
+    });
+}
+
+
 void HierarchicalAllocatorProcess::deallocate()
 {
   // If no frameworks are currently registered, no work to do.
@@ -2064,16 +2615,27 @@ void HierarchicalAllocatorProcess::_expire(
 
       if (agentFilters != roleFilters->second.end()) {
         // Erase the filter (may be a no-op per the comment above).
-        agentFilters->second.erase(offerFilter);
+        bool erased = agentFilters->second.filters.erase(offerFilter) > 0;
 
-        if (agentFilters->second.empty()) {
+        if (agentFilters->second.filters.empty()) {
           roleFilters->second.erase(slaveId);
         }
+
+        // The framework may now be offered the resources it filtered.
+        if (erased && incrementalAllocation) {
+          allocate(frameworkId, slaveId);
+        }
       }
     }
   }
 
-  delete offerFilter;
+  // The offer candidates of an allocation might still be computed from
+  // a snapshot which refers to the filter, see `offerCandidates()`.
+  if (removedOfferFilters) {
+    removedOfferFilters->push_back(offerFilter);
+  } else {
+    delete offerFilter;
+  }
 }
 
 
@@ -2081,15 +2643,62 @@ void HierarchicalAllocatorProcess::expire(
     const FrameworkID& frameworkId,
     const string& role,
     const SlaveID& slaveId,
-    OfferFilter* offerFilter)
+    OfferFilter* offerFilter,
+    const Duration& timeout)
 {
-  dispatch(
-      self(),
-      &Self::_expire,
-      frameworkId,
-      role,
-      slaveId,
-      offerFilter);
+  const Time time = Clock::now() + timeout;
+
+  offerFilterExpiries.emplace(
+      time,
+      OfferFilterExpiry{frameworkId, role, slaveId, offerFilter});
+
+  // Only arm the timer if it isn't armed already for an earlier time.
+  // A timer armed for a later time is left as is: it finds no offer
+  // filter to remove, or the ones added since.
+  if (offerFilterTimer.isNone() || time < offerFilterTimer.get()) {
+    offerFilterTimer = time;
+    delay(timeout, self(), &Self::expireOfferFilters);
+  }
+}
+
+
+void HierarchicalAllocatorProcess::expireOfferFilters()
+{
+  dispatch(self(), &Self::_expireOfferFilters);
+}
+
+
+void HierarchicalAllocatorProcess::_expireOfferFilters()
+{
+  const Time now = Clock::now();
+
+  while (!offerFilterExpiries.empty() &&
+         offerFilterExpiries.begin()->first <= now) {
+    const OfferFilterExpiry& expiry = offerFilterExpiries.begin()->second;
+
+    _expire(
+        expiry.frameworkId,
+        expiry.role,
+        expiry.slaveId,
+        expiry.offerFilter);
+
+    offerFilterExpiries.erase(offerFilterExpiries.begin());
+  }
+
+  // Re-arm the timer for the earliest of the remaining offer filters,
+  // unless it is armed already for a time that hasn't come yet.
+  if (offerFilterTimer.isSome() && offerFilterTimer.get() <= now) {
+    offerFilterTimer = None();
+  }
+
+  if (!offerFilterExpiries.empty()) {
+    const Time time = offerFilterExpiries.begin()->first;
+
+    if (offerFilterTimer.isNone() || time < offerFilterTimer.get()) {
+      offerFilterTimer = time;
+      delay(time - now, self(), &Self::expireOfferFilters);
+    }
+  }
 }
 
 
@@ -2136,6 +2745,21 @@ bool HierarchicalAllocatorProcess::isWhitelisted(
 }
 
 
+bool HierarchicalAllocatorProcess::isAllocationCandidate(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId) const
+{
+  if (allocationCandidates.contains(slaveId)) {
+    return true;
+  }
+
+  auto candidates = frameworkAllocationCandidates.find(frameworkId);
+
+  return candidates != frameworkAllocationCandidates.end() &&
+    (candidates->second.isNone() || candidates->second->contains(slaveId));
+}
+
+
 bool HierarchicalAllocatorProcess::isFiltered(
     const FrameworkID& frameworkId,
     const string& role,
@@ -2148,29 +2772,14 @@ bool HierarchicalAllocatorProcess::isFiltered(
   const Framework& framework = frameworks.at(frameworkId);
   const Slave& slave = slaves.at(slaveId);
 
-  // TODO(mpark): Consider moving these filter logic out and into the master,
-  // since they are not specific to the hierarchical allocator but rather are
-  // global allocation constraints.
-
-  // Prevent offers from non-MULTI_ROLE agents to be allocated
-  // to MULTI_ROLE frameworks.
-  if (framework.capabilities.multiRole &&
-      !slave.capabilities.multiRole) {
-    LOG(WARNING) << "Implicitly filtering agent " << slaveId
-                 << " from framework " << frameworkId
-                 << " because the framework is MULTI_ROLE capable"
-                 << " but the agent is not";
-
-    return true;
-  }
+  Option<string> reason =
+    implicitlyFiltered(framework.capabilities, slave.capabilities, role);
 
-  // Prevent offers from non-HIERARCHICAL_ROLE agents to be allocated
-  // to hierarchical roles.
-  if (!slave.capabilities.hierarchicalRole && strings::contains(role, "/")) {
+  if (reason.isSome()) {
     LOG(WARNING) << "Implicitly filtering agent " << slaveId
                  << " from role " << role
-                 << " because the role is hierarchical but the agent is not"
-                 << " HIERARCHICAL_ROLE capable";
+                 << " of framework " << frameworkId
+                 << " because " << reason.get();
 
     return true;
   }
@@ -2187,21 +2796,47 @@ bool HierarchicalAllocatorProcess::isFiltered(
     return false;
   }
 
-  foreach (OfferFilter* offerFilter, agentFilters->second) {
-    if (offerFilter->filter(resources)) {
-      VLOG(1) << "Filtered offer with " << resources
-              << " on agent " << slaveId
-              << " for role " << role
-              << " of framework " << frameworkId;
+  if (agentFilters->second.filter(resources)) {
+    VLOG(1) << "Filtered offer with " << resources
+            << " on agent " << slaveId
+            << " for role " << role
+            << " of framework " << frameworkId;
 
-      return true;
-    }
+    return true;
   }
 
   return false;
 }
 
 
+Option<string> HierarchicalAllocatorProcess::implicitlyFiltered(
+    const Capabilities& frameworkCapabilities,
+    const protobuf::slave::Capabilities& slaveCapabilities,
+    const string& role)
+{
+  // TODO(mpark): Consider moving these filter logic out and into the master,
+  // since they are not specific to the hierarchical allocator but rather are
+  // global allocation constraints.
+
+  // Prevent offers from non-MULTI_ROLE agents to be allocated
+  // to MULTI_ROLE frameworks.
+  if (frameworkCapabilities.multiRole && !slaveCapabilities.multiRole) {
+    return string(
+        "the framework is MULTI_ROLE capable but the agent is not");
+  }
+
+  // Prevent offers from non-HIERARCHICAL_ROLE agents to be allocated
+  // to hierarchical roles.
+  if (!slaveCapabilities.hierarchicalRole && strings::contains(role, "/")) {
+    return string(
+        "the role is hierarchical but the agent is not HIERARCHICAL_ROLE"
+        " capable");
+  }
+
+  return None();
+}
+
+
 bool HierarchicalAllocatorProcess::isFiltered(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId) const
@@ -2290,7 +2925,7 @@ double HierarchicalAllocatorProcess::_offer_filters_active(
     }
 
     foreachkey (const SlaveID& slaveId, framework.offerFilters.at(role)) {
-      result += framework.offerFilters.at(role).at(slaveId).size();
+      result += framework.offerFilters.at(role).at(slaveId).filters.size();
     }
   }
 
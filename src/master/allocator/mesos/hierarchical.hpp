@@ -17,14 +17,18 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/owned.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
@@ -104,7 +108,9 @@ public:
       const Option<std::set<std::string>>&
         fairnessExcludeResourceNames = None(),
       bool filterGpuResources = true,
-      const Option<DomainInfo>& domain = None());
+      const Option<DomainInfo>& domain = None(),
+      const mesos::allocator::Options& options =
+        mesos::allocator::Options());
 
   void recover(
       const int _expectedAgentCount,
@@ -229,22 +235,83 @@ protected:
   // is deferred and batched with other allocation requests.
   process::Future<Nothing> allocate(const hashset<SlaveID>& slaveIds);
 
-  // Method that performs allocation work.
-  Nothing _allocate();
+  // Allocate resources from the specified agent, or from all known
+  // agents if none is specified, to the specified framework only.
+  // The allocation is deferred and batched like the above.
+  process::Future<Nothing> allocate(
+      const FrameworkID& frameworkId,
+      const Option<SlaveID>& slaveId);
+
+  // Method that performs allocation work. If `allocationParallelism`
+  // is greater than 1, the offer candidates are computed ahead (see
+  // `offerCandidates()`) and the allocation is completed once they are.
+  process::Future<Nothing> _allocate();
+
+  // The resources that can be offered on each agent during the second
+  // stage of an allocation to each framework under each role (keyed by
+  // agent, role and framework), see `offerCandidates()`.
+  //
+  // A candidate is only used while the state it assumes is current,
+  // which is checked against the live state when it is used, see
+  // `___allocate()`. The framework's offer filters are applied to it
+  // only then as well.
+  struct OfferCandidate
+  {
+    // The resources allocated on the agent earlier during the
+    // allocation, which the candidate assumes. The candidate is only
+    // current while exactly these have been allocated on the agent.
+    Resources allocated;
+
+    // Whether the role has quota, and the capabilities of the
+    // framework, which the candidate assumes.
+    bool quota;
+    protobuf::framework::Capabilities capabilities;
+
+    // The resources that can be offered to the framework regardless of
+    // its offer filters, see `offerableResources()`.
+    Option<Resources> resources;
+  };
+
+  struct AgentCandidates
+  {
+    // The non-shared resources available on the agent and its shared
+    // resources, which the candidates of the agent assume.
+    Resources available;
+    Resources shared;
 
-  // Helper for `_allocate()` that allocates resources for offers.
-  void __allocate();
+    // The candidates keyed by role and framework.
+    hashmap<std::string, hashmap<std::string, OfferCandidate>> candidates;
+  };
+
+  typedef hashmap<SlaveID, AgentCandidates> OfferCandidates;
+
+  // Helper for `_allocate()` that performs the allocation, given the
+  // offer candidates computed ahead, if any.
+  void __allocate(const OfferCandidates& candidates);
+
+  // Helper for `__allocate()` that allocates resources for offers.
+  void ___allocate(const OfferCandidates& candidates);
 
   // Helper for `_allocate()` that deallocates resources for inverse offers.
   void deallocate();
 
-  // Remove an offer filter for the specified role of the framework.
+  // Schedules an offer filter for the specified role of the framework
+  // to be removed once the timeout elapses.
   void expire(
       const FrameworkID& frameworkId,
       const std::string& role,
       const SlaveID& slaveId,
-      OfferFilter* offerFilter);
+      OfferFilter* offerFilter,
+      const Duration& timeout);
 
+  // Remove the offer filters whose timeout elapsed. All of the offer
+  // filters share a single timer, which is armed for the earliest of
+  // them and re-armed by `_expireOfferFilters()`.
+  void expireOfferFilters();
+
+  void _expireOfferFilters();
+
+  // Remove an offer filter for the specified role of the framework.
   void _expire(
       const FrameworkID& frameworkId,
       const std::string& role,
@@ -260,6 +327,12 @@ protected:
   // Checks whether the slave is whitelisted.
   bool isWhitelisted(const SlaveID& slaveId) const;
 
+  // Returns true if the resources of this slave need to be considered
+  // for this framework during the current allocation.
+  bool isAllocationCandidate(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId) const;
+
   // Returns true if there is a resource offer filter for the
   // specified role of this framework on this slave.
   bool isFiltered(
@@ -276,6 +349,57 @@ protected:
 
   static bool allocatable(const Resources& resources);
 
+  // Returns the resources on the agent that can be offered to the
+  // framework under the role during the second stage of an allocation,
+  // given the shared resources already offered on each agent during
+  // the allocation. Returns `None` if the resources are not allocatable
+  // for the role, in which case none of the role's frameworks need to
+  // be considered. Returns resources that are not allocatable if only
+  // this framework can't be offered anything. A current offer
+  // `candidate`, if any, saves calculating what can be offered out of
+  // the available resources.
+  Option<Resources> offerableResources(
+      const SlaveID& slaveId,
+      const std::string& role,
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& offeredSharedResources,
+      const OfferCandidate* candidate = nullptr) const;
+
+  // Returns the resources out of the `available` ones on an agent that
+  // can be offered to a framework with the given capabilities under the
+  // role, regardless of the framework's offer filters. See
+  // `offerableResources()` for the result.
+  static Option<Resources> offerableResources(
+      const Resources& available,
+      const std::string& role,
+      bool quota,
+      const protobuf::framework::Capabilities& capabilities);
+
+  // Returns the reason why the agent is never offered to the framework
+  // under the role, if it isn't, see `isFiltered()`.
+  static Option<std::string> implicitlyFiltered(
+      const protobuf::framework::Capabilities& frameworkCapabilities,
+      const protobuf::slave::Capabilities& slaveCapabilities,
+      const std::string& role);
+
+  // Returns the agents to consider during the next allocation, i.e.,
+  // the whitelisted and activated ones out of `allocationCandidates`
+  // and `frameworkAllocationCandidates`.
+  std::vector<SlaveID> allocationSlaveIds() const;
+
+  // A copy of the state of the allocator that the offer candidates are
+  // computed from, see `offerCandidates()`.
+  struct CandidatesSnapshot;
+
+  // Computes the offer candidates of the agents of the next allocation
+  // from a snapshot of the allocator's state, in parallel on other
+  // worker threads, by partitioning the agents into
+  // `allocationParallelism` shards. The candidates of an agent are
+  // computed for the roles and their frameworks in their current fair
+  // share order, assuming that each framework that can be offered
+  // anything on the agent is allocated what it can be offered.
+  process::Future<OfferCandidates> offerCandidates();
+
   bool initialized;
   bool paused;
 
@@ -297,6 +421,30 @@ protected:
   friend Metrics;
   Metrics metrics;
 
+  // The offer filters of a framework for one of its roles on an agent.
+  struct OfferFilters
+  {
+    // Adds the filter, which refused the given resources.
+    void add(OfferFilter* offerFilter, const Resources& resources);
+
+    // Returns false if the resources can't be filtered by any of the
+    // filters, without going through the filters one by one.
+    bool mayFilter(const Resources& resources) const;
+
+    // Returns true if any of the filters filters the resources.
+    bool filter(const Resources& resources) const;
+
+    hashset<OfferFilter*> filters;
+
+    // The largest quantity of each scalar resource refused by any of
+    // the filters. Since a filter only filters resources it contains,
+    // resources with more of any of these can't be filtered.
+    //
+    // NOTE: This is not updated when a filter is removed, so it may be
+    // larger than needed until all of the filters are removed.
+    hashmap<std::string, Value::Scalar> refused;
+  };
+
   struct Framework
   {
     explicit Framework(
@@ -312,7 +460,7 @@ protected:
     // Active offer and inverse offer filters for the framework.
     // Offer filters are tied to the role the filtered resources
     // were allocated to.
-    hashmap<std::string, hashmap<SlaveID, hashset<OfferFilter*>>> offerFilters;
+    hashmap<std::string, hashmap<SlaveID, OfferFilters>> offerFilters;
     hashmap<SlaveID, hashset<InverseOfferFilter*>> inverseOfferFilters;
   };
 
@@ -423,10 +571,38 @@ protected:
   // processed, the set of candidates is cleared.
   hashset<SlaveID> allocationCandidates;
 
+  // The frameworks that are kept as allocation candidates on top of
+  // `allocationCandidates`, along with the agents they are candidates
+  // for, `None` standing for all agents. Events that only affect some
+  // frameworks add them in the incremental allocation mode, so that
+  // the next allocation doesn't consider the other frameworks on these
+  // agents. The map is cleared along with `allocationCandidates`.
+  hashmap<FrameworkID, Option<hashset<SlaveID>>> frameworkAllocationCandidates;
+
+  // An offer filter waiting for its timeout to elapse.
+  struct OfferFilterExpiry
+  {
+    FrameworkID frameworkId;
+    std::string role;
+    SlaveID slaveId;
+    OfferFilter* offerFilter;
+  };
+
+  // The offer filters waiting for their timeout to elapse, ordered by
+  // the time they expire at, along with the time the timer removing
+  // them is armed for, if any.
+  std::multimap<process::Time, OfferFilterExpiry> offerFilterExpiries;
+  Option<process::Time> offerFilterTimer;
+
   // Future for the dispatched allocation that becomes
   // ready after the allocation run is complete.
   Option<process::Future<Nothing>> allocation;
 
+  // The offer filters removed while the offer candidates of an
+  // allocation are computed, which might still be read by that
+  // computation. They are deleted once it is done, see `_expire()`.
+  std::shared_ptr<std::vector<OfferFilter*>> removedOfferFilters;
+
   // We track information about roles that we're aware of in the system.
   // Specifically, we keep track of the roles when a framework subscribes to
   // the role, and/or when there are resources allocated to the role
@@ -454,6 +630,17 @@ protected:
   // The master's domain, if any.
   Option<DomainInfo> domain;
 
+  // The number of shards the agents are partitioned into in order to
+  // compute the offer candidates in parallel during an allocation.
+  size_t allocationParallelism;
+
+  // Whether to allocate the resources affected by each event as soon as
+  // possible rather than waiting for the next batch allocation. Recovered
+  // resources are allocated right away, and revived frameworks as well as
+  // expired offer filters only lead to allocations for the frameworks
+  // they concern.
+  bool incrementalAllocation;
+
   // There are two stages of allocation. During the first stage resources
   // are allocated only to frameworks in roles with quota set. During the
   // second stage remaining resources that would not be required to satisfy
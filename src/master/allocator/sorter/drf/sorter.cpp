@@ -16,6 +16,7 @@
 
 #include "master/allocator/sorter/drf/sorter.hpp"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <vector>
@@ -273,18 +274,14 @@ void DRFSorter::activate(const string& clientPath)
     client->kind = Node::ACTIVE_LEAF;
 
     // `client` has been activated, so move it to the beginning of its
-    // parent's list of children. We mark the tree dirty, so that the
-    // client's share is updated correctly and it is sorted properly.
-    //
-    // TODO(neilc): We could instead calculate share here and insert
-    // the client into the appropriate place here, which would avoid
-    // dirtying the whole tree.
+    // parent's list of children, and then to its position in DRF
+    // order, since its share might be stale.
     CHECK_NOTNULL(client->parent);
 
     client->parent->removeChild(client);
     client->parent->addChild(client);
 
-    dirty = true;
+    reposition(client);
   }
 }
 
@@ -320,7 +317,8 @@ void DRFSorter::allocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  Node* current = CHECK_NOTNULL(find(clientPath));
+  Node* client = CHECK_NOTNULL(find(clientPath));
+  Node* current = client;
 
   // NOTE: We don't currently update the `allocation` for the root
   // node. This is debatable, but the current implementation doesn't
@@ -330,8 +328,7 @@ void DRFSorter::allocated(
     current = CHECK_NOTNULL(current->parent);
   }
 
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
+  reposition(client);
 }
 
 
@@ -346,7 +343,8 @@ void DRFSorter::update(
   // Otherwise, we need to ensure we re-calculate the shares, as
   // is being currently done, for safety.
 
-  Node* current = CHECK_NOTNULL(find(clientPath));
+  Node* client = CHECK_NOTNULL(find(clientPath));
+  Node* current = client;
 
   // NOTE: We don't currently update the `allocation` for the root
   // node. This is debatable, but the current implementation doesn't
@@ -356,8 +354,10 @@ void DRFSorter::update(
     current = CHECK_NOTNULL(current->parent);
   }
 
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
+  // NOTE: Only the shares of `client` and its ancestors can change,
+  // even if the quantities of the allocation have changed, since the
+  // total resources are unaffected.
+  reposition(client);
 }
 
 
@@ -366,7 +366,8 @@ void DRFSorter::unallocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  Node* current = CHECK_NOTNULL(find(clientPath));
+  Node* client = CHECK_NOTNULL(find(clientPath));
+  Node* current = client;
 
   // NOTE: We don't currently update the `allocation` for the root
   // node. This is debatable, but the current implementation doesn't
@@ -376,8 +377,7 @@ void DRFSorter::unallocated(
     current = CHECK_NOTNULL(current->parent);
   }
 
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
+  reposition(client);
 }
 
 
@@ -632,6 +632,56 @@ double DRFSorter::findWeight(const Node* node) const
 }
 
 
+void DRFSorter::reposition(Node* node)
+{
+  // There is no point in keeping the tree sorted if it is going to be
+  // resorted anyway.
+  if (dirty) {
+    return;
+  }
+
+  for (; node != root; node = CHECK_NOTNULL(node->parent)) {
+    // The position of an inactive leaf doesn't depend on its share,
+    // which is recalculated once it gets activated. Since the shares
+    // of the ancestors of an inactive leaf might have changed we keep
+    // going though.
+    if (node->kind == Node::INACTIVE_LEAF) {
+      continue;
+    }
+
+    node->share = calculateShare(node);
+
+    vector<Node*>& siblings = node->parent->children;
+
+    // The active leaves and internal nodes come before the inactive
+    // leaves (ordering invariant (1)) and all but `node` are sorted.
+    auto end = std::partition_point(
+        siblings.begin(),
+        siblings.end(),
+        [](const Node* sibling) {
+          return sibling->kind != Node::INACTIVE_LEAF;
+        });
+
+    auto it = std::find(siblings.begin(), end, node);
+    CHECK(it != end);
+
+    // Move `node` either towards the front or towards the back,
+    // shifting the siblings in between by one position.
+    if (it != siblings.begin() && Node::compareDRF(node, *(it - 1))) {
+      auto position =
+        std::upper_bound(siblings.begin(), it, node, Node::compareDRF);
+
+      std::rotate(position, it, it + 1);
+    } else if (it + 1 != end && Node::compareDRF(*(it + 1), node)) {
+      auto position =
+        std::lower_bound(it + 1, end, node, Node::compareDRF);
+
+      std::rotate(it, it + 1, position);
+    }
+  }
+}
+
+
 DRFSorter::Node* DRFSorter::find(const string& clientPath) const
 {
   Option<Node*> client_ = clients.get(clientPath);
@@ -122,10 +122,21 @@ private:
   // internal node in the tree (not a client).
   Node* find(const std::string& clientPath) const;
 
+  // Recalculates the shares of the node and of its ancestors, whose
+  // allocations (or activation) have changed, and moves each of them
+  // to its position in DRF order among its siblings. This keeps the
+  // tree sorted without recalculating all shares and resorting the
+  // whole tree, unless it is dirty already.
+  void reposition(Node* node);
+
   // Resources (by name) that will be excluded from fair sharing.
   Option<std::set<std::string>> fairnessExcludeResourceNames;
 
   // If true, sort() will recalculate all shares and resort the tree.
+  // This is only needed when all shares might have changed (e.g., if
+  // the total resources have changed) or when the structure of the
+  // tree has changed; changes to the allocation of a client only
+  // reposition the affected nodes (see `reposition()`).
   bool dirty = false;
 
   // The root node in the sorter tree.
@@ -258,7 +269,8 @@ struct DRFSorter::Node
   // can stop when the first inactive leaf is observed.
   //
   // (2) If the tree is not dirty, the active leaves and internal
-  // nodes are kept sorted by DRF share.
+  // nodes are kept sorted by DRF share, and their shares are up to
+  // date. The shares of inactive leaves might be stale.
   std::vector<Node*> children;
 
   // If this node represents a sorter client, this returns the path of
@@ -81,6 +81,14 @@ constexpr double RECOVERY_AGENT_REMOVAL_PERCENT_LIMIT = 1.0; // 100%.
 // Maximum number of removed slaves to store in the cache.
 constexpr size_t MAX_REMOVED_SLAVES = 100000;
 
+// Maximum number of responses to the read-only HTTP endpoints to
+// store in the cache, see `--cache_http_readonly_responses`.
+constexpr size_t MAX_CACHED_HTTP_RESPONSES = 64;
+
+// Maximum number of snapshots of the master's state which the
+// responses to the read-only HTTP endpoints may read at a time.
+constexpr size_t MAX_READONLY_SNAPSHOTS = 2;
+
 // Default maximum number of completed frameworks to store in the cache.
 constexpr size_t DEFAULT_MAX_COMPLETED_FRAMEWORKS = 50;
 
@@ -114,6 +114,17 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(20));
 
+  add(&Flags::registry_store_deltas,
+      "registry_store_deltas",
+      "Whether the registrar stores the changes made to the registry by\n"
+      "each update as deltas appended to the stored registry, rather than\n"
+      "storing the whole registry on every update. The registry is\n"
+      "compacted (stored whole) once the deltas are as large as it.\n"
+      "NOTE: Masters that do not support this flag fail to recover the\n"
+      "registry once deltas have been stored, so this flag should only be\n"
+      "enabled once all masters support it.",
+      false);
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -194,6 +205,35 @@ mesos::internal::master::Flags::Flags()
       " (batch) allocations (e.g., 500ms, 1sec, etc).",
       DEFAULT_ALLOCATION_INTERVAL);
 
+  add(&Flags::allocation_parallelism,
+      "allocation_parallelism",
+      "The number of shards the agents are partitioned into during an\n"
+      "allocation cycle. When greater than 1, the offers that could be\n"
+      "made on the agents of each shard are computed in parallel, before\n"
+      "the allocator hands them out to the roles and frameworks in their\n"
+      "fair share order. The resulting allocations are the same as with\n"
+      "a single shard.",
+      1,
+      [](size_t value) -> Option<Error> {
+        if (value < 1) {
+          return Error("Expected `--allocation_parallelism` to be at least 1");
+        }
+        return None();
+      });
+
+  add(&Flags::incremental_allocation,
+      "incremental_allocation",
+      "When set to true, the allocator allocates the resources affected\n"
+      "by an event as soon as it is processed, instead of waiting for the\n"
+      "next batch allocation: recovered resources are offered right away,\n"
+      "and reviving offers or the expiry of an offer filter only leads to\n"
+      "an allocation for the framework concerned. A framework declining\n"
+      "an offer is filtered from the declined resources for at least an\n"
+      "`--allocation_interval`, even if it declined with a zero\n"
+      "`refuse_seconds`. Batch allocations still take place every\n"
+      "`--allocation_interval`.",
+      false);
+
   add(&Flags::cluster,
       "cluster",
       "Human readable name for the cluster, displayed in the webui.");
@@ -252,6 +292,15 @@ mesos::internal::master::Flags::Flags()
       "If `false`, HTTP frameworks are not authenticated.",
       false);
 
+  add(&Flags::cache_http_readonly_responses,
+      "cache_http_readonly_responses",
+      "If `true`, the responses to the read-only endpoints `/state`,\n"
+      "`/state-summary`, `/frameworks`, `/slaves` and `/tasks` are cached\n"
+      "until the state of the master changes, and they carry an `ETag` so\n"
+      "that clients can revalidate them with `If-None-Match`. Note that\n"
+      "the body of a cached response to `/state` is not streamed.",
+      false);
+
   add(&Flags::credentials,
       "credentials",
       "Path to a JSON-formatted file containing credentials.\n"
@@ -54,6 +54,7 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  bool registry_store_deltas;
   bool log_auto_initialize;
   Duration agent_reregister_timeout;
   std::string recovery_agent_removal_limit;
@@ -63,6 +64,8 @@ public:
   std::string user_sorter;
   std::string framework_sorter;
   Duration allocation_interval;
+  size_t allocation_parallelism;
+  bool incremental_allocation;
   Option<std::string> cluster;
   Option<std::string> roles;
   Option<std::string> weights;
@@ -71,6 +74,7 @@ public:
   bool authenticate_http_readonly;
   bool authenticate_http_readwrite;
   bool authenticate_http_frameworks;
+  bool cache_http_readonly_responses;
   Option<Path> credentials;
   Option<ACLs> acls;
   Option<Firewall> firewall_rules;
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
@@ -36,16 +37,21 @@
 
 #include <mesos/v1/master/master.hpp>
 
+#include <process/async.hpp>
+#include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
+#include <process/dispatch.hpp>
 #include <process/help.hpp>
 #include <process/logging.hpp>
+#include <process/loop.hpp>
 
 #include <process/metrics/metrics.hpp>
 
 #include <stout/base64.hpp>
 #include <stout/errorbase.hpp>
 #include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/json.hpp>
@@ -89,13 +95,19 @@ using google::protobuf::RepeatedPtrField;
 
 using process::AUTHENTICATION;
 using process::AUTHORIZATION;
+using process::Break;
 using process::Clock;
+using process::Continue;
+using process::ControlFlow;
 using process::DESCRIPTION;
 using process::Failure;
 using process::Future;
 using process::HELP;
 using process::Logging;
+using process::Promise;
+using process::Shared;
 using process::TLDR;
+using process::UPID;
 
 using process::http::Accepted;
 using process::http::BadRequest;
@@ -192,6 +204,189 @@ using process::http::Request;
 using process::Owned;
 
 
+// The size of the chunks in which the parts of the body of a streamed
+// JSON response are written into its pipe, see `streamJSON`.
+static const size_t JSON_CHUNK_SIZE = 64 * 1024;
+
+
+// A part of the body of a streamed JSON response, which writes its
+// JSON to the passed function in chunks, see `streamJSON`.
+typedef lambda::function<void(const lambda::function<void(string&&)>&)>
+  JSONPart;
+
+
+// Returns a part which writes the field `key` of a JSON object along
+// with its value (anything that can be `jsonify`'d). The field must
+// not be the first field of the object.
+template <typename T>
+static JSONPart streamJSONField(const string& key, const T& value)
+{
+  return [key, value](const lambda::function<void(string&&)>& chunk) {
+    chunk("," + string(jsonify(key)) + ":");
+    jsonify(value).write(JSON_CHUNK_SIZE, chunk);
+  };
+}
+
+
+// Appends the parts which write the field `key` of a JSON object as
+// an array with a part per element of `elements`, so that a large
+// array gets written across many parts. `element` writes the JSON of
+// an element, or nothing to skip it (e.g., if it is gone by the time
+// its part gets written). The field must not be the first field of
+// the object.
+template <typename T>
+static void streamJSONArray(
+    vector<JSONPart>* parts,
+    const string& key,
+    const vector<T>& elements,
+    const lambda::function<
+        void(const T&, const lambda::function<void(string&&)>&)>& element)
+{
+  // The number of elements written so far, to separate them by commas.
+  std::shared_ptr<size_t> written(new size_t(0));
+
+  parts->push_back([key](const lambda::function<void(string&&)>& chunk) {
+    chunk("," + string(jsonify(key)) + ":[");
+  });
+
+  foreach (const T& t, elements) {
+    parts->push_back(
+        [written, element, t](
+            const lambda::function<void(string&&)>& chunk) {
+      bool first = true;
+
+      element(t, [&](string&& data) {
+        if (first) {
+          if (*written > 0) {
+            chunk(",");
+          }
+
+          (*written)++;
+          first = false;
+        }
+
+        chunk(std::move(data));
+      });
+    });
+  }
+
+  parts->push_back([](const lambda::function<void(string&&)>& chunk) {
+    chunk("]");
+  });
+}
+
+
+// Satisfies `response` with an `OK` response whose body is the JSON
+// written by `parts`, streamed through a pipe. The response gets
+// satisfied right away. The parts then get written into the pipe one
+// after another, each only once the reader has consumed the previous
+// parts, either in its own turn of `pid` or, without a `pid`, by
+// whoever consumed the previous parts. This way the body gets produced
+// only as fast as the client consumes it, and only about one part of
+// the body is held in memory at a time. No more parts get written once
+// the reader closes the pipe (e.g., because the client disconnected).
+//
+// If `compress` is set, the body gets gzip-compressed as it gets
+// streamed. It is up to the caller to check that the client accepts
+// that encoding.
+//
+// NOTE: Unlike `OK(jsonify(...))`, the body is sent with "chunked"
+// transfer encoding.
+static void streamJSON(
+    Promise<Response>* response,
+    const Option<UPID>& pid,
+    const vector<JSONPart>& parts,
+    const Option<string>& jsonp,
+    bool compress)
+{
+  CHECK(!parts.empty());
+
+  Pipe pipe;
+
+  OK ok;
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+  ok.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : "application/json";
+
+  if (compress) {
+    ok.headers["Content-Encoding"] = "gzip";
+  }
+
+  response->set(ok);
+
+  Pipe::Writer writer = pipe.writer();
+
+  std::shared_ptr<gzip::Compressor> compressor(
+      compress ? new gzip::Compressor() : nullptr);
+
+  // Writes a chunk of the body into the pipe. Returns false if the
+  // chunk could not be written, i.e., if the reader closed the pipe.
+  auto write = [writer, compressor](const string& chunk) mutable {
+    if (compressor.get() == nullptr) {
+      return writer.write(chunk);
+    }
+
+    Try<string> compressed = compressor->compress(chunk);
+    if (compressed.isError()) {
+      writer.fail("Failed to compress the body: " + compressed.error());
+      return false;
+    }
+
+    return writer.write(compressed.get());
+  };
+
+  // The index of the next part to be written.
+  std::shared_ptr<size_t> next(new size_t(0));
+
+  process::loop(
+      pid,
+      [writer]() {
+        return writer.drained();
+      },
+      [writer, compressor, write, parts, jsonp, next](
+          const Nothing&) mutable -> ControlFlow<Nothing> {
+        bool written = true;
+
+        auto chunk = [&](string&& data) {
+          written = written && write(data);
+        };
+
+        if (*next == 0 && jsonp.isSome()) {
+          chunk(jsonp.get() + "(");
+        }
+
+        parts[(*next)++](chunk);
+
+        if (!written) {
+          return Break();
+        }
+
+        if (*next < parts.size()) {
+          return Continue();
+        }
+
+        if (jsonp.isSome()) {
+          chunk(");");
+        }
+
+        if (compressor.get() != nullptr) {
+          Try<string> compressed = compressor->finish();
+          if (compressed.isError()) {
+            writer.fail("Failed to compress the body: " + compressed.error());
+            return Break();
+          }
+
+          writer.write(compressed.get());
+        }
+
+        writer.close();
+
+        return Break();
+      });
+}
+
+
 // The summary representation of `T` to support the `/state-summary` endpoint.
 // e.g., `Summary<Slave>`.
 template <typename T>
@@ -567,6 +762,268 @@ static void json(JSON::ObjectWriter* writer, const Summary<Framework>& summary)
 }
 
 
+// NOTE: The frameworks and agents of a snapshot are copies, whereas
+// the completed frameworks (and the completed tasks of every framework)
+// are shared with the master since they don't change anymore. Only the
+// specified `SnapshotCollections` are included, the others are empty.
+struct Master::Http::Snapshot
+{
+  Snapshot(Master* master, int collections)
+    : generation(master->generation),
+      electedTime(master->electedTime),
+      leader(master->leader),
+      slavesActive(master->_slaves_active()),
+      slavesInactive(master->_slaves_inactive()),
+      slavesUnreachable(master->_slaves_unreachable()),
+      frameworks(
+          collections & FRAMEWORKS
+            ? master->frameworks.completed
+            : BoundedHashMap<FrameworkID, Owned<Framework>>(0))
+  {
+    if (collections & FRAMEWORKS) {
+      foreachpair (const FrameworkID& frameworkId,
+                   const Framework* framework,
+                   master->frameworks.registered) {
+        copies.frameworks.push_back(
+            framework->copy(&copies.tasks, &copies.offers));
+
+        frameworks.registered[frameworkId] = copies.frameworks.back().get();
+      }
+    }
+
+    if (collections & SLAVES) {
+      foreachvalue (const Slave* slave, master->slaves.registered) {
+        copies.slaves.push_back(slave->copy());
+        slaves.registered.put(copies.slaves.back().get());
+      }
+
+      slaves.recovered = master->slaves.recovered;
+    }
+  }
+
+  ~Snapshot()
+  {
+    released.set(Nothing());
+  }
+
+  // Completed once the snapshot is no longer read by anyone.
+  Promise<Nothing> released;
+
+  // The generation of the master's state this is a snapshot of.
+  const uint64_t generation;
+
+  const Option<process::Time> electedTime;
+  const Option<MasterInfo> leader;
+
+  const double slavesActive;
+  const double slavesInactive;
+  const double slavesUnreachable;
+
+  struct Frameworks
+  {
+    explicit Frameworks(
+        const BoundedHashMap<FrameworkID, Owned<Framework>>& _completed)
+      : completed(_completed) {}
+
+    hashmap<FrameworkID, Framework*> registered;
+    BoundedHashMap<FrameworkID, Owned<Framework>> completed;
+  } frameworks;
+
+  // Only the registered and the recovered agents are included.
+  Master::Slaves slaves;
+
+private:
+  // The copies which `frameworks` and `slaves` point to.
+  struct
+  {
+    vector<Owned<Framework>> frameworks;
+    vector<Owned<Slave>> slaves;
+    vector<Owned<Task>> tasks;
+    vector<Owned<Offer>> offers;
+  } copies;
+};
+
+
+Future<Response> Master::Http::batch(
+    int collections,
+    const ReadOnlyHandler& handler) const
+{
+  if (batchedRequests.empty() &&
+      !servingBatch &&
+      snapshots < MAX_READONLY_SNAPSHOTS) {
+    // Serve the batch in a subsequent turn of the master, so that the
+    // read-only requests received in the meantime join it.
+    dispatch(master->self(), [this]() {
+      processRequestsBatch();
+    });
+  }
+
+  Owned<Promise<Response>> promise(new Promise<Response>());
+
+  batchedRequests.push_back(BatchedRequest{collections, handler, promise});
+
+  return batchedRequests.back().promise->future();
+}
+
+
+void Master::Http::processRequestsBatch() const
+{
+  // The read-only requests received while the handlers of a batch run
+  // are served by the next batch, from a new snapshot, once they are
+  // done. The next batch also waits as long as the maximum number of
+  // snapshots is still read, e.g., by responses being streamed from
+  // them. This way the master bounds the number (and hence the memory)
+  // of its snapshots no matter how many read-only requests it receives
+  // and how slowly their responses get consumed.
+  if (batchedRequests.empty() ||
+      servingBatch ||
+      snapshots >= MAX_READONLY_SNAPSHOTS) {
+    return;
+  }
+
+  // The handlers read a snapshot of the master's state, so that they
+  // can run concurrently on other worker threads while the master
+  // keeps processing events (and modifying its state). All the master
+  // does is to take the snapshot, which is much cheaper than serving
+  // the requests, e.g., than serializing its state as JSON.
+  //
+  // NOTE: The snapshot is kept alive for as long as a handler (or a
+  // response streamed by it, see `streamJSON`) still reads it.
+  int collections = 0;
+  foreach (const BatchedRequest& request, batchedRequests) {
+    collections |= request.collections;
+  }
+
+  Shared<Snapshot> snapshot(new Snapshot(master, collections));
+
+  snapshots++;
+
+  snapshot->released.future()
+    .onAny(defer(master->self(), [this](const Future<Nothing>&) {
+      snapshots--;
+      processRequestsBatch();
+    }));
+
+  list<Future<Nothing>> handled;
+
+  foreach (const BatchedRequest& request, batchedRequests) {
+    handled.push_back(process::async(
+        [snapshot](
+            const ReadOnlyHandler& handler,
+            const Owned<Promise<Response>>& promise) {
+          handler(snapshot, promise.get());
+        },
+        request.handler,
+        request.promise));
+  }
+
+  batchedRequests.clear();
+
+  servingBatch = true;
+
+  collect(handled)
+    .onAny(defer(master->self(), [this](const Future<list<Nothing>>&) {
+      servingBatch = false;
+      processRequestsBatch();
+    }));
+}
+
+
+Future<Response> Master::Http::cached(
+    const Request& request,
+    const Option<Principal>& principal,
+    int collections,
+    const ReadOnlyHandler& handler) const
+{
+  if (!master->flags.cache_http_readonly_responses) {
+    return batch(collections, handler);
+  }
+
+  // NOTE: The query parameters are sorted so that the same requests
+  // map to the same key regardless of the order of their parameters.
+  const std::map<string, string> query(
+      request.url.query.begin(), request.url.query.end());
+
+  string key = request.url.path + "?";
+  foreachpair (const string& name, const string& value, query) {
+    key += name + "=" + value + "&";
+  }
+
+  if (principal.isSome()) {
+    key += "#" + stringify(principal.get());
+  }
+
+  // Since the generation of the master's state is part of the `ETag`,
+  // a matching `ETag` means that the response would be the same even
+  // if it isn't cached (anymore).
+  Option<string> ifNoneMatch = request.headers.get("If-None-Match");
+  if (ifNoneMatch.isSome() &&
+      ifNoneMatch.get() == etag(key, master->generation)) {
+    Response response(process::http::Status::NOT_MODIFIED);
+    response.headers["ETag"] = ifNoneMatch.get();
+    return response;
+  }
+
+  Option<CachedResponse> cachedResponse = cachedResponses.get(key);
+  if (cachedResponse.isSome() &&
+      cachedResponse->generation == master->generation) {
+    return cachedResponse->response;
+  }
+
+  return batch(collections, [this, key, handler](
+      const Shared<Snapshot>& snapshot,
+      Promise<Response>* promise) {
+    // NOTE: A response gets tagged with the generation of the snapshot
+    // it was produced from, which is the master's state as of the start
+    // of its batch.
+    const uint64_t generation = snapshot->generation;
+
+    Owned<Promise<Response>> produced(new Promise<Response>());
+    handler(snapshot, produced.get());
+
+    promise->associate(produced->future()
+      .then([produced](Response response) -> Future<Response> {
+        if (response.type != Response::PIPE) {
+          return response;
+        }
+
+        // Turn a streamed response into one with a body, which can be
+        // cached, once it has been streamed as a whole.
+        return response.reader->readAll()
+          .then([response](const string& body) mutable {
+            response.type = Response::BODY;
+            response.body = body;
+            response.reader = None();
+            response.headers["Content-Length"] = stringify(body.size());
+
+            return response;
+          });
+      })
+      .then(defer(
+          master->self(),
+          [this, key, generation](Response response) {
+        response.headers["ETag"] = etag(key, generation);
+
+        if (response.code == process::http::Status::OK) {
+          cachedResponses.put(key, CachedResponse{generation, response});
+        }
+
+        return response;
+      })));
+  });
+}
+
+
+string Master::Http::etag(const string& key, uint64_t generation) const
+{
+  // NOTE: The ID of the master is included since the generations of
+  // the states of different masters (e.g., after a failover) aren't
+  // related.
+  return "\"" + master->info().id() + "-" + stringify(generation) + "-" +
+         stringify(std::hash<string>()(key)) + "\"";
+}
+
+
 string Master::Http::API_HELP()
 {
   return HELP(
@@ -683,6 +1140,40 @@ Future<Response> Master::Http::api(
         "'" + APPLICATION_PROTOBUF + "' or '" + APPLICATION_JSON + "'");
   }
 
+  // Only the calls which might change the master's state invalidate the
+  // cached responses to the read-only endpoints (see `Master::modified`).
+  switch (call.type()) {
+    case mesos::master::Call::GET_HEALTH:
+    case mesos::master::Call::GET_FLAGS:
+    case mesos::master::Call::GET_VERSION:
+    case mesos::master::Call::GET_METRICS:
+    case mesos::master::Call::GET_LOGGING_LEVEL:
+    case mesos::master::Call::LIST_FILES:
+    case mesos::master::Call::READ_FILE:
+    case mesos::master::Call::GET_STATE:
+    case mesos::master::Call::GET_AGENTS:
+    case mesos::master::Call::GET_FRAMEWORKS:
+    case mesos::master::Call::GET_EXECUTORS:
+    case mesos::master::Call::GET_TASKS:
+    case mesos::master::Call::GET_ROLES:
+    case mesos::master::Call::GET_WEIGHTS:
+    case mesos::master::Call::GET_MASTER:
+    case mesos::master::Call::GET_MAINTENANCE_STATUS:
+    case mesos::master::Call::GET_MAINTENANCE_SCHEDULE:
+    case mesos::master::Call::GET_QUOTA:
+      return _api(call, principal, acceptType);
+
+    default:
+      return master->modified(_api(call, principal, acceptType));
+  }
+}
+
+
+Future<Response> Master::Http::_api(
+    const mesos::master::Call& call,
+    const Option<Principal>& principal,
+    ContentType acceptType) const
+{
   switch (call.type()) {
     case mesos::master::Call::UNKNOWN:
       return NotImplemented();
@@ -1552,14 +2043,18 @@ Future<Response> Master::Http::frameworks(
       authorizeExecutorInfo,
       selectFrameworkId)
     .then(defer(master->self(),
-        [this, request](const tuple<Owned<AuthorizationAcceptor>,
-                                    Owned<AuthorizationAcceptor>,
-                                    Owned<AuthorizationAcceptor>,
-                                    IDAcceptor<FrameworkID>>& acceptors)
-          -> Response {
-      // This lambda is consumed before the outer lambda
-      // returns, hence capture by reference is fine here.
-      auto frameworks = [this, &acceptors](JSON::ObjectWriter* writer) {
+        [this, request, principal](
+            const tuple<Owned<AuthorizationAcceptor>,
+                        Owned<AuthorizationAcceptor>,
+                        Owned<AuthorizationAcceptor>,
+                        IDAcceptor<FrameworkID>>& acceptors)
+          -> Future<Response> {
+      // This lambda is consumed once the request gets served by a
+      // batch (see `processRequestsBatch`), hence the acceptors are
+      // captured by value.
+      auto frameworks = [acceptors](
+          const Snapshot& snapshot,
+          JSON::ObjectWriter* writer) {
         Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
         Owned<AuthorizationAcceptor> authorizeTask;
         Owned<AuthorizationAcceptor> authorizeExecutorInfo;
@@ -1572,12 +2067,12 @@ Future<Response> Master::Http::frameworks(
         // Model all of the frameworks.
         writer->field(
             "frameworks",
-            [this,
+            [&snapshot,
              &authorizeFrameworkInfo,
              &authorizeTask,
              &authorizeExecutorInfo,
              &selectFrameworkId](JSON::ArrayWriter* writer) {
-          foreachvalue (Framework* framework, master->frameworks.registered) {
+          foreachvalue (Framework* framework, snapshot.frameworks.registered) {
             // Skip unauthorized frameworks or frameworks without a matching ID.
             if (!selectFrameworkId.accept(framework->id()) ||
                 !authorizeFrameworkInfo->accept(framework->info)) {
@@ -1596,13 +2091,13 @@ Future<Response> Master::Http::frameworks(
         // Model all of the completed frameworks.
         writer->field(
             "completed_frameworks",
-            [this,
+            [&snapshot,
              &authorizeFrameworkInfo,
              &authorizeTask,
              &authorizeExecutorInfo,
              &selectFrameworkId](JSON::ArrayWriter* writer) {
           foreachvalue (const Owned<Framework>& framework,
-                        master->frameworks.completed) {
+                        snapshot.frameworks.completed) {
             // Skip unauthorized frameworks or frameworks without a matching ID.
             if (!selectFrameworkId.accept(framework->id()) ||
                 !authorizeFrameworkInfo->accept(framework->info)) {
@@ -1623,7 +2118,21 @@ Future<Response> Master::Http::frameworks(
         writer->field("unregistered_frameworks", [](JSON::ArrayWriter*) {});
       };
 
-      return OK(jsonify(frameworks), request.url.query.get("jsonp"));
+      Option<string> jsonp = request.url.query.get("jsonp");
+
+      return cached(
+          request,
+          principal,
+          FRAMEWORKS,
+          [frameworks, jsonp](
+              const Shared<Snapshot>& snapshot,
+              Promise<Response>* response) {
+        response->set(OK(
+            jsonify([&](JSON::ObjectWriter* writer) {
+              frameworks(*snapshot, writer);
+            }),
+            jsonp));
+      });
   }));
 }
 
@@ -2520,16 +3029,26 @@ Future<Response> Master::Http::slaves(
 
   return collect(authorizeRole, selectSlaveId)
     .then(defer(master->self(),
-        [master, jsonp](const tuple<Owned<AuthorizationAcceptor>,
-                                    IDAcceptor<SlaveID>>& acceptors)
+        [master, request, principal, jsonp](
+            const tuple<Owned<AuthorizationAcceptor>,
+                        IDAcceptor<SlaveID>>& acceptors)
           -> Future<Response> {
-      Owned<AuthorizationAcceptor> authorizeRole;
-      IDAcceptor<SlaveID> selectSlaveId;
-      tie(authorizeRole, selectSlaveId) = acceptors;
+      return master->http.cached(
+          request,
+          principal,
+          SLAVES,
+          [jsonp, acceptors](
+              const Shared<Snapshot>& snapshot,
+              Promise<Response>* response) {
+        Owned<AuthorizationAcceptor> authorizeRole;
+        IDAcceptor<SlaveID> selectSlaveId;
+        tie(authorizeRole, selectSlaveId) = acceptors;
 
-      return OK(
-          jsonify(SlavesWriter(master->slaves, authorizeRole, selectSlaveId)),
-          jsonp);
+        response->set(OK(
+            jsonify(
+                SlavesWriter(snapshot->slaves, authorizeRole, selectSlaveId)),
+            jsonp));
+      });
   }));
 }
 
@@ -2850,169 +3369,205 @@ Future<Response> Master::Http::state(
       authorizeFlags)
     .then(defer(
         master->self(),
-        [this, request](const tuple<Owned<AuthorizationAcceptor>,
-                                    Owned<AuthorizationAcceptor>,
-                                    Owned<AuthorizationAcceptor>,
-                                    Owned<AuthorizationAcceptor>,
-                                    Owned<AuthorizationAcceptor>>& acceptors)
-          -> Response {
-      // This lambda is consumed before the outer lambda
-      // returns, hence capture by reference is fine here.
-      auto state = [this, &acceptors](JSON::ObjectWriter* writer) {
-        Owned<AuthorizationAcceptor> authorizeRole;
-        Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
-        Owned<AuthorizationAcceptor> authorizeTask;
-        Owned<AuthorizationAcceptor> authorizeExecutorInfo;
-        Owned<AuthorizationAcceptor> authorizeFlags;
-        tie(authorizeRole,
-            authorizeFrameworkInfo,
-            authorizeTask,
-            authorizeExecutorInfo,
-            authorizeFlags) = acceptors;
+        [this, request, principal](
+            const tuple<Owned<AuthorizationAcceptor>,
+                        Owned<AuthorizationAcceptor>,
+                        Owned<AuthorizationAcceptor>,
+                        Owned<AuthorizationAcceptor>,
+                        Owned<AuthorizationAcceptor>>& acceptors)
+          -> Future<Response> {
+      Owned<AuthorizationAcceptor> authorizeRole;
+      Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
+      Owned<AuthorizationAcceptor> authorizeTask;
+      Owned<AuthorizationAcceptor> authorizeExecutorInfo;
+      Owned<AuthorizationAcceptor> authorizeFlags;
+      tie(authorizeRole,
+          authorizeFrameworkInfo,
+          authorizeTask,
+          authorizeExecutorInfo,
+          authorizeFlags) = acceptors;
+
+      Option<string> jsonp = request.url.query.get("jsonp");
+
+      // The body gets compressed as it gets streamed if the client
+      // accepts that. A response which gets cached doesn't, as it might
+      // get served to other clients, it gets compressed when sent.
+      bool compress = request.acceptsEncoding("gzip") &&
+                      !master->flags.cache_http_readonly_responses;
+
+      // This lambda is consumed once the request gets served by a
+      // batch (see `processRequestsBatch`), hence the acceptors are
+      // captured by value.
+      return cached(
+          request,
+          principal,
+          FRAMEWORKS | SLAVES,
+          [=](const Shared<Snapshot>& snapshot, Promise<Response>* response) {
+        // The body gets streamed in parts (see `streamJSON`): first the
+        // top-level fields, then every agent and framework on its own.
+        //
+        // NOTE: The parts hold on to the snapshot, which the agents and
+        // frameworks below point into, until the body has been streamed.
+        vector<JSONPart> parts;
+
+        parts.push_back([=](const lambda::function<void(string&&)>& chunk) {
+          string fields = jsonify([&](JSON::ObjectWriter* writer) {
+            writer->field("version", MESOS_VERSION);
+
+            if (build::GIT_SHA.isSome()) {
+              writer->field("git_sha", build::GIT_SHA.get());
+            }
 
-        writer->field("version", MESOS_VERSION);
+            if (build::GIT_BRANCH.isSome()) {
+              writer->field("git_branch", build::GIT_BRANCH.get());
+            }
 
-        if (build::GIT_SHA.isSome()) {
-          writer->field("git_sha", build::GIT_SHA.get());
-        }
+            if (build::GIT_TAG.isSome()) {
+              writer->field("git_tag", build::GIT_TAG.get());
+            }
 
-        if (build::GIT_BRANCH.isSome()) {
-          writer->field("git_branch", build::GIT_BRANCH.get());
-        }
+            writer->field("build_date", build::DATE);
+            writer->field("build_time", build::TIME);
+            writer->field("build_user", build::USER);
+            writer->field("start_time", master->startTime.secs());
 
-        if (build::GIT_TAG.isSome()) {
-          writer->field("git_tag", build::GIT_TAG.get());
-        }
+            if (snapshot->electedTime.isSome()) {
+              writer->field(
+                  "elected_time", snapshot->electedTime.get().secs());
+            }
 
-        writer->field("build_date", build::DATE);
-        writer->field("build_time", build::TIME);
-        writer->field("build_user", build::USER);
-        writer->field("start_time", master->startTime.secs());
+            writer->field("id", master->info().id());
+            writer->field("pid", string(master->self()));
+            writer->field("hostname", master->info().hostname());
+            writer->field("activated_slaves", snapshot->slavesActive);
+            writer->field("deactivated_slaves", snapshot->slavesInactive);
+            writer->field("unreachable_slaves", snapshot->slavesUnreachable);
 
-        if (master->electedTime.isSome()) {
-          writer->field("elected_time", master->electedTime.get().secs());
-        }
+            if (master->info().has_domain()) {
+              writer->field("domain", master->info().domain());
+            }
 
-        writer->field("id", master->info().id());
-        writer->field("pid", string(master->self()));
-        writer->field("hostname", master->info().hostname());
-        writer->field("activated_slaves", master->_slaves_active());
-        writer->field("deactivated_slaves", master->_slaves_inactive());
-        writer->field("unreachable_slaves", master->_slaves_unreachable());
+            // TODO(haosdent): Deprecated this in favor of `leader_info` below.
+            if (snapshot->leader.isSome()) {
+              writer->field("leader", snapshot->leader->pid());
+            }
 
-        if (master->info().has_domain()) {
-          writer->field("domain", master->info().domain());
-        }
+            if (snapshot->leader.isSome()) {
+              writer->field("leader_info", [&](JSON::ObjectWriter* writer) {
+                json(writer, snapshot->leader.get());
+              });
+            }
 
-        // TODO(haosdent): Deprecated this in favor of `leader_info` below.
-        if (master->leader.isSome()) {
-          writer->field("leader", master->leader->pid());
-        }
+            if (authorizeFlags->accept()) {
+              if (master->flags.cluster.isSome()) {
+                writer->field("cluster", master->flags.cluster.get());
+              }
 
-        if (master->leader.isSome()) {
-          writer->field("leader_info", [this](JSON::ObjectWriter* writer) {
-            json(writer, master->leader.get());
-          });
-        }
+              if (master->flags.log_dir.isSome()) {
+                writer->field("log_dir", master->flags.log_dir.get());
+              }
 
-        if (authorizeFlags->accept()) {
-          if (master->flags.cluster.isSome()) {
-            writer->field("cluster", master->flags.cluster.get());
-          }
+              if (master->flags.external_log_file.isSome()) {
+                writer->field("external_log_file",
+                              master->flags.external_log_file.get());
+              }
 
-          if (master->flags.log_dir.isSome()) {
-            writer->field("log_dir", master->flags.log_dir.get());
-          }
+              writer->field("flags", [this](JSON::ObjectWriter* writer) {
+                  foreachvalue (const flags::Flag& flag, master->flags) {
+                    Option<string> value = flag.stringify(master->flags);
+                    if (value.isSome()) {
+                      writer->field(flag.effective_name().value, value.get());
+                    }
+                  }
+                });
+            }
+          });
 
-          if (master->flags.external_log_file.isSome()) {
-            writer->field("external_log_file",
-                          master->flags.external_log_file.get());
-          }
+          // Drop the closing brace, the fields of the other parts follow.
+          fields.pop_back();
 
-          writer->field("flags", [this](JSON::ObjectWriter* writer) {
-              foreachvalue (const flags::Flag& flag, master->flags) {
-                Option<string> value = flag.stringify(master->flags);
-                if (value.isSome()) {
-                  writer->field(flag.effective_name().value, value.get());
-                }
-              }
-            });
-        }
+          chunk(std::move(fields));
+        });
 
         // Model all of the registered slaves.
-        writer->field("slaves",
-          [this, &authorizeRole](JSON::ArrayWriter* writer) {
-            foreachvalue (Slave* slave, master->slaves.registered) {
-              writer->element(SlaveWriter(*slave, authorizeRole));
-            }
-          });
+        vector<const Slave*> slaves;
+        foreachvalue (const Slave* slave, snapshot->slaves.registered) {
+          slaves.push_back(slave);
+        }
+
+        streamJSONArray<const Slave*>(
+            &parts,
+            "slaves",
+            slaves,
+            [=](const Slave* slave,
+                const lambda::function<void(string&&)>& chunk) {
+          jsonify(SlaveWriter(*slave, authorizeRole))
+            .write(JSON_CHUNK_SIZE, chunk);
+        });
 
         // Model all of the recovered slaves.
-        writer->field("recovered_slaves", [this](JSON::ArrayWriter* writer) {
-          foreachvalue (const SlaveInfo& slaveInfo, master->slaves.recovered) {
+        parts.push_back(streamJSONField(
+            "recovered_slaves",
+            [snapshot](JSON::ArrayWriter* writer) {
+          foreachvalue (const SlaveInfo& slaveInfo,
+                        snapshot->slaves.recovered) {
             writer->element([&slaveInfo](JSON::ObjectWriter* writer) {
               json(writer, slaveInfo);
             });
           }
-        });
+        }));
 
-        // Model all of the frameworks.
-        writer->field(
-            "frameworks",
-            [this,
-             &authorizeFrameworkInfo,
-             &authorizeTask,
-             &authorizeExecutorInfo](JSON::ArrayWriter* writer) {
-          foreachvalue (
-              Framework* framework,
-              master->frameworks.registered) {
-            // Skip unauthorized frameworks.
-            if (!authorizeFrameworkInfo->accept(framework->info)) {
-              continue;
-            }
+        auto framework = [=](
+            const Framework* framework,
+            const lambda::function<void(string&&)>& chunk) {
+          // Skip unauthorized frameworks.
+          if (!authorizeFrameworkInfo->accept(framework->info)) {
+            return;
+          }
 
-            auto frameworkWriter = FullFrameworkWriter(
-                authorizeTask,
-                authorizeExecutorInfo,
-                framework);
+          jsonify(FullFrameworkWriter(
+              authorizeTask,
+              authorizeExecutorInfo,
+              framework))
+            .write(JSON_CHUNK_SIZE, chunk);
+        };
 
-            writer->element(frameworkWriter);
-          }
-        });
+        // Model all of the frameworks.
+        vector<const Framework*> frameworks;
+        foreachvalue (const Framework* framework,
+                      snapshot->frameworks.registered) {
+          frameworks.push_back(framework);
+        }
 
-        // Model all of the completed frameworks.
-        writer->field(
-            "completed_frameworks",
-            [this,
-             &authorizeFrameworkInfo,
-             &authorizeTask,
-             &authorizeExecutorInfo](JSON::ArrayWriter* writer) {
-          foreachvalue (const Owned<Framework>& framework,
-                        master->frameworks.completed) {
-            // Skip unauthorized frameworks.
-            if (!authorizeFrameworkInfo->accept(framework->info)) {
-              continue;
-            }
+        streamJSONArray<const Framework*>(
+            &parts, "frameworks", frameworks, framework);
 
-            auto frameworkWriter = FullFrameworkWriter(
-                authorizeTask,
-                authorizeExecutorInfo,
-                framework.get());
+        // Model all of the completed frameworks.
+        vector<const Framework*> completedFrameworks;
+        foreachvalue (const Owned<Framework>& framework,
+                      snapshot->frameworks.completed) {
+          completedFrameworks.push_back(framework.get());
+        }
 
-            writer->element(frameworkWriter);
-          }
-        });
+        streamJSONArray<const Framework*>(
+            &parts, "completed_frameworks", completedFrameworks, framework);
 
         // Orphan tasks are no longer possible. We emit an empty array
         // for the sake of backward compatibility.
-        writer->field("orphan_tasks", [](JSON::ArrayWriter*) {});
+        parts.push_back(
+            streamJSONField("orphan_tasks", [](JSON::ArrayWriter*) {}));
 
         // Unregistered frameworks are no longer possible. We emit an
         // empty array for the sake of backward compatibility.
-        writer->field("unregistered_frameworks", [](JSON::ArrayWriter*) {});
-      };
+        parts.push_back(streamJSONField(
+            "unregistered_frameworks", [](JSON::ArrayWriter*) {}));
 
-      return OK(jsonify(state), request.url.query.get("jsonp"));
+        parts.push_back([](const lambda::function<void(string&&)>& chunk) {
+          chunk("}");
+        });
+
+        streamJSON(response, None(), parts, jsonp, compress);
+      });
     }));
 }
 
@@ -3297,10 +3852,16 @@ Future<Response> Master::Http::stateSummary(
 
   return collect(authorizeRole, authorizeFrameworkInfo).then(defer(
       master->self(),
-      [this, request](const tuple<Owned<AuthorizationAcceptor>,
-                                  Owned<AuthorizationAcceptor>>& acceptors)
-          -> Response {
-        auto stateSummary = [this, &acceptors](JSON::ObjectWriter* writer) {
+      [this, request, principal](
+          const tuple<Owned<AuthorizationAcceptor>,
+                      Owned<AuthorizationAcceptor>>& acceptors)
+          -> Future<Response> {
+        // This lambda is consumed once the request gets served by a
+        // batch (see `processRequestsBatch`), hence the acceptors are
+        // captured by value.
+        auto stateSummary = [this, acceptors](
+            const Snapshot& snapshot,
+            JSON::ObjectWriter* writer) {
           Owned<AuthorizationAcceptor> authorizeRole;
           Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
           tie(authorizeRole, authorizeFrameworkInfo) = acceptors;
@@ -3321,19 +3882,20 @@ Future<Response> Master::Http::stateSummary(
 
           // Generate mappings from 'slave' to 'framework' and reverse.
           SlaveFrameworkMapping slaveFrameworkMapping(
-              master->frameworks.registered);
+              snapshot.frameworks.registered);
 
           // Generate 'TaskState' summaries for all framework and slave ids.
-          TaskStateSummaries taskStateSummaries(master->frameworks.registered);
+          TaskStateSummaries taskStateSummaries(
+              snapshot.frameworks.registered);
 
           // Model all of the slaves.
           writer->field(
               "slaves",
-              [this,
+              [&snapshot,
                &slaveFrameworkMapping,
                &taskStateSummaries,
                &authorizeRole](JSON::ArrayWriter* writer) {
-                foreachvalue (Slave* slave, master->slaves.registered) {
+                foreachvalue (Slave* slave, snapshot.slaves.registered) {
                   writer->element(
                       [&slave,
                        &slaveFrameworkMapping,
@@ -3384,13 +3946,13 @@ Future<Response> Master::Http::stateSummary(
           // Model all of the frameworks.
           writer->field(
               "frameworks",
-              [this,
+              [&snapshot,
                &slaveFrameworkMapping,
                &taskStateSummaries,
                &authorizeFrameworkInfo](JSON::ArrayWriter* writer) {
                 foreachpair (const FrameworkID& frameworkId,
                              Framework* framework,
-                             master->frameworks.registered) {
+                             snapshot.frameworks.registered) {
                   // Skip unauthorized frameworks.
                   if (!authorizeFrameworkInfo->accept(framework->info)) {
                     continue;
@@ -3436,7 +3998,21 @@ Future<Response> Master::Http::stateSummary(
               });
         };
 
-        return OK(jsonify(stateSummary), request.url.query.get("jsonp"));
+        Option<string> jsonp = request.url.query.get("jsonp");
+
+        return cached(
+            request,
+            principal,
+            FRAMEWORKS | SLAVES,
+            [stateSummary, jsonp](
+                const Shared<Snapshot>& snapshot,
+                Promise<Response>* response) {
+          response->set(OK(
+              jsonify([&](JSON::ObjectWriter* writer) {
+                stateSummary(*snapshot, writer);
+              }),
+              jsonp));
+        });
       }));
 }
 
@@ -3995,100 +4571,111 @@ Future<Response> Master::Http::tasks(
                         Owned<AuthorizationAcceptor>,
                         IDAcceptor<FrameworkID>,
                         IDAcceptor<TaskID>>& acceptors)-> Future<Response> {
-          Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
-          Owned<AuthorizationAcceptor> authorizeTask;
-          IDAcceptor<FrameworkID> selectFrameworkId;
-          IDAcceptor<TaskID> selectTaskId;
-          tie(authorizeFrameworkInfo,
-              authorizeTask,
-              selectFrameworkId,
-              selectTaskId) = acceptors;
-
-          // Construct framework list with both active and completed frameworks.
-          vector<const Framework*> frameworks;
-          foreachvalue (Framework* framework, master->frameworks.registered) {
-            // Skip unauthorized frameworks or frameworks without matching
-            // framework ID.
-            if (!selectFrameworkId.accept(framework->id()) ||
-                !authorizeFrameworkInfo->accept(framework->info)) {
-              continue;
+          Option<string> jsonp = request.url.query.get("jsonp");
+
+          return cached(
+              request,
+              principal,
+              FRAMEWORKS,
+              [=](const Shared<Snapshot>& snapshot,
+                  Promise<Response>* response) {
+            Owned<AuthorizationAcceptor> authorizeFrameworkInfo;
+            Owned<AuthorizationAcceptor> authorizeTask;
+            IDAcceptor<FrameworkID> selectFrameworkId;
+            IDAcceptor<TaskID> selectTaskId;
+            tie(authorizeFrameworkInfo,
+                authorizeTask,
+                selectFrameworkId,
+                selectTaskId) = acceptors;
+
+            // Construct framework list with both active and completed
+            // frameworks.
+            vector<const Framework*> frameworks;
+            foreachvalue (Framework* framework,
+                          snapshot->frameworks.registered) {
+              // Skip unauthorized frameworks or frameworks without matching
+              // framework ID.
+              if (!selectFrameworkId.accept(framework->id()) ||
+                  !authorizeFrameworkInfo->accept(framework->info)) {
+                continue;
+              }
+
+              frameworks.push_back(framework);
             }
 
-            frameworks.push_back(framework);
-          }
+            foreachvalue (const Owned<Framework>& framework,
+                          snapshot->frameworks.completed) {
+              // Skip unauthorized frameworks or frameworks without matching
+              // framework ID.
+              if (!selectFrameworkId.accept(framework->id()) ||
+                  !authorizeFrameworkInfo->accept(framework->info)) {
+               continue;
+              }
 
-          foreachvalue (const Owned<Framework>& framework,
-                        master->frameworks.completed) {
-            // Skip unauthorized frameworks or frameworks without matching
-            // framework ID.
-            if (!selectFrameworkId.accept(framework->id()) ||
-                !authorizeFrameworkInfo->accept(framework->info)) {
-             continue;
+              frameworks.push_back(framework.get());
             }
 
-            frameworks.push_back(framework.get());
-          }
+            // Construct task list with both running,
+            // completed and unreachable tasks.
+            vector<const Task*> tasks;
+            foreach (const Framework* framework, frameworks) {
+              foreachvalue (Task* task, framework->tasks) {
+                CHECK_NOTNULL(task);
+                // Skip unauthorized tasks or tasks without matching task ID.
+                if (!selectTaskId.accept(task->task_id()) ||
+                    !authorizeTask->accept(*task, framework->info)) {
+                  continue;
+                }
 
-          // Construct task list with both running,
-          // completed and unreachable tasks.
-          vector<const Task*> tasks;
-          foreach (const Framework* framework, frameworks) {
-            foreachvalue (Task* task, framework->tasks) {
-              CHECK_NOTNULL(task);
-              // Skip unauthorized tasks or tasks without matching task ID.
-              if (!selectTaskId.accept(task->task_id()) ||
-                  !authorizeTask->accept(*task, framework->info)) {
-                continue;
+                tasks.push_back(task);
               }
 
-              tasks.push_back(task);
-            }
+              foreachvalue (
+                  const Owned<Task>& task,
+                  framework->unreachableTasks) {
+                // Skip unauthorized tasks or tasks without matching task ID.
+                if (!selectTaskId.accept(task.get()->task_id()) ||
+                    !authorizeTask->accept(*task.get(), framework->info)) {
+                  continue;
+                }
 
-            foreachvalue (
-                const Owned<Task>& task,
-                framework->unreachableTasks) {
-              // Skip unauthorized tasks or tasks without matching task ID.
-              if (!selectTaskId.accept(task.get()->task_id()) ||
-                  !authorizeTask->accept(*task.get(), framework->info)) {
-                continue;
+                tasks.push_back(task.get());
               }
 
-              tasks.push_back(task.get());
-            }
+              foreach (const Owned<Task>& task, framework->completedTasks) {
+                // Skip unauthorized tasks or tasks without matching task ID.
+                if (!selectTaskId.accept(task.get()->task_id()) ||
+                    !authorizeTask->accept(*task.get(), framework->info)) {
+                  continue;
+                }
 
-            foreach (const Owned<Task>& task, framework->completedTasks) {
-              // Skip unauthorized tasks or tasks without matching task ID.
-              if (!selectTaskId.accept(task.get()->task_id()) ||
-                  !authorizeTask->accept(*task.get(), framework->info)) {
-                continue;
+                tasks.push_back(task.get());
               }
-
-              tasks.push_back(task.get());
             }
-          }
 
-          // Sort tasks by task status timestamp. Default order is descending.
-          // The earliest timestamp is chosen for comparison when
-          // multiple are present.
-          if (_order == "asc") {
-            sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-          } else {
-            sort(tasks.begin(), tasks.end(), TaskComparator::descending);
-          }
+            // Sort tasks by task status timestamp. Default order is descending.
+            // The earliest timestamp is chosen for comparison when
+            // multiple are present.
+            if (_order == "asc") {
+              sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
+            } else {
+              sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+            }
 
-          auto tasksWriter =
-            [&tasks, limit, offset](JSON::ObjectWriter* writer) {
-            writer->field("tasks",
-                          [&tasks, limit, offset](JSON::ArrayWriter* writer) {
-              // Collect 'limit' number of tasks starting from 'offset'.
-              size_t end = std::min(offset + limit, tasks.size());
-              for (size_t i = offset; i < end; i++) {
-                writer->element(*tasks[i]);
-              }
-            });
-          };
+            auto tasksWriter =
+              [&tasks, limit, offset](JSON::ObjectWriter* writer) {
+              writer->field("tasks",
+                            [&tasks, limit, offset](JSON::ArrayWriter* writer) {
+                // Collect 'limit' number of tasks starting from 'offset'.
+                size_t end = std::min(offset + limit, tasks.size());
+                for (size_t i = offset; i < end; i++) {
+                  writer->element(*tasks[i]);
+                }
+              });
+            };
 
-          return OK(jsonify(tasksWriter), request.url.query.get("jsonp"));
+            response->set(OK(jsonify(tasksWriter), jsonp));
+          });
   }));
 }
 
@@ -393,7 +393,7 @@ int main(int argc, char** argv)
           flags.log_auto_initialize,
           "registrar/");
     }
-    storage = new LogStorage(log);
+    storage = new LogStorage(log, 0, flags.registry_store_deltas);
 #endif // __WINDOWS__
   } else {
     EXIT(EXIT_FAILURE)
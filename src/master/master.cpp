@@ -106,6 +106,7 @@ using std::vector;
 using process::await;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
+using process::DispatchEvent;
 using process::ExitedEvent;
 using process::Failure;
 using process::Future;
@@ -304,6 +305,7 @@ Master::Master(
   : ProcessBase("master"),
     flags(_flags),
     http(this),
+    generation(0),
     allocator(_allocator),
     registrar(_registrar),
     files(_files),
@@ -311,6 +313,7 @@ Master::Master(
     detector(_detector),
     authorizer(_authorizer),
     frameworks(flags),
+    subscribers(this),
     authenticator(None()),
     metrics(new Metrics(*this)),
     electedTime(None())
@@ -440,6 +443,54 @@ void Framework::untrackUnderRole(const string& role)
 }
 
 
+Owned<Framework> Framework::copy(
+    vector<Owned<Task>>* _tasks,
+    vector<Owned<Offer>>* _offers) const
+{
+  Owned<Framework> framework(new Framework(*this));
+
+  foreachpair (const TaskID& taskId, Task* task, tasks) {
+    _tasks->push_back(Owned<Task>(new Task(*task)));
+    framework->tasks[taskId] = _tasks->back().get();
+  }
+
+  // NOTE: The completed tasks are shared with the copy as they don't
+  // change anymore, unlike the unreachable ones.
+  foreach (const TaskID& taskId, unreachableTasks.keys()) {
+    framework->unreachableTasks.set(
+        taskId, Owned<Task>(new Task(*unreachableTasks.at(taskId))));
+  }
+
+  foreach (Offer* offer, offers) {
+    _offers->push_back(Owned<Offer>(new Offer(*offer)));
+    framework->offers.insert(_offers->back().get());
+  }
+
+  return framework;
+}
+
+
+Framework::Framework(const Framework& that)
+  : master(that.master),
+    info(that.info),
+    roles(that.roles),
+    capabilities(that.capabilities),
+    pid(that.pid),
+    state(that.state),
+    registeredTime(that.registeredTime),
+    reregisteredTime(that.reregisteredTime),
+    unregisteredTime(that.unregisteredTime),
+    pendingTasks(that.pendingTasks),
+    tasks(that.tasks),
+    completedTasks(that.completedTasks),
+    unreachableTasks(that.unreachableTasks),
+    executors(that.executors),
+    totalUsedResources(that.totalUsedResources),
+    usedResources(that.usedResources),
+    totalOfferedResources(that.totalOfferedResources),
+    offeredResources(that.offeredResources) {}
+
+
 void Master::initialize()
 {
   LOG(INFO) << "Master " << info_.id() << " (" << info_.hostname() << ")"
@@ -765,6 +816,10 @@ void Master::initialize()
       << " for --offer_timeout: Must be greater than zero";
   }
 
+  mesos::allocator::Options options;
+  options.allocationParallelism = flags.allocation_parallelism;
+  options.incrementalAllocation = flags.incremental_allocation;
+
   // Initialize the allocator.
   allocator->initialize(
       flags.allocation_interval,
@@ -772,7 +827,8 @@ void Master::initialize()
       defer(self(), &Master::inverseOffer, lambda::_1, lambda::_2),
       flags.fair_sharing_excluded_resource_names,
       flags.filter_gpu_resources,
-      flags.domain);
+      flags.domain,
+      options);
 
   // Parse the whitelist. Passing Allocator::updateWhitelist()
   // callback is safe because we shut down the whitelistWatcher in
@@ -918,6 +974,9 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
+
+          // NOTE: Only the calls which might change the state are
+          // `modified`, see `Http::api`.
           return http.api(request, principal);
         });
   route("/api/v1/scheduler",
@@ -926,7 +985,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.scheduler(request, principal);
+          return modified(http.scheduler(request, principal));
         });
   route("/create-volumes",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -934,7 +993,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.createVolumes(request, principal);
+          return modified(http.createVolumes(request, principal));
         });
   route("/destroy-volumes",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -942,7 +1001,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.destroyVolumes(request, principal);
+          return modified(http.destroyVolumes(request, principal));
         });
   route("/frameworks",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -976,7 +1035,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.reserve(request, principal);
+          return modified(http.reserve(request, principal));
         });
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle on 0.26.
@@ -1002,7 +1061,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.teardown(request, principal);
+          return modified(http.teardown(request, principal));
         });
   route("/slaves",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -1062,7 +1121,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.maintenanceSchedule(request, principal);
+          return modified(http.maintenanceSchedule(request, principal));
         });
   route("/maintenance/status",
         READONLY_HTTP_AUTHENTICATION_REALM,
@@ -1078,7 +1137,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.machineDown(request, principal);
+          return modified(http.machineDown(request, principal));
         });
   route("/machine/up",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -1086,7 +1145,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.machineUp(request, principal);
+          return modified(http.machineUp(request, principal));
         });
   route("/unreserve",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -1094,7 +1153,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.unreserve(request, principal);
+          return modified(http.unreserve(request, principal));
         });
   route("/quota",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -1102,7 +1161,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.quota(request, principal);
+          return modified(http.quota(request, principal));
         });
   route("/weights",
         READWRITE_HTTP_AUTHENTICATION_REALM,
@@ -1110,7 +1169,7 @@ void Master::initialize()
         [this](const process::http::Request& request,
                const Option<Principal>& principal) {
           logRequest(request);
-          return http.weights(request, principal);
+          return modified(http.weights(request, principal));
         });
 
   // Provide HTTP assets from a "webui" directory. This is either
@@ -1479,6 +1538,8 @@ Future<bool> Master::authorizeLogAccess(const Option<Principal>& principal)
 
 void Master::visit(const MessageEvent& event)
 {
+  generation++;
+
   // There are three cases about the message's UPID with respect to
   // 'frameworks.principals':
   // 1) if a <UPID, principal> pair exists and the principal is Some,
@@ -1580,8 +1641,45 @@ void Master::visit(const MessageEvent& event)
 }
 
 
+void Master::visit(const DispatchEvent& event)
+{
+  // NOTE: The metrics gauges read the master's state via dispatches of
+  // its `double _x()` and `double _x(const string&)` methods, which we
+  // ignore so that polling the metrics doesn't invalidate the cached
+  // responses to the read-only endpoints.
+  typedef double(Self::*Gauge)();
+  typedef double(Self::*ResourceGauge)(const string&);
+
+  if (event.functionType.isSome() &&
+      *event.functionType.get() != typeid(Gauge) &&
+      *event.functionType.get() != typeid(ResourceGauge)) {
+    generation++;
+  }
+
+  ProcessBase::visit(event);
+}
+
+
+Future<process::http::Response> Master::modified(
+    const Future<process::http::Response>& response)
+{
+  generation++;
+
+  // The state might also be changed by the continuations of the
+  // request (e.g., once an operation has been applied by the
+  // registrar), which are done by the time the response is.
+  response.onAny(defer(
+      self(),
+      [this](const Future<process::http::Response>&) { generation++; }));
+
+  return response;
+}
+
+
 void Master::visit(const ExitedEvent& event)
 {
+  generation++;
+
   // See comments in 'visit(const MessageEvent& event)' for which
   // RateLimiter is used to throttle this UPID and when it is not
   // throttled.
@@ -2041,6 +2139,8 @@ void Master::_markUnreachableAfterFailover(
     const TimeInfo& unreachableTime,
     const Future<bool>& registrarResult)
 {
+  generation++;
+
   CHECK(slaves.markingUnreachable.contains(slaveInfo.id()));
   slaves.markingUnreachable.erase(slaveInfo.id());
 
@@ -3234,6 +3334,8 @@ void Master::deactivateFramework(
 
 void Master::disconnect(Framework* framework)
 {
+  generation++;
+
   CHECK_NOTNULL(framework);
   CHECK(framework->connected());
 
@@ -3261,6 +3363,8 @@ void Master::disconnect(Framework* framework)
 
 void Master::deactivate(Framework* framework, bool rescind)
 {
+  generation++;
+
   CHECK_NOTNULL(framework);
   CHECK(framework->active());
 
@@ -3299,6 +3403,8 @@ void Master::deactivate(Framework* framework, bool rescind)
 
 void Master::disconnect(Slave* slave)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
 
   LOG(INFO) << "Disconnecting agent " << *slave;
@@ -3318,6 +3424,8 @@ void Master::disconnect(Slave* slave)
 
 void Master::deactivate(Slave* slave)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
 
   LOG(INFO) << "Deactivating agent " << *slave;
@@ -4310,6 +4418,8 @@ void Master::_accept(
     const scheduler::Call::Accept& accept,
     const Future<list<Future<bool>>>& _authorizations)
 {
+  generation++;
+
   Framework* framework = getFramework(frameworkId);
 
   // TODO(jieyu): Consider using the 'drop' overload mentioned in
@@ -6107,6 +6217,8 @@ void Master::_reregisterSlave(
     const vector<SlaveInfo::Capability>& agentCapabilities,
     const Future<bool>& authorized)
 {
+  generation++;
+
   CHECK(!authorized.isDiscarded());
   CHECK(slaves.reregistering.contains(slaveInfo.id()));
 
@@ -6678,6 +6790,8 @@ void Master::updateFramework(
     const FrameworkInfo& frameworkInfo,
     const set<string>& suppressedRoles)
 {
+  generation++;
+
   LOG(INFO) << "Updating info for framework " << framework->id();
 
   // NOTE: The allocator takes care of activating/deactivating
@@ -6706,6 +6820,8 @@ void Master::updateFramework(
 
 void Master::updateSlave(const UpdateSlaveMessage& message)
 {
+  generation++;
+
   ++metrics->messages_update_slave;
 
   const SlaveID& slaveId = message.slave_id();
@@ -6796,6 +6912,8 @@ void Master::updateUnavailability(
     const MachineID& machineId,
     const Option<Unavailability>& unavailability)
 {
+  generation++;
+
   if (unavailability.isSome()) {
     machines[machineId].info.mutable_unavailability()->CopyFrom(
         unavailability.get());
@@ -7155,6 +7273,8 @@ void Master::_markUnreachable(
     const string& message,
     const Future<bool>& registrarResult)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
   CHECK(slaves.markingUnreachable.contains(slave->info.id()));
   slaves.markingUnreachable.erase(slave->info.id());
@@ -7566,6 +7686,8 @@ void Master::offer(
     const FrameworkID& frameworkId,
     const hashmap<string, hashmap<SlaveID, Resources>>& resources)
 {
+  generation++;
+
   if (!frameworks.registered.contains(frameworkId) ||
       !frameworks.registered[frameworkId]->active()) {
     LOG(WARNING) << "Master returning resources offered to framework "
@@ -8108,6 +8230,8 @@ void Master::addFramework(
     Framework* framework,
     const set<string>& suppressedRoles)
 {
+  generation++;
+
   CHECK_NOTNULL(framework);
 
   CHECK(!frameworks.registered.contains(framework->id()))
@@ -8166,6 +8290,8 @@ void Master::recoverFramework(
     const FrameworkInfo& info,
     const set<string>& suppressedRoles)
 {
+  generation++;
+
   CHECK(!frameworks.registered.contains(info.id()));
 
   Framework* framework = new Framework(this, flags, info);
@@ -8197,6 +8323,8 @@ Try<Nothing> Master::activateRecoveredFramework(
     const Option<HttpConnection>& http,
     const set<string>& suppressedRoles)
 {
+  generation++;
+
   // Exactly one of `pid` or `http` must be provided.
   CHECK(pid.isSome() != http.isSome());
 
@@ -8359,6 +8487,8 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
 
 void Master::_failoverFramework(Framework* framework)
 {
+  generation++;
+
   // Remove the framework's offers (if they weren't removed before).
   foreach (Offer* offer, utils::copy(framework->offers)) {
     allocator->recoverResources(
@@ -8413,6 +8543,8 @@ void Master::teardown(Framework* framework)
 
 void Master::removeFramework(Framework* framework)
 {
+  generation++;
+
   CHECK_NOTNULL(framework);
 
   LOG(INFO) << "Removing framework " << *framework;
@@ -8581,6 +8713,8 @@ void Master::removeFramework(Framework* framework)
 
 void Master::removeFramework(Slave* slave, Framework* framework)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
   CHECK_NOTNULL(framework);
 
@@ -8632,6 +8766,8 @@ void Master::addSlave(
     Slave* slave,
     const vector<Archive::Framework>& completedFrameworks)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
   CHECK(!slaves.registered.contains(slave->id));
   CHECK(!slaves.unreachable.contains(slave->id));
@@ -8753,6 +8889,8 @@ void Master::removeSlave(
     const string& message,
     Option<Counter> reason)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
 
   // It would be better to remove the slave here instead of continuing
@@ -8798,6 +8936,8 @@ void Master::_removeSlave(
     const string& removalCause,
     Option<Counter> reason)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
   CHECK(slaves.removing.contains(slave->info.id()));
   slaves.removing.erase(slave->info.id());
@@ -8922,6 +9062,8 @@ void Master::_removeSlave(
 
 void Master::updateTask(Task* task, const StatusUpdate& update)
 {
+  generation++;
+
   CHECK_NOTNULL(task);
 
   // Get the unacknowledged status.
@@ -9063,6 +9205,8 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
 void Master::removeTask(Task* task)
 {
+  generation++;
+
   CHECK_NOTNULL(task);
 
   // The slave owns the Task object and cannot be nullptr.
@@ -9108,6 +9252,8 @@ void Master::removeExecutor(
     const FrameworkID& frameworkId,
     const ExecutorID& executorId)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
   CHECK(slave->hasExecutor(frameworkId, executorId));
 
@@ -9140,6 +9286,8 @@ Future<Nothing> Master::apply(Slave* slave, const Offer::Operation& operation)
 
 void Master::_apply(Slave* slave, const Offer::Operation& operation)
 {
+  generation++;
+
   CHECK_NOTNULL(slave);
 
   slave->apply(operation);
@@ -9191,6 +9339,8 @@ void Master::offerTimeout(const OfferID& offerId)
 // 'useOffer()', 'discardOffer()' and 'rescindOffer()' for clarity.
 void Master::removeOffer(Offer* offer, bool rescind)
 {
+  generation++;
+
   // Remove from framework.
   Framework* framework = getFramework(offer->framework_id());
   CHECK(framework != nullptr)
@@ -9247,6 +9397,8 @@ void Master::inverseOfferTimeout(const OfferID& inverseOfferId)
 
 void Master::removeInverseOffer(InverseOffer* inverseOffer, bool rescind)
 {
+  generation++;
+
   // Remove from framework.
   Framework* framework = getFramework(inverseOffer->framework_id());
   CHECK(framework != nullptr)
@@ -9651,37 +9803,63 @@ void Master::Subscribers::send(const mesos::master::Event& event)
   VLOG(1) << "Notifying all active subscribers about " << event.type()
           << " event";
 
-  foreachvalue (const Owned<Subscriber>& subscriber, subscribed) {
+  // The subscribers with the same principal are authorized the same
+  // way, hence we authorize the event, evolve it and encode it (once
+  // per content type) only once for all of them, rather than once for
+  // each subscriber.
+  vector<Option<Principal>> principals;
+  vector<vector<UUID>> streams;
+
+  foreachpair (const UUID& id,
+               const Owned<Subscriber>& subscriber,
+               subscribed) {
+    size_t i = 0;
+    while (i < principals.size() && !(principals[i] == subscriber->principal)) {
+      i++;
+    }
+
+    if (i == principals.size()) {
+      principals.push_back(subscriber->principal);
+      streams.push_back(vector<UUID>());
+    }
+
+    streams[i].push_back(id);
+  }
+
+  for (size_t i = 0; i < principals.size(); i++) {
     Future<Owned<AuthorizationAcceptor>> authorizeRole =
       AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
+          principals[i],
+          master->authorizer,
           authorization::VIEW_ROLE);
 
     Future<Owned<AuthorizationAcceptor>> authorizeFramework =
       AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
+          principals[i],
+          master->authorizer,
           authorization::VIEW_FRAMEWORK);
 
     Future<Owned<AuthorizationAcceptor>> authorizeTask =
       AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
+          principals[i],
+          master->authorizer,
           authorization::VIEW_TASK);
 
     Future<Owned<AuthorizationAcceptor>> authorizeExecutor =
       AuthorizationAcceptor::create(
-          subscriber->principal,
-          subscriber->master->authorizer,
+          principals[i],
+          master->authorizer,
           authorization::VIEW_EXECUTOR);
 
+    const vector<UUID>& ids = streams[i];
+
     collect(authorizeRole, authorizeFramework, authorizeTask, authorizeExecutor)
-      .then(defer(subscriber->master->self(),
-          [=](const tuple<Owned<AuthorizationAcceptor>,
-                          Owned<AuthorizationAcceptor>,
-                          Owned<AuthorizationAcceptor>,
-                          Owned<AuthorizationAcceptor>>& acceptors) {
+      .then(defer(master->self(),
+          [this, event, ids](const tuple<Owned<AuthorizationAcceptor>,
+                                         Owned<AuthorizationAcceptor>,
+                                         Owned<AuthorizationAcceptor>,
+                                         Owned<AuthorizationAcceptor>>&
+                               acceptors) {
         Owned<AuthorizationAcceptor> authorizeRole;
         Owned<AuthorizationAcceptor> authorizeFramework;
         Owned<AuthorizationAcceptor> authorizeTask;
@@ -9692,24 +9870,53 @@ void Master::Subscribers::send(const mesos::master::Event& event)
             authorizeTask,
             authorizeExecutor) = acceptors;
 
-        subscriber->send(event,
+        Option<mesos::master::Event> authorized = authorize(
+            event,
             authorizeRole,
             authorizeFramework,
             authorizeTask,
             authorizeExecutor);
 
+        if (authorized.isNone()) {
+          return Nothing();
+        }
+
+        const v1::master::Event evolved = evolve(authorized.get());
+
+        // The records sent to the subscribers, keyed by content type.
+        std::map<ContentType, string> records;
+
+        foreach (const UUID& id, ids) {
+          // Skip the subscribers which disconnected in the meantime.
+          Option<Owned<Subscriber>> subscriber = subscribed.get(id);
+          if (subscriber.isNone()) {
+            continue;
+          }
+
+          const ContentType contentType = subscriber.get()->http.contentType;
+
+          if (records.count(contentType) == 0) {
+            ::recordio::Encoder<v1::master::Event> encoder(lambda::bind(
+                serialize, contentType, lambda::_1));
+
+            records[contentType] = encoder.encode(evolved);
+          }
+
+          subscriber.get()->http.write(records.at(contentType));
+        }
+
         return Nothing();
       }));
   }
 }
 
 
-void Master::Subscribers::Subscriber::send(
+Option<mesos::master::Event> Master::Subscribers::authorize(
     const mesos::master::Event& event,
     const Owned<AuthorizationAcceptor>& authorizeRole,
     const Owned<AuthorizationAcceptor>& authorizeFramework,
     const Owned<AuthorizationAcceptor>& authorizeTask,
-    const Owned<AuthorizationAcceptor>& authorizeExecutor)
+    const Owned<AuthorizationAcceptor>& authorizeExecutor) const
 {
   switch (event.type()) {
     case mesos::master::Event::TASK_ADDED: {
@@ -9722,7 +9929,7 @@ void Master::Subscribers::Subscriber::send(
 
       if (authorizeTask->accept(event.task_added().task(), framework->info) &&
           authorizeFramework->accept(framework->info)) {
-        http.send<mesos::master::Event, v1::master::Event>(event);
+        return event;
       }
       break;
     }
@@ -9743,7 +9950,7 @@ void Master::Subscribers::Subscriber::send(
 
       if (authorizeTask->accept(*task, framework->info) &&
           authorizeFramework->accept(framework->info)) {
-        http.send<mesos::master::Event, v1::master::Event>(event);
+        return event;
       }
       break;
     }
@@ -9774,7 +9981,7 @@ void Master::Subscribers::Subscriber::send(
           }
         }
 
-        http.send<mesos::master::Event, v1::master::Event>(event_);
+        return event_;
       }
       break;
     }
@@ -9805,14 +10012,14 @@ void Master::Subscribers::Subscriber::send(
           }
         }
 
-        http.send<mesos::master::Event, v1::master::Event>(event_);
+        return event_;
       }
       break;
     }
     case mesos::master::Event::FRAMEWORK_REMOVED: {
       if (authorizeFramework->accept(
               event.framework_removed().framework_info())) {
-        http.send<mesos::master::Event, v1::master::Event>(event);
+        return event;
       }
       break;
     }
@@ -9830,13 +10037,13 @@ void Master::Subscribers::Subscriber::send(
         }
       }
 
-      http.send<mesos::master::Event, v1::master::Event>(event_);
-      break;
+      return event_;
     }
     default:
-      http.send<mesos::master::Event, v1::master::Event>(event);
-      break;
+      return event;
   }
+
+  return None();
 }
 
 
@@ -9935,6 +10142,33 @@ Slave::~Slave()
 }
 
 
+Owned<Slave> Slave::copy() const
+{
+  return Owned<Slave>(new Slave(*this));
+}
+
+
+Slave::Slave(const Slave& that)
+  : master(that.master),
+    id(that.id),
+    info(that.info),
+    machineId(that.machineId),
+    pid(that.pid),
+    version(that.version),
+    capabilities(that.capabilities),
+    registeredTime(that.registeredTime),
+    reregisteredTime(that.reregisteredTime),
+    connected(that.connected),
+    active(that.active),
+    executors(that.executors),
+    pendingTasks(that.pendingTasks),
+    usedResources(that.usedResources),
+    offeredResources(that.offeredResources),
+    checkpointedResources(that.checkpointedResources),
+    totalResources(that.totalResources),
+    observer(nullptr) {}
+
+
 Task* Slave::getTask(const FrameworkID& frameworkId, const TaskID& taskId) const
 {
   if (tasks.contains(frameworkId) && tasks.at(frameworkId).contains(taskId)) {
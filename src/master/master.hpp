@@ -49,15 +49,18 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
+#include <process/shared.hpp>
 #include <process/timer.hpp>
 
 #include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
 
 #include <stout/boundedhashmap.hpp>
 #include <stout/cache.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
 #include <stout/linkedhashmap.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/nothing.hpp>
@@ -255,8 +258,18 @@ struct Slave
 
   SlaveObserver* observer;
 
+  // Returns a copy of this agent which can be read while the master
+  // keeps modifying this agent, e.g., to serve the read-only endpoints
+  // (see `Master::Http::processRequestsBatch`). The copy includes
+  // neither the tasks nor the offers of this agent (which the read-only
+  // endpoints read through the frameworks instead), nor its timer and
+  // observer.
+  process::Owned<Slave> copy() const;
+
 private:
-  Slave(const Slave&);              // No copying.
+  // Only used by `copy()`.
+  Slave(const Slave& that);
+
   Slave& operator=(const Slave&); // No assigning.
 };
 
@@ -290,6 +303,14 @@ struct HttpConnection
     return writer.write(encoder.encode(evolve(message)));
   }
 
+  // Sends an event that has already been evolved and encoded into a
+  // RecordIO record for this connection's content type, e.g., once
+  // for all of the connections that are sent the same event.
+  bool write(const std::string& record)
+  {
+    return writer.write(record);
+  }
+
   bool close()
   {
     return writer.close();
@@ -532,8 +553,15 @@ protected:
   virtual void finalize();
 
   virtual void visit(const process::MessageEvent& event);
+  virtual void visit(const process::DispatchEvent& event);
   virtual void visit(const process::ExitedEvent& event);
 
+  // Returns the response to a request that might have changed the
+  // state of the master, after making sure that the cached responses
+  // to the read-only endpoints get invalidated (see `generation`).
+  process::Future<process::http::Response> modified(
+      const process::Future<process::http::Response>& response);
+
   virtual void exited(const process::UPID& pid);
   void exited(const FrameworkID& frameworkId, const HttpConnection& http);
   void _exited(Framework* framework);
@@ -1250,9 +1278,13 @@ private:
   class Http
   {
   public:
-    explicit Http(Master* _master) : master(_master),
-                                     quotaHandler(_master),
-                                     weightsHandler(_master) {}
+    explicit Http(Master* _master)
+      : master(_master),
+        quotaHandler(_master),
+        weightsHandler(_master),
+        servingBatch(false),
+        snapshots(0),
+        cachedResponses(MAX_CACHED_HTTP_RESPONSES) {}
 
     // /api/v1
     process::Future<process::http::Response> api(
@@ -1260,6 +1292,12 @@ private:
         const Option<process::http::authentication::Principal>&
             principal) const;
 
+    // Serves a parsed and validated call to /api/v1.
+    process::Future<process::http::Response> _api(
+        const mesos::master::Call& call,
+        const Option<process::http::authentication::Principal>& principal,
+        ContentType acceptType) const;
+
     // /api/v1/scheduler
     process::Future<process::http::Response> scheduler(
         const process::http::Request& request,
@@ -1660,6 +1698,74 @@ private:
         const Option<process::http::authentication::Principal>& principal,
         ContentType contentType) const;
 
+    // A copy of the parts of the master's state which the read-only
+    // endpoints read, see `processRequestsBatch`.
+    struct Snapshot;
+
+    // The collections of the master's state which a read-only handler
+    // reads. The snapshot of a batch only copies the collections which
+    // its handlers read.
+    enum SnapshotCollections
+    {
+      FRAMEWORKS = 1 << 0,
+      SLAVES = 1 << 1
+    };
+
+    // Produces the response to a read-only request from a snapshot of
+    // the master's state. Note that the promise might be satisfied
+    // before the handler is done reading the snapshot (e.g., when the
+    // response gets streamed) or after the handler returns (e.g., when
+    // the response gets cached).
+    typedef lambda::function<void(
+        const process::Shared<Snapshot>&,
+        process::Promise<process::http::Response>*)> ReadOnlyHandler;
+
+    // A read-only request (e.g., to '/state') whose response gets
+    // produced along with the responses to the other read-only
+    // requests received in the meantime, see `processRequestsBatch`.
+    struct BatchedRequest
+    {
+      // The `SnapshotCollections` which the handler reads.
+      int collections;
+
+      ReadOnlyHandler handler;
+
+      process::Owned<process::Promise<process::http::Response>> promise;
+    };
+
+    // Queues a read-only request to be served by the next batch.
+    process::Future<process::http::Response> batch(
+        int collections,
+        const ReadOnlyHandler& handler) const;
+
+    // Serves all of the batched read-only requests in parallel, on
+    // other worker threads, from a snapshot of the master's state,
+    // unless the batch has to wait (see `processRequestsBatch`).
+    void processRequestsBatch() const;
+
+    // A response to a read-only request along with the generation of
+    // the master's state it was produced from.
+    struct CachedResponse
+    {
+      uint64_t generation;
+      process::http::Response response;
+    };
+
+    // Like `batch`, but if `--cache_http_readonly_responses` is set
+    // the response gets cached (keyed by the path and query of the
+    // request and by the principal) until the master's state changes,
+    // and gets tagged with an `ETag` so that clients can revalidate
+    // it using `If-None-Match`.
+    process::Future<process::http::Response> cached(
+        const process::http::Request& request,
+        const Option<process::http::authentication::Principal>& principal,
+        int collections,
+        const ReadOnlyHandler& handler) const;
+
+    // Returns the `ETag` of the response for the specified cache key
+    // as of the specified generation of the master's state.
+    std::string etag(const std::string& key, uint64_t generation) const;
+
     Master* master;
 
     // NOTE: The quota specific pieces of the Operator API are factored
@@ -1669,6 +1775,21 @@ private:
     // NOTE: The weights specific pieces of the Operator API are factored
     // out into this separate class.
     WeightsHandler weightsHandler;
+
+    // The read-only requests to be served by the next batch.
+    mutable std::vector<BatchedRequest> batchedRequests;
+
+    // Whether the handlers of a batch are still running, in which case
+    // the next batch waits for them.
+    mutable bool servingBatch;
+
+    // The number of snapshots which are still read, e.g., by responses
+    // being streamed from them. The next batch waits while there are
+    // `MAX_READONLY_SNAPSHOTS` of them.
+    mutable size_t snapshots;
+
+    // The cached responses to read-only requests, see `cached`.
+    mutable Cache<std::string, CachedResponse> cachedResponses;
   };
 
   Master(const Master&);              // No copying.
@@ -1695,6 +1816,21 @@ private:
 
   Http http;
 
+  // The generation of the master's state, which gets bumped whenever
+  // the state might have changed, i.e., upon every message, exited
+  // event and dispatch of a method (other than of a metrics gauge),
+  // upon every request to an endpoint that might change the state
+  // (see `modified`), as well as by every helper which adds, removes
+  // or updates frameworks, agents, tasks, executors or offers. A
+  // cached response to a read-only endpoint is only valid for the
+  // generation it was produced from.
+  //
+  // NOTE: Dispatches of lambdas don't bump the generation since
+  // libprocess serves every HTTP request (including read-only ones)
+  // through some of those. The state they change is covered by the
+  // helpers they call.
+  uint64_t generation;
+
   Option<MasterInfo> leader; // Current leading master.
 
   mesos::allocator::Allocator* allocator;
@@ -1892,6 +2028,8 @@ private:
 
   struct Subscribers
   {
+    explicit Subscribers(Master* _master) : master(_master) {}
+
     // Represents a client subscribed to the 'api/vX' endpoint.
     //
     // TODO(anand): Add support for filtering. Some subscribers
@@ -1904,8 +2042,14 @@ private:
           const Option<process::http::authentication::Principal> _principal)
         : master(_master),
           http(_http),
-          principal(_principal)
+          principal(_principal),
+          lag("master/subscribers/" + stringify(_http.streamId) + "/lag_bytes",
+              [_http]() -> process::Future<double> {
+                return _http.writer.buffered();
+              })
       {
+        process::metrics::add(lag);
+
         mesos::master::Event event;
         event.set_type(mesos::master::Event::HEARTBEAT);
 
@@ -1925,12 +2069,6 @@ private:
       Subscriber(const Subscriber&) = delete;
       Subscriber& operator=(const Subscriber&) = delete;
 
-      void send(const mesos::master::Event& event,
-          const process::Owned<AuthorizationAcceptor>& authorizeRole,
-          const process::Owned<AuthorizationAcceptor>& authorizeFramework,
-          const process::Owned<AuthorizationAcceptor>& authorizeTask,
-          const process::Owned<AuthorizationAcceptor>& authorizeExecutor);
-
       ~Subscriber()
       {
         // TODO(anand): Refactor `HttpConnection` to being a RAII class instead.
@@ -1941,6 +2079,8 @@ private:
 
         terminate(heartbeater.get());
         wait(heartbeater.get());
+
+        process::metrics::remove(lag);
       }
 
       Master* master;
@@ -1948,11 +2088,26 @@ private:
       process::Owned<Heartbeater<mesos::master::Event, v1::master::Event>>
         heartbeater;
       const Option<process::http::authentication::Principal> principal;
+
+      // The number of bytes of the events sent to the subscriber which
+      // haven't been read off of its connection yet.
+      process::metrics::Gauge lag;
     };
 
     // Sends the event to all subscribers connected to the 'api/vX' endpoint.
     void send(const mesos::master::Event& event);
 
+    // Returns the event as it may be seen by the subscribers authorized
+    // by the specified acceptors, or `None` if they may not see it.
+    Option<mesos::master::Event> authorize(
+        const mesos::master::Event& event,
+        const process::Owned<AuthorizationAcceptor>& authorizeRole,
+        const process::Owned<AuthorizationAcceptor>& authorizeFramework,
+        const process::Owned<AuthorizationAcceptor>& authorizeTask,
+        const process::Owned<AuthorizationAcceptor>& authorizeExecutor) const;
+
+    Master* master;
+
     // Active subscribers to the 'api/vX' endpoint keyed by the stream
     // identifier.
     hashmap<UUID, process::Owned<Subscriber>> subscribed;
@@ -2085,6 +2240,12 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual bool describe(Registry::Delta* delta) const
+  {
+    delta->add_slaves()->mutable_info()->CopyFrom(info);
+    return true;
+  }
+
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs)
   {
@@ -2117,6 +2278,17 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual bool describe(Registry::Delta* delta) const
+  {
+    delta->add_removed_slaves()->CopyFrom(info.id());
+
+    Registry::UnreachableSlave* unreachable = delta->add_unreachable();
+    unreachable->mutable_id()->CopyFrom(info.id());
+    unreachable->mutable_timestamp()->CopyFrom(unreachableTime);
+
+    return true;
+  }
+
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs)
   {
@@ -2167,6 +2339,13 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual bool describe(Registry::Delta* delta) const
+  {
+    delta->add_removed_unreachable()->CopyFrom(info.id());
+    delta->add_slaves()->mutable_info()->CopyFrom(info);
+    return true;
+  }
+
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs)
   {
@@ -2220,6 +2399,15 @@ public:
   explicit PruneUnreachable(const hashset<SlaveID>& _toRemove)
     : toRemove(_toRemove) {}
 
+  virtual bool describe(Registry::Delta* delta) const
+  {
+    foreach (const SlaveID& slaveId, toRemove) {
+      delta->add_removed_unreachable()->CopyFrom(slaveId);
+    }
+
+    return true;
+  }
+
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* /*slaveIDs*/)
   {
@@ -2240,7 +2428,7 @@ protected:
         Registry::UnreachableSlaves* unreachable =
           registry->mutable_unreachable();
 
-        unreachable->mutable_slaves()->DeleteSubrange(i, i+1);
+        unreachable->mutable_slaves()->DeleteSubrange(i, 1);
         mutate = true;
         continue;
       }
@@ -2265,6 +2453,12 @@ public:
     CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
   }
 
+  virtual bool describe(Registry::Delta* delta) const
+  {
+    delta->add_removed_slaves()->CopyFrom(info.id());
+    return true;
+  }
+
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs)
   {
@@ -2890,6 +3084,18 @@ struct Framework
   Option<process::Owned<Heartbeater<scheduler::Event, v1::scheduler::Event>>>
     heartbeater;
 
+  // Returns a copy of this framework which can be read while the
+  // master keeps modifying this framework, e.g., to serve the read-only
+  // endpoints (see `Master::Http::processRequestsBatch`). The running
+  // and unreachable tasks and the offers of the copy are copies as
+  // well, which get appended to `_tasks` and `_offers` so that the
+  // caller owns them. The copy is neither connected to the framework
+  // nor tracked under the framework's roles, and it doesn't include
+  // the inverse offers.
+  process::Owned<Framework> copy(
+      std::vector<process::Owned<Task>>* _tasks,
+      std::vector<process::Owned<Offer>>* _offers) const;
+
 private:
   Framework(Master* const _master,
             const Flags& masterFlags,
@@ -2916,7 +3122,9 @@ private:
     }
   }
 
-  Framework(const Framework&);              // No copying.
+  // Only used by `copy()`.
+  Framework(const Framework& that);
+
   Framework& operator=(const Framework&); // No assigning.
 };
 
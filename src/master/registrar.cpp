@@ -34,7 +34,10 @@
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
+#include <stout/linkedhashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -63,6 +66,7 @@ using process::Process;
 using process::Promise;
 using process::TLDR;
 
+using process::http::InternalServerError;
 using process::http::OK;
 
 using process::http::authentication::Principal;
@@ -92,6 +96,7 @@ public:
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
       state(_state),
+      compacted(0),
       updating(false),
       flags(_flags),
       authenticationRealm(_authenticationRealm) {}
@@ -134,6 +139,12 @@ private:
   public:
     explicit Recover(const MasterInfo& _info) : info(_info) {}
 
+    virtual bool describe(Registry::Delta* delta) const
+    {
+      delta->mutable_master()->mutable_info()->CopyFrom(info);
+      return true;
+    }
+
   protected:
     virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs)
     {
@@ -187,10 +198,13 @@ private:
     return operations.size();
   }
 
+  // NOTE: This is the size of the last stored registry, including
+  // the deltas appended to it since it was last compacted (see
+  // `--registry_store_deltas`).
   Future<double> _registry_size_bytes()
   {
-    if (registry.isSome()) {
-      return registry->ByteSize();
+    if (variable.isSome()) {
+      return variable->value().size();
     }
 
     return Failure("Not recovered yet");
@@ -207,7 +221,7 @@ private:
   void update();
   void _update(
       const Future<Option<Variable>>& store,
-      const Owned<Registry>& updatedRegistry,
+      size_t compacted,
       deque<Owned<Operation>> operations);
 
   // Fails all pending operations and transitions the Registrar
@@ -227,9 +241,20 @@ private:
   // Per the TODO above, we store both serialized and deserialized versions
   // of the `Registry` protobuf. If we're able to move to `protobuf::State`,
   // we could just store a single `protobuf::state::Variable<Registry>`.
+  // NOTE: While an update is in flight, 'registry' already reflects
+  // the operations being stored while 'variable' does not.
   Option<Variable> variable;
   Option<Registry> registry;
 
+  // The set of admitted agents, kept across updates for the
+  // operations to use as their 'slaveIDs' accumulator.
+  hashset<SlaveID> slaveIDs;
+
+  // Size of the stored registry when it was last compacted, i.e.,
+  // when the whole registry was last stored rather than appending
+  // the deltas of the operations to it.
+  size_t compacted;
+
   deque<Owned<Operation>> operations;
   bool updating; // Used to signify fetching (recovering) or storing.
 
@@ -262,6 +287,66 @@ Future<T> timeout(
 }
 
 
+// Helper for compacting a stored registry, i.e., applying (in order)
+// and clearing the deltas that have been appended to it.
+void compact(Registry* registry)
+{
+  if (registry->deltas().empty()) {
+    return;
+  }
+
+  // Index the agents by their IDs, preserving their order, so that
+  // each delta is applied in constant time rather than with a linear
+  // scan of the agents.
+  LinkedHashMap<SlaveID, const Registry::Slave*> slaves;
+  foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
+    slaves[slave.info().id()] = &slave;
+  }
+
+  LinkedHashMap<SlaveID, const Registry::UnreachableSlave*> unreachable;
+  foreach (const Registry::UnreachableSlave& slave,
+           registry->unreachable().slaves()) {
+    unreachable[slave.id()] = &slave;
+  }
+
+  foreach (const Registry::Delta& delta, registry->deltas()) {
+    if (delta.has_master()) {
+      registry->mutable_master()->CopyFrom(delta.master());
+    }
+
+    foreach (const SlaveID& slaveId, delta.removed_slaves()) {
+      slaves.erase(slaveId);
+    }
+
+    foreach (const SlaveID& slaveId, delta.removed_unreachable()) {
+      unreachable.erase(slaveId);
+    }
+
+    foreach (const Registry::Slave& slave, delta.slaves()) {
+      slaves[slave.info().id()] = &slave;
+    }
+
+    foreach (const Registry::UnreachableSlave& slave, delta.unreachable()) {
+      unreachable[slave.id()] = &slave;
+    }
+  }
+
+  Registry::Slaves admitted;
+  foreachvalue (const Registry::Slave* slave, slaves) {
+    admitted.add_slaves()->CopyFrom(*slave);
+  }
+
+  Registry::UnreachableSlaves unreached;
+  foreachvalue (const Registry::UnreachableSlave* slave, unreachable) {
+    unreached.add_slaves()->CopyFrom(*slave);
+  }
+
+  registry->mutable_slaves()->Swap(&admitted);
+  registry->mutable_unreachable()->Swap(&unreached);
+  registry->clear_deltas();
+}
+
+
 // Helper for failing a deque of operations.
 void fail(deque<Owned<Operation>>* operations, const string& message)
 {
@@ -278,8 +363,23 @@ Future<Response> RegistrarProcess::getRegistry(
 {
   JSON::Object result;
 
-  if (registry.isSome()) {
+  // The operations of an update are applied to 'registry' before it
+  // is stored, so while an update is in flight we serve the last
+  // stored registry instead.
+  if (variable.isSome() && !updating) {
     result = JSON::protobuf(registry.get());
+  } else if (variable.isSome()) {
+    Try<Registry> stored =
+      ::protobuf::deserialize<Registry>(variable->value());
+
+    if (stored.isError()) {
+      return InternalServerError(
+          "Failed to deserialize the registry: " + stored.error());
+    }
+
+    compact(&stored.get());
+
+    result = JSON::protobuf(stored.get());
   }
 
   return OK(result, request.url.query.get("jsonp"));
@@ -392,6 +492,19 @@ void RegistrarProcess::_recover(
             << " (" << Bytes(deserialized->ByteSize()) << ")"
             << " in " << elapsed;
 
+  // Apply the deltas that have been stored since the registry was
+  // last compacted. The registry is then compacted when storing the
+  // new MasterInfo below, since its size is not known until then.
+  if (!deserialized->deltas().empty()) {
+    LOG(INFO) << "Applying " << deserialized->deltas().size()
+              << " registry deltas";
+
+    compact(&deserialized.get());
+    compacted = 0;
+  } else {
+    compacted = recovery->value().size();
+  }
+
   // Save the registry.
   variable = recovery.get();
 
@@ -399,6 +512,11 @@ void RegistrarProcess::_recover(
   registry = Option<Registry>(Registry());
   registry->Swap(&deserialized.get());
 
+  slaveIDs.clear();
+  foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
+    slaveIDs.insert(slave.info().id());
+  }
+
   // Perform the Recover operation to add the new MasterInfo.
   Owned<Operation> operation(new Recover(info));
   operations.push_back(operation);
@@ -477,19 +595,22 @@ void RegistrarProcess::update()
 
   updating = true;
 
-  // Create a snapshot of the current registry. We use an `Owned` here
-  // to avoid copying, since protobuf doesn't suppport move construction.
-  auto updatedRegistry = Owned<Registry>(new Registry(registry.get()));
-
-  // Create the 'slaveIDs' accumulator.
-  hashset<SlaveID> slaveIDs;
-  foreach (const Registry::Slave& slave, updatedRegistry->slaves().slaves()) {
-    slaveIDs.insert(slave.info().id());
-  }
+  // The operations are applied to the registry directly rather than
+  // to a copy of it: if the registry can not be stored the registrar
+  // aborts, so the registry is never used after a failed update.
+  //
+  // The changes made by the operations are collected as deltas in
+  // an otherwise empty registry, which can be appended to the stored
+  // registry (see `Registry.deltas`).
+  Registry deltas;
+  bool described = flags.registry_store_deltas;
 
   foreach (Owned<Operation>& operation, operations) {
-    // No need to process the result of the operation.
-    (*operation)(updatedRegistry.get(), &slaveIDs);
+    Try<bool> mutation = (*operation)(&registry.get(), &slaveIDs);
+
+    if (described && mutation.isSome() && mutation.get()) {
+      described = operation->describe(deltas.add_deltas());
+    }
   }
 
   LOG(INFO) << "Applied " << operations.size() << " operations in "
@@ -498,16 +619,37 @@ void RegistrarProcess::update()
   // Perform the store, and time the operation.
   metrics.state_store.start();
 
-  // Serialize updated registry.
-  Try<string> serialized = ::protobuf::serialize(*updatedRegistry);
-  if (serialized.isError()) {
-    string message = "Failed to update registry: " + serialized.error();
-    fail(&operations, message);
-    abort(message);
-    return;
+  // Append the deltas to the stored registry until it has doubled in
+  // size since it was last compacted, so that the cost of storing the
+  // whole registry again is amortized over the preceding updates.
+  string value;
+  size_t _compacted = compacted;
+
+  if (described && variable->value().size() < 2 * compacted) {
+    Try<string> serialized = ::protobuf::serialize(deltas);
+    if (serialized.isError()) {
+      string message = "Failed to update registry: " + serialized.error();
+      fail(&operations, message);
+      abort(message);
+      return;
+    }
+
+    value = variable->value() + serialized.get();
+  } else {
+    // Serialize updated registry.
+    Try<string> serialized = ::protobuf::serialize(registry.get());
+    if (serialized.isError()) {
+      string message = "Failed to update registry: " + serialized.error();
+      fail(&operations, message);
+      abort(message);
+      return;
+    }
+
+    value = serialized.get();
+    _compacted = value.size();
   }
 
-  state->store(variable->mutate(serialized.get()))
+  state->store(variable->mutate(value))
     .after(flags.registry_store_timeout,
            lambda::bind(
                &timeout<Option<Variable>>,
@@ -515,7 +657,7 @@ void RegistrarProcess::update()
                flags.registry_store_timeout,
                lambda::_1))
     .onAny(defer(
-        self(), &Self::_update, lambda::_1, updatedRegistry, operations));
+        self(), &Self::_update, lambda::_1, _compacted, operations));
 
   // Clear the operations, _update will transition the Promises!
   operations.clear();
@@ -524,7 +666,7 @@ void RegistrarProcess::update()
 
 void RegistrarProcess::_update(
     const Future<Option<Variable>>& store,
-    const Owned<Registry>& updatedRegistry,
+    size_t _compacted,
     deque<Owned<Operation>> applied)
 {
   updating = false;
@@ -552,7 +694,7 @@ void RegistrarProcess::_update(
   LOG(INFO) << "Successfully updated the registry in " << elapsed;
 
   variable = store.get().get();
-  registry->Swap(updatedRegistry.get());
+  compacted = _compacted;
 
   // Remove the operations.
   while (!applied.empty()) {
@@ -66,6 +66,12 @@ public:
   // Sets the promise based on whether the operation was successful.
   bool set() { return process::Promise<bool>::set(success); }
 
+  // Describes the changes made to the registry by the operation in
+  // 'delta', after it has been invoked and mutated the registry.
+  // Returns false if the operation does not describe its changes, in
+  // which case the whole registry is stored.
+  virtual bool describe(Registry::Delta* delta) const { return false; }
+
 protected:
   virtual Try<bool> perform(Registry* registry, hashset<SlaveID>* slaveIDs) = 0;
 
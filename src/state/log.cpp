@@ -84,7 +84,7 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots, bool appends);
 
   virtual ~LogStorageProcess();
 
@@ -137,6 +137,9 @@ private:
 
   const size_t diffsBetweenSnapshots;
 
+  // Whether values which extend their snapshot are stored as APPENDs.
+  const bool appends;
+
   // Used to serialize Log::Writer::append/truncate operations.
   Mutex mutex;
 
@@ -183,6 +186,19 @@ private:
       return Snapshot(position, entry, diffs + 1);
     }
 
+    // Returns a snapshot after having applied the specified append.
+    Try<Snapshot> patch(const Operation::Append& append) const
+    {
+      if (append.entry().name() != entry.name()) {
+        return Error("Attempted to patch the wrong snapshot");
+      }
+
+      Entry entry(append.entry());
+      entry.set_value(this->entry.value() + append.entry().value());
+
+      return Snapshot(position, entry, diffs + 1);
+    }
+
     // Position in the log where this snapshot is located. NOTE: if
     // 'diffs' is greater than 0 this still represents the location of
     // the snapshot, not the last DIFF record in the log.
@@ -193,9 +209,10 @@ private:
     // data so we don't use too much memory.
     const Entry entry;
 
-    // This value represents the number of Operation::DIFFs in the
-    // underlying log that make up this "snapshot". If this snapshot
-    // is actually represented in the log this value is 0.
+    // This value represents the number of Operation::DIFFs (and
+    // Operation::APPENDs) in the underlying log that make up this
+    // "snapshot". If this snapshot is actually represented in the log
+    // this value is 0.
     const size_t diffs;
   };
 
@@ -222,11 +239,15 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    bool appends)
   : ProcessBase(process::ID::generate("log-storage")),
     reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    appends(appends) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -354,6 +375,25 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
           break;
         }
 
+        case Operation::APPEND: {
+          CHECK(operation.has_append());
+
+          Option<Snapshot> snapshot =
+            snapshots.get(operation.append().entry().name());
+
+          CHECK_SOME(snapshot);
+
+          Try<Snapshot> patched = snapshot.get().patch(operation.append());
+
+          if (patched.isError()) {
+            return Failure("Failed to apply the append: " + patched.error());
+          }
+
+          // Replace the snapshot with the patched snapshot.
+          snapshots.put(patched.get().entry.name(), patched.get());
+          break;
+        }
+
         case Operation::EXPUNGE: {
           CHECK(operation.has_expunge());
           snapshots.erase(operation.expunge().name());
@@ -490,6 +530,39 @@ Future<bool> LogStorageProcess::__set(
     return false;
   }
 
+  // Check if the new value only appends to the value of the snapshot
+  // (e.g., the registrar storing registry deltas), in which case we
+  // can write just the appended bytes without computing a diff. It
+  // is up to the user to eventually store a value which does not
+  // extend the snapshot, as the APPENDs are not bounded by
+  // 'diffsBetweenSnapshots'.
+  if (appends &&
+      snapshot.isSome() &&
+      entry.value().size() > snapshot.get().entry.value().size() &&
+      entry.value().compare(
+          0,
+          snapshot.get().entry.value().size(),
+          snapshot.get().entry.value()) == 0) {
+    Operation operation;
+    operation.set_type(Operation::APPEND);
+    operation.mutable_append()->mutable_entry()->set_name(entry.name());
+    operation.mutable_append()->mutable_entry()->set_uuid(entry.uuid());
+    operation.mutable_append()->mutable_entry()->set_value(
+        entry.value().substr(snapshot.get().entry.value().size()));
+
+    string value;
+    if (!operation.SerializeToString(&value)) {
+      return Failure("Failed to serialize APPEND Operation");
+    }
+
+    return writer.append(value)
+      .then(defer(self(),
+                  &Self::___set,
+                  entry,
+                  snapshot.get().diffs + 1,
+                  lambda::_1));
+  }
+
   // Check if we should try to compute a diff.
   if (snapshot.isSome() && snapshot.get().diffs < diffsBetweenSnapshots) {
     // Keep metrics for the time to calculate diffs.
@@ -658,9 +731,9 @@ Future<std::set<string>> LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots, bool appends)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process = new LogStorageProcess(log, diffsBetweenSnapshots, appends);
   spawn(process);
 }
 
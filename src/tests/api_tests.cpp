@@ -971,7 +971,7 @@ TEST_P(MasterAPITest, ReserveResources)
 {
   TestAllocator<> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _, _));
 
   // Set a low allocation interval to speed up this test.
   master::Flags flags = MesosTest::CreateMasterFlags();
@@ -1063,7 +1063,7 @@ TEST_P(MasterAPITest, UnreserveResources)
 {
   TestAllocator<> allocator;
 
-  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _));
+  EXPECT_CALL(allocator, initialize(_, _, _, _, _, _, _));
 
   // Set a low allocation interval to speed up this test.
   master::Flags flags = MesosTest::CreateMasterFlags();
@@ -1643,6 +1643,95 @@ TEST_P(MasterAPITest, SubscribeAgentEvents)
 }
 
 
+// This test verifies that an event gets sent to all of the subscribers,
+// regardless of the content type they subscribed with, and that the
+// master exposes the lag of each of them.
+TEST_P(MasterAPITest, SubscribeMultipleSubscribers)
+{
+  Try<Owned<cluster::Master>> master = this->StartMaster();
+  ASSERT_SOME(master);
+
+  v1::master::Call v1Call;
+  v1Call.set_type(v1::master::Call::SUBSCRIBE);
+
+  vector<Owned<Reader<v1::master::Event>>> decoders;
+
+  // Subscribe once using the content type of the test and once using
+  // the other one.
+  const vector<ContentType> contentTypes = {
+    GetParam(),
+    GetParam() == ContentType::PROTOBUF ? ContentType::JSON
+                                        : ContentType::PROTOBUF};
+
+  foreach (ContentType contentType, contentTypes) {
+    http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+    headers["Accept"] = stringify(contentType);
+
+    Future<http::Response> response = http::streaming::post(
+        master.get()->pid,
+        "api/v1",
+        headers,
+        serialize(contentType, v1Call),
+        stringify(contentType));
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+    ASSERT_EQ(http::Response::PIPE, response->type);
+    ASSERT_SOME(response->reader);
+
+    auto deserializer =
+      lambda::bind(deserialize<v1::master::Event>, contentType, lambda::_1);
+
+    decoders.push_back(Owned<Reader<v1::master::Event>>(
+        new Reader<v1::master::Event>(
+            Decoder<v1::master::Event>(deserializer),
+            response->reader.get())));
+
+    Future<Result<v1::master::Event>> event = decoders.back()->read();
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+    EXPECT_EQ(v1::master::Event::SUBSCRIBED, event->get().type());
+
+    event = decoders.back()->read();
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+    EXPECT_EQ(v1::master::Event::HEARTBEAT, event->get().type());
+  }
+
+  // Each of the subscribers has a lag metric.
+  JSON::Object metrics = Metrics();
+
+  size_t lags = 0;
+  foreachkey (const string& key, metrics.values) {
+    if (strings::startsWith(key, "master/subscribers/") &&
+        strings::endsWith(key, "/lag_bytes")) {
+      lags++;
+    }
+  }
+
+  EXPECT_EQ(2u, lags);
+
+  Future<SlaveRegisteredMessage> agentRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get()->pid, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(agentRegisteredMessage);
+
+  foreach (const Owned<Reader<v1::master::Event>>& decoder, decoders) {
+    Future<Result<v1::master::Event>> event = decoder->read();
+    AWAIT_READY(event);
+    ASSERT_SOME(event.get());
+
+    ASSERT_EQ(v1::master::Event::AGENT_ADDED, event->get().type());
+    EXPECT_EQ(
+        evolve(agentRegisteredMessage->slave_id()),
+        event->get().agent_added().agent().agent_info().id());
+  }
+}
+
+
 // This test verifies that no information about reservations and/or allocations
 // is returned to unauthorized users in response to the GET_AGENTS call.
 TEST_P(MasterAPITest, GetAgentsFiltering)
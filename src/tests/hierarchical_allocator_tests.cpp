@@ -176,11 +176,18 @@ protected:
         };
     }
 
+    mesos::allocator::Options options;
+    options.allocationParallelism = flags.allocation_parallelism;
+    options.incrementalAllocation = flags.incremental_allocation;
+
     allocator->initialize(
         flags.allocation_interval,
         offerCallback.get(),
         inverseOfferCallback.get(),
-        flags.fair_sharing_excluded_resource_names);
+        flags.fair_sharing_excluded_resource_names,
+        flags.filter_gpu_resources,
+        flags.domain,
+        options);
   }
 
   SlaveInfo createSlaveInfo(const Resources& resources)
@@ -448,6 +455,123 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
 }
 
 
+// Tests that when the agents are partitioned into shards, the batch
+// allocations are the same as with a single shard, for agents of
+// different sizes, reservations and offer filters.
+TEST_F(HierarchicalAllocatorTest, ParallelAllocation)
+{
+  Clock::pause();
+
+  vector<SlaveInfo> agents;
+  hashset<SlaveID> declined;
+  for (int i = 0; i < 12; i++) {
+    string resources =
+      "cpus:" + stringify(1 + i % 3) + ";mem:" + stringify(512 << (i % 2)) +
+      ";disk:0";
+
+    if (i % 4 == 0) {
+      resources += ";cpus(role1):2;mem(role1):256";
+    }
+
+    agents.push_back(createSlaveInfo(resources));
+
+    if (i % 2 == 0) {
+      declined.insert(agents.back().id());
+    }
+  }
+
+  vector<FrameworkInfo> frameworks = {
+    createFrameworkInfo({"role1"}),
+    createFrameworkInfo({"role1"}),
+    createFrameworkInfo({"role2"}),
+    createFrameworkInfo({"role2", "role3"})
+  };
+
+  // Runs two batch allocations with the given parallelism. In between,
+  // the frameworks decline the resources on every other agent with a
+  // long filter and recover the others.
+  auto run = [&](size_t parallelism) {
+    vector<Allocation> offered;
+
+    delete allocator;
+    allocator = createAllocator<HierarchicalDRFAllocator>();
+
+    master::Flags flags_;
+    flags_.allocation_parallelism = parallelism;
+
+    initialize(
+        flags_,
+        [&offered](
+            const FrameworkID& frameworkId,
+            const hashmap<string, hashmap<SlaveID, Resources>>& resources) {
+          Allocation allocation;
+          allocation.frameworkId = frameworkId;
+          allocation.resources = resources;
+
+          offered.push_back(allocation);
+        });
+
+    // Hold back all of the agents so that they are allocated in the
+    // same batch allocation.
+    allocator->updateWhitelist(hashset<string>());
+
+    foreach (const FrameworkInfo& framework, frameworks) {
+      allocator->addFramework(framework.id(), framework, {}, true, {});
+    }
+
+    foreach (const SlaveInfo& agent, agents) {
+      allocator->addSlave(
+          agent.id(),
+          agent,
+          AGENT_CAPABILITIES(),
+          None(),
+          agent.resources(),
+          {});
+    }
+
+    allocator->updateWhitelist(None());
+
+    // The agents are shuffled before each batch allocation, so both
+    // runs need to start from the same seed.
+    Clock::settle();
+    std::srand(1);
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    Filters offerFilter;
+    offerFilter.set_refuse_seconds(Days(1).secs());
+
+    const vector<Allocation> allocated = offered;
+    foreach (const Allocation& allocation, allocated) {
+      foreachvalue (const auto& resources, allocation.resources) {
+        foreachpair (const SlaveID& slaveId,
+                     const Resources& slaveResources,
+                     resources) {
+          Option<Filters> filters = None();
+          if (declined.contains(slaveId)) {
+            filters = offerFilter;
+          }
+
+          allocator->recoverResources(
+              allocation.frameworkId, slaveId, slaveResources, filters);
+        }
+      }
+    }
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    return offered;
+  };
+
+  const vector<Allocation> expected = run(1);
+  ASSERT_FALSE(expected.empty());
+
+  EXPECT_EQ(expected, run(4));
+}
+
+
 // This test ensures that reserved resources do affect the sharing across roles.
 TEST_F(HierarchicalAllocatorTest, ReservedDRF)
 {
@@ -904,6 +1028,265 @@ TEST_F(HierarchicalAllocatorTest, OfferFilter)
 }
 
 
+// This test ensures that an offer filter does not filter more
+// resources than the ones that were refused.
+TEST_F(HierarchicalAllocatorTest, OfferFilterMoreResources)
+{
+  Clock::pause();
+
+  const string ROLE{"role"};
+
+  initialize();
+
+  FrameworkInfo framework = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  SlaveInfo agent = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  Allocation expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  // `framework` keeps half of the resources and declines the
+  // other half with a long filter.
+  Resources half = Resources::parse("cpus:1;mem:512").get();
+  half.allocate(ROLE);
+
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(Days(1).secs());
+
+  allocator->recoverResources(framework.id(), agent.id(), half, offerFilter);
+
+  // There should be no allocation due to the offer filter.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  // Once `framework` recovers the other half as well, the available
+  // resources are no longer filtered.
+  allocator->recoverResources(framework.id(), agent.id(), half, None());
+
+  Clock::advance(flags.allocation_interval);
+
+  AWAIT_EXPECT_EQ(expected, allocation);
+}
+
+
+// This test ensures that the offer filters which time out at the same
+// time are all removed at once, while the ones timing out later stay.
+TEST_F(HierarchicalAllocatorTest, OfferFiltersExpireTogether)
+{
+  Clock::pause();
+
+  const string ROLE{"role"};
+
+  initialize();
+
+  vector<SlaveInfo> agents;
+  for (int i = 0; i < 3; i++) {
+    SlaveInfo agent = createSlaveInfo("cpus:1;mem:512;disk:0");
+    allocator->addSlave(
+        agent.id(),
+        agent,
+        AGENT_CAPABILITIES(),
+        None(),
+        agent.resources(),
+        {});
+
+    agents.push_back(agent);
+  }
+
+  FrameworkInfo framework = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  Allocation expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agents[0].id(), agents[0].resources()},
+               {agents[1].id(), agents[1].resources()},
+               {agents[2].id(), agents[2].resources()}}}});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  // `framework` declines the resources of the first two agents with
+  // the same filter, and those of the last agent with a longer one.
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds((flags.allocation_interval * 2).secs());
+
+  Filters longerOfferFilter;
+  longerOfferFilter.set_refuse_seconds(
+      (flags.allocation_interval * 4).secs());
+
+  for (int i = 0; i < 3; i++) {
+    allocator->recoverResources(
+        framework.id(),
+        agents[i].id(),
+        allocation->resources.at(ROLE).at(agents[i].id()),
+        i < 2 ? offerFilter : longerOfferFilter);
+  }
+
+  Clock::settle();
+
+  string activeOfferFilters =
+    "allocator/mesos/offer_filters/roles/" + ROLE + "/active";
+
+  JSON::Object metrics = Metrics();
+  EXPECT_EQ(3, metrics.values[activeOfferFilters]);
+
+  // Once the first two filters time out, both agents are offered in
+  // the same batch allocation.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agents[0].id(), agents[0].resources()},
+               {agents[1].id(), agents[1].resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  metrics = Metrics();
+  EXPECT_EQ(1, metrics.values[activeOfferFilters]);
+
+  // The longer filter times out on its own later.
+  Clock::advance(flags.allocation_interval * 2);
+  Clock::settle();
+
+  expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agents[2].id(), agents[2].resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocations.get());
+
+  metrics = Metrics();
+  EXPECT_EQ(0, metrics.values[activeOfferFilters]);
+}
+
+
+// This test ensures that in the incremental allocation mode recovered
+// resources and revived frameworks are offered resources without
+// waiting for the next batch allocation.
+TEST_F(HierarchicalAllocatorTest, IncrementalAllocation)
+{
+  // Pause the clock so that no batch allocation takes place.
+  Clock::pause();
+
+  const string ROLE{"role"};
+
+  master::Flags flags_;
+  flags_.incremental_allocation = true;
+
+  initialize(flags_);
+
+  FrameworkInfo framework1 = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework1.id(), framework1, {}, true, {});
+
+  SlaveInfo agent = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  Allocation expected = Allocation(
+      framework1.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  FrameworkInfo framework2 = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework2.id(), framework2, {}, true, {});
+
+  // The declined resources are offered right away, but not to
+  // `framework1` which declined them (even without a filter), so that
+  // the offer doesn't bounce back and forth until the next batch
+  // allocation.
+  Filters noFilter;
+  noFilter.set_refuse_seconds(0);
+
+  allocator->recoverResources(
+      framework1.id(),
+      agent.id(),
+      allocation->resources.at(ROLE).at(agent.id()),
+      noFilter);
+
+  expected = Allocation(
+      framework2.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  // Now `framework2` declines the offer and sets a filter, hence
+  // nobody is offered the recovered resources.
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(Days(1).secs());
+
+  allocator->recoverResources(
+      framework2.id(),
+      agent.id(),
+      allocation->resources.at(ROLE).at(agent.id()),
+      offerFilter);
+
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  // `framework1` is offered the resources again from the next batch
+  // allocation on.
+  Clock::advance(flags.allocation_interval);
+
+  expected = Allocation(
+      framework1.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  // Once `framework1` declines with a filter as well, reviving
+  // `framework2` clears its filter and leads to an offer right away.
+  allocator->recoverResources(
+      framework1.id(),
+      agent.id(),
+      allocation->resources.at(ROLE).at(agent.id()),
+      offerFilter);
+
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  allocator->reviveOffers(framework2.id(), {});
+
+  expected = Allocation(
+      framework2.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocation);
+}
+
+
 // This test ensures that an offer filter is not removed earlier than
 // the next batch allocation. See MESOS-4302 for more information.
 //
@@ -6000,6 +6383,127 @@ TEST_P(HierarchicalAllocator_BENCHMARK_Test, AllocatorBacklog)
        << " allocation runs" << endl;
 }
 
+
+class HierarchicalAllocator_Parallel_BENCHMARK_Test
+  : public HierarchicalAllocatorTestBase,
+    public WithParamInterface<std::tuple<size_t, size_t, size_t>> {};
+
+
+// The multi-threaded Hierarchical Allocator benchmark tests are
+// parameterized by the number of agents, the number of frameworks
+// and the number of shards the agents are partitioned into.
+INSTANTIATE_TEST_CASE_P(
+    AgentFrameworkAndShardCount,
+    HierarchicalAllocator_Parallel_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 10000U, 30000U),
+      ::testing::Values(100U, 1000U),
+      ::testing::Values(1U, 2U, 4U, 8U))
+    );
+
+
+// This test measures how long a batch allocation cycle over all of
+// the agents takes, while the frameworks keep declining the offers.
+TEST_P(HierarchicalAllocator_Parallel_BENCHMARK_Test, DeclineOffers)
+{
+  size_t agentCount = std::get<0>(GetParam());
+  size_t frameworkCount = std::get<1>(GetParam());
+  size_t shardCount = std::get<2>(GetParam());
+
+  // Pause the clock because we want to manually drive the allocations.
+  Clock::pause();
+
+  struct OfferedResources
+  {
+    FrameworkID   frameworkId;
+    SlaveID       slaveId;
+    Resources     resources;
+  };
+
+  vector<OfferedResources> offers;
+
+  auto offerCallback = [&offers](
+      const FrameworkID& frameworkId,
+      const hashmap<string, hashmap<SlaveID, Resources>>& resources_)
+  {
+    foreachkey (const string& role, resources_) {
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& resources,
+                   resources_.at(role)) {
+        offers.push_back(OfferedResources{frameworkId, slaveId, resources});
+      }
+    }
+  };
+
+  cout << "Using " << agentCount << " agents, "
+       << frameworkCount << " frameworks and "
+       << shardCount << " shards" << endl;
+
+  master::Flags flags_;
+  flags_.allocation_parallelism = shardCount;
+
+  initialize(flags_, offerCallback);
+
+  // Hold back the agents until the first batch allocation.
+  allocator->updateWhitelist(hashset<string>());
+
+  for (size_t i = 0; i < frameworkCount; i++) {
+    FrameworkInfo framework = createFrameworkInfo({"role" + stringify(i)});
+    allocator->addFramework(framework.id(), framework, {}, true, {});
+  }
+
+  const Resources agentResources = Resources::parse(
+      "cpus:24;mem:4096;disk:4096;ports:[31000-32000]").get();
+
+  for (size_t i = 0; i < agentCount; i++) {
+    SlaveInfo agent = createSlaveInfo(agentResources);
+    allocator->addSlave(
+        agent.id(),
+        agent,
+        AGENT_CAPABILITIES(),
+        None(),
+        agent.resources(),
+        {});
+  }
+
+  allocator->updateWhitelist(None());
+
+  // Wait for all the operations to be processed.
+  Clock::settle();
+
+  Stopwatch watch;
+
+  for (size_t i = 0; i < 5; i++) {
+    watch.start();
+
+    // Advance the clock and trigger a background allocation cycle.
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    watch.stop();
+
+    cout << "round " << i
+         << " allocate() took " << watch.elapsed()
+         << " to make " << offers.size() << " offers" << endl;
+
+    // Permanently decline the offered resources, so that the
+    // next round considers the frameworks that are left.
+    foreach (const OfferedResources& offer, offers) {
+      Filters filters;
+      filters.set_refuse_seconds(INT_MAX);
+
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, filters);
+    }
+
+    // Wait for the declined offers.
+    Clock::settle();
+    offers.clear();
+  }
+
+  Clock::resume();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
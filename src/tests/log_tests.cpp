@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include <iostream>
 #include <list>
 #include <set>
 #include <string>
@@ -65,6 +66,8 @@ using namespace mesos::internal::log;
 
 using namespace process;
 
+using std::cout;
+using std::endl;
 using std::list;
 using std::set;
 using std::string;
@@ -321,6 +324,196 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+// Verifies that staged actions can be read before they are committed
+// and are persisted once committed.
+TYPED_TEST(LogStorageTest, GroupCommit)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    // Stage from position 0 to position 9.
+    for (uint64_t i = 0; i < 10; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(true);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      ASSERT_SOME(storage.stage(action));
+    }
+
+    // Truncate to position 3 (at position 10) in the same commit.
+    Action truncate;
+    truncate.set_position(10);
+    truncate.set_promised(1);
+    truncate.set_performed(1);
+    truncate.set_learned(true);
+    truncate.set_type(Action::TRUNCATE);
+    truncate.mutable_truncate()->set_to(3);
+
+    ASSERT_SOME(storage.stage(truncate));
+
+    for (uint64_t i = 0; i < 3; i++) {
+      EXPECT_ERROR(storage.read(i));
+    }
+
+    for (uint64_t i = 3; i < 10; i++) {
+      Try<Action> action = storage.read(i);
+      ASSERT_SOME(action);
+      EXPECT_EQ(stringify(i), action->append().bytes());
+    }
+
+    ASSERT_SOME(storage.commit());
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(3u, state->begin);
+  EXPECT_EQ(10u, state->end);
+
+  for (uint64_t i = 0; i < 3; i++) {
+    EXPECT_ERROR(storage.read(i));
+  }
+
+  for (uint64_t i = 3; i < 10; i++) {
+    Try<Action> action = storage.read(i);
+    ASSERT_SOME(action);
+    EXPECT_EQ(Action::APPEND, action->type());
+    EXPECT_EQ(stringify(i), action->append().bytes());
+  }
+
+  Try<Action> action = storage.read(10);
+  ASSERT_SOME(action);
+  EXPECT_EQ(Action::TRUNCATE, action->type());
+}
+
+
+// This test verifies that the positions covered by the checkpoint
+// are restored (without being read) along with the positions after
+// it, including after truncations.
+TYPED_TEST(LogStorageTest, Checkpoint)
+{
+  const string path = os::getcwd() + "/.log";
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    Metadata metadata;
+    metadata.set_status(Metadata::VOTING);
+    metadata.set_promised(1);
+
+    ASSERT_SOME(storage.persist(metadata));
+
+    // Learn positions 0 to 9 and 11, leaving position 10 unlearned
+    // so that the checkpoint stops at position 9.
+    for (uint64_t i = 0; i < 12; i++) {
+      Action action;
+      action.set_position(i);
+      action.set_promised(1);
+      action.set_performed(1);
+      action.set_learned(i != 10);
+      action.set_type(Action::APPEND);
+      action.mutable_append()->set_bytes(stringify(i));
+
+      ASSERT_SOME(storage.stage(action));
+    }
+
+    ASSERT_SOME(storage.commit());
+  }
+
+  {
+    TypeParam storage;
+
+    Try<Storage::State> state = storage.restore(path);
+    ASSERT_SOME(state);
+
+    EXPECT_EQ(Metadata::VOTING, state->metadata.status());
+    EXPECT_EQ(1u, state->metadata.promised());
+    ASSERT_TRUE(state->metadata.has_checkpoint());
+    EXPECT_EQ(9u, state->metadata.checkpoint().position());
+
+    EXPECT_EQ(0u, state->begin);
+    EXPECT_EQ(11u, state->end);
+
+    IntervalSet<uint64_t> learned;
+    learned += (Bound<uint64_t>::closed(0), Bound<uint64_t>::closed(9));
+    learned += 11;
+
+    EXPECT_EQ(learned, state->learned);
+    EXPECT_EQ(IntervalSet<uint64_t>(10), state->unlearned);
+
+    for (uint64_t i = 0; i < 12; i++) {
+      Try<Action> action = storage.read(i);
+      ASSERT_SOME(action);
+      EXPECT_EQ(stringify(i), action->append().bytes());
+    }
+
+    // Learn position 10 and truncate to position 6 (at position 12).
+    Action action;
+    action.set_position(10);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes("10");
+
+    ASSERT_SOME(storage.stage(action));
+
+    Action truncate;
+    truncate.set_position(12);
+    truncate.set_promised(1);
+    truncate.set_performed(1);
+    truncate.set_learned(true);
+    truncate.set_type(Action::TRUNCATE);
+    truncate.mutable_truncate()->set_to(6);
+
+    ASSERT_SOME(storage.stage(truncate));
+    ASSERT_SOME(storage.commit());
+  }
+
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(path);
+  ASSERT_SOME(state);
+
+  ASSERT_TRUE(state->metadata.has_checkpoint());
+  EXPECT_EQ(12u, state->metadata.checkpoint().position());
+
+  EXPECT_EQ(6u, state->begin);
+  EXPECT_EQ(12u, state->end);
+
+  EXPECT_EQ(
+      IntervalSet<uint64_t>(
+          (Bound<uint64_t>::closed(6), Bound<uint64_t>::closed(12))),
+      state->learned);
+
+  EXPECT_TRUE(state->unlearned.empty());
+
+  for (uint64_t i = 0; i < 6; i++) {
+    EXPECT_ERROR(storage.read(i));
+  }
+
+  for (uint64_t i = 6; i < 12; i++) {
+    Try<Action> action = storage.read(i);
+    ASSERT_SOME(action);
+    EXPECT_EQ(stringify(i), action->append().bytes());
+  }
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1282,6 +1475,170 @@ TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 }
 
 
+// Verifies that a coordinator with a write window can have several
+// appends in flight, and that the positions are learned in order on
+// all the replicas.
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network, 4);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  list<Future<Option<uint64_t>>> appendings;
+  for (uint64_t position = 1; position <= 4; position++) {
+    appendings.push_back(coord.append(stringify(position)));
+  }
+
+  // The window is full now.
+  AWAIT_FAILED(coord.append("5"));
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t>>& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position++, appending.get());
+  }
+
+  // The learned messages to 'replica2' might still be in flight.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  list<Shared<Replica>> replicas = {replica1, replica2};
+  foreach (const Shared<Replica>& replica, replicas) {
+    AWAIT_EXPECT_EQ(IntervalSet<uint64_t>(), replica->missing(1, 4));
+
+    Future<list<Action>> actions = replica->read(1, 4);
+    AWAIT_READY(actions);
+    EXPECT_EQ(4u, actions->size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+
+  // The window is available again.
+  {
+    Future<Option<uint64_t>> appending = coord.append("5");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(5u, appending.get());
+  }
+}
+
+
+// Tests that when a pipelined write is rejected, the writes after it
+// are given up as well, including the ones already accepted by a
+// quorum, while the writes before it are still learned.
+TEST_F(CoordinatorTest, PipelinedAppendRejected)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network, 3);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Promise position 2 to a higher proposal on 'replica2', so that it
+  // rejects the coordinator's write at that position.
+  {
+    PromiseRequest request;
+    request.set_proposal(100);
+    request.set_position(2);
+
+    Future<PromiseResponse> response =
+      protocol::promise(replica2->pid(), request);
+
+    AWAIT_READY(response);
+    ASSERT_TRUE(response->okay());
+  }
+
+  // Hold back the write at position 2 to 'replica2' until the write
+  // at position 3 has been accepted.
+  Future<Message> writeRequest2 =
+    DROP_MESSAGE(WriteRequest().GetTypeName(), _, Eq(replica2->pid()));
+
+  Future<Message> writeRequest1 =
+    FUTURE_MESSAGE(WriteRequest().GetTypeName(), _, Eq(replica2->pid()));
+
+  Future<Option<uint64_t>> appending1 = coord.append("1");
+  Future<Option<uint64_t>> appending2 = coord.append("2");
+  Future<Option<uint64_t>> appending3 = coord.append("3");
+
+  AWAIT_READY(writeRequest1);
+  AWAIT_READY(writeRequest2);
+
+  AWAIT_READY(appending1);
+  EXPECT_SOME_EQ(1u, appending1.get());
+
+  // Wait for the write at position 3 to be accepted by both replicas.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  {
+    Future<list<Action>> actions = replica2->read(3, 3);
+    AWAIT_READY(actions);
+    ASSERT_EQ(1u, actions->size());
+    EXPECT_TRUE(actions->front().has_performed());
+    EXPECT_FALSE(actions->front().has_learned());
+  }
+
+  EXPECT_TRUE(appending2.isPending());
+  EXPECT_TRUE(appending3.isPending());
+
+  post(writeRequest2->from,
+       writeRequest2->to,
+       writeRequest2->name,
+       writeRequest2->body.data(),
+       writeRequest2->body.size());
+
+  AWAIT_READY(appending2);
+  EXPECT_NONE(appending2.get());
+
+  AWAIT_READY(appending3);
+  EXPECT_NONE(appending3.get());
+}
+
+
 TEST_F(CoordinatorTest, Truncate)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1844,6 +2201,167 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// This test verifies that a recovering replica transfers the learned
+// actions from the other replicas without running Paxos for them.
+TEST_F(RecoverTest, Transfer)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t>> appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  // Make sure the positions can not be caught-up using Paxos.
+  DROP_PROTOBUFS(PromiseRequest(), _, _);
+
+  Owned<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Future<Owned<Replica>> recovering = recover(2, replica3, network2);
+  AWAIT_READY(recovering);
+
+  Owned<Replica> owned = recovering.get();
+
+  Future<Metadata::Status> status = owned->status();
+  AWAIT_EXPECT_EQ(Metadata::VOTING, status);
+
+  Future<list<Action>> actions = owned->read(1, 10);
+  AWAIT_READY(actions);
+  EXPECT_EQ(10u, actions->size());
+  foreach (const Action& action, actions.get()) {
+    ASSERT_TRUE(action.has_type());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
+// This test verifies that a recovering replica transfers the learned
+// actions from all the other replicas, skipping the replicas that
+// have not learned them, and reports the progress of the transfer.
+TEST_F(RecoverTest, ParallelTransfer)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  ASSERT_SOME(initializer.execute());
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  ASSERT_SOME(initializer.execute());
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  // Make sure replica2 does not learn any position.
+  DROP_PROTOBUFS(LearnedMessage(), _, Eq(replica2->pid()));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1, 16);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Write more positions than requested by a single read request.
+  const uint64_t count = 3000;
+
+  list<Future<Option<uint64_t>>> appendings;
+  for (uint64_t position = 1; position <= count; position++) {
+    // Keep at most 16 appends in flight (the coordinator's window).
+    if (appendings.size() == 16) {
+      AWAIT_READY(appendings.front());
+      EXPECT_SOME(appendings.front().get());
+      appendings.pop_front();
+    }
+
+    appendings.push_back(coord.append(stringify(position)));
+  }
+
+  foreach (const Future<Option<uint64_t>>& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_SOME(appending.get());
+  }
+
+  // Make sure the positions can not be caught-up using Paxos.
+  DROP_PROTOBUFS(PromiseRequest(), _, _);
+
+  Owned<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  Option<TransferProgress> progress;
+
+  Future<Owned<Replica>> recovering = recover(
+      2,
+      replica3,
+      network2,
+      false,
+      [&progress](const TransferProgress& progress_) {
+        progress = progress_;
+      });
+
+  AWAIT_READY(recovering);
+
+  ASSERT_SOME(progress);
+  EXPECT_EQ(count + 1, progress->transferred);
+  EXPECT_EQ(0u, progress->remaining);
+
+  Owned<Replica> owned = recovering.get();
+
+  AWAIT_EXPECT_EQ(IntervalSet<uint64_t>(), owned->missing(0, count));
+
+  Future<list<Action>> actions = owned->read(1, count);
+  AWAIT_READY(actions);
+  EXPECT_EQ(count, actions->size());
+  foreach (const Action& action, actions.get()) {
+    ASSERT_TRUE(action.has_type());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -2105,6 +2623,16 @@ TEST_F(LogTest, Metrics)
 
   ASSERT_EQ(1u, snapshot.values.count("prefix/log/ensemble_size"));
   EXPECT_EQ(1, snapshot.values["prefix/log/ensemble_size"]);
+
+  // Nothing has been caught-up since the log was initialized.
+  ASSERT_EQ(1u, snapshot.values.count("prefix/log/catchup/transferred"));
+  EXPECT_EQ(0, snapshot.values["prefix/log/catchup/transferred"]);
+
+  ASSERT_EQ(1u, snapshot.values.count("prefix/log/catchup/remaining"));
+  EXPECT_EQ(0, snapshot.values["prefix/log/catchup/remaining"]);
+
+  ASSERT_EQ(1u, snapshot.values.count("prefix/log/catchup/throughput"));
+  EXPECT_EQ(0, snapshot.values["prefix/log/catchup/throughput"]);
 }
 
 
@@ -2245,6 +2773,85 @@ TEST_F(CoordinatorTest, LearnedOnOneReplica_NotLearnedOnAnother) {}
 TEST_F(CoordinatorTest,
        LearnedOnOneReplica_NotLearnedOnAnother_AnotherFailsAndRecovers) {}
 
+class Coordinator_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public ::testing::WithParamInterface<size_t>
+{
+protected:
+  // Used to change the status of a replicated log from `EMPTY` to `VOTING`.
+  tool::Initialize initializer;
+};
+
+
+// The coordinator benchmark tests are parameterized by the size of
+// the write window.
+INSTANTIATE_TEST_CASE_P(
+    WindowSize,
+    Coordinator_BENCHMARK_Test,
+    ::testing::Values(1U, 4U, 16U, 64U));
+
+
+// Measures the append throughput of a coordinator writing to three
+// replicas while keeping its write window full.
+TEST_P(Coordinator_BENCHMARK_Test, Append)
+{
+  const size_t window = GetParam();
+  const size_t count = 2000;
+
+  set<UPID> pids;
+  list<Shared<Replica>> replicas;
+
+  for (int i = 1; i <= 3; i++) {
+    const string path = os::getcwd() + "/.log" + stringify(i);
+    initializer.flags.path = path;
+    ASSERT_SOME(initializer.execute());
+
+    Shared<Replica> replica(new Replica(path));
+    pids.insert(replica->pid());
+    replicas.push_back(replica);
+  }
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replicas.front(), network, window);
+
+  {
+    Future<Option<uint64_t>> electing = coord.elect();
+    AWAIT_READY(electing);
+    ASSERT_SOME(electing.get());
+  }
+
+  const string bytes(1024, 'a');
+
+  Stopwatch watch;
+  watch.start();
+
+  // Appends are set in the order of their positions, so awaiting the
+  // oldest one always frees a slot in the window.
+  list<Future<Option<uint64_t>>> appendings;
+  for (size_t i = 0; i < count; i++) {
+    if (appendings.size() == window) {
+      AWAIT_READY(appendings.front());
+      ASSERT_SOME(appendings.front().get());
+      appendings.pop_front();
+    }
+
+    appendings.push_back(coord.append(bytes));
+  }
+
+  foreach (const Future<Option<uint64_t>>& appending, appendings) {
+    AWAIT_READY(appending);
+    ASSERT_SOME(appending.get());
+  }
+
+  watch.stop();
+
+  cout << "Appended " << count << " entries with a window of " << window
+       << " in " << watch.elapsed() << " ("
+       << count / watch.elapsed().secs() << " entries/s)" << endl;
+}
+
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -4506,6 +4506,236 @@ TEST_F(MasterTest, StateEndpoint)
 }
 
 
+// This test ensures that the master's state endpoint streams its
+// body and wraps it into the JSONP callback, if one is requested.
+TEST_F(MasterTest, StateEndpointJsonp)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      "jsonp=callback",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "text/javascript", "Content-Type", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "chunked", "Transfer-Encoding", response);
+
+  const string& body = response->body;
+
+  ASSERT_TRUE(strings::startsWith(body, "callback("));
+  ASSERT_TRUE(strings::endsWith(body, ");"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(
+      body.substr(strlen("callback("), body.size() - strlen("callback();")));
+
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(MESOS_VERSION, parse->values["version"]);
+  EXPECT_EQ(stringify(master.get()->pid), parse->values["pid"]);
+}
+
+
+// This test ensures that the master's state endpoint compresses its
+// streamed body if the client accepts that, and that the streamed
+// body includes the registered agents.
+TEST_F(MasterTest, StateEndpointGzip)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  process::http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+  headers["Accept-Encoding"] = "gzip";
+
+  Future<Response> response = process::http::get(
+      master.get()->pid,
+      "state",
+      None(),
+      headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(APPLICATION_JSON, "Content-Type", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("gzip", "Content-Encoding", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "chunked", "Transfer-Encoding", response);
+
+  // NOTE: The body gets decompressed by the client.
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(parse);
+
+  JSON::Object state = parse.get();
+
+  EXPECT_EQ(MESOS_VERSION, state.values["version"]);
+
+  ASSERT_TRUE(state.values["slaves"].is<JSON::Array>());
+  ASSERT_EQ(1u, state.values["slaves"].as<JSON::Array>().values.size());
+
+  JSON::Object agent =
+    state.values["slaves"].as<JSON::Array>().values[0].as<JSON::Object>();
+
+  EXPECT_EQ(slaveRegisteredMessage->slave_id().value(), agent.values["id"]);
+
+  ASSERT_TRUE(state.values["frameworks"].is<JSON::Array>());
+  EXPECT_TRUE(state.values["frameworks"].as<JSON::Array>().values.empty());
+}
+
+
+// This test ensures that concurrent requests to the master's read-only
+// endpoints, which get served in batches, all get served correctly.
+TEST_F(MasterTest, BatchedReadOnlyRequests)
+{
+  Try<Owned<cluster::Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get());
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  const vector<string> endpoints =
+    {"state", "state-summary", "frameworks", "slaves", "tasks"};
+
+  vector<Future<Response>> responses;
+  for (int i = 0; i < 4; i++) {
+    foreach (const string& endpoint, endpoints) {
+      responses.push_back(process::http::get(
+          master.get()->pid,
+          endpoint,
+          None(),
+          createBasicAuthHeaders(DEFAULT_CREDENTIAL)));
+    }
+  }
+
+  foreach (const Future<Response>& response, responses) {
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+    EXPECT_SOME(JSON::parse<JSON::Object>(response->body));
+  }
+
+  // The registered agent is part of the state.
+  Try<JSON::Object> state = JSON::parse<JSON::Object>(responses[0]->body);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(1, state->values["activated_slaves"]);
+}
+
+
+// This test verifies that the master caches the responses to its
+// read-only endpoints when `--cache_http_readonly_responses` is set,
+// and that the cached responses get revalidated using their `ETag`
+// until the master's state changes.
+TEST_F(MasterTest, CachedReadOnlyResponses)
+{
+  Clock::pause();
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.cache_http_readonly_responses = true;
+
+  Try<Owned<cluster::Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Clock::settle();
+
+  process::http::Headers headers = createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+
+  Future<Response> response =
+    process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_TRUE(response->headers.contains("ETag"));
+
+  const string etag = response->headers.at("ETag");
+  const string body = response->body;
+
+  // The cached response is served as long as the state is unchanged.
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_SOME_EQ(etag, response->headers.get("ETag"));
+  EXPECT_EQ(body, response->body);
+
+  headers["If-None-Match"] = etag;
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Response(process::http::Status::NOT_MODIFIED).status, response);
+  EXPECT_TRUE(response->body.empty());
+
+  // Read-only calls to the v1 operator API don't change the state.
+  {
+    v1::master::Call call;
+    call.set_type(v1::master::Call::GET_HEALTH);
+
+    ContentType contentType = ContentType::PROTOBUF;
+
+    process::http::Headers v1Headers =
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL);
+    v1Headers["Accept"] = stringify(contentType);
+
+    Future<Response> v1Response = process::http::post(
+        master.get()->pid,
+        "api/v1",
+        v1Headers,
+        serialize(contentType, call),
+        stringify(contentType));
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, v1Response);
+  }
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Response(process::http::Status::NOT_MODIFIED).status, response);
+
+  // The responses for different queries are tagged differently.
+  response = process::http::get(
+      master.get()->pid, "state", "jsonp=callback", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_NE(Option<string>(etag), response->headers.get("ETag"));
+
+  // Registering an agent changes the state and hence invalidates the
+  // cached response.
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  slave::Flags agentFlags = CreateSlaveFlags();
+  Owned<MasterDetector> detector = master.get()->createDetector();
+  Try<Owned<cluster::Slave>> slave = StartSlave(detector.get(), agentFlags);
+  ASSERT_SOME(slave);
+
+  Clock::advance(agentFlags.registration_backoff_factor);
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = process::http::get(master.get()->pid, "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_NE(Option<string>(etag), response->headers.get("ETag"));
+
+  Try<JSON::Object> state = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(state);
+
+  EXPECT_EQ(1, state->values["activated_slaves"]);
+}
+
+
 // This test ensures that the framework's information is included in
 // the master's state endpoint.
 //
@@ -39,6 +39,7 @@
 #include <process/process.hpp>
 
 #include <stout/bytes.hpp>
+#include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/uuid.hpp>
 
@@ -115,6 +116,7 @@ using mesos::http::authentication::BasicAuthenticatorFactory;
 using mesos::state::LogStorage;
 using mesos::state::State;
 using mesos::state::Storage;
+using mesos::state::Variable;
 
 using state::Entry;
 
@@ -171,7 +173,9 @@ protected:
     pids.insert(replica2->pid());
 
     log = new Log(2, path1, pids);
-    storage = new LogStorage(log);
+
+    // Allow the appends for the tests enabling registry deltas.
+    storage = new LogStorage(log, 0, true);
     state = new State(storage);
 
     // Compensate for slow CI machines / VMs.
@@ -385,6 +389,47 @@ TEST_F(RegistrarTest, PruneUnreachable)
 }
 
 
+// This test verifies that pruning an unreachable agent which is not
+// the first one in the unreachable list only removes that agent.
+TEST_F(RegistrarTest, PruneUnreachableNotFirst)
+{
+  vector<SlaveInfo> infos;
+  for (int i = 1; i <= 3; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    foreach (const SlaveInfo& info, infos) {
+      AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+
+      AWAIT_TRUE(
+          registrar.apply(
+              Owned<Operation>(
+                  new MarkSlaveUnreachable(info, protobuf::getCurrentTime()))));
+    }
+
+    AWAIT_TRUE(
+        registrar.apply(
+            Owned<Operation>(new PruneUnreachable({infos[1].id()}))));
+  }
+
+  Registrar registrar(flags, state);
+
+  Future<Registry> registry = registrar.recover(master);
+  AWAIT_READY(registry);
+
+  ASSERT_EQ(2, registry->unreachable().slaves().size());
+  EXPECT_EQ(infos[0].id(), registry->unreachable().slaves(0).id());
+  EXPECT_EQ(infos[2].id(), registry->unreachable().slaves(1).id());
+}
+
+
 TEST_F(RegistrarTest, Remove)
 {
   Registrar registrar(flags, state);
@@ -1068,6 +1113,97 @@ TEST_F(RegistrarTest, Bootstrap)
 }
 
 
+// This test verifies that the changes stored as registry deltas are
+// recovered, and that the registry is compacted upon recovery.
+TEST_F(RegistrarTest, RecoverDeltas)
+{
+  flags.registry_store_deltas = true;
+
+  vector<SlaveInfo> infos;
+  for (int i = 1; i <= 4; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    foreach (const SlaveInfo& info, infos) {
+      AWAIT_TRUE(registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+    }
+
+    AWAIT_TRUE(
+        registrar.apply(
+            Owned<Operation>(
+                new MarkSlaveUnreachable(
+                    infos[0], protobuf::getCurrentTime()))));
+
+    AWAIT_TRUE(
+        registrar.apply(Owned<Operation>(new MarkSlaveReachable(infos[0]))));
+
+    AWAIT_TRUE(
+        registrar.apply(
+            Owned<Operation>(
+                new MarkSlaveUnreachable(
+                    infos[2], protobuf::getCurrentTime()))));
+
+    AWAIT_TRUE(
+        registrar.apply(
+            Owned<Operation>(
+                new MarkSlaveUnreachable(
+                    infos[3], protobuf::getCurrentTime()))));
+
+    AWAIT_TRUE(
+        registrar.apply(
+            Owned<Operation>(new PruneUnreachable({infos[3].id()}))));
+
+    AWAIT_TRUE(registrar.apply(Owned<Operation>(new RemoveSlave(infos[1]))));
+  }
+
+  // The changes should have been appended to the stored registry.
+  Future<Variable> variable = state->fetch("registry");
+  AWAIT_READY(variable);
+
+  Try<Registry> stored = ::protobuf::deserialize<Registry>(variable->value());
+  ASSERT_SOME(stored);
+  EXPECT_FALSE(stored->deltas().empty());
+
+  MasterInfo info;
+  info.set_id("master");
+  info.set_ip(10000000);
+  info.set_port(5050);
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(info);
+    AWAIT_READY(registry);
+
+    EXPECT_EQ(info, registry->master().info());
+    EXPECT_TRUE(registry->deltas().empty());
+
+    ASSERT_EQ(1, registry->slaves().slaves().size());
+    EXPECT_EQ(infos[0], registry->slaves().slaves(0).info());
+
+    ASSERT_EQ(1, registry->unreachable().slaves().size());
+    EXPECT_EQ(infos[2].id(), registry->unreachable().slaves(0).id());
+  }
+
+  // The recovery should have compacted the stored registry.
+  variable = state->fetch("registry");
+  AWAIT_READY(variable);
+
+  stored = ::protobuf::deserialize<Registry>(variable->value());
+  ASSERT_SOME(stored);
+  EXPECT_TRUE(stored->deltas().empty());
+  EXPECT_EQ(info, stored->master().info());
+  EXPECT_EQ(1, stored->slaves().slaves().size());
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -1439,6 +1575,90 @@ TEST_P(Registrar_BENCHMARK_Test, GcManyAgents)
        << watch.elapsed() << endl;
 }
 
+
+// Test the performance of updating the registry one operation at a
+// time, with and without storing the changes as registry deltas, and
+// of recovering the registry from the stored deltas.
+TEST_P(Registrar_BENCHMARK_Test, StoreDeltas)
+{
+  Attributes attributes = Attributes::parse("foo:bar;baz:quux");
+  Resources resources =
+    Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+  size_t slaveCount = GetParam();
+
+  // Create slaves.
+  vector<SlaveInfo> infos;
+  for (size_t i = 0; i < slaveCount; ++i) {
+    // Simulate real slave information.
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(
+        string("201310101658-2280333834-5050-48574-") + stringify(i));
+    info.mutable_resources()->MergeFrom(resources);
+    info.mutable_attributes()->MergeFrom(attributes);
+    infos.push_back(info);
+  }
+
+  // Admit slaves.
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    Stopwatch watch;
+    watch.start();
+    Future<bool> result;
+    foreach (const SlaveInfo& info, infos) {
+      result = registrar.apply(Owned<Operation>(new AdmitSlave(info)));
+    }
+    AWAIT_READY_FOR(result, Minutes(5));
+    LOG(INFO) << "Admitted " << slaveCount << " agents in " << watch.elapsed();
+  }
+
+  // Shuffle the slaves so that we mark them unreachable in random
+  // order (same as in production).
+  std::random_shuffle(infos.begin(), infos.end());
+
+  // Mark some slaves unreachable and then reachable again, waiting
+  // for each operation so that every one of them updates the registry.
+  const size_t updates = 100;
+
+  for (bool deltas : {false, true}) {
+    flags.registry_store_deltas = deltas;
+
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    TimeInfo unreachableTime = protobuf::getCurrentTime();
+
+    Stopwatch watch;
+    watch.start();
+    for (size_t i = 0; i < updates / 2; i++) {
+      AWAIT_TRUE_FOR(
+          registrar.apply(
+              Owned<Operation>(
+                  new MarkSlaveUnreachable(infos[i], unreachableTime))),
+          Minutes(5));
+
+      AWAIT_TRUE_FOR(
+          registrar.apply(Owned<Operation>(new MarkSlaveReachable(infos[i]))),
+          Minutes(5));
+    }
+    cout << "Updated the registry " << updates << " times "
+         << (deltas ? "with" : "without") << " deltas in "
+         << watch.elapsed() << endl;
+  }
+
+  // Recover slaves from the stored deltas.
+  Registrar registrar(flags, state);
+  Stopwatch watch;
+  watch.start();
+  Future<Registry> registry = registrar.recover(master);
+  AWAIT_READY(registry);
+  cout << "Recovered " << slaveCount << " agents ("
+       << Bytes(registry->ByteSize()) << ") in " << watch.elapsed() << endl;
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
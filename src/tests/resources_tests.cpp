@@ -1768,6 +1768,45 @@ TEST(ResourcesTest, ToUnreserved)
 }
 
 
+// This test verifies that pushing and popping a reservation in place
+// leaves resources which compare (and contain one another) just like
+// resources which have been created with the same reservations.
+TEST(ResourcesTest, PushAndPopReservation)
+{
+  Resources unreserved = Resources::parse("cpus:1;mem:512").get();
+
+  Resource::ReservationInfo reservation =
+    createDynamicReservationInfo("role1", "principal1");
+
+  Resources expected;
+  foreach (Resource resource, unreserved) {
+    resource.add_reservations()->CopyFrom(reservation);
+    expected += resource;
+  }
+
+  Resources reserved = unreserved.pushReservation(reservation);
+
+  EXPECT_EQ(expected, reserved);
+  EXPECT_TRUE(reserved.contains(expected));
+  EXPECT_TRUE(expected.contains(reserved));
+  EXPECT_FALSE(reserved.contains(unreserved));
+  EXPECT_FALSE(unreserved.contains(reserved));
+
+  EXPECT_EQ(expected + expected, reserved + expected);
+  EXPECT_TRUE((reserved - expected).empty());
+
+  Resources popped = reserved.popReservation();
+
+  EXPECT_EQ(unreserved, popped);
+  EXPECT_TRUE(popped.contains(unreserved));
+  EXPECT_TRUE(unreserved.contains(popped));
+  EXPECT_FALSE(popped.contains(reserved));
+
+  EXPECT_EQ(unreserved + unreserved, popped + unreserved);
+  EXPECT_TRUE((popped - unreserved).empty());
+}
+
+
 TEST(ResourcesTest, Find)
 {
   Resources resources1 = Resources::parse(
@@ -3224,6 +3263,89 @@ TEST(AllocatedResourcesTest, Subtraction)
 }
 
 
+// This test verifies that allocating and unallocating resources in
+// place leaves resources which compare (and contain one another) just
+// like resources which have been created with the same allocations.
+TEST(AllocatedResourcesTest, AllocateAndUnallocate)
+{
+  Resources unallocated = Resources::parse("cpus:1;mem:512").get();
+
+  Resources expected;
+  foreach (Resource resource, unallocated) {
+    resource.mutable_allocation_info()->set_role("role1");
+    expected += resource;
+  }
+
+  Resources allocated = unallocated;
+  allocated.allocate("role1");
+
+  EXPECT_EQ(expected, allocated);
+  EXPECT_TRUE(allocated.contains(expected));
+  EXPECT_TRUE(expected.contains(allocated));
+  EXPECT_FALSE(allocated.contains(unallocated));
+  EXPECT_FALSE(unallocated.contains(allocated));
+
+  // Allocating to another role replaces the allocation.
+  Resources reallocated = allocated;
+  reallocated.allocate("role2");
+
+  EXPECT_NE(allocated, reallocated);
+  EXPECT_FALSE(reallocated.contains(allocated));
+  EXPECT_EQ(4u, (allocated + reallocated).size());
+
+  reallocated.unallocate();
+
+  EXPECT_EQ(unallocated, reallocated);
+  EXPECT_TRUE(reallocated.contains(unallocated));
+  EXPECT_TRUE(unallocated.contains(reallocated));
+  EXPECT_TRUE((reallocated - unallocated).empty());
+}
+
+
+// This test verifies that the scalar arithmetic in place combines
+// allocated resources only with resources of the same allocation.
+TEST(AllocatedResourcesTest, ScalarArithmetic)
+{
+  Resources cpus1 = Resources::parse("cpus", "1", "*").get();
+  Resources cpus2 = Resources::parse("cpus", "2", "*").get();
+  Resources cpus3 = Resources::parse("cpus", "3", "*").get();
+
+  cpus1.allocate("role1");
+  cpus2.allocate("role1");
+  cpus3.allocate("role1");
+
+  Resources other = Resources::parse("cpus", "1", "*").get();
+  other.allocate("role2");
+
+  Resources resources = cpus1;
+  resources += cpus2;
+
+  EXPECT_EQ(cpus3, resources);
+  EXPECT_EQ(1u, resources.size());
+
+  resources += other;
+
+  EXPECT_EQ(2u, resources.size());
+  EXPECT_TRUE(resources.contains(cpus3));
+  EXPECT_TRUE(resources.contains(other));
+  EXPECT_FALSE(resources.contains(cpus3 + cpus1));
+
+  resources -= cpus2;
+
+  EXPECT_EQ(cpus1 + other, resources);
+
+  // Subtracting resources of another allocation has no effect.
+  resources -= Resources::parse("cpus", "1", "*").get();
+
+  EXPECT_EQ(cpus1 + other, resources);
+
+  resources -= cpus1;
+  resources -= other;
+
+  EXPECT_TRUE(resources.empty());
+}
+
+
 TEST(AllocatedResourcesTest, Allocations)
 {
   // Unreserved resources can be allocated to any role (including *).
@@ -3313,6 +3435,17 @@ public:
     }
     reservations.totalOperations = 10;
 
+    // Test a large amount of allocations to different roles. This
+    // can occur when aggregating what is allocated on an agent.
+    ScalarArithmeticParameter allocations;
+    for (int i = 0; i < 1000; ++i) {
+      Resources allocated = scalars.resources;
+      allocated.allocate("role_" + stringify(i));
+
+      allocations.resources += allocated;
+    }
+    allocations.totalOperations = 10;
+
     // Test the performance of ranges using a fragmented range of
     // ports: [1-2,4-5,7-8,...,1000]. Note that the benchmark will
     // continuously sum together the same port range, which does
@@ -3342,6 +3475,7 @@ public:
 
     parameters_.push_back(std::move(scalars));
     parameters_.push_back(std::move(reservations));
+    parameters_.push_back(std::move(allocations));
     parameters_.push_back(std::move(ranges));
     parameters_.push_back(std::move(shared));
 
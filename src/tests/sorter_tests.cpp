@@ -1550,6 +1550,76 @@ TEST(SorterTest, RemoveSharedResources)
 }
 
 
+// This test verifies that the order of the clients is the same when
+// the sorter only repositions the clients whose allocations changed
+// as when it resorts the whole tree.
+TEST(SorterTest, IncrementalSort)
+{
+  // The `full` sorter gets resorted before every sort since updating
+  // a weight dirties the whole tree.
+  DRFSorter incremental;
+  DRFSorter full;
+
+  SlaveID slaveId;
+  slaveId.set_value("agentId");
+
+  Resources totalResources = Resources::parse("cpus:100;mem:100").get();
+
+  incremental.add(slaveId, totalResources);
+  full.add(slaveId, totalResources);
+
+  const vector<string> clients =
+    {"a", "b", "c/d", "c/e", "c", "f/g/h", "f/g/i", "f/j"};
+
+  foreach (const string& client, clients) {
+    incremental.add(client);
+    incremental.activate(client);
+
+    full.add(client);
+    full.activate(client);
+  }
+
+  EXPECT_EQ(full.sort(), incremental.sort());
+
+  const vector<Resources> allocations = {
+    Resources::parse("cpus:1;mem:3").get(),
+    Resources::parse("cpus:2").get(),
+    Resources::parse("mem:5").get()
+  };
+
+  for (size_t i = 0; i < 64; i++) {
+    const string& client = clients[(i * 5) % clients.size()];
+    const Resources& allocation = allocations[i % allocations.size()];
+
+    incremental.allocated(client, slaveId, allocation);
+    full.allocated(client, slaveId, allocation);
+
+    // Deactivate and reactivate some client every now and then.
+    if (i % 7 == 0) {
+      const string& other = clients[(i * 3) % clients.size()];
+
+      incremental.deactivate(other);
+      full.deactivate(other);
+
+      if (i % 2 == 0) {
+        incremental.activate(other);
+        full.activate(other);
+      }
+    }
+
+    // Recover some of the allocations every now and then.
+    if (i % 3 == 0) {
+      incremental.unallocated(client, slaveId, allocation);
+      full.unallocated(client, slaveId, allocation);
+    }
+
+    full.updateWeight("unused", 1.0);
+
+    EXPECT_EQ(full.sort(), incremental.sort());
+  }
+}
+
+
 class Sorter_BENCHMARK_Test
   : public ::testing::Test,
     public ::testing::WithParamInterface<std::tuple<size_t, size_t>> {};
@@ -1675,6 +1745,35 @@ TEST_P(Sorter_BENCHMARK_Test, FullSort)
   cout << "Removed allocations for " << agentCount << " agents in "
          << watch.elapsed() << endl;
 
+  foreach (const string& client, clients) {
+    sorter.activate(client);
+  }
+
+  sorter.sort();
+
+  vector<string> allocations;
+  allocations.reserve(agentCount);
+
+  watch.start();
+  {
+    // Allocate resources on all agents like an allocation cycle does,
+    // i.e., to the client which comes first in DRF order, sorting the
+    // clients again after every allocation.
+    foreach (const SlaveID& slaveId, agents) {
+      const string client = sorter.sort().front();
+      sorter.allocated(client, slaveId, allocated);
+      allocations.push_back(client);
+    }
+  }
+  watch.stop();
+
+  cout << "Sorted and allocated for " << agentCount << " agents in "
+       << watch.elapsed() << endl;
+
+  for (size_t i = 0; i < agentCount; i++) {
+    sorter.unallocated(allocations[i], agents[i], allocated);
+  }
+
   watch.start();
   {
     foreach (const SlaveID& slaveId, agents) {
@@ -1854,6 +1953,35 @@ TEST_P(HierarchicalSorter_BENCHMARK_Test, FullSort)
   cout << "Removed allocations for " << agentCount << " agents in "
          << watch.elapsed() << endl;
 
+  foreach (const string& client, clients) {
+    sorter.activate(client);
+  }
+
+  sorter.sort();
+
+  vector<string> allocations;
+  allocations.reserve(agentCount);
+
+  watch.start();
+  {
+    // Allocate resources on all agents like an allocation cycle does,
+    // i.e., to the client which comes first in DRF order, sorting the
+    // clients again after every allocation.
+    foreach (const SlaveID& slaveId, agents) {
+      const string client = sorter.sort().front();
+      sorter.allocated(client, slaveId, allocated);
+      allocations.push_back(client);
+    }
+  }
+  watch.stop();
+
+  cout << "Sorted and allocated for " << agentCount << " agents in "
+       << watch.elapsed() << endl;
+
+  for (size_t i = 0; i < agentCount; i++) {
+    sorter.unallocated(allocations[i], agents[i], allocated);
+  }
+
   watch.start();
   {
     foreach (const SlaveID& slaveId, agents) {
@@ -691,6 +691,99 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+// This test verifies that a value which extends its snapshot is
+// stored as an APPEND when the storage allows it, and that the value
+// is recovered from the APPEND.
+TEST_F(LogStateTest, Append)
+{
+  delete state;
+  delete storage;
+
+  storage = new mesos::state::LogStorage(log, 0, true);
+  state = new State(storage);
+
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable = future1.get();
+
+  Slaves slaves = variable.get();
+  ASSERT_TRUE(slaves.slaves().empty());
+
+  for (size_t i = 0; i < 1024; i++) {
+    Slave* slave = slaves.add_slaves();
+    slave->mutable_info()->set_hostname("localhost" + stringify(i));
+  }
+
+  variable = variable.mutate(slaves);
+
+  Future<Option<Variable<Slaves>>> future2 = state->store(variable);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  variable = future2->get();
+
+  // Adding a slave extends the serialized 'Slaves'.
+  Slave* slave = slaves.add_slaves();
+  slave->mutable_info()->set_hostname("localhost1024");
+
+  variable = variable.mutate(slaves);
+
+  future2 = state->store(variable);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // See the comment in the 'Diff' test above.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Log::Reader reader(log);
+
+  Future<Log::Position> beginning = reader.beginning();
+  Future<Log::Position> ending = reader.ending();
+
+  AWAIT_READY(beginning);
+  AWAIT_READY(ending);
+
+  Future<list<Log::Entry>> entries = reader.read(beginning.get(), ending.get());
+
+  AWAIT_READY(entries);
+
+  vector<Operation> operations;
+
+  foreach (const Log::Entry& entry, entries.get()) {
+    Operation operation;
+
+    google::protobuf::io::ArrayInputStream stream(
+        entry.data.data(),
+        entry.data.size());
+
+    ASSERT_TRUE(operation.ParseFromZeroCopyStream(&stream));
+
+    operations.push_back(operation);
+  }
+
+  ASSERT_EQ(2u, operations.size());
+  EXPECT_EQ(Operation::SNAPSHOT, operations[0].type());
+  EXPECT_EQ(Operation::APPEND, operations[1].type());
+
+  // Recover the value from the log.
+  delete state;
+  delete storage;
+
+  storage = new mesos::state::LogStorage(log);
+  state = new State(storage);
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Slaves recovered = future1->get();
+  ASSERT_EQ(1025, recovered.slaves().size());
+  EXPECT_EQ("localhost1024", recovered.slaves(1024).info().hostname());
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {